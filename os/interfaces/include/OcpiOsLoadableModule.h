@@ -143,6 +143,11 @@ namespace OCPI {
         throw (std::string);
 
       static void *load(const char *fileName, bool global, std::string &error) throw ();
+      /**
+       * Release a handle returned by load().  The module is unloaded when
+       * no other handles or instances refer to it.
+       */
+      static void unload(void *handle) throw ();
       static const char *suffix() throw();
 
     private:
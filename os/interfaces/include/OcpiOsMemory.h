@@ -0,0 +1,125 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// -*- c++ -*-
+
+#ifndef OCPIOSMEMORY_H__
+#define OCPIOSMEMORY_H__
+
+/**
+ * \file
+ * \brief Page-level memory allocation with huge page and NUMA placement options.
+ *
+ * These functions are for large, long-lived buffer pools.  Every option is
+ * a request, not a requirement: when the system cannot honor it the
+ * allocation still succeeds with ordinary pages and the caller is told what
+ * was actually obtained so it can report it.
+ */
+
+#include <cstddef>
+
+namespace OCPI {
+  namespace OS {
+
+    /**
+     * Bits returned by allocateMemory describing what was obtained.
+     */
+    enum MemoryObtained {
+      MemoryHugePages   = 1, // backed by reserved (hugetlb) huge pages
+      MemoryHugeAdvised = 2, // ordinary pages with transparent huge page advice
+      MemoryNumaBound   = 4  // placement preference set to the requested NUMA node
+    };
+
+    /**
+     * Allocate page-aligned memory.
+     *
+     * \param[in,out] size  The number of bytes requested.  On return it is the
+     *                      size actually mapped, which must be passed to
+     *                      freeMemory.
+     * \param[in] hugePages Request huge pages: hugetlb pages if any are free,
+     *                      otherwise transparent huge page advice.
+     * \param[in] numaNode  The NUMA node to place the memory on, or -1 for
+     *                      the system's default policy.
+     * \param[out] obtained A mask of MemoryObtained bits.
+     * \return   The memory, or NULL if none could be allocated at all.
+     */
+    void *allocateMemory(size_t &size, bool hugePages, int numaNode, unsigned &obtained)
+      throw ();
+
+    /**
+     * Free memory returned by allocateMemory, with the size it returned.
+     */
+    void freeMemory(void *p, size_t size)
+      throw ();
+
+    /**
+     * Prefer the given NUMA node for pages of this range not yet touched.
+     * \return false if the system does not support it.
+     */
+    bool bindMemory(void *p, size_t size, unsigned numaNode)
+      throw ();
+
+    /**
+     * Advise the system to use transparent huge pages for this range.
+     * \return false if the advice was rejected.
+     */
+    bool adviseHugePages(void *p, size_t size)
+      throw ();
+
+    /**
+     * The size of a huge page in bytes, or zero if huge pages are not supported.
+     */
+    size_t hugePageSize()
+      throw ();
+
+    /**
+     * The number of huge pages currently free in the system pool.
+     */
+    size_t freeHugePages()
+      throw ();
+
+    /**
+     * The directory where a hugetlbfs file system is mounted, or NULL if none.
+     */
+    const char *hugePageDirectory()
+      throw ();
+
+    /**
+     * The NUMA node of the processor running the calling thread, or -1 if unknown.
+     */
+    int currentNumaNode()
+      throw ();
+
+    /**
+     * The number of NUMA nodes in the system (at least 1).
+     */
+    unsigned numaNodeCount()
+      throw ();
+
+    /**
+     * Restrict the calling thread to the processors of the given NUMA node.
+     * \return false if the node does not exist or the system does not support it.
+     */
+    bool runOnNumaNode(unsigned numaNode)
+      throw ();
+  }
+}
+
+#endif
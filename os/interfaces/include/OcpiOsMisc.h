@@ -36,6 +36,7 @@
  */
 
 #include <string>
+#include <vector>
 
 namespace OCPI {
   namespace OS {
@@ -151,6 +152,28 @@ namespace OCPI {
 
     void getExecFile(std::string &name);
 
+    /**
+     * Returns the processors that the calling thread is allowed to run on.
+     *
+     * \param[out] cpus The processor numbers, in increasing order.  If the
+     *             system cannot say, this is processors 0 to N-1 for the
+     *             N processors online.
+     */
+
+    void getProcessors(std::vector<unsigned> &cpus)
+      throw ();
+
+    /**
+     * Restrict the calling thread to one processor.
+     *
+     * \param[in] cpu The processor number.
+     * \return    false if the processor is not available or the system
+     *             does not support it.
+     */
+
+    bool runOnProcessor(unsigned cpu)
+      throw ();
+
   }
 }
 
@@ -192,6 +192,8 @@ namespace OCPI {
       int fd()
 	throw();
       size_t sendmsg (const void * iovect, unsigned int flags ) throw (std::string);
+      // Send an array of "struct msghdr" datagrams, with one system call where possible
+      void sendmsgs (const void * msghdrs, unsigned n, unsigned int flags ) throw (std::string);
       size_t sendto (const char * data, size_t amount, int flags,  char * src_addr,
 		     size_t addrlen) throw (std::string);
       size_t recvfrom(char  *buf, size_t amount, int flags, char *  src_addr,
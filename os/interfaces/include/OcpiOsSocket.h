@@ -40,6 +40,7 @@
  */
 
 #include <OcpiOsDataTypes.h>
+#include <OcpiOsIovec.h>
 #include <string>
 
 namespace OCPI {
@@ -160,6 +161,22 @@ namespace OCPI {
 
       size_t send(const char *data, size_t amount)
         throw (std::string);
+
+      /**
+       * Sends the data in several buffers to the peer, in order, with as
+       * few system calls as possible.
+       *
+       * Like send(), keeps trying until all bytes are sent.  The buffer
+       * descriptors are consumed as the data is sent.
+       *
+       * \param[in] iov     The buffers to send.
+       * \param[in] n       The number of buffers.
+       * \return            The number of octets sent.
+       *
+       * \throw std::string In case of error, such as a broken connection.
+       */
+      size_t sendv(IOVec *iov, unsigned n)
+        throw (std::string);
       size_t sendmsg(const void * iovect, unsigned int flags )
         throw (std::string);
       size_t sendto(const char * data, size_t amount, int flags,  char * src_addr,
@@ -90,20 +90,30 @@ OCPI::OS::LoadableModule::open (const std::string & fileName, bool global)
 
 // Static: used with the class as well as usable standalone
 // Return handle.  Or null and set error
+// dlopen itself is thread-safe, so only the error retrieval is under the mutex, which lets
+// modules be loaded in parallel (e.g. artifact prefetching).
 void *
 OCPI::OS::LoadableModule::load(const char *fileName, bool global, std::string &error) throw () {
-  pthread_mutex_lock (&g_slMutex);
   void *handle = dlopen (fileName, RTLD_NOW | (global ? RTLD_GLOBAL : RTLD_LOCAL));
   if (!handle) {
+    pthread_mutex_lock (&g_slMutex);
     error = "error loading \"";
     error += fileName;
     error += "\": ";
-    error += dlerror();
+    const char *err = dlerror();
+    error += err ? err : "unknown error";
+    pthread_mutex_unlock (&g_slMutex);
   }
-  pthread_mutex_unlock (&g_slMutex);
   return handle;
 }
 
+void
+OCPI::OS::LoadableModule::unload(void *handle) throw () {
+  pthread_mutex_lock (&g_slMutex);
+  dlclose (handle);
+  pthread_mutex_unlock (&g_slMutex);
+}
+
 const char *
 OCPI::OS::LoadableModule::suffix() throw() {
 #ifdef OCPI_OS_macos
@@ -0,0 +1,244 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * NUMA placement uses the mbind and getcpu system calls directly rather than
+ * libnuma so there is no additional runtime dependency.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "ocpi-config.h"
+#ifdef OCPI_OS_linux
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+#include "OcpiOsAssert.h"
+#include "OcpiOsMemory.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace OCPI {
+  namespace OS {
+
+#ifdef OCPI_OS_linux
+    // Get a number in kB (or plain) from /proc/meminfo
+    static size_t
+    memInfo(const char *key) {
+      FILE *f = fopen("/proc/meminfo", "r");
+      size_t value = 0, len = strlen(key);
+      if (f) {
+	char line[256];
+	while (fgets(line, sizeof(line), f))
+	  if (!strncmp(line, key, len) && line[len] == ':') {
+	    unsigned long long ull;
+	    char unit[8] = "";
+	    if (sscanf(line + len + 1, "%llu %7s", &ull, unit) >= 1)
+	      value = (size_t)(unit[0] == 'k' ? ull * 1024 : ull);
+	    break;
+	  }
+	fclose(f);
+      }
+      return value;
+    }
+#endif
+
+    size_t
+    hugePageSize() throw () {
+#ifdef OCPI_OS_linux
+      static size_t size = memInfo("Hugepagesize");
+      return size;
+#else
+      return 0;
+#endif
+    }
+
+    size_t
+    freeHugePages() throw () {
+#ifdef OCPI_OS_linux
+      return memInfo("HugePages_Free");
+#else
+      return 0;
+#endif
+    }
+
+#ifdef OCPI_OS_linux
+    static pthread_once_t s_hugeDirOnce = PTHREAD_ONCE_INIT;
+    static char s_hugeDir[256];
+    // Find the first writable hugetlbfs mount, once, whichever thread asks first
+    static void
+    findHugePageDirectory() {
+      FILE *f = fopen("/proc/mounts", "r");
+      if (f) {
+	char line[512], mnt[256], type[64];
+	while (fgets(line, sizeof(line), f))
+	  if (sscanf(line, "%*s %255s %63s", mnt, type) == 2 && !strcmp(type, "hugetlbfs") &&
+	      !access(mnt, W_OK)) {
+	    strcpy(s_hugeDir, mnt);
+	    break;
+	  }
+	fclose(f);
+      }
+    }
+#endif
+
+    const char *
+    hugePageDirectory() throw () {
+#ifdef OCPI_OS_linux
+      pthread_once(&s_hugeDirOnce, findHugePageDirectory);
+      return s_hugeDir[0] ? s_hugeDir : NULL;
+#else
+      return NULL;
+#endif
+    }
+
+    bool
+    bindMemory(void *p, size_t size, unsigned numaNode) throw () {
+#ifdef OCPI_OS_linux
+      const int preferred = 1; // MPOL_PREFERRED from <numaif.h>
+      unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+      if (numaNode >= sizeof(mask) * 8)
+	return false;
+      memset(mask, 0, sizeof(mask));
+      mask[numaNode / (8 * sizeof(unsigned long))] |= 1ul << (numaNode % (8 * sizeof(unsigned long)));
+      return syscall(SYS_mbind, p, size, preferred, mask, sizeof(mask) * 8, 0) == 0;
+#else
+      (void)p; (void)size; (void)numaNode;
+      return false;
+#endif
+    }
+
+    bool
+    adviseHugePages(void *p, size_t size) throw () {
+#if defined(OCPI_OS_linux) && defined(MADV_HUGEPAGE)
+      return madvise(p, size, MADV_HUGEPAGE) == 0;
+#else
+      (void)p; (void)size;
+      return false;
+#endif
+    }
+
+    void *
+    allocateMemory(size_t &size, bool hugePages, int numaNode, unsigned &obtained) throw () {
+      void *p = MAP_FAILED;
+      obtained = 0;
+#if defined(OCPI_OS_linux) && defined(MAP_HUGETLB)
+      size_t hps = hugePageSize();
+      if (hugePages && hps) {
+	size_t hsize = (size + hps - 1) & ~(hps - 1);
+	// Only try when the pool has enough pages, to avoid a noisy kernel failure
+	if (freeHugePages() >= hsize / hps &&
+	    (p = mmap(NULL, hsize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,
+		      -1, 0)) != MAP_FAILED) {
+	  size = hsize;
+	  obtained |= MemoryHugePages;
+	}
+      }
+#endif
+      if (p == MAP_FAILED) {
+	size_t ps = (size_t)getpagesize();
+	size = (size + ps - 1) & ~(ps - 1);
+	if ((p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0))
+	    == MAP_FAILED)
+	  return NULL;
+	if (hugePages && adviseHugePages(p, size))
+	  obtained |= MemoryHugeAdvised;
+      }
+      // Nothing has been touched yet so the policy applies to every page
+      if (numaNode >= 0 && bindMemory(p, size, (unsigned)numaNode))
+	obtained |= MemoryNumaBound;
+      return p;
+    }
+
+    void
+    freeMemory(void *p, size_t size) throw () {
+      if (p)
+	ocpiCheck(munmap(p, size) == 0);
+    }
+
+    int
+    currentNumaNode() throw () {
+#if defined(OCPI_OS_linux) && defined(SYS_getcpu)
+      unsigned cpu, node;
+      if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+	return (int)node;
+#endif
+      return -1;
+    }
+
+    unsigned
+    numaNodeCount() throw () {
+#ifdef OCPI_OS_linux
+      // This file contains a range list like "0" or "0-1"
+      FILE *f = fopen("/sys/devices/system/node/online", "r");
+      unsigned first = 0, last = 0;
+      if (f) {
+	int n = fscanf(f, "%u-%u", &first, &last);
+	fclose(f);
+	if (n == 2)
+	  return last + 1;
+	if (n == 1)
+	  return first + 1;
+      }
+#endif
+      return 1;
+    }
+
+    bool
+    runOnNumaNode(unsigned numaNode) throw () {
+#ifdef OCPI_OS_linux
+      char file[128], list[1024];
+      snprintf(file, sizeof(file), "/sys/devices/system/node/node%u/cpulist", numaNode);
+      FILE *f = fopen(file, "r");
+      if (!f)
+	return false;
+      bool ok = fgets(list, sizeof(list), f) != NULL;
+      fclose(f);
+      if (!ok)
+	return false;
+      // Parse a cpu list like "0-7,16-23"
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (char *cp = list; *cp && *cp != '\n'; ) {
+	char *end;
+	unsigned long first = strtoul(cp, &end, 10), last = first;
+	if (end == cp)
+	  return false;
+	if (*end == '-')
+	  last = strtoul(end + 1, &end, 10);
+	for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+	  CPU_SET(cpu, &set);
+	cp = *end == ',' ? end + 1 : end;
+      }
+      return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+      (void)numaNode;
+      return false;
+#endif
+    }
+  }
+}
@@ -197,3 +197,39 @@ getExecFile(std::string &file) {
   file = buf;
   delete [] buf;
 }
+
+void OCPI::OS::
+getProcessors(std::vector<unsigned> &cpus)
+  throw ()
+{
+  cpus.clear();
+#ifdef OCPI_OS_linux
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    for (unsigned n = 0; n < CPU_SETSIZE; n++)
+      if (CPU_ISSET(n, &set))
+	cpus.push_back(n);
+#endif
+  if (cpus.empty()) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    for (unsigned u = 0; u < (n > 0 ? (unsigned)n : 1); u++)
+      cpus.push_back(u);
+  }
+}
+
+bool OCPI::OS::
+runOnProcessor(unsigned cpu)
+  throw ()
+{
+#ifdef OCPI_OS_linux
+  if (cpu >= CPU_SETSIZE)
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
@@ -245,6 +245,38 @@ sendmsg (const void * iovect, unsigned int flags  ) throw (std::string) {
   return static_cast<size_t>(ret);
 }
 
+#if defined(OCPI_OS_linux) && defined(__GLIBC__) && \
+  (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+#define HAVE_SENDMMSG 1
+#endif
+void ServerSocket::
+sendmsgs (const void * msghdrs, unsigned n, unsigned int flags) throw (std::string) {
+  const struct msghdr * msgs = static_cast<const struct msghdr *>(msghdrs);
+#ifdef HAVE_SENDMMSG
+  const unsigned chunk = 32;
+  struct mmsghdr mmsgs[chunk];
+  while (n) {
+    unsigned nn = n < chunk ? n : chunk;
+    for (unsigned i = 0; i < nn; i++) {
+      mmsgs[i].msg_hdr = msgs[i];
+      mmsgs[i].msg_len = 0;
+    }
+    int ret = ::sendmmsg (o2fd (m_osOpaque), mmsgs, nn, (int)flags);
+    if (ret == -1) {
+      if (errno == EINTR)
+	continue;
+      if (errno == ENOSYS) // kernel older than the library
+	break;
+      throw Posix::getErrorMessage (errno);
+    }
+    msgs += ret;
+    n -= (unsigned)ret;
+  }
+#endif
+  for (; n; n--, msgs++)
+    sendmsg (msgs, flags);
+}
+
 size_t ServerSocket::
 sendto (const char * data, size_t amount, int flags,  char * src_addr, size_t addrlen)
   throw (std::string) {
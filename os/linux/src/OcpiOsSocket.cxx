@@ -253,6 +253,43 @@ send(const char * data, size_t amount) throw (std::string) {
   return amount;
 }
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+// Send the buffers using sendmsg, with the same persistence as "send" above
+size_t Socket::
+sendv(IOVec *iov, unsigned n) throw (std::string) {
+  size_t amount = 0;
+  for (unsigned i = 0; i < n; i++)
+    amount += iov[i].iov_len;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  for (;;) {
+    for (; n && !iov->iov_len; n--, iov++)
+      ;
+    if (!n)
+      break;
+    msg.msg_iov = (struct iovec *)iov; // IOVec is layout compatible
+    msg.msg_iovlen = n < IOV_MAX ? n : IOV_MAX;
+    ssize_t nsent = ::sendmsg(o2fd(m_osOpaque), &msg, SEND_OPTS);
+    if (nsent == 0)
+      throw std::string("Error sending to network: got EOF");
+    else if (nsent < 0) {
+      if (errno == EINTR)
+	continue;
+      throw "Error sending to network: " + Posix::getErrorMessage(errno);
+    }
+    size_t left = (size_t)nsent;
+    for (; n && left >= iov->iov_len; n--, iov++)
+      left -= iov->iov_len;
+    if (left) {
+      iov->iov_base = (char *)iov->iov_base + left;
+      iov->iov_len -= left;
+    }
+  }
+  return amount;
+}
+
 // NOTE THIS CODE IS REPLICATED IN THE SERVER FOR DATAGRAMS
 size_t Socket::
 sendmsg (const void * iovect, unsigned int flags  ) throw (std::string) {
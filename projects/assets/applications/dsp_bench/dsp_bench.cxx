@@ -0,0 +1,196 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark of the signal processing kernels used by the RCC workers of the
+ * dsp_comps library.  Each kernel is run single threaded at every SIMD level the CPU
+ * supports, reporting throughput per core, and the output of every SIMD level is
+ * checked against the portable scalar code.  The CIC and DC offset kernels are
+ * recursive and have a single implementation, so they are only timed.
+ *
+ * Usage: dsp_bench [samples [seconds]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "dsp_simd.h"
+
+namespace DS = DspSimd;
+
+static size_t nSamples = 8192; // samples per call, like the default messageSize
+static double minSeconds = 0.5;
+
+static double
+now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Call a kernel repeatedly for at least minSeconds and report Msamples/s
+template <typename F> static double
+timeIt(F f) {
+  size_t calls = 0;
+  double start = now(), elapsed;
+  do {
+    for (unsigned n = 0; n < 16; n++)
+      f();
+    calls += 16;
+  } while ((elapsed = now() - start) < minSeconds);
+  return (double)calls * (double)nSamples / elapsed / 1e6;
+}
+
+static void
+report(const char *kernel, const char *level, double msps, double base, const char *check) {
+  printf("%-24s %-8s %10.1f %8.2fx  %s\n", kernel, level, msps, msps / base, check);
+}
+
+static void
+random16(std::vector<int16_t> &v, int amplitude) {
+  for (size_t n = 0; n < v.size(); n++)
+    v[n] = (int16_t)(rand() % (2 * amplitude + 1) - amplitude);
+}
+
+static int errors;
+
+static void
+firBench(const char *name, unsigned nTaps, unsigned stride) {
+  std::vector<int16_t> taps(nTaps), x(stride * nSamples), ref, y(x.size());
+  random16(taps, 32767);
+  random16(x, 16383);
+  double base = 0;
+  for (unsigned l = 0; l <= DS::bestLevel(); l++) {
+    DS::Level level = (DS::Level)l;
+    std::vector<int32_t> h(taps.begin(), taps.end());
+    std::vector<int16_t> in(stride * (2 * nTaps - 1) + x.size());
+    memcpy(&in[stride * (2 * nTaps - 1)], &x[0], x.size() * sizeof(int16_t));
+    double msps = timeIt([&] {
+	DS::firSymEven(&in[stride * (2 * nTaps - 1)], &y[0], x.size(), &h[0], nTaps, stride,
+		       15, level);
+      });
+    const char *check = "reference";
+    if (l == DS::SCALAR) {
+      ref = y;
+      base = msps;
+    } else if (y != ref) {
+      check = "MISMATCH";
+      errors++;
+    } else
+      check = "bit exact";
+    report(name, DS::levelName(level), msps, base, check);
+  }
+}
+
+static void
+peakBench() {
+  std::vector<int16_t> x(2 * nSamples);
+  random16(x, 32767);
+  int16_t ref = 0, p = 0;
+  // Keep the compiler from hoisting this loop invariant call out of the timing loop
+  const int16_t *volatile xp = &x[0];
+  double base = 0;
+  for (unsigned l = 0; l <= DS::bestLevel(); l++) {
+    DS::Level level = (DS::Level)l;
+    double msps = timeIt([&] { p = DS::peak(xp, x.size(), p, level); });
+    const char *check = "reference";
+    if (l == DS::SCALAR) {
+      ref = p;
+      base = msps;
+    } else if (p != ref) {
+      check = "MISMATCH";
+      errors++;
+    } else
+      check = "bit exact";
+    report("peak (I/Q)", DS::levelName(level), msps, base, check);
+  }
+}
+
+static void
+mixBench() {
+  std::vector<int16_t> x(2 * nSamples), ref, y(x.size());
+  random16(x, 16383);
+  uint32_t inc = (uint32_t)(int32_t)-8192 << 16;
+  double base = 0;
+  for (unsigned l = 0; l <= DS::bestLevel(); l++) {
+    DS::Level level = (DS::Level)l;
+    uint32_t phase = 0;
+    double msps = timeIt([&] { DS::mix(&x[0], &y[0], nSamples, phase, inc, level); });
+    // Check one call from a known phase: SIMD rounding may differ by one LSB
+    phase = 0x12345678;
+    DS::mix(&x[0], &y[0], nSamples, phase, inc, level);
+    const char *check = "reference";
+    if (l == DS::SCALAR) {
+      ref = y;
+      base = msps;
+    } else {
+      check = "within 1 LSB";
+      for (size_t n = 0; n < y.size(); n++)
+	if (abs(y[n] - ref[n]) > 1) {
+	  check = "MISMATCH";
+	  errors++;
+	  break;
+	}
+    }
+    report("complex_mixer", DS::levelName(level), msps, base, check);
+  }
+}
+
+static void
+recursiveBench() {
+  std::vector<int16_t> x(2 * nSamples), y(2 * 8 * nSamples);
+  random16(x, 16383);
+  int16_t state[2] = { 0, 0 };
+  double msps = timeIt([&] { DS::dcOffset(&x[0], &y[0], nSamples, 121, true, state); });
+  report("dc_offset_filter", "vector", msps, msps, "");
+  DS::Cic<3, 1> dec;
+  size_t nOut;
+  msps = timeIt([&] { dec.decimate(&x[0], nSamples, &y[0], nSamples, nOut, 8, 16, 25, 16); });
+  report("cic_dec N=3 R=8", "vector", msps, msps, "input samples/s");
+  DS::Cic<3, 1> interp;
+  msps = timeIt([&] {
+      interp.interpolate(&x[0], nSamples / 8, &y[0], nSamples, nOut, 8, 16, 25, 16);
+    });
+  report("cic_int N=3 R=8", "vector", msps, msps, "output samples/s");
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1)
+    nSamples = (size_t)atoi(argv[1]) & ~(size_t)15;
+  if (argc > 2)
+    minSeconds = atof(argv[2]);
+  if (!nSamples) {
+    fprintf(stderr, "Usage: dsp_bench [samples [seconds]]\n");
+    return 1;
+  }
+  srand(1);
+  printf("Best SIMD level on this CPU: %s, %zu samples per call\n",
+	 DS::levelName(DS::bestLevel()), nSamples);
+  printf("%-24s %-8s %10s %9s  %s\n", "kernel", "level", "Msps/core", "speedup", "check");
+  firBench("fir_real_sse 64 taps", 64, 1);
+  firBench("fir_real_sse 128 taps", 128, 1);
+  firBench("fir_complex_sse 64 taps", 64, 2);
+  peakBench();
+  mixBench();
+  recursiveBench();
+  if (errors)
+    printf("%d SIMD kernels did not match the scalar reference\n", errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RCC implementation of the cic_dec spec, with the register structure and
+ * arithmetic of the HDL worker so that outputs match it sample for sample.
+ * Output messages are filled to messageSize bytes (or the buffer size if smaller)
+ * across input messages; a zero length input message flushes any partial output
+ * message before being passed on.
+ */
+
+#include <algorithm>
+#include "cic_dec-worker.hh"
+#include "dsp_simd.h"
+
+using namespace OCPI::RCC; // for easy access to RCC data types and constants
+using namespace Cic_decWorkerTypes;
+
+class Cic_decWorker : public Cic_decWorkerBase {
+  DspSimd::Cic<CIC_DEC_N, CIC_DEC_M> m_cic;
+  size_t m_inPos, m_outPos; // samples consumed from input and produced to output
+public:
+  Cic_decWorker() : m_inPos(0), m_outPos(0) {}
+private:
+  RCCResult initialize() {
+    if (!CIC_DEC_N || !CIC_DEC_M || !CIC_DEC_R)
+      return setError("N, M and R must all be nonzero");
+    if (!CIC_DEC_DIN_WIDTH || CIC_DEC_DIN_WIDTH > 16 || !CIC_DEC_DOUT_WIDTH ||
+	CIC_DEC_DOUT_WIDTH > 16)
+      return setError("DIN_WIDTH and DOUT_WIDTH must be between 1 and 16");
+    if (CIC_DEC_ACC_WIDTH > 64 || CIC_DEC_ACC_WIDTH < CIC_DEC_DOUT_WIDTH ||
+	CIC_DEC_ACC_WIDTH < CIC_DEC_DIN_WIDTH)
+      return setError("ACC_WIDTH (%u) must be at least DIN_WIDTH and DOUT_WIDTH, and at "
+		      "most 64", CIC_DEC_ACC_WIDTH);
+    // Start from scratch: this runs again when the application is reset
+    m_cic.reset();
+    m_inPos = m_outPos = 0;
+    return RCC_OK;
+  }
+  RCCResult flush() {
+    out.iq().data().resize(m_outPos);
+    out.advance();
+    m_outPos = 0;
+    return RCC_OK;
+  }
+  RCCResult run(bool /*timedout*/) {
+    if (!in.length()) {
+      if (m_outPos)
+	return flush(); // the zero length message is passed on in the next run
+      out.iq().data().resize(0);
+      return RCC_ADVANCE_DONE;
+    }
+    size_t
+      maxOut = std::max<size_t>(std::min<size_t>(properties().messageSize, out.maxLength()) /
+				sizeof(IqstreamIqData), 1),
+      nIn = in.iq().data().size(), nOut;
+    if (m_outPos >= maxOut)
+      return flush();
+    m_inPos += m_cic.decimate(&in.iq().data().data()[m_inPos].I, nIn - m_inPos,
+			      &out.iq().data().data()[m_outPos].I, maxOut - m_outPos, nOut,
+			      CIC_DEC_R, CIC_DEC_DIN_WIDTH, CIC_DEC_ACC_WIDTH, CIC_DEC_DOUT_WIDTH);
+    m_outPos += nOut;
+    if (m_inPos == nIn) {
+      in.advance();
+      m_inPos = 0;
+    }
+    return m_outPos == maxOut ? flush() : RCC_OK;
+  }
+};
+
+CIC_DEC_START_INFO
+// Insert any static info assignments here (memSize, memSizes, portInfo)
+// e.g.: info.memSize = sizeof(MyMemoryStruct);
+CIC_DEC_END_INFO
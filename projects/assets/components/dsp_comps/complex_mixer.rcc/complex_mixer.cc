@@ -26,76 +26,46 @@
  * This file contains the implementation skeleton for the complex_mixer worker in C++
  */
 
+#include <cstring>
 #include "complex_mixer-worker.hh"
-#include "liquid/liquid.h"
-#include <cmath>
-#include <iostream>
-#include <climits>
+#include "dsp_simd.h"
 
 using namespace OCPI::RCC; // for easy access to RCC data types and constants
 using namespace Complex_mixerWorkerTypes;
-using namespace std;
-
-#define Uscale(x)  (float)((float)(x) / (pow(2,15) -1))
-#define Scale(x)   (int16_t)((float)(x) * (pow(2,15) -1))
 
+/*
+ * The NCO frequency is phs_inc / 2^16 cycles per sample, as in the HDL worker.
+ * The phase is kept as a 32 bit fraction of a cycle so it wraps exactly, and
+ * persists across messages so the NCO is continuous.
+ */
 class Complex_mixerWorker : public Complex_mixerWorkerBase
 {
-  nco_crcf q;
-
-  RCCResult initialize()
-  {
-    q = nco_crcf_create(LIQUID_NCO);
-    nco_crcf_set_phase(q, 0.0f);
+  uint32_t m_phase;
 
-    return RCC_OK;
-  }
+public:
+  Complex_mixerWorker() : m_phase(0) {}
 
-  RCCResult release()
+private:
+  // The NCO restarts at phase zero, also when the application is reset
+  RCCResult initialize()
   {
-    nco_crcf_destroy(q);
-
+    m_phase = 0;
     return RCC_OK;
   }
 
   RCCResult run(bool /*timedout*/)
   {
-    const IqstreamIqData* inData = in.iq().data().data();
-    IqstreamIqData* outData = out.iq().data().data();
     const size_t num_of_elements = in.iq().data().size(); // size in IqstreamIqData units
     out.iq().data().resize(num_of_elements);
-
-    // set each time so that if the conatiner changes it gets updated
-    // might be better to put this into a write sync function but this is for training
-    float phase_inc = properties().phs_inc * ((2*M_PI)/(SHRT_MAX * 2));
-    nco_crcf_set_frequency(q,phase_inc);
-
-    liquid_float_complex out_sample;
-    liquid_float_complex in_sample;
-
-    for (unsigned int j = 0; j < num_of_elements; j++)
-    {
-      if (properties().enable)
-      {
-        in_sample.real = Uscale(inData->I);
-        in_sample.imag = Uscale(inData->Q);
-
-        nco_crcf_step(q);
-        nco_crcf_mix_up(q, in_sample, &out_sample);
-        outData->I = Scale(out_sample.real);
-        outData->Q = Scale(out_sample.imag);
-
-        inData++;
-        outData++;
-      }
-      else
-      {
-        outData->I = inData->I;
-        outData->Q = inData->Q;
-        inData++;
-        outData++;
-      }
-    }
+    const int16_t *x = &in.iq().data().data()->I;
+    int16_t *y = &out.iq().data().data()->I;
+
+    // read each time so that if the container changes it gets updated
+    if (properties().enable)
+      DspSimd::mix(x, y, num_of_elements, m_phase,
+		   (uint32_t)(int32_t)properties().phs_inc << 16);
+    else
+      memcpy(y, x, num_of_elements * sizeof(IqstreamIqData));
 
     return num_of_elements ? RCC_ADVANCE : RCC_ADVANCE_DONE;
   }
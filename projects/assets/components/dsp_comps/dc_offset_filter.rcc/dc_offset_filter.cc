@@ -0,0 +1,72 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RCC implementation of the dc_offset_filter spec, with the arithmetic of the HDL
+ * worker.  The tc property is the signed time constant 128 * alpha, as in the HDL
+ * worker.  When bypassed, the input is passed through while the filter state keeps
+ * tracking it, as the HDL primitive does.
+ */
+
+#include <cstring>
+#include "dc_offset_filter-worker.hh"
+#include "dsp_simd.h"
+
+using namespace OCPI::RCC; // for easy access to RCC data types and constants
+using namespace Dc_offset_filterWorkerTypes;
+
+class Dc_offset_filterWorker : public Dc_offset_filterWorkerBase {
+  int16_t m_state[2]; // previous accumulator for I and Q
+  int16_t m_peak;
+public:
+  Dc_offset_filterWorker() : m_peak(0) {
+    m_state[0] = m_state[1] = 0;
+  }
+private:
+  // Also called again when the application is reset
+  RCCResult initialize() {
+    m_state[0] = m_state[1] = 0;
+    m_peak = 0;
+    return RCC_OK;
+  }
+  RCCResult peak_read() {
+    properties().peak = m_peak;
+    m_peak = 0;
+    return RCC_OK;
+  }
+  RCCResult run(bool /*timedout*/) {
+    size_t n = in.iq().data().size();
+    out.iq().data().resize(n);
+    if (!n)
+      return RCC_ADVANCE_DONE;
+    const int16_t *x = &in.iq().data().data()->I;
+    int16_t *y = &out.iq().data().data()->I;
+    DspSimd::dcOffset(x, y, n, (int8_t)properties().tc, properties().update, m_state);
+    if (properties().bypass)
+      memcpy(y, x, n * sizeof(IqstreamIqData));
+    m_peak = DspSimd::peak(y, 2 * n, m_peak);
+    return RCC_ADVANCE;
+  }
+};
+
+DC_OFFSET_FILTER_START_INFO
+// Insert any static info assignments here (memSize, memSizes, portInfo)
+// e.g.: info.memSize = sizeof(MyMemoryStruct);
+DC_OFFSET_FILTER_END_INFO
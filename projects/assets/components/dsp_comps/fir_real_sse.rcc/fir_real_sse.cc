@@ -0,0 +1,80 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * RCC implementation of the fir_real_sse spec: an even length symmetric FIR filter
+ * with the arithmetic and latency of the HDL worker.  The filtering and output
+ * peak detection use the SIMD kernels of dsp_simd.h.
+ */
+
+#include "fir_real_sse-worker.hh"
+#include "OcpiOsDebugApi.hh" // OCPI_LOG_INFO
+#include "dsp_simd.h"
+
+using namespace OCPI::RCC; // for easy access to RCC data types and constants
+using namespace Fir_real_sseWorkerTypes;
+
+// The HDL worker delays its output by this many samples after the input
+static const unsigned LATENCY = FIR_REAL_SSE_NUM_TAPS_P + 3;
+
+class Fir_real_sseWorker : public Fir_real_sseWorkerBase {
+  DspSimd::SymFir m_fir;
+  int16_t m_peak;
+public:
+  Fir_real_sseWorker()
+    : m_fir(FIR_REAL_SSE_NUM_TAPS_P, 1, FIR_REAL_SSE_COEFF_WIDTH_P, LATENCY), m_peak(0) {
+  }
+private:
+  RCCResult initialize() {
+    if (FIR_REAL_SSE_DATA_WIDTH_P != 16)
+      return setError("DATA_WIDTH_p must be 16, not %u", FIR_REAL_SSE_DATA_WIDTH_P);
+    if (FIR_REAL_SSE_COEFF_WIDTH_P < 2 || FIR_REAL_SSE_COEFF_WIDTH_P > 16)
+      return setError("COEFF_WIDTH_p must be between 2 and 16, not %u",
+		      FIR_REAL_SSE_COEFF_WIDTH_P);
+    log(OCPI_LOG_INFO, "fir_real_sse using %s kernels", DspSimd::levelName(m_fir.level()));
+    m_fir.reset(); // no history from a run before the application was reset
+    m_peak = 0;
+    return RCC_OK;
+  }
+  RCCResult taps_written() {
+    m_fir.setTaps(properties().taps);
+    return RCC_OK;
+  }
+  RCCResult peak_read() {
+    properties().peak = m_peak;
+    m_peak = 0;
+    return RCC_OK;
+  }
+  RCCResult run(bool /*timedout*/) {
+    size_t n = in.data().real().size();
+    out.data().real().resize(n);
+    if (!n)
+      return RCC_ADVANCE_DONE;
+    int16_t *y = out.data().real().data();
+    m_fir.filter(in.data().real().data(), y, n);
+    m_peak = DspSimd::peak(y, n, m_peak);
+    return RCC_ADVANCE;
+  }
+};
+
+FIR_REAL_SSE_START_INFO
+// Insert any static info assignments here (memSize, memSizes, portInfo)
+// e.g.: info.memSize = sizeof(MyMemoryStruct);
+FIR_REAL_SSE_END_INFO
@@ -0,0 +1,515 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Signal processing kernels shared by the RCC workers of this library and by the
+ * dsp_bench application.
+ *
+ * Each data-parallel kernel has a portable scalar version and, on x86, SSE4.1 and
+ * AVX2 versions selected at run time from the capabilities of the CPU, so a single
+ * worker binary runs on any x86 processor.  The fixed-point kernels reproduce the
+ * arithmetic of the HDL primitives used by the HDL workers of the same specs,
+ * so the outputs of RCC and HDL implementations match sample for sample.
+ */
+
+#ifndef DSP_SIMD_H
+#define DSP_SIMD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#define DSP_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace DspSimd {
+
+  enum Level { SCALAR, SSE41, AVX2, NLEVELS };
+
+  inline const char *levelName(Level l) {
+    static const char *names[] = { "scalar", "sse4.1", "avx2" };
+    return names[l];
+  }
+
+  // The best level supported by this CPU, which the OCPI_DSP_SIMD environment
+  // variable can lower (e.g. to "scalar") when comparing implementations.
+  inline Level bestLevel() {
+    static int s_level = -1;
+    if (s_level < 0) {
+      int l = SCALAR;
+#ifdef DSP_SIMD_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+	l = AVX2;
+      else if (__builtin_cpu_supports("sse4.1"))
+	l = SSE41;
+#endif
+      const char *env = getenv("OCPI_DSP_SIMD");
+      if (env)
+	for (int n = 0; n < l; n++)
+	  if (!strcasecmp(env, levelName((Level)n))) {
+	    l = n;
+	    break;
+	  }
+      s_level = l;
+    }
+    return (Level)s_level;
+  }
+
+  /*
+   * Peak detection: the largest magnitude of a set of 16 bit values, where the
+   * magnitude of a negative value is its one's complement, as in the peakDetect
+   * HDL primitive.
+   */
+  inline int16_t peakScalar(const int16_t *x, size_t n, int16_t peak) {
+    for (size_t i = 0; i < n; i++) {
+      int16_t m = (int16_t)(x[i] ^ (x[i] >> 15));
+      if (m > peak)
+	peak = m;
+    }
+    return peak;
+  }
+
+#ifdef DSP_SIMD_X86
+  __attribute__((target("sse4.1")))
+  inline int16_t peakSse41(const int16_t *x, size_t n, int16_t peak) {
+    __m128i vmax = _mm_set1_epi16(peak);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(x + i));
+      vmax = _mm_max_epi16(vmax, _mm_xor_si128(v, _mm_srai_epi16(v, 15)));
+    }
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+    vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+    return peakScalar(x + i, n - i, (int16_t)_mm_extract_epi16(vmax, 0));
+  }
+
+  __attribute__((target("avx2")))
+  inline int16_t peakAvx2(const int16_t *x, size_t n, int16_t peak) {
+    __m256i vmax = _mm256_set1_epi16(peak);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+      vmax = _mm256_max_epi16(vmax, _mm256_xor_si256(v, _mm256_srai_epi16(v, 15)));
+    }
+    __m128i m = _mm_max_epi16(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 8));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 2));
+    return peakScalar(x + i, n - i, (int16_t)_mm_extract_epi16(m, 0));
+  }
+#endif
+
+  inline int16_t peak(const int16_t *x, size_t n, int16_t peak, Level level = bestLevel()) {
+#ifdef DSP_SIMD_X86
+    if (level == AVX2)
+      return peakAvx2(x, n, peak);
+    if (level == SSE41)
+      return peakSse41(x, n, peak);
+#else
+    (void)level;
+#endif
+    return peakScalar(x, n, peak);
+  }
+
+  /*
+   * Symmetric FIR filter with an even number (2 * nSections) of taps, of which h
+   * holds the first half, as in the fir_systolic_sym_even HDL primitive:
+   *
+   *   y[e] = sum(k < nSections) round(h[k] * (x[e - s*k] + x[e - s*(2*nSections-1-k)]))
+   *
+   * where each product is rounded convergently (half to even) to drop "shift" bits
+   * (COEFF_WIDTH - 1) and the sum wraps to 16 bits.  The stride s is 1 for real
+   * data and 2 for interleaved I/Q data, where n counts 16 bit values rather than
+   * samples.  x must be preceded by s * (2 * nSections - 1) values of history.
+   */
+  inline int32_t roundConv(uint32_t p, unsigned shift) {
+    return (int32_t)(p + (1u << (shift - 1)) - 1 + ((p >> shift) & 1)) >> shift;
+  }
+
+  inline void firSymEvenScalar(const int16_t *x, int16_t *y, size_t n, const int32_t *h,
+			       unsigned nSections, unsigned stride, unsigned shift) {
+    const ptrdiff_t s = stride, last = s * (2 * nSections - 1);
+    for (size_t e = 0; e < n; e++) {
+      const int16_t *a = x + e, *b = x + e - last;
+      uint32_t acc = 0;
+      for (unsigned k = 0; k < nSections; k++, a -= s, b += s)
+	acc += (uint32_t)roundConv((uint32_t)h[k] * (uint32_t)(*a + *b), shift);
+      y[e] = (int16_t)acc;
+    }
+  }
+
+#ifdef DSP_SIMD_X86
+  __attribute__((target("sse4.1")))
+  inline void firSymEvenSse41(const int16_t *x, int16_t *y, size_t n, const int32_t *h,
+			      unsigned nSections, unsigned stride, unsigned shift) {
+    const ptrdiff_t s = stride, last = s * (2 * nSections - 1);
+    const __m128i half = _mm_set1_epi32((1 << (shift - 1)) - 1), one = _mm_set1_epi32(1),
+      low = _mm_set1_epi32(0xffff), sh = _mm_cvtsi32_si128((int)shift);
+    size_t e = 0;
+    for (; e + 8 <= n; e += 8) {
+      __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+      const int16_t *a = x + e, *b = x + e - last;
+      for (unsigned k = 0; k < nSections; k++, a -= s, b += s) {
+	__m128i
+	  va = _mm_loadu_si128((const __m128i *)a),
+	  vb = _mm_loadu_si128((const __m128i *)b),
+	  hk = _mm_set1_epi32(h[k]),
+	  p0 = _mm_mullo_epi32(_mm_add_epi32(_mm_cvtepi16_epi32(va), _mm_cvtepi16_epi32(vb)), hk),
+	  p1 = _mm_mullo_epi32(_mm_add_epi32(_mm_cvtepi16_epi32(_mm_srli_si128(va, 8)),
+					     _mm_cvtepi16_epi32(_mm_srli_si128(vb, 8))), hk);
+	p0 = _mm_add_epi32(p0, _mm_add_epi32(half, _mm_and_si128(_mm_srl_epi32(p0, sh), one)));
+	p1 = _mm_add_epi32(p1, _mm_add_epi32(half, _mm_and_si128(_mm_srl_epi32(p1, sh), one)));
+	acc0 = _mm_add_epi32(acc0, _mm_sra_epi32(p0, sh));
+	acc1 = _mm_add_epi32(acc1, _mm_sra_epi32(p1, sh));
+      }
+      // Keep the low 16 bits of each sum: they are in range for the unsigned pack
+      _mm_storeu_si128((__m128i *)(y + e),
+		       _mm_packus_epi32(_mm_and_si128(acc0, low), _mm_and_si128(acc1, low)));
+    }
+    firSymEvenScalar(x + e, y + e, n - e, h, nSections, stride, shift);
+  }
+
+  __attribute__((target("avx2")))
+  inline void firSymEvenAvx2(const int16_t *x, int16_t *y, size_t n, const int32_t *h,
+			     unsigned nSections, unsigned stride, unsigned shift) {
+    const ptrdiff_t s = stride, last = s * (2 * nSections - 1);
+    const __m256i half = _mm256_set1_epi32((1 << (shift - 1)) - 1), one = _mm256_set1_epi32(1),
+      low = _mm256_set1_epi32(0xffff);
+    const __m128i sh = _mm_cvtsi32_si128((int)shift);
+    size_t e = 0;
+    for (; e + 16 <= n; e += 16) {
+      __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+      const int16_t *a = x + e, *b = x + e - last;
+      for (unsigned k = 0; k < nSections; k++, a -= s, b += s) {
+	__m256i
+	  hk = _mm256_set1_epi32(h[k]),
+	  p0 = _mm256_mullo_epi32(_mm256_add_epi32(
+	         _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)a)),
+		 _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)b))), hk),
+	  p1 = _mm256_mullo_epi32(_mm256_add_epi32(
+		 _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(a + 8))),
+		 _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(b + 8)))), hk);
+	p0 = _mm256_add_epi32(p0, _mm256_add_epi32(half, _mm256_and_si256(_mm256_srl_epi32(p0, sh), one)));
+	p1 = _mm256_add_epi32(p1, _mm256_add_epi32(half, _mm256_and_si256(_mm256_srl_epi32(p1, sh), one)));
+	acc0 = _mm256_add_epi32(acc0, _mm256_sra_epi32(p0, sh));
+	acc1 = _mm256_add_epi32(acc1, _mm256_sra_epi32(p1, sh));
+      }
+      // The pack interleaves 128 bit lanes, which the permute puts back in order
+      __m256i packed = _mm256_packus_epi32(_mm256_and_si256(acc0, low), _mm256_and_si256(acc1, low));
+      _mm256_storeu_si256((__m256i *)(y + e), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    firSymEvenSse41(x + e, y + e, n - e, h, nSections, stride, shift);
+  }
+#endif
+
+  inline void firSymEven(const int16_t *x, int16_t *y, size_t n, const int32_t *h,
+			 unsigned nSections, unsigned stride, unsigned shift,
+			 Level level = bestLevel()) {
+#ifdef DSP_SIMD_X86
+    if (level == AVX2)
+      return firSymEvenAvx2(x, y, n, h, nSections, stride, shift);
+    if (level == SSE41)
+      return firSymEvenSse41(x, y, n, h, nSections, stride, shift);
+#else
+    (void)level;
+#endif
+    firSymEvenScalar(x, y, n, h, nSections, stride, shift);
+  }
+
+  /*
+   * Streaming form of the symmetric FIR filter for real (stride 1) or interleaved I/Q
+   * (stride 2) data, which keeps the history between calls.  Outputs are delayed by
+   * "delay" samples, which lets the RCC workers reproduce the latency of the HDL
+   * workers.
+   */
+  class SymFir {
+    std::vector<int32_t> m_taps;
+    std::vector<int16_t> m_data; // history followed by the current input
+    unsigned m_stride, m_shift, m_history;
+    Level m_level;
+  public:
+    SymFir(unsigned nSections, unsigned stride, unsigned coeffWidth, unsigned delay)
+      : m_taps(nSections), m_data(stride * (delay + 2 * nSections - 1)), m_stride(stride),
+	m_shift(coeffWidth - 1), m_history(stride * (delay + 2 * nSections - 1)),
+	m_level(bestLevel()) {
+    }
+    void setTaps(const int16_t *taps) {
+      for (size_t k = 0; k < m_taps.size(); k++)
+	m_taps[k] = taps[k];
+    }
+    void reset() {
+      memset(&m_data[0], 0, m_history * sizeof(int16_t));
+    }
+    Level level() const { return m_level; }
+    // Filter n 16 bit values (samples or I/Q halves)
+    void filter(const int16_t *x, int16_t *y, size_t n) {
+      if (m_data.size() < m_history + n)
+	m_data.resize(m_history + n);
+      memcpy(&m_data[m_history], x, n * sizeof(int16_t));
+      firSymEven(&m_data[m_stride * (2 * m_taps.size() - 1)], y, n, &m_taps[0],
+		 (unsigned)m_taps.size(), m_stride, m_shift, m_level);
+      memmove(&m_data[0], &m_data[n], m_history * sizeof(int16_t));
+    }
+  };
+
+  /*
+   * Complex mixer: multiply n interleaved I/Q samples by a complex sinusoid whose
+   * phase, in units of 2^-32 cycles, starts at "phase" and advances by "inc" per
+   * sample.  The phase is left at the value for the next sample so that successive
+   * calls are continuous.  The sinusoid is generated by rotating a vector of
+   * consecutive phases, which is recomputed exactly every kMixerSync samples to keep
+   * rounding errors well below one output LSB.  Outputs are rounded and saturated.
+   */
+  const size_t kMixerSync = 1024;
+
+  inline int16_t saturate16(float f) {
+    long l = lrintf(f);
+    return (int16_t)(l > INT16_MAX ? INT16_MAX : l < INT16_MIN ? INT16_MIN : l);
+  }
+
+  // cos/sin pairs for "count" consecutive phases
+  inline void mixerPhases(float *cs, unsigned count, uint32_t phase, uint32_t inc) {
+    for (unsigned k = 0; k < count; k++, phase += inc) {
+      double a = 2 * M_PI * phase / 4294967296.;
+      cs[2*k] = (float)cos(a);
+      cs[2*k+1] = (float)sin(a);
+    }
+  }
+
+  inline void mixScalar(const int16_t *x, int16_t *y, size_t n, uint32_t &phase, uint32_t inc) {
+    while (n) {
+      size_t chunk = n < kMixerSync ? n : kMixerSync;
+      float r[2], step[2];
+      mixerPhases(r, 1, phase, inc);
+      mixerPhases(step, 1, inc, 0);
+      for (size_t i = 0; i < chunk; i++, x += 2, y += 2) {
+	float xi = x[0], xq = x[1];
+	y[0] = saturate16(xi * r[0] - xq * r[1]);
+	y[1] = saturate16(xi * r[1] + xq * r[0]);
+	float c = r[0] * step[0] - r[1] * step[1];
+	r[1] = r[0] * step[1] + r[1] * step[0];
+	r[0] = c;
+      }
+      phase += (uint32_t)chunk * inc;
+      n -= chunk;
+    }
+  }
+
+#ifdef DSP_SIMD_X86
+  // Complex multiply of interleaved (re, im) floats
+  __attribute__((target("sse4.1")))
+  inline __m128 cmulSse41(__m128 a, __m128 b) {
+    return _mm_addsub_ps(_mm_mul_ps(a, _mm_moveldup_ps(b)),
+			 _mm_mul_ps(_mm_shuffle_ps(a, a, 0xb1), _mm_movehdup_ps(b)));
+  }
+
+  __attribute__((target("sse4.1")))
+  inline void mixSse41(const int16_t *x, int16_t *y, size_t n, uint32_t &phase, uint32_t inc) {
+    while (n >= 4) {
+      size_t chunk = (n < kMixerSync ? n : kMixerSync) & ~(size_t)3;
+      float cs[8], st[2];
+      mixerPhases(cs, 4, phase, inc);
+      mixerPhases(st, 1, 4 * inc, 0);
+      __m128 r0 = _mm_loadu_ps(cs), r1 = _mm_loadu_ps(cs + 4),
+	step = _mm_setr_ps(st[0], st[1], st[0], st[1]);
+      for (size_t i = 0; i < chunk; i += 4, x += 8, y += 8) {
+	__m128i v = _mm_loadu_si128((const __m128i *)x);
+	__m128
+	  a0 = cmulSse41(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(v)), r0),
+	  a1 = cmulSse41(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(v, 8))), r1);
+	_mm_storeu_si128((__m128i *)y, _mm_packs_epi32(_mm_cvtps_epi32(a0), _mm_cvtps_epi32(a1)));
+	r0 = cmulSse41(r0, step);
+	r1 = cmulSse41(r1, step);
+      }
+      phase += (uint32_t)chunk * inc;
+      n -= chunk;
+    }
+    mixScalar(x, y, n, phase, inc);
+  }
+
+  __attribute__((target("avx2")))
+  inline __m256 cmulAvx2(__m256 a, __m256 b) {
+    return _mm256_addsub_ps(_mm256_mul_ps(a, _mm256_moveldup_ps(b)),
+			    _mm256_mul_ps(_mm256_permute_ps(a, 0xb1), _mm256_movehdup_ps(b)));
+  }
+
+  __attribute__((target("avx2")))
+  inline void mixAvx2(const int16_t *x, int16_t *y, size_t n, uint32_t &phase, uint32_t inc) {
+    while (n >= 8) {
+      size_t chunk = (n < kMixerSync ? n : kMixerSync) & ~(size_t)7;
+      float cs[16], st[2];
+      mixerPhases(cs, 8, phase, inc);
+      mixerPhases(st, 1, 8 * inc, 0);
+      __m256 r0 = _mm256_loadu_ps(cs), r1 = _mm256_loadu_ps(cs + 8),
+	step = _mm256_setr_ps(st[0], st[1], st[0], st[1], st[0], st[1], st[0], st[1]);
+      for (size_t i = 0; i < chunk; i += 8, x += 16, y += 16) {
+	__m256
+	  a0 = cmulAvx2(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)x))), r0),
+	  a1 = cmulAvx2(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(x + 8)))), r1);
+	__m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a0), _mm256_cvtps_epi32(a1));
+	_mm256_storeu_si256((__m256i *)y, _mm256_permute4x64_epi64(packed, 0xd8));
+	r0 = cmulAvx2(r0, step);
+	r1 = cmulAvx2(r1, step);
+      }
+      phase += (uint32_t)chunk * inc;
+      n -= chunk;
+    }
+    mixSse41(x, y, n, phase, inc);
+  }
+#endif
+
+  inline void mix(const int16_t *x, int16_t *y, size_t n, uint32_t &phase, uint32_t inc,
+		  Level level = bestLevel()) {
+#ifdef DSP_SIMD_X86
+    if (level == AVX2)
+      return mixAvx2(x, y, n, phase, inc);
+    if (level == SSE41)
+      return mixSse41(x, y, n, phase, inc);
+#else
+    (void)level;
+#endif
+    mixScalar(x, y, n, phase, inc);
+  }
+
+  /*
+   * DC offset cancellation of n interleaved I/Q samples, as in the
+   * dc_offset_cancellation HDL primitive:
+   *
+   *   a[n] = x[n] + ((tc * a[n-1]) >> 8),  y[n] = a[n] - a[n-1]
+   *
+   * with 16 bit wrapping arithmetic.  The recursion leaves no parallelism across
+   * samples, so the I and Q channels are interleaved for instruction level
+   * parallelism instead.  state holds a[n-1] for I and Q, which only advances when
+   * "update" is set, freezing the DC estimate otherwise.
+   */
+  inline void dcOffset(const int16_t *x, int16_t *y, size_t n, int8_t tc, bool update,
+		       int16_t state[2]) {
+    int16_t ai = state[0], aq = state[1];
+    for (size_t i = 0; i < n; i++, x += 2, y += 2) {
+      int16_t
+	ni = (int16_t)(x[0] + ((tc * ai) >> 8)),
+	nq = (int16_t)(x[1] + ((tc * aq) >> 8));
+      y[0] = (int16_t)(ni - ai);
+      y[1] = (int16_t)(nq - aq);
+      if (update)
+	ai = ni, aq = nq;
+    }
+    state[0] = ai;
+    state[1] = aq;
+  }
+
+  /*
+   * CIC decimator and interpolator for interleaved I/Q samples, with the register
+   * structure of the cic_dec_gen and cic_int_gen HDL primitives.  Every stage is a
+   * register that updates from the previous value of the stage before it, so all
+   * stages of a section update at once, and each I/Q pair of a stage is one two lane
+   * vector.  Accumulators wrap like ACC_WIDTH bit registers, and outputs are the
+   * DOUT_WIDTH most significant bits of the last stage.
+   */
+  typedef int64_t I64x2 __attribute__((vector_size(16)));
+
+  template <unsigned N, unsigned M>
+  struct Cic {
+    I64x2 integ[N], comb[N], delay[N][M]; // comb delay lines, newest first
+    unsigned phase;                      // position within each group of R samples
+    Cic() { reset(); }
+    void reset() {
+      memset(integ, 0, sizeof(integ));
+      memset(comb, 0, sizeof(comb));
+      memset(delay, 0, sizeof(delay));
+      phase = 0;
+    }
+    inline void integrate(I64x2 in) {
+      for (unsigned i = N - 1; i > 0; i--)
+	integ[i] += integ[i-1];
+      integ[0] += in;
+    }
+    inline void differentiate(I64x2 in) {
+      for (unsigned i = N - 1; i < N; i--) {
+	I64x2 prev = i ? comb[i-1] : in;
+	comb[i] = prev - delay[i][M-1];
+	for (unsigned j = M - 1; j > 0; j--)
+	  delay[i][j] = delay[i][j-1];
+	delay[i][0] = prev;
+      }
+    }
+    static inline I64x2 input(const int16_t *x, unsigned dinWidth) {
+      I64x2 v = { x[0], x[1] };
+      return (v << (64 - dinWidth)) >> (64 - dinWidth);
+    }
+    static inline void output(I64x2 v, int16_t *y, unsigned accWidth, unsigned doutWidth) {
+      v = (v << (64 - accWidth)) >> (64 - doutWidth);
+      y[0] = (int16_t)v[0];
+      y[1] = (int16_t)v[1];
+    }
+    // Consume up to nIn samples producing one output per R, stopping when maxOut
+    // outputs are produced.  Returns the number of inputs consumed.
+    size_t decimate(const int16_t *x, size_t nIn, int16_t *y, size_t maxOut, size_t &nOut,
+		    unsigned R, unsigned dinWidth, unsigned accWidth, unsigned doutWidth) {
+      size_t i = 0;
+      nOut = 0;
+      for (; i < nIn; i++, x += 2) {
+	if (phase == R - 1) {
+	  if (nOut == maxOut)
+	    break;
+	  // The comb section sees the last integrator before this sample is added
+	  I64x2 sample = integ[N-1];
+	  output(comb[N-1], y, accWidth, doutWidth);
+	  y += 2, nOut++;
+	  differentiate(sample);
+	  phase = 0;
+	} else
+	  phase++;
+	integrate(input(x, dinWidth));
+      }
+      return i;
+    }
+    // Produce up to maxOut outputs, R per input sample, from nIn inputs.  Returns the
+    // number of inputs completely consumed; a partially consumed input is resumed on
+    // the next call.
+    size_t interpolate(const int16_t *x, size_t nIn, int16_t *y, size_t maxOut, size_t &nOut,
+		       unsigned R, unsigned dinWidth, unsigned accWidth, unsigned doutWidth) {
+      size_t i = 0;
+      nOut = 0;
+      for (; i < nIn && nOut < maxOut; ) {
+	output(integ[N-1], y, accWidth, doutWidth);
+	y += 2, nOut++;
+	// The integrators see the last comb output before this sample is added
+	I64x2 held = comb[N-1];
+	if (phase == 0)
+	  differentiate(input(x, dinWidth));
+	integrate(held);
+	if (++phase == R) {
+	  phase = 0;
+	  i++, x += 2;
+	}
+      }
+      return i;
+    }
+  };
+}
+#endif
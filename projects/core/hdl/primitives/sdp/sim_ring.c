@@ -0,0 +1,139 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The simulator side of the shared memory rings used by the local simulation server
+ * when its "simTransport" is "shm".  These are byte-at-a-time accessors that the
+ * "ring" architecture of sdp_sim calls in place of reading and writing the fifos.
+ * They are plain C functions so they can be bound with GHDL's VHPIDIRECT
+ * (see sim_ring_pkg.vhd), or wrapped as VPI/DPI tasks for other simulators.
+ * This file is not part of the primitive library: it is compiled into the simulator
+ * executable, e.g. for GHDL:
+ *   ghdl -e -Wl,sim_ring.c -Wl,-I$OCPI_CDK_DIR/include/hdl ...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "HdlSimRing.h"
+
+static OcpiSimRings *rings;
+
+/* Map the rings named in the environment.  Return 0 on success, -1 on failure */
+int
+ocpi_sim_ring_open(void) {
+  const char *name = getenv(OCPI_SIM_RING_ENV);
+  int fd;
+  void *p;
+  if (rings)
+    return 0;
+  if (!name) {
+    fprintf(stderr, "sim_ring: no %s in the environment\n", OCPI_SIM_RING_ENV);
+    return -1;
+  }
+  if ((fd = open(name, O_RDWR)) < 0) {
+    perror("sim_ring: cannot open ring file");
+    return -1;
+  }
+  p = mmap(NULL, sizeof(OcpiSimRings), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    perror("sim_ring: cannot map ring file");
+    return -1;
+  }
+  if (__atomic_load_n(&((OcpiSimRings *)p)->magic, __ATOMIC_ACQUIRE) != OCPI_SIM_RING_MAGIC ||
+      ((OcpiSimRings *)p)->nRings != OCPI_SIM_RING_COUNT ||
+      ((OcpiSimRings *)p)->ringBytes != OCPI_SIM_RING_BYTES) {
+    fprintf(stderr, "sim_ring: ring file %s has the wrong format\n", name);
+    munmap(p, sizeof(OcpiSimRings));
+    return -1;
+  }
+  rings = (OcpiSimRings *)p;
+  return 0;
+}
+
+/* Return the next byte from a ring, or -1 if it is empty */
+int
+ocpi_sim_ring_getc(int ring) {
+  uint8_t c;
+  return rings && (unsigned)ring < OCPI_SIM_RING_COUNT &&
+    ocpiSimRingGet(&rings->rings[ring], &c, 1) ? c : -1;
+}
+
+/* Put a byte into a ring.  Return 1 if it was put, 0 if the ring is full */
+int
+ocpi_sim_ring_putc(int ring, int c) {
+  uint8_t b = (uint8_t)c;
+  return rings && (unsigned)ring < OCPI_SIM_RING_COUNT &&
+    ocpiSimRingPut(&rings->rings[ring], &b, 1) ? 1 : 0;
+}
+
+/*
+ * Wait for the server: spin briefly, then yield, checking now and then that the server
+ * is still there.  Return -1 when it is gone.
+ */
+static int
+server_wait(unsigned *n) {
+  if (++*n < 1000)
+    return 0;
+  sched_yield();
+  if (!(*n & 0xfff) && rings->serverPid > 0 && kill(rings->serverPid, 0) < 0 &&
+      errno == ESRCH) {
+    fprintf(stderr, "sim_ring: the simulation server (pid %d) is gone\n",
+	    (int)rings->serverPid);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Return the next byte from a ring, waiting for it as a read of the fifo would.
+ * Return -1 if the rings are not open or the server has gone away.
+ */
+int
+ocpi_sim_ring_read(int ring) {
+  unsigned n = 0;
+  int c;
+  if (!rings || (unsigned)ring >= OCPI_SIM_RING_COUNT)
+    return -1;
+  while ((c = ocpi_sim_ring_getc(ring)) < 0)
+    if (server_wait(&n))
+      return -1;
+  return c;
+}
+
+/*
+ * Put a byte into a ring, waiting for room as a write to the fifo would.
+ * Return 1 when it was put, 0 if the rings are not open or the server has gone away.
+ */
+int
+ocpi_sim_ring_write(int ring, int c) {
+  unsigned n = 0;
+  if (!rings || (unsigned)ring >= OCPI_SIM_RING_COUNT)
+    return 0;
+  while (!ocpi_sim_ring_putc(ring, c))
+    if (server_wait(&n))
+      return 0;
+  return 1;
+}
@@ -0,0 +1,74 @@
+-- This file is protected by Copyright. Please refer to the COPYRIGHT file
+-- distributed with this source distribution.
+--
+-- This file is part of OpenCPI <http://www.opencpi.org>
+--
+-- OpenCPI is free software: you can redistribute it and/or modify it under the
+-- terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+-- A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+-- details.
+--
+-- You should have received a copy of the GNU Lesser General Public License
+-- along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+-- Bindings for GHDL (VHPIDIRECT) to the shared memory rings in sim_ring.c,
+-- used by the "ring" architecture of sdp_sim instead of the request/response/control/ack
+-- fifos.  The ring numbers match OcpiSimRingIndex in HdlSimRing.h.
+-- This package is only for simulators that support VHPIDIRECT, so it is not in the
+-- SourceFiles of this library: GHDL builds compile it, and sdp_sim_ring.vhd, into this
+-- library and link sim_ring.c into the executable.
+
+package sim_ring_pkg is
+  constant ring_request_c  : integer := 0; -- from the server: SDP requests and responses
+  constant ring_response_c : integer := 1; -- to the server: SDP responses and requests
+  constant ring_control_c  : integer := 2; -- from the server: spin and DCP credits etc.
+  constant ring_ack_c      : integer := 3; -- to the server: spin credit acks
+  -- Returns 0 on success
+  impure function ring_open return integer;
+  attribute foreign of ring_open : function is "VHPIDIRECT ocpi_sim_ring_open";
+  -- Returns the next byte, or -1 when the ring is empty
+  impure function ring_getc(ring : integer) return integer;
+  attribute foreign of ring_getc : function is "VHPIDIRECT ocpi_sim_ring_getc";
+  -- Returns 1 if the byte was put, 0 when the ring is full
+  impure function ring_putc(ring : integer; c : integer) return integer;
+  attribute foreign of ring_putc : function is "VHPIDIRECT ocpi_sim_ring_putc";
+  -- Waits for the next byte as a fifo read would.  Returns -1 if the server is gone.
+  impure function ring_read(ring : integer) return integer;
+  attribute foreign of ring_read : function is "VHPIDIRECT ocpi_sim_ring_read";
+  -- Waits for room for the byte as a fifo write would.  Returns 0 if the server is gone.
+  impure function ring_write(ring : integer; c : integer) return integer;
+  attribute foreign of ring_write : function is "VHPIDIRECT ocpi_sim_ring_write";
+end package sim_ring_pkg;
+
+package body sim_ring_pkg is
+  impure function ring_open return integer is
+  begin
+    assert false report "VHPIDIRECT ocpi_sim_ring_open" severity failure;
+    return -1;
+  end ring_open;
+  impure function ring_getc(ring : integer) return integer is
+  begin
+    assert false report "VHPIDIRECT ocpi_sim_ring_getc" severity failure;
+    return -1;
+  end ring_getc;
+  impure function ring_putc(ring : integer; c : integer) return integer is
+  begin
+    assert false report "VHPIDIRECT ocpi_sim_ring_putc" severity failure;
+    return 0;
+  end ring_putc;
+  impure function ring_read(ring : integer) return integer is
+  begin
+    assert false report "VHPIDIRECT ocpi_sim_ring_read" severity failure;
+    return -1;
+  end ring_read;
+  impure function ring_write(ring : integer; c : integer) return integer is
+  begin
+    assert false report "VHPIDIRECT ocpi_sim_ring_write" severity failure;
+    return 0;
+  end ring_write;
+end package body sim_ring_pkg;
@@ -108,6 +108,14 @@ namespace OCPI {
       OCPI::Container::Launcher::Members m_launchMembers;
       OCPI::Container::Launcher::Connections m_launchConnections;
       Booking *m_bookings;
+      // Artifacts loaded in the background, in parallel, from planning until launch
+      struct Prefetch {
+	OCPI::Container::Container *m_container;
+	OCPI::Library::Artifact *m_artifact;
+	void *m_handle;
+      };
+      std::vector<Prefetch> m_prefetches;
+      OCPI::OS::ThreadManager *m_prefetchThread;
       // This class represents a mapping from an externally visible property of the assembly
       // to an individual property of an instance. It must be at this layer
       // (not util::assembly or library::assembly) because it potentially depends on the 
@@ -117,6 +125,7 @@ namespace OCPI {
 	unsigned m_instance;    // ordinal of instance in assembly
 	unsigned m_property;    // ordinal of property in implememtation of instance
 	const char *m_dumpFile; // pointer to dump file if one was specified
+	bool m_isCounter;       // m_property is the ordinal of a built-in worker counter
       } *m_properties;
       // This is a queue entry for a delayed property value setting
       struct DelayedPropertyValue {
@@ -126,6 +135,7 @@ namespace OCPI {
       };
       typedef std::map<OCPI::Util::Assembly::Delay, DelayedPropertyValue> DelayedPropertyValues;
       DelayedPropertyValues    m_delayedPropertyValues;
+      DelayedPropertyValues    m_setDelayedPropertyValues; // already set, kept for reset
       size_t m_nProperties;
       CMap m_curMap;              // A temporary indicating possible containers for a candidate
       unsigned m_curContainers;   // A temporary that counts containers for a candidate
@@ -168,7 +178,10 @@ namespace OCPI {
       bool m_verbose;
       bool m_dump;
       std::string m_dumpFile;
+      std::string m_snapshotFile; // binary snapshot of property values written at finish
+      std::string m_restoreFile;  // binary snapshot of property values applied at initialize
       bool m_dumpPlatforms;
+      bool m_counters;            // expose built-in worker counters as properties
       Application &m_apiApplication;
 
       void clear();
@@ -184,6 +197,11 @@ namespace OCPI {
       void finalizeLaunchPort(OCPI::Container::Launcher::Port &p);
       void finalizeLaunchConnections();
       void finalizeLaunchMembers();
+      static void exchangeLauncher(void *arg, size_t chunk, size_t, size_t);
+      void startPrefetch();
+      void finishPrefetch();
+      static void prefetchThread(void *arg);
+      static void prefetchArtifact(void *arg, size_t chunk, size_t, size_t);
       void checkPropertyValue(unsigned nInstance, const OCPI::Util::Worker &w,
 			      const OCPI::Util::Assembly::Property &aProp, unsigned *&pn,
 			      OU::Value *&pv);
@@ -232,6 +250,7 @@ namespace OCPI {
       void setDelayedProperties();
       bool wait(OCPI::OS::Timer *);
       void finish();
+      void reset();
       ExternalPort &getPort(const char *, const OCPI::API::PValue *);
       ExternalPort &getPort(unsigned index, std::string &name );
       size_t getPortCount();
@@ -245,6 +264,8 @@ namespace OCPI {
       void setProperty(const char* worker_name, const char* prop_name, const char *value);
       void dumpDeployment(const char *appFile, const std::string &file);
       void dumpProperties(bool printParameters, bool printCached, const char *context) const;
+      void saveSnapshot(const char *file) const;
+      void restoreSnapshot(const char *file);
       void genScaPrf(const char *outDir) const;
       void genScaScd(const char *outDir) const;
       void genScaSpd(const char *outDir, const char *pkg) const;
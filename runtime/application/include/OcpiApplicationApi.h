@@ -64,6 +64,11 @@ namespace OCPI {
       void finish();
       // Suspension, that can be resumed with "start".
       void stop();
+      // Return to the state after "initialize", ready to "start" again, keeping all
+      // workers, connections and buffers: workers are reinitialized, initial property
+      // values are set again, and any unconsumed input is discarded.  Workers must set up
+      // their own state in their initialize method, not only when they are constructed.
+      void reset();
       const std::string &name() const;
       ExternalPort &getPort(const char *, const OCPI::API::PValue *params = NULL);
 #if 0
@@ -83,6 +88,10 @@ namespace OCPI {
       void dumpDeployment(const char *appFile, const std::string &file);
       void dumpProperties(bool printParameters = true, bool printCached = true,
 			  const char *context = NULL) const;
+      // Save all readable property values to a binary snapshot file, or restore the
+      // writable ones from one.  See the "ocpisnapshot" utility to view them as text.
+      void saveSnapshot(const char *file) const;
+      void restoreSnapshot(const char *file);
       // setter template without implementation.  we only implement the ones for our types
       template <typename T> void
       setPropertyValue(const char *w, const char *p, const T value,
@@ -20,6 +20,7 @@
 
 #include <unistd.h>
 #include <climits>
+#include <algorithm>
 #include "OcpiOsFileSystem.h"
 #include "OcpiContainerApi.h"
 #include "OcpiOsMisc.h"
@@ -27,6 +28,8 @@
 #include "OcpiPValue.h"
 #include "OcpiTimeEmit.h"
 #include "OcpiUtilMisc.h"
+#include "OcpiUtilThreadPool.h"
+#include "OcpiUtilPropertySnapshot.h"
 #include "ContainerLauncher.h"
 #include "OcpiApplication.h"
 
@@ -135,6 +138,7 @@ namespace OCPI {
       clear();
     }
     void ApplicationI::clear() {
+      finishPrefetch();
       m_assembly--;
       ezxml_free(m_deployXml);
       ezxml_free(m_appXml);
@@ -488,8 +492,12 @@ namespace OCPI {
       // For all instances in the assembly, create the app-level property array
       m_nProperties = m_assembly.m_mappedProperties.size();
       i = m_instances;
-      for (unsigned n = 0; n < m_nInstances; n++, i++)
-        m_nProperties += i->m_bestDeployment.m_impls[0]->m_metadataImpl.nProperties();
+      for (unsigned n = 0; n < m_nInstances; n++, i++) {
+        const OU::Worker &impl = i->m_bestDeployment.m_impls[0]->m_metadataImpl;
+        m_nProperties += impl.nProperties();
+        if (m_counters)
+          m_nProperties += OC::Worker::nCounters(impl);
+      }
       // Over allocate: mapped ones plus all the instances' ones
       Property *p = m_properties = new Property[m_nProperties];
       OU::Assembly::MappedProperty *mp = &m_assembly.m_mappedProperties[0];
@@ -500,6 +508,7 @@ namespace OCPI {
         p->m_name = mp->m_name;
         p->m_instance = mp->m_instance;
         p->m_dumpFile = NULL;
+        p->m_isCounter = false;
         ocpiDebug("Instance %s (%u) property %s (%u) named %s in assembly",
                   m_assembly.instance(p->m_instance).name().c_str(), p->m_instance,
                   mp->m_instPropName.c_str(), p->m_property, p->m_name.c_str());
@@ -512,6 +521,7 @@ namespace OCPI {
           p->m_name = m_assembly.instance(n).name() + "." + meta->m_name;
           p->m_instance = n;
           p->m_property = nn;
+          p->m_isCounter = false;
           ocpiDebug("Instance %s (%u) property %s (%u) named %s",
                     m_assembly.instance(n).name().c_str(), n,
                     meta->m_name.c_str(), nn, p->m_name.c_str());
@@ -527,6 +537,20 @@ namespace OCPI {
             }
         }
       }
+      // The built-in counters follow all the instances' own properties
+      i = m_instances;
+      for (unsigned n = 0; m_counters && n < m_nInstances; n++, i++) {
+        const OU::Worker &impl = i->m_bestDeployment.m_impls[0]->m_metadataImpl;
+        for (unsigned nn = 0; nn < OC::Worker::nCounters(impl); nn++, p++) {
+          std::string counter;
+          OC::Worker::counterName(impl, nn, counter);
+          p->m_name = m_assembly.instance(n).name() + "." + counter;
+          p->m_instance = n;
+          p->m_property = nn;
+          p->m_dumpFile = NULL;
+          p->m_isCounter = true;
+        }
+      }
     }
 
     void ApplicationI::
@@ -902,6 +926,7 @@ namespace OCPI {
         // We must initialize everything before anything that might cause an exception
         m_instances = NULL;
         m_bookings = NULL;
+        m_prefetchThread = NULL;
         m_properties = NULL;
         m_nProperties = 0;
         m_curMap = 0;
@@ -923,14 +948,20 @@ namespace OCPI {
         m_verbose = false;
         m_dump = false;
         m_dumpPlatforms = false;
+        m_counters = false;
         OU::findBool(params, "verbose", m_verbose);
         OU::findBool(params, "dump", m_dump);
         const char *dumpFile;
         if (OU::findString(params, "dumpFile", dumpFile))
           m_dumpFile = dumpFile;
+        if (OU::findString(params, "snapshotFile", dumpFile))
+          m_snapshotFile = dumpFile;
+        if (OU::findString(params, "restoreFile", dumpFile))
+          m_restoreFile = dumpFile;
         OU::findBool(params, "dumpPlatforms", m_dumpPlatforms);
         OU::findBool(params, "hex", m_hex);
         OU::findBool(params, "uncached", m_uncached);
+        OU::findBool(params, "counters", m_counters);
         // Initializations for externals may add instances to the assembly
         initExternals(params);
         // Now that we have added any extra instances for external connections, do
@@ -958,7 +989,10 @@ namespace OCPI {
         if ((err = finalizePortParam(params, "bufferCount")) ||
             (err = finalizePortParam(params, "bufferSize")) ||
             (err = finalizePortParam(params, "transport")) ||
-            (err = finalizePortParam(params, "transferRole")))
+            (err = finalizePortParam(params, "transferRole")) ||
+            (err = finalizePortParam(params, "hugePages")) ||
+            (err = finalizePortParam(params, "numaNode")) ||
+            (err = finalizePortParam(params, "aggregate")))
           throw OU::Error("Port parameter error: %s", err);
         initLaunchConnections();
         finalizeProperties(params);
@@ -1016,12 +1050,73 @@ namespace OCPI {
               }
             }
         }
+        startPrefetch();
       } catch (...) {
         clear();
         throw;
       }
     }
 
+    // Start loading, in the background, the artifacts that the deployment has chosen for
+    // local containers, so that the loading overlaps with whatever happens before launch
+    // and artifacts are loaded in parallel with each other rather than one at a time when
+    // workers are created.
+    void ApplicationI::
+    startPrefetch() {
+      OC::Launcher &local = OC::LocalLauncher::getSingleton();
+      std::set<std::pair<OC::Container *, OL::Artifact *> > seen;
+      Instance *i = m_instances;
+      for (unsigned n = 0; n < m_nInstances; n++, i++)
+        for (unsigned m = 0; m < i->m_bestDeployment.m_scale; m++) {
+          OC::Container &c =
+            OC::Container::nthContainer(m_usedContainers[i->m_usedContainers[m]]);
+          OL::Artifact &a = i->m_bestDeployment.m_impls[m]->m_artifact;
+          if (&c.launcher() == &local && seen.insert(std::make_pair(&c, &a)).second) {
+            Prefetch p = { &c, &a, NULL };
+            m_prefetches.push_back(p);
+          }
+        }
+      if (m_prefetches.size() > 1) {
+        ocpiInfo("Prefetching %zu artifacts", m_prefetches.size());
+        m_prefetchThread = new OCPI::OS::ThreadManager(prefetchThread, this);
+      } else
+        m_prefetches.clear(); // nothing to overlap with
+    }
+
+    void ApplicationI::
+    prefetchArtifact(void *arg, size_t chunk, size_t, size_t) {
+      Prefetch &p = (*(std::vector<Prefetch> *)arg)[chunk];
+      p.m_handle = p.m_container->prefetchArtifact(*p.m_artifact);
+    }
+
+    void ApplicationI::
+    prefetchThread(void *arg) {
+      std::vector<Prefetch> &prefetches = ((ApplicationI *)arg)->m_prefetches;
+      try {
+        // Loading is mostly I/O and relocation, so more threads than this do not help
+        OU::ThreadPool pool((unsigned)std::min(prefetches.size(), (size_t)8) - 1, false);
+        pool.run(prefetches.size(), 1, prefetchArtifact, &prefetches);
+      } catch (std::string &e) {
+        // Errors will be reported when the artifacts are actually loaded
+        ocpiInfo("Artifact prefetching failed: %s", e.c_str());
+      }
+    }
+
+    // Wait for prefetching to finish and drop our references to the artifacts, which are
+    // held by the containers by now, if they were used.
+    void ApplicationI::
+    finishPrefetch() {
+      if (m_prefetchThread) {
+        m_prefetchThread->join();
+        delete m_prefetchThread;
+        m_prefetchThread = NULL;
+      }
+      for (unsigned n = 0; n < m_prefetches.size(); n++)
+        if (m_prefetches[n].m_handle)
+          m_prefetches[n].m_container->releasePrefetch(m_prefetches[n].m_handle);
+      m_prefetches.clear();
+    }
+
     void ApplicationI::
     setLaunchPort(OC::Launcher::Port &p, const OU::Port *mp, const OU::PValue *connParams,
                   const std::string &a_name, const OU::PValue *portParams,
@@ -1345,13 +1440,36 @@ namespace OCPI {
       for (LaunchersIter li = launchers.begin(); li != launchers.end(); li++)
         if (*li != &local)
           (*li)->launch(m_launchMembers, m_launchConnections);
+      // When more than one launcher is waiting on a server, their round trips (and any
+      // artifact downloads) are overlapped, so startup takes the longest rather than the sum.
+      std::vector<OC::Launcher *> exchanging;
+      OU::ThreadPool *pool = NULL;
       bool more;
-      do {
-        more = false;
-        for (LaunchersIter li = launchers.begin(); li != launchers.end(); li++)
-          if ((*li)->work(m_launchMembers, m_launchConnections))
-            more = true;
-      } while (more);
+      try {
+        do {
+          more = false;
+          exchanging.clear();
+          for (LaunchersIter li = launchers.begin(); li != launchers.end(); li++)
+            if ((*li)->exchanges())
+              exchanging.push_back(*li);
+          if (exchanging.size() > 1) {
+            if (!pool)
+              pool = new OU::ThreadPool((unsigned)launchers.size() - 1, false);
+            pool->run(exchanging.size(), 1, exchangeLauncher, &exchanging);
+          }
+          for (LaunchersIter li = launchers.begin(); li != launchers.end(); li++)
+            if ((*li)->work(m_launchMembers, m_launchConnections))
+              more = true;
+        } while (more);
+      } catch (std::string &e) {
+        delete pool;
+        throw OU::Error("%s", e.c_str());
+      } catch (...) {
+        delete pool;
+        throw;
+      }
+      delete pool;
+      finishPrefetch();
       if (m_assembly.m_doneInstance != -1)
         m_doneInstance = &m_instances[m_assembly.m_doneInstance];
       //      m_launchMembers[m_instances[m_assembly.m_doneInstance].m_firstMember].m_worker;
@@ -1368,6 +1486,78 @@ namespace OCPI {
         fprintf(stderr,
                 "Application established: containers, workers, connections all created\n"
                 "Communication with the application established\n");
+      if (m_restoreFile.size())
+        restoreSnapshot(m_restoreFile.c_str());
+    }
+    // Save the values of all readable, non-parameter properties, as raw images.
+    // Properties mapped to application-level names are aliases of instance properties
+    // and are skipped so each value is saved (and restored) once, by its qualified name.
+    void ApplicationI::
+    saveSnapshot(const char *file) const {
+      OU::PropertySnapshot snap;
+      size_t nMapped = m_assembly.m_mappedProperties.size();
+      Property *p = m_properties + nMapped;
+      for (size_t n = nMapped; n < m_nProperties; n++, p++) {
+        if (p->m_isCounter)
+          continue;
+        OC::Worker &w = *m_launchMembers[m_instances[p->m_instance].m_firstMember].m_worker;
+        const OU::Property &prop = w.property(p->m_property);
+        if (prop.m_isParameter || prop.m_baseType == OA::OCPI_Type || !w.hasPropertyValue(prop))
+          continue;
+        w.getPropertyImage(prop, snap.add(p->m_name.c_str(), prop).m_image, m_uncached);
+      }
+      const char *err;
+      if ((err = snap.save(file)))
+        throw OU::Error("Error saving property snapshot: %s", err);
+      ocpiInfo("Saved %zu property values to snapshot file \"%s\"", snap.entries().size(),
+               file);
+    }
+    // Restore the values of writable properties from a snapshot.  Entries for properties
+    // that are not in this application or not writable are skipped, but a type mismatch is
+    // an error since the image would be misinterpreted.
+    void ApplicationI::
+    restoreSnapshot(const char *file) {
+      OU::PropertySnapshot snap;
+      const char *err;
+      if ((err = snap.load(file)))
+        throw OU::Error("Error loading property snapshot: %s", err);
+      // Index the qualified instance property names by ordinal, skipping mapped aliases
+      typedef std::map<const char *, size_t, OU::ConstCharCaseComp> Index;
+      Index index;
+      for (size_t n = m_assembly.m_mappedProperties.size(); n < m_nProperties; n++)
+        if (!m_properties[n].m_isCounter)
+          index[m_properties[n].m_name.c_str()] = n;
+      unsigned nRestored = 0;
+      std::string type;
+      for (OU::PropertySnapshot::Entries::const_iterator it = snap.entries().begin();
+           it != snap.entries().end(); ++it) {
+        Index::const_iterator ii = index.find(it->m_name.c_str());
+        if (ii == index.end()) {
+          ocpiInfo("Snapshot property \"%s\" is not in the application: skipped",
+                   it->m_name.c_str());
+          continue;
+        }
+        Property *p = &m_properties[ii->second];
+        OC::Worker &w = *m_launchMembers[m_instances[p->m_instance].m_firstMember].m_worker;
+        const OU::Property &prop = w.property(p->m_property);
+        if (prop.m_isParameter || !w.canSetProperty(prop)) {
+          ocpiDebug("Snapshot property \"%s\" is not writable: skipped", it->m_name.c_str());
+          continue;
+        }
+        OU::PropertySnapshot::typeDescriptor(prop, type);
+        if (type != it->m_type)
+          throw OU::Error("Snapshot property \"%s\" has a different type than in the application",
+                          it->m_name.c_str());
+        w.setPropertyImage(prop, (const uint8_t *)it->m_image.data(), it->m_image.size());
+        nRestored++;
+      }
+      ocpiInfo("Restored %u of %zu property values from snapshot file \"%s\"", nRestored,
+               snap.entries().size(), file);
+    }
+    // ThreadPool function to run the exchange phase of one launcher
+    void ApplicationI::
+    exchangeLauncher(void *arg, size_t chunk, size_t, size_t) {
+      (*(std::vector<OC::Launcher *> *)arg)[chunk]->exchange();
     }
     void ApplicationI::
     dumpProperties(bool printParameters, bool printCached, const char *context) const
@@ -1449,6 +1639,8 @@ namespace OCPI {
           m_launchMembers[m_instances[it->second.m_instance].m_firstMember].m_worker->
             setPropertyValue(*it->second.m_property, it->second.m_value);
         }
+        // Keep them to be set again after a reset
+        m_setDelayedPropertyValues.swap(m_delayedPropertyValues);
         m_delayedPropertyValues.clear();
       }
     }
@@ -1518,6 +1710,42 @@ namespace OCPI {
         if ((err = OU::string2File(dump, m_dumpFile)))
           throw OU::Error("error when dumping properties to a file: %s", err);
       }
+      if (m_snapshotFile.size())
+        saveSnapshot(m_snapshotFile.c_str());
+    }
+
+    // Prepare to run again without relaunching: stop everything, reinitialize all workers
+    // (slaves first, as they were created) with their initial property values, and discard
+    // unconsumed input and unsent aggregated output at external ports.  Containers,
+    // connections and buffers are kept.
+    void ApplicationI::reset() {
+      if (!m_launched)
+        throw OU::Error("OA::Application::reset() called before/without calling initialize().");
+      OS::Time startTime = OS::Time::now();
+      stop();
+      for (unsigned slaves = 2; slaves--; ) {
+        OC::Launcher::Member *m = &m_launchMembers[0];
+        for (unsigned n = 0; n < m_launchMembers.size(); n++, m++)
+          if (m->m_hasMaster == (slaves != 0)) {
+            ocpiInfo("Reinitializing worker: %s", m->m_worker->name().c_str());
+            m->m_worker->reinitialize();
+            OC::LocalLauncher::setInitialProperties(*m);
+          }
+      }
+      for (ExternalsIter ei = m_externals.begin(); ei != m_externals.end(); ++ei)
+        if (ei->second.m_external) {
+          ei->second.m_external->discardInput();
+          ei->second.m_external->discardOutput();
+        }
+      if (m_setDelayedPropertyValues.size())
+        m_delayedPropertyValues.swap(m_setDelayedPropertyValues);
+      if (m_restoreFile.size())
+        restoreSnapshot(m_restoreFile.c_str());
+      if (m_verbose) {
+        OS::Time elapsed = OS::Time::now() - startTime;
+        fprintf(stderr, "Application reset in %.3f ms, ready to start again\n",
+                elapsed.seconds() * 1e3 + elapsed.nanoseconds() / 1e6);
+      }
     }
 
     // Get an external port to use corresponding to an external port defined in the assembly.
@@ -1625,6 +1853,8 @@ namespace OCPI {
         return NULL;
       Property &p = m_properties[ordinal];
       a_name = p.m_name;
+      if (p.m_isCounter)
+        return NULL;
       return
         &m_launchMembers[m_instances[p.m_instance].m_firstMember].
         m_worker->property(p.m_property);
@@ -1639,11 +1869,16 @@ namespace OCPI {
       OC::Worker &w = *m_launchMembers[m_instances[p.m_instance].m_firstMember].m_worker;
       bool unreadable;
       std::string dummy;
-      w.getProperty(p.m_property, dummy, value, &unreadable, hex, cachedp, uncached);
+      if (p.m_isCounter) {
+        w.getCounter(p.m_property, dummy, value, &unreadable);
+        if (cachedp)
+          *cachedp = false;
+      } else
+        w.getProperty(p.m_property, dummy, value, &unreadable, hex, cachedp, uncached);
       if (unreadable)
         value = "<unreadable>";
       if (parp)
-        *parp = w.property(p.m_property).m_isParameter;
+        *parp = !p.m_isCounter && w.property(p.m_property).m_isParameter;
       return true;
     }
 
@@ -1672,13 +1907,18 @@ namespace OCPI {
                 bool hex) {
       Property &p = findProperty(worker_inst_name, prop_name);
       std::string dummy;
-      m_launchMembers[m_instances[p.m_instance].m_firstMember].m_worker->
-        getProperty(p.m_property, dummy, value, NULL, hex);
+      OC::Worker &w = *m_launchMembers[m_instances[p.m_instance].m_firstMember].m_worker;
+      if (p.m_isCounter)
+        w.getCounter(p.m_property, dummy, value);
+      else
+        w.getProperty(p.m_property, dummy, value, NULL, hex);
     }
 
     void ApplicationI::
     setProperty(const char * worker_inst_name, const char * prop_name, const char *value) {
       Property &p = findProperty(worker_inst_name, prop_name);
+      if (p.m_isCounter)
+        throw OU::Error("Application property \"%s\" is a read-only counter", p.m_name.c_str());
       m_launchMembers[m_instances[p.m_instance].m_firstMember].m_worker->
         setProperty(p.m_property, value);
     }
@@ -1791,6 +2031,9 @@ namespace OCPI {
     void Application::
     stop() { m_application.stop(); }
 
+    void Application::
+    reset() { m_application.reset(); }
+
     void Application::
     setDelayedProperties() {
       m_application.setDelayedProperties();
@@ -1902,6 +2145,16 @@ namespace OCPI {
     dumpProperties(bool printParameters, bool printCached, const char *context) const {
       return m_application.dumpProperties(printParameters, printCached, context);
     }
+
+    void Application::
+    saveSnapshot(const char *file) const {
+      m_application.saveSnapshot(file);
+    }
+
+    void Application::
+    restoreSnapshot(const char *file) {
+      m_application.restoreSnapshot(file);
+    }
     // Type-specific scalar property value setters.
     #define OCPI_DATA_TYPE(sca,corba,letter,bits,run,pretty,store)         \
     template <> void Application::                                         \
@@ -89,6 +89,13 @@
                                         "set buffercount at a port") \
   CMD_OPTION_S(buffer_size, Z, String,0, "<instance-name>=<port-name>=<buffersize>\n" \
                                          "set buffer size at a port") \
+  CMD_OPTION_S(huge_pages,,String,0, "<instance-name>=<port-name>=<bool>\n" \
+                                     "use huge pages for buffers at a port") \
+  CMD_OPTION_S(numa_node,,String,0, "<instance-name>=<port-name>=<node>\n" \
+                                    "place buffers at a port on a NUMA node") \
+  CMD_OPTION_S(aggregate,,String,0, "<instance-name>=<port-name>=<microseconds>\n" \
+                                    "pack small messages from an output port into shared\n" \
+                                    "buffers, each sent after at most this delay") \
   CMD_OPTION_S(target,   r, String, 0, "a target when printing artifacts/specs in path") \
   CMD_OPTION(list_artifacts,, Bool, 0, "print artifacts in path, for specified targets") \
   CMD_OPTION(list_specs,,     Bool, 0, "print specs in path, for specified targets") \
@@ -106,10 +113,18 @@
   CMD_OPTION(specs,      G, String, 0, "deprecated: comma-separated targets for specs") \
   CMD_OPTION(only_platforms,, Bool, 0, "modifies the list command to show only platforms")\
   CMD_OPTION(dump_file,   , String, 0, "dump properties in raw parsable format to this file") \
+  CMD_OPTION(snapshot_file,, String, 0, "save property values in a binary snapshot file at the end") \
+  CMD_OPTION(restore_file,, String, 0, "restore writable property values from a binary snapshot\n" \
+	                               "file before starting") \
+  CMD_OPTION(runs,        , ULong,  0, "<count>\n" \
+	                               "run the application this many times, resetting it\n" \
+	                               "between runs rather than relaunching it") \
   CMD_OPTION(component,   , Bool,   0, "first non-option argument is a component name,\n" \
 	                               "not an application XML file") \
   CMD_OPTION(seconds,     , Long,   0, "<seconds> -- legacy, use \"duration\" now\n") \
   CMD_OPTION(version,     , Bool,   0, "print the OpenCPI release version") \
+  CMD_OPTION(counters,    , Bool,   0, "include built-in worker and port performance counters\n" \
+	                               "as read-only properties when dumping properties") \
   /**/
 
 //  CMD_OPTION_S(simulator, H,String, 0, "Create a container with this HDL simulator")
@@ -299,8 +314,14 @@ static int mymain(const char **ap) {
     params.addBool("dump", true);
   if (options.dump_file())
     params.addString("dumpFile", options.dump_file());
+  if (options.snapshot_file())
+    params.addString("snapshotFile", options.snapshot_file());
+  if (options.restore_file())
+    params.addString("restoreFile", options.restore_file());
   if (options.dump_platforms())
     params.addBool("dumpPlatforms", true);
+  if (options.counters())
+    params.addBool("counters", true);
   if (options.sim_dir())
     params.addString("simDir", options.sim_dir());
   if (options.sim_ticks())
@@ -319,6 +340,9 @@ static int mymain(const char **ap) {
   addParams("transferRole", options.transfer_role(n), params);
   addParams("bufferCount", options.buffer_count(n), params);
   addParams("bufferSize", options.buffer_size(n), params);
+  addParams("hugePages", options.huge_pages(n), params);
+  addParams("numaNode", options.numa_node(n), params);
+  addParams("aggregate", options.aggregate(n), params);
   addParams("scale", options.scale(n), params);
   addParams("server", options.server(n), params);
   if (options.deployment())
@@ -348,18 +372,24 @@ static int mymain(const char **ap) {
       }
       if (!options.no_execute()) {
 	app.initialize();
-	app.start();
-
 	unsigned timeout =
 	  options.timeout() ? options.timeout() :
 	  options.duration() < 0 ? -options.duration() : // legacy negative
 	  options.duration() ? options.duration() :
 	  options.seconds() < 0 ? -options.seconds() :
 	  options.seconds();
-	app.wait(timeout * 1000000, options.timeout() != 0);
-	app.stop(); // make sure all workers are stopped after time duration or done
-	// In case application specifically defines things to do that aren't in the destructor
-	app.finish();
+	for (unsigned run = 0; run < (options.runs() ? options.runs() : 1); run++) {
+	  if (run) {
+	    if (options.verbose())
+	      fprintf(stderr, "Resetting application for run %u\n", run + 1);
+	    app.reset(); // reuse the workers, connections and buffers from the first run
+	  }
+	  app.start();
+	  app.wait(timeout * 1000000, options.timeout() != 0);
+	  app.stop(); // make sure all workers are stopped after time duration or done
+	  // In case application specifically defines things to do that aren't in the destructor
+	  app.finish();
+	}
       }
   } catch (...) {
     ezxml_free(xml);
@@ -42,6 +42,8 @@
 #include "OcpiContainerApi.h"
 
 #include "OcpiOsThreadManager.h"
+#include "OcpiOsTimer.h"
+#include "OcpiUtilMisc.h"
 #include "OcpiUtilSelfMutex.h"
 #include "OcpiTransport.h"
 #include "OcpiLibraryManager.h"
@@ -54,6 +56,23 @@ namespace OCPI {
     class Artifact;
     class Launcher;
 
+    // How a container's dispatch thread waits when dispatching finds nothing to do.
+    // It dispatches again at once for the spin period after work was last found, then
+    // yields the processor for the yield period, then blocks for up to the block period
+    // between dispatches.  With no block period it keeps yielding, which is the default.
+    struct WaitPolicy {
+      uint32_t m_spinUsecs, m_yieldUsecs, m_blockUsecs;
+    };
+    // Time spent waiting in each phase, written only by the dispatching thread
+    struct WaitCounters {
+      uint8_t  m_pad0[OCPI_CACHE_LINE_SIZE];
+      uint64_t m_spinTime,  // in OS::Time units
+	       m_yieldTime,
+	       m_blockTime,
+	       m_blocks;    // number of blocking waits
+      uint8_t  m_pad1[OCPI_CACHE_LINE_SIZE - 4 * sizeof(uint64_t)];
+    };
+
     // Container base class.
     class Container
       : public OCPI::API::Container,
@@ -79,6 +98,15 @@ namespace OCPI {
       bool m_enabled;
       bool m_ownThread;
       bool m_verbose;
+      bool m_hugePages;  // default for buffer memory of this container's ports
+      int m_numaNode;    // NUMA node of our thread and our ports' buffers, -1 if none
+      WaitPolicy m_wait;
+      // How long after becoming idle spinning and then yielding end, from m_wait
+      OCPI::OS::Time m_spinEnd, m_yieldEnd;
+      WaitCounters m_waitCounters;
+      enum WaitPhase { NotWaiting, Spinning, Yielding, Blocking } m_waitPhase;
+      OCPI::OS::Time m_idleStart; // when dispatching last found nothing to do, 0 if busy
+      OCPI::OS::Time m_waitStart; // when the current wait phase was entered
       OCPI::OS::ThreadManager *m_thread;
       // This is not an embedded member to potentially control lifecycle better...
       OCPI::DataTransport::Transport &m_transport;
@@ -92,6 +120,7 @@ namespace OCPI {
       virtual ~Container();
     private:
       bool runInternal(uint32_t usecs = 0);
+      void idle(DataTransfer::EventManager *em, uint32_t usecs);
     public:
       virtual Driver &driver() = 0;
       const std::string &platform() const { return m_platform; }
@@ -101,6 +130,10 @@ namespace OCPI {
       const std::string &arch() const { return m_arch; }
       virtual bool portsInProcess() = 0;
       bool dynamic() const { return m_dynamic; }
+      bool hugePages() const { return m_hugePages; }
+      int numaNode() const { return m_numaNode; }
+      const WaitPolicy &waitPolicy() const { return m_wait; }
+      const WaitCounters &waitCounters() const { return m_waitCounters; }
       virtual Container *nextContainer() = 0;
       virtual bool supportsImplementation(OCPI::Util::Worker &);
       virtual OCPI::API::ContainerApplication *
@@ -133,6 +166,11 @@ namespace OCPI {
       virtual Artifact *findLoadedArtifact(const OCPI::Library::Artifact &a) = 0;
       virtual Artifact &createArtifact(OCPI::Library::Artifact &,
 				       const OCPI::API::PValue *props = NULL) = 0;
+      // Start loading an artifact that is about to be used, in advance of and in parallel
+      // with other artifacts.  This is called from other threads and must not touch the
+      // container's artifact list.  Returns a handle for releasePrefetch, or NULL.
+      virtual void *prefetchArtifact(OCPI::Library::Artifact &) { return NULL; }
+      virtual void releasePrefetch(void *) {}
       //      virtual void start(DataTransfer::EventManager* event_manager) throw();
       //      virtual void stop(DataTransfer::EventManager* event_manager) throw();
       virtual void stop();
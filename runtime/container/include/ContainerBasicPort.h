@@ -27,6 +27,7 @@
 
 #include "OcpiContainerApi.h"
 
+#include "OcpiUtilMisc.h"
 #include "OcpiUtilSelfMutex.h"
 #include "OcpiPValue.h"
 #include "OcpiRDTInterface.h"
@@ -79,6 +80,16 @@ namespace OCPI {
       }
     };
 
+    // Runtime performance counters for a port.  They are only written by the thread using the
+    // worker side of the port, and are padded so they never share a cache line with other data.
+    struct PortCounters {
+      uint8_t  m_pad0[OCPI_CACHE_LINE_SIZE];
+      uint64_t m_messages, // messages moved through the port
+	       m_bytes,    // bytes of message payload moved through the port
+	       m_blocked;  // output buffer requests refused due to flow control
+      uint8_t  m_pad1[OCPI_CACHE_LINE_SIZE - 3 * sizeof(uint64_t)];
+    };
+
     class BasicPort;
     // Information visible to others
     // vvvvvv THIS IS REPLICATED in OCL_Worker.h
@@ -154,6 +165,9 @@ typedef int pthread_spinlock_t;
       // These two are for external port mode as opposed to shim mode
       ExternalBuffer *m_dtLastBuffer; // the "current buffer" for DT mode
       OCPI::DataTransport::Port *m_dtPort; // NULL for shim
+      // Messages from other ports waiting, in order, for room in the transport.
+      // They are detached from their ports and linked by m_zcNext.
+      ExternalBuffer *m_dtPendingHead, *m_dtPendingTail;
       // End external port mode
       // Shim mode.  Slightly clever allocation in order to allocate once for headers and data
       // that is sized at runtime - better locality, no fragmentation, sequential access
@@ -162,7 +176,11 @@ typedef int pthread_spinlock_t;
       // Cycle is: get for write, put, get for read, release
       ExternalBuffer  *m_next2write, *m_next2put, *m_next2read, *m_next2release;
       BasicPort *m_allocator;
+      bool m_hugePages;        // request huge pages for the allocation
+      int m_numaNode;          // NUMA node for the allocation, -1 for no placement
+      size_t m_allocationSize; // non-zero when allocated with OS::allocateMemory
       // end shim mode
+      uint32_t m_aggregate;    // if non-zero, aggregate small output messages: timeout in us
     protected:
       BasicPort *m_forward;  // if set, forward worker-side to this other port
       BasicPort *m_backward; // if set, other is forwarded to here
@@ -170,6 +188,7 @@ typedef int pthread_spinlock_t;
       OCPI::RDT::Desc_t &myDesc; // convenience
       const OCPI::Util::Port &m_metaPort;
       Container &m_container;
+      PortCounters m_counters;
       
       BasicPort(Container &container, const OCPI::Util::Port &mPort, bool isProvider,
 		const OCPI::Util::PValue *params);
@@ -192,9 +211,11 @@ typedef int pthread_spinlock_t;
       virtual uint8_t *allocateBuffers(size_t len);
       virtual void freeBuffers(uint8_t *allocation);
       unsigned fullCount(), emptyCount();
+      bool sendDt(ExternalBuffer &b), sendPending();
     public:
       Container &container() const { return m_container; }
       inline const OCPI::Util::Port &metaPort() const { return m_metaPort; }
+      inline const PortCounters &counters() const { return m_counters; }
       OCPI::API::BaseType getOperationInfo(uint8_t opCode, size_t &nbytes);
       virtual void mapBuffers(size_t /*offset*/, size_t /*size*/) {};
       virtual void unmapBuffers(size_t /*offset*/, size_t /*size*/) {};
@@ -245,6 +266,10 @@ typedef int pthread_spinlock_t;
       // release most recently gotten input buffer
       void release();
       void releaseBuffer(ExternalBuffer &b);
+      // release all input that has arrived but not been consumed, returning how many
+      virtual unsigned discardInput();
+      // discard output messages that are produced but held back for aggregation
+      virtual unsigned discardOutput();
       // take this buffer
       void takeBuffer(ExternalBuffer &b);
       // put/send the most recently gotten output buffer
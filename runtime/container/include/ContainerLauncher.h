@@ -122,12 +122,22 @@ namespace OCPI {
       virtual bool
 	launch(Launcher::Members &members, Launcher::Connections &connections) = 0,
 	work(Launcher::Members &members, Launcher::Connections &connections) = 0;
+      // Do any blocking communication that the next call to work() needs, so it can overlap
+      // with that of other launchers.  This is called concurrently for different launchers,
+      // so it must not touch members or connections.
+      virtual void exchange() {}
+      // Whether exchange() would have anything to do
+      virtual bool exchanges() const { return false; }
     };
     // Concrete class that will be a singleton
     class LocalLauncher : public Launcher, public OCPI::Util::Singleton<LocalLauncher> {
-      void createWorker(Launcher::Member &i);
+      static void createWorker(Launcher::Member &i);
+      static void createWorkers(void *arg, size_t chunk, size_t, size_t);
+      void createWorkers(Launcher::Members &members, bool slaves);
     public:
       virtual ~LocalLauncher();
+      // Set the initial property values of a member's worker, from the instance or defaults
+      static void setInitialProperties(Launcher::Member &i);
       bool launch(Launcher::Members &members, Launcher::Connections &connections);
       bool work(Launcher::Members &members, Launcher::Connections &connections);
     };
@@ -27,6 +27,7 @@
 
 #include "OcpiOsMutex.h"
 #include "OcpiOsTimer.h"
+#include "OcpiUtilMisc.h"
 #include "OcpiUtilProperty.h"
 #include "OcpiUtilWorker.h"
 #include "OcpiPValue.h"
@@ -103,6 +104,16 @@ namespace OCPI {
       virtual void controlOperation(OCPI::Util::Worker::ControlOperation) = 0;
     };
     typedef uint32_t PortMask;
+    // Runtime performance counters for a worker.  They are only written by the thread
+    // dispatching the worker, and are padded so they never share a cache line with other data.
+    struct WorkerCounters {
+      uint8_t  m_pad0[OCPI_CACHE_LINE_SIZE];
+      uint64_t m_runs,       // times the run method was called
+	       m_notReady,   // times the run condition was evaluated but not satisfied
+	       m_runTime,    // total time spent in the run method, in OS::Time units
+	       m_maxRunTime; // longest single call to the run method, in OS::Time units
+      uint8_t  m_pad1[OCPI_CACHE_LINE_SIZE - 4 * sizeof(uint64_t)];
+    };
     class Worker;
     typedef std::vector<Worker *> Workers;
     extern const Workers NoWorkers;
@@ -129,6 +140,9 @@ namespace OCPI {
       std::vector<uint8_t *> m_cache; // cache for writable, non-volatile property values
       bool beforeStart();
     protected:
+      WorkerCounters m_counters;
+      // Containers that maintain the performance counters override this
+      virtual bool hasCounters() const { return false; }
       void connectPort(OCPI::Util::PortOrdinal ordinal);
       PortMask &connectedPorts() { return m_connectedPorts; }
       PortMask &optionalPorts() { return m_optionalPorts; }
@@ -159,11 +173,24 @@ namespace OCPI {
 			       const OCPI::Util::PValue *props) = 0;
       virtual Worker *nextWorker() = 0;
 
+      void checkWritable(const OCPI::Util::Property &p);
+      uint8_t *cacheFor(const OCPI::Util::Property &p);
     public:
       virtual void setPropertyValue(const OCPI::Util::Property &p, const OCPI::Util::Value &v);
       // Return true when ignored due to "ignored due to existing state"
       bool controlOp(OCPI::Util::Worker::ControlOperation);
+      // Return to the INITIALIZED state, keeping ports, connections and buffers.
+      // Unconsumed input and unsent aggregated output are discarded; property values are
+      // left as they are.  The worker's own state is whatever its initialize method
+      // establishes: state set up only by its constructor survives.
+      void reinitialize();
       void setPropertyValue(const OCPI::Util::Property &p, const char *v);
+      // Set many property values at once, in ascending ordinal order, as when a worker is
+      // created.  Values of adjacent properties are assembled and written with one
+      // setPropertyBytes call.  Write-sync notifications are made as they would be if the
+      // values were set one at a time, after the value and those before it are written.
+      virtual void setPropertyValues(size_t nValues, const unsigned *ordinals,
+				     const OCPI::Util::Value *const *values);
       virtual const std::string &name() const = 0;
       // This class is actually used in some contexts (e.g. ocpihdl),
       // Where it is not a child of an application, hence this method
@@ -179,6 +206,22 @@ namespace OCPI {
       bool getProperty(unsigned ordinal, std::string &name, std::string &value,
 		       bool *unreadablep = NULL, bool hex = false, bool *cachedp = NULL,
 		       bool uncached = false);
+      // Raw property value images (see OcpiUtilPropertySnapshot.h), read or written with
+      // one bulk property access rather than converting to or from text.
+      void getPropertyImage(const OCPI::Util::Property &p, std::string &image,
+			    bool uncached = false);
+      void setPropertyImage(const OCPI::Util::Property &p, const uint8_t *image, size_t length);
+      // Whether a property's value can be read (perhaps from the cache) or written now
+      bool hasPropertyValue(const OCPI::Util::Property &p) const;
+      bool canSetProperty(const OCPI::Util::Property &p);
+      // Built-in read-only performance counters, available for any worker implementation:
+      // some for the worker as a whole, followed by some for each port.
+      static unsigned nCounters(const OCPI::Util::Worker &impl);
+      static void counterName(const OCPI::Util::Worker &impl, unsigned n, std::string &name);
+      // Return false if n is out of range.  Set *unreadablep if the container does not
+      // maintain counters or the port does not exist.
+      bool getCounter(unsigned n, std::string &name, std::string &value,
+		      bool *unreadablep = NULL);
       bool hasImplTag(const char *tag);
       bool hasInstTag(const char *tag);
       typedef unsigned Ordinal;
@@ -19,8 +19,10 @@
  */
 
 #include <signal.h>
+#include <time.h>
 #include "ocpi-config.h"
 #include "OcpiOsMisc.h"
+#include "OcpiOsMemory.h"
 #include "OcpiUtilCppMacros.h"
 #include "XferManager.h"
 #include "ContainerManager.h"
@@ -42,7 +44,8 @@ namespace OCPI {
       throw ( OU::EmbeddedException )
       : //m_ourUID(mkUID()),
       OCPI::Time::Emit("Container", a_name ),
-      m_enabled(false), m_ownThread(true), m_verbose(false), m_thread(NULL),
+      m_enabled(false), m_ownThread(true), m_verbose(false), m_hugePages(false),
+      m_numaNode(-1), m_waitPhase(NotWaiting), m_idleStart(0), m_waitStart(0), m_thread(NULL),
       m_transport(*new OCPI::DataTransport::Transport(&Manager::getTransportGlobal(params), false, this))
     {
       OU::findBool(params, "verbose", m_verbose);
@@ -63,6 +66,43 @@ namespace OCPI {
       // It works because stuff can be overriden and no threads are created until
       // "start", which is
       OU::findBool(params, "ownthread", m_ownThread);
+      OU::findBool(params, "hugePages", m_hugePages);
+      OA::ULong node;
+      if (OU::findULong(params, "numaNode", node)) {
+	if (node < OS::numaNodeCount())
+	  m_numaNode = (int)node;
+	else
+	  ocpiBad("NUMA node %u for container \"%s\" does not exist (there are %u): ignored",
+		  node, a_name, OS::numaNodeCount());
+      }
+      // The wait policy defaults come from the environment as "spin,yield,block" in usecs,
+      // and can be overridden by container parameters.
+      memset(&m_wait, 0, sizeof(m_wait));
+      memset(&m_waitCounters, 0, sizeof(m_waitCounters));
+      const char *env = getenv("OCPI_CONTAINER_WAIT");
+      if (env) {
+	uint32_t *w = &m_wait.m_spinUsecs;
+	for (unsigned n = 0; n < 3 && *env; n++) {
+	  char *end;
+	  w[n] = (uint32_t)strtoul(env, &end, 0);
+	  if (end == env || (*end && *end != ',')) {
+	    ocpiBad("Invalid OCPI_CONTAINER_WAIT value: \"%s\": ignored", getenv("OCPI_CONTAINER_WAIT"));
+	    memset(&m_wait, 0, sizeof(m_wait));
+	    break;
+	  }
+	  env = *end ? end + 1 : end;
+	}
+      }
+      OU::findULong(params, "spinUsecs", m_wait.m_spinUsecs);
+      OU::findULong(params, "yieldUsecs", m_wait.m_yieldUsecs);
+      OU::findULong(params, "blockUsecs", m_wait.m_blockUsecs);
+      if (m_wait.m_spinUsecs || m_wait.m_yieldUsecs || m_wait.m_blockUsecs)
+	ocpiInfo("Container \"%s\" waits by spinning for %u usecs, yielding for %u usecs, "
+		 "then blocking for %u usecs", a_name, m_wait.m_spinUsecs,
+		 m_wait.m_yieldUsecs, m_wait.m_blockUsecs);
+      uint64_t yieldEnd = (uint64_t)m_wait.m_spinUsecs + m_wait.m_yieldUsecs;
+      m_spinEnd.set(m_wait.m_spinUsecs / 1000000, (m_wait.m_spinUsecs % 1000000) * 1000);
+      m_yieldEnd.set((uint32_t)(yieldEnd / 1000000), (uint32_t)(yieldEnd % 1000000) * 1000);
       if (getenv("OCPI_NO_THREADS"))
 	m_ownThread = false;
       m_os = OCPI_CPP_STRINGIFY(OCPI_OS) + strlen("OCPI");
@@ -209,13 +249,28 @@ namespace OCPI {
 	  (*bpi)->runBridge();
       }
       DataTransfer::EventManager *em = getEventManager();
-      switch (dispatch(em)) {
+      if (em)
+	em->arm();
+      DispatchRetCode rc = dispatch(em);
+      if (m_waitPhase != NotWaiting) {
+	// Charge the time since the last wait began to that wait's phase
+	uint64_t waited = (OS::Time::now() - m_waitStart).bits();
+	switch (m_waitPhase) {
+	case Spinning: m_waitCounters.m_spinTime += waited; break;
+	case Yielding: m_waitCounters.m_yieldTime += waited; break;
+	case Blocking: m_waitCounters.m_blockTime += waited; break;
+	default:;
+	}
+	m_waitPhase = NotWaiting;
+      }
+      switch (rc) {
       case DispatchNoMore:
 	// All done, exit from dispatch thread.
 	return false;
 
       case MoreWorkNeeded:
 	// No-op. To prevent blocking the CPU, yield.
+	m_idleStart = 0;
 	OCPI::OS::sleep (0);
 	return true;
 
@@ -224,6 +279,24 @@ namespace OCPI {
 	return false;
 
       case Spin:
+	idle(em, usecs);
+      }
+      return true;
+    }
+
+    // Wait after a dispatch that found nothing to do, according to the wait policy.
+    void Container::idle(DataTransfer::EventManager *em, uint32_t usecs) {
+      OS::Time now = OS::Time::now();
+      if (!m_idleStart.bits())
+	m_idleStart = now;
+      OS::Time idleTime = now - m_idleStart;
+      m_waitStart = now;
+      if (idleTime < m_spinEnd) {
+	m_waitPhase = Spinning; // dispatch again right away
+	return;
+      }
+      if (!m_wait.m_blockUsecs || idleTime < m_yieldEnd) {
+	m_waitPhase = Yielding;
 	/*
 	 * If we have an event manager, ask it to go to sleep and wait for
 	 * an event.  If we are not event driven, the event manager will
@@ -231,20 +304,42 @@ namespace OCPI {
 	 * threads a chance to run.
 	 */
 	if (em &&
-	    em->waitForEvent(usecs) == DataTransfer::EventTimeout && m_verbose)
+	    em->waitForEvent((int)usecs) == DataTransfer::EventTimeout && m_verbose)
 	  ocpiBad("Timeout after %u usecs waiting for event", usecs);
 	OCPI::OS::sleep (0);
+	return;
+      }
+      // Block until an event or for the bounded block period.  Without an event manager
+      // there is nothing to wake us early.
+      m_waitPhase = Blocking;
+      m_waitCounters.m_blocks++;
+      if (em)
+	em->waitForEvent((int)m_wait.m_blockUsecs);
+      else {
+	struct timespec ts;
+	ts.tv_sec = (time_t)(m_wait.m_blockUsecs / 1000000);
+	ts.tv_nsec = (long)(m_wait.m_blockUsecs % 1000000) * 1000;
+	nanosleep(&ts, NULL);
       }
-      return true;
     }
     // This will be called inside a separate thread for this container.
     void Container::thread() {
       while (m_enabled && runInternal())
 	;
+      const WaitCounters &w = m_waitCounters;
+      if (w.m_spinTime || w.m_yieldTime || w.m_blockTime)
+	ocpiInfo("Container \"%s\" waited %.6fs spinning, %.6fs yielding and %.6fs blocking "
+		 "(%llu blocks)", name().c_str(),
+		 (double)w.m_spinTime / OS::Time::ticksPerSecond,
+		 (double)w.m_yieldTime / OS::Time::ticksPerSecond,
+		 (double)w.m_blockTime / OS::Time::ticksPerSecond,
+		 (unsigned long long)w.m_blocks);
     }
     void Container::stop() {
       //      stop(getEventManager());
       m_enabled = false;
+      if (getEventManager())
+	DataTransfer::EventManager::wake();
     }
     void runContainer(void*arg) {
 
@@ -262,8 +357,17 @@ namespace OCPI {
       for (int *sp = sigs; *sp; sp++)
 	sigaddset(&set, *sp);
       ocpiCheck(pthread_sigmask(SIG_BLOCK, &set, NULL) == 0);
+      Container &c = *(Container *)arg;
+      if (c.numaNode() >= 0) {
+	if (OS::runOnNumaNode((unsigned)c.numaNode()))
+	  ocpiInfo("Container \"%s\" thread is running on NUMA node %d",
+		   c.name().c_str(), c.numaNode());
+	else
+	  ocpiInfo("Container \"%s\" thread could not be restricted to NUMA node %d",
+		   c.name().c_str(), c.numaNode());
+      }
       try {
-	((Container *)arg)->thread();
+	c.thread();
       } catch (const std::string &s) {
 	std::cerr << "Container \"" << ((Container *)arg)->name()
 		  << "\" background thread exception:  " << s << std::endl;
@@ -25,6 +25,8 @@
 #include "../../../foreign/pwq/src/platform.c"
 #endif
 #include "OcpiOsAssert.h"
+#include "OcpiOsMemory.h"
+#include "OcpiOsMisc.h"
 #include "OcpiUtilCDR.h"
 #include "Container.h"
 #include "ContainerPort.h"
@@ -34,6 +36,7 @@ namespace OCPI {
   namespace Container {
     namespace OA = OCPI::API;
     namespace OU = OCPI::Util;
+    namespace OS = OCPI::OS;
     namespace OD = OCPI::DataTransport;
     namespace OR = OCPI::RDT;
 
@@ -120,10 +123,13 @@ namespace OCPI {
     BasicPort::
     BasicPort(Container &c, const OU::Port &mPort, bool a_isProvider, const OU::PValue *params)
       : PortData(mPort, a_isProvider, NULL), m_lastInBuffer(NULL), m_lastOutBuffer(NULL),
-	m_dtLastBuffer(NULL), m_dtPort(NULL), m_allocation(NULL), m_bufferStride(0),
+	m_dtLastBuffer(NULL), m_dtPort(NULL), m_dtPendingHead(NULL), m_dtPendingTail(NULL),
+	m_allocation(NULL), m_bufferStride(0),
 	m_next2write(NULL), m_next2put(NULL), m_next2read(NULL), m_next2release(NULL),
-	m_forward(NULL), m_backward(NULL), m_nRead(0), m_nWritten(0),
+	m_hugePages(c.hugePages()), m_numaNode(c.numaNode()), m_allocationSize(0),
+	m_aggregate(0), m_forward(NULL), m_backward(NULL), m_nRead(0), m_nWritten(0),
 	myDesc(getData().data.desc), m_metaPort(mPort), m_container(c) {
+      memset(&m_counters, 0, sizeof(m_counters));
       applyPortParams(params);
     }
 
@@ -149,6 +155,10 @@ namespace OCPI {
       if (m_allocation && m_allocator == this)
 	freeBuffers(m_allocation);
       delete m_dtLastBuffer;
+      while (ExternalBuffer *b = m_dtPendingHead) {
+	m_dtPendingHead = b->m_zcNext;
+	delete b;
+      }
     }
 
     void BasicPort::
@@ -163,6 +173,16 @@ namespace OCPI {
 		    name().c_str(), m_nBuffers);
 	}
       }
+      OU::findBool(params, "hugePages", m_hugePages);
+      if (OU::findULong(params, "numaNode", ul)) {
+	if (ul < OS::numaNodeCount())
+	  m_numaNode = (int)ul;
+	else
+	  ocpiBad("NUMA node %u for port \"%s\" does not exist (there are %u): ignored",
+		  ul, name().c_str(), OS::numaNodeCount());
+      }
+      if (OU::findULong(params, "aggregate", ul))
+	m_aggregate = ul;
     }
 
     /*
@@ -595,7 +615,8 @@ namespace OCPI {
       size_t length;
       if (!m_dtLastBuffer)
 	m_dtLastBuffer = new ExternalBuffer(*this, NULL, 0);
-      if (m_dtPort &&
+      // Messages waiting for the transport go first
+      if (m_dtPort && sendPending() &&
 	  (m_dtLastBuffer->m_dtBuffer =
 	   m_dtPort->getNextEmptyOutputBuffer(m_dtLastBuffer->m_dtData, length))) {
 	m_dtLastBuffer->m_hdr.m_length = OCPI_UTRUNCATE(uint32_t, length);
@@ -618,7 +639,8 @@ namespace OCPI {
 	data = b->data();
 	length = b->m_hdr.m_length;
 	(m_forward ? m_forward : this)->m_lastOutBuffer = b;
-      }
+      } else
+	m_counters.m_blocked++;
       return b;
     }
 
@@ -640,6 +662,10 @@ namespace OCPI {
 	throw OU::Error("put called on output port %s without a previous buffer",
 			name().c_str());
       m_lastOutBuffer->send(length, opCode, end, direct);
+      // Count on the worker-side port when it is forwarding to us
+      PortCounters &c = (m_backward ? m_backward : this)->m_counters;
+      c.m_messages++;
+      c.m_bytes += length;
       ocpiDebug("Putting (internal) on %p(f %p) buffer %p length %zu", this, m_forward,
 		m_lastOutBuffer, length);
       m_lastOutBuffer = NULL;
@@ -736,6 +762,8 @@ namespace OCPI {
       b.m_hdr.m_opCode = op;
       b.m_hdr.m_eof = end ? 1 : 0;
       b.m_hdr.m_direct = OCPI_UTRUNCATE(uint8_t, direct);
+      m_counters.m_messages++;
+      m_counters.m_bytes += len;
       put(buf);
     }
     // The API level zero-copy put of another port's buffer to this port
@@ -762,11 +790,69 @@ namespace OCPI {
 	  m_next2write->m_zcHead = &b;
 	m_next2write->m_zcTail = &b;
 	pthread_spin_unlock(&m_next2write->m_zcLock);
-      } else if (m_dtPort && b.m_dtBuffer)
+      } else if (m_dtPort && b.m_dtBuffer) {
+	if (!sendPending() || !sendDt(b)) {
+	  // No room in the transport: rather than waiting for it here, detach the message
+	  // from its port, as take() does, and send it when there is room, which is checked
+	  // whenever this port is asked for an output buffer.
+	  BasicPort &from = b.m_port;
+	  if (from.m_dtLastBuffer == &b)
+	    from.m_dtLastBuffer = NULL;
+	  if (from.m_lastInBuffer == &b)
+	    from.m_lastInBuffer = NULL;
+	  b.m_zcNext = NULL;
+	  if (m_dtPendingTail)
+	    m_dtPendingTail->m_zcNext = &b;
+	  else
+	    m_dtPendingHead = &b;
+	  m_dtPendingTail = &b;
+	  m_counters.m_blocked++;
+	}
+      } else
+	assert("No support yet for zery-copy send of shim buffer to external port"==0);
+    }
+
+    // Send a message from a transport input port to this transport output port.
+    // Return false if it must wait for an empty output buffer.
+    bool BasicPort::
+    sendDt(ExternalBuffer &b) {
+      if (!b.m_dtBuffer) // it was dropped
+	return true;
+      if (b.m_port.m_dtPort && b.m_port.m_dtPort->isAggregated(*b.m_dtBuffer)) {
+	// The message shares its transport buffer with the others unpacked from the same
+	// aggregate, so it is copied rather than forwarding the whole buffer.
+	uint8_t *data;
+	size_t length;
+	OCPI::DataTransport::BufferUserFacet *out =
+	  m_dtPort->getNextEmptyOutputBuffer(data, length);
+	if (!out)
+	  return false;
+	if (b.m_hdr.m_length > length) {
+	  b.m_port.releaseBuffer(b);
+	  throw OU::Error("Message of length %zu is too long for the buffers (%zu) of "
+			  "port \"%s\"", (size_t)b.m_hdr.m_length, length, name().c_str());
+	}
+	memcpy(data, b.data(), b.m_hdr.m_length);
+	m_dtPort->sendOutputBuffer(out, b.m_hdr.m_length, b.m_hdr.m_opCode, b.m_hdr.m_eof);
+	b.m_port.releaseBuffer(b);
+      } else
 	m_dtPort->sendZcopyInputBuffer(*b.m_dtBuffer,
 				       b.m_hdr.m_length, b.m_hdr.m_opCode, b.m_hdr.m_eof);
-      else
-	assert("No support yet for zery-copy send of shim buffer to external port"==0);
+      return true;
+    }
+
+    // Send the messages waiting for the transport, in order, as far as there is room.
+    // Return true when none are left.
+    bool BasicPort::
+    sendPending() {
+      while (ExternalBuffer *b = m_dtPendingHead) {
+	if (!sendDt(*b))
+	  return false;
+	if (!(m_dtPendingHead = b->m_zcNext))
+	  m_dtPendingTail = NULL;
+	delete b; // detached from its port when it was queued
+      }
+      return true;
     }
 
     bool BasicPort::
@@ -777,7 +863,7 @@ namespace OCPI {
       if ((m_forward ? m_forward : this)->m_lastOutBuffer)
 	throw OU::Error("tryFlush called on output port %s with a previous buffer",
 			name().c_str());
-      return
+      return !(m_forward ? m_forward : this)->sendPending() ||
 	(m_forward ? m_forward->m_nWritten - m_forward->m_nRead : m_nWritten - m_nRead) != 0;
     }
 
@@ -799,6 +885,8 @@ namespace OCPI {
 	end = b->m_hdr.m_eof;
 	assert(!m_forward);
 	m_lastInBuffer = b;
+	m_counters.m_messages++;
+	m_counters.m_bytes += length;
 	//	(m_forward ? m_forward : this)->m_lastInBuffer = b;
       }
       return b;
@@ -974,6 +1062,43 @@ namespace OCPI {
       return releaseBuffer(*m_lastInBuffer);
     }
 
+    // Return an input port to its initial empty state, e.g. when the application is reset
+    // to run again, without disturbing the connection or its buffers.
+    unsigned BasicPort::
+    discardInput() {
+      if (m_forward || !isProvider())
+	return 0;
+      unsigned n = 0;
+      if (m_lastInBuffer) {
+	releaseBuffer(*m_lastInBuffer);
+	n++;
+      }
+      for (ExternalBuffer *b; (b = getFullBuffer()); n++)
+	releaseBuffer(*b);
+      if (n)
+	ocpiInfo("Discarded %u unconsumed input buffers at port \"%s\"", n, name().c_str());
+      return n;
+    }
+
+    // Output that is held back to be aggregated is discarded too, since it belongs to the
+    // run before the reset.
+    unsigned BasicPort::
+    discardOutput() {
+      if (isProvider() || !m_dtPort)
+	return 0;
+      unsigned n = m_dtPort->discardAggregate();
+      for (ExternalBuffer *b; (b = m_dtPendingHead); n++) {
+	if (!(m_dtPendingHead = b->m_zcNext))
+	  m_dtPendingTail = NULL;
+	if (b->m_dtBuffer)
+	  b->m_port.releaseBuffer(*b);
+	delete b;
+      }
+      if (n)
+	ocpiInfo("Discarded %u unsent output messages at port \"%s\"", n, name().c_str());
+      return n;
+    }
+
     // Step 4: release, API level on a particular buffer - perhaps not the current one
     void ExternalBuffer::
     release() {
@@ -1009,13 +1134,35 @@ namespace OCPI {
 
     uint8_t *BasicPort::
     allocateBuffers(size_t len) {
-      return new uint8_t[len];
+      if (!m_hugePages && m_numaNode < 0)
+	return new uint8_t[len];
+      unsigned obtained;
+      size_t size = len;
+      void *p = OS::allocateMemory(size, m_hugePages, m_numaNode, obtained);
+      if (!p)
+	throw OU::Error("Could not allocate %zu bytes of buffer memory for port \"%s\"",
+			len, name().c_str());
+      m_allocationSize = size;
+      ocpiInfo("Buffers for port \"%s\": %zu bytes, %s pages%s, NUMA node %s%s",
+	       name().c_str(), size,
+	       obtained & OS::MemoryHugePages ? "huge" :
+	       obtained & OS::MemoryHugeAdvised ? "transparent huge" : "normal",
+	       m_hugePages && !(obtained & OS::MemoryHugePages) ? " (huge pages unavailable)" : "",
+	       obtained & OS::MemoryNumaBound ? "preferred" : "default",
+	       m_numaNode >= 0 && !(obtained & OS::MemoryNumaBound) ? " (placement unavailable)" :
+	       "");
+      return (uint8_t *)p;
     }
     // This is virtual, but during destruction it gets called anyway, so we do the check.
     void BasicPort::
     freeBuffers(uint8_t *p) {
-      if (m_allocator == this)
-	delete [] p;
+      if (m_allocator == this) {
+	if (m_allocationSize)
+	  OS::freeMemory(p, m_allocationSize);
+	else
+	  delete [] p;
+	m_allocationSize = 0;
+      }
     }
 
     // Make this port into a SHIM - meaning there is no "connection",
@@ -1159,13 +1306,23 @@ namespace OCPI {
     // Default local behavior for basic ports that need to behave like external or bridge ports
     const OCPI::RDT::Descriptors *BasicPort::
     startConnect(const OCPI::RDT::Descriptors *other, OCPI::RDT::Descriptors &feedback, bool &done) {
-      if (isProvider())
+      if (isProvider()) {
 	m_dtPort = container().getTransport().createInputPort(getData().data);
-      else if (other)
+	// Software input ports unpack aggregated messages (Port::getNextFullInputBuffer)
+	getData().data.options |= 1 << OCPI::RDT::FlagCanAggregate;
+      } else if (other)
 	m_dtPort = container().getTransport().createOutputPort(getData().data, *other);
       if (m_dtPort) {
 	// FIXME: put this in the constructor, and have better names
 	m_dtPort->setInstanceName(m_metaPort.m_name.c_str());
+	// Only aggregate to input ports that say they can unpack aggregates
+	if (m_aggregate && !isProvider()) {
+	  if (!(other->options & (1 << OCPI::RDT::FlagCanAggregate)))
+	    ocpiInfo("Port \"%s\" cannot aggregate messages to a port that cannot unpack them",
+		     name().c_str());
+	  else
+	    m_dtPort->setAggregation(m_aggregate);
+	}
 	if (other)
 	  return finishConnect(other, feedback, done);
 	done = false;
@@ -18,6 +18,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <map>
+#include "OcpiUtilThreadPool.h"
 #include "XferEndPoint.h"
 #include "Container.h"
 #include "ContainerPort.h"
@@ -42,54 +44,99 @@ createWorker(Launcher::Member &i) {
 					       i.m_slaveWorkers,
 					       i.m_hasMaster,
 					       i.m_member, i.m_crew ? i.m_crew->m_size : 1);
-  // Now we need to set the initial properties - either from instance or from defaults
+  setInitialProperties(i);
+}
+
+// Set the initial properties - either from instance or from defaults.
+// This is also used when an application is reset to run again.
+// All the values are collected in ordinal order and set together so that the container can
+// write adjacent values in bulk rather than one property at a time.
+void LocalLauncher::
+setInitialProperties(Launcher::Member &i) {
+  unsigned nProps = i.m_impl->m_metadataImpl.nProperties();
+  OU::Property *props = i.m_impl->m_metadataImpl.properties();
+  std::vector<const OU::Value *> byOrdinal(nProps, NULL);
   for (unsigned p = 0; p < i.m_crew->m_propValues.size(); p++) {
     ocpiDebug("Setting the initial specified value of property '%s' of instance '%s'",
-	      i.m_impl->m_metadataImpl.properties()[i.m_crew->m_propOrdinals[p]].cname(),
-	      i.m_name.c_str());
-    i.m_worker->setProperty(i.m_crew->m_propOrdinals[p], i.m_crew->m_propValues[p]);
+	      props[i.m_crew->m_propOrdinals[p]].cname(), i.m_name.c_str());
+    byOrdinal[i.m_crew->m_propOrdinals[p]] = &i.m_crew->m_propValues[p];
   }
-  unsigned nProps = i.m_impl->m_metadataImpl.nProperties();
-  OU::Property *prop = i.m_impl->m_metadataImpl.properties();
-  for (unsigned nn = 0; nn < nProps; nn++, prop++)
-    if (prop->m_default && !prop->m_isParameter) {
-      bool found = false;
-      for (unsigned m = 0; m < i.m_crew->m_propValues.size(); m++)
-	if (i.m_crew->m_propOrdinals[m] == prop->m_ordinal) {
-	  found = true;
-	  break;
-	}
-      if (!found) {
-	ocpiDebug("Setting the default value of property '%s' of instance '%s'",
-		  prop->m_name.c_str(), i.m_name.c_str());
-	i.m_worker->setProperty(prop->m_ordinal, *prop->m_default);
-      }
+  std::vector<unsigned> ordinals;
+  std::vector<const OU::Value *> values;
+  for (unsigned nn = 0; nn < nProps; nn++) {
+    OU::Property &prop = props[nn];
+    if (!byOrdinal[nn] && prop.m_default && !prop.m_isParameter) {
+      ocpiDebug("Setting the default value of property '%s' of instance '%s'",
+		prop.m_name.c_str(), i.m_name.c_str());
+      byOrdinal[nn] = prop.m_default;
+    }
+    if (byOrdinal[nn]) {
+      ordinals.push_back(prop.m_ordinal);
+      values.push_back(byOrdinal[nn]);
     }
+  }
+  if (ordinals.size())
+    i.m_worker->setPropertyValues(ordinals.size(), &ordinals[0], &values[0]);
 }
 
-// Local launcher: do local launching for the instances managed by this launcher.
-// Do the initial connection work that can be done in this first pass.
-bool LocalLauncher::
-launch(Launcher::Members &instances, Launcher::Connections &connections) {
-  m_more = false;
+// The members to be created in each container, in order
+typedef std::vector<std::vector<Launcher::Member *> > ContainerMembers;
+void LocalLauncher::
+createWorkers(void *arg, size_t chunk, size_t, size_t) {
+  std::vector<Launcher::Member *> &members = (*(ContainerMembers *)arg)[chunk];
+  for (unsigned n = 0; n < members.size(); n++)
+    createWorker(*members[n]);
+}
+
+// Create the workers for members in different containers in parallel, since this
+// can include slow artifact loading (e.g. FPGA bitstreams).  Workers in the same container
+// are created in order, by one thread.
+void LocalLauncher::
+createWorkers(Launcher::Members &instances, bool slaves) {
+  std::map<Container *, unsigned> index;
+  ContainerMembers members;
   Launcher::Member *i = &instances[0];
   for (unsigned n = 0; n < instances.size(); n++, i++)
-    if (&i->m_container->launcher() == this && i->m_hasMaster)
-      createWorker(*i);
-  i = &instances[0];
-  for (unsigned n = 0; n < instances.size(); n++, i++)
-    if (&i->m_container->launcher() == this && !i->m_hasMaster) {
+    if (&i->m_container->launcher() == this && i->m_hasMaster == slaves && !i->m_worker) {
       bool needSlave = false;
       for (unsigned nn = 0; nn < i->m_slaves.size(); ++nn)
 	if (!(i->m_slaveWorkers[nn] = i->m_slaves[nn]->m_worker)) {
 	  needSlave = true;
 	  break;
 	}
-      if (needSlave)
+      if (needSlave) {
 	m_more = true; // instance is local, but a slave is remote
-      else
-	createWorker(*i);
+	continue;
+      }
+      std::map<Container *, unsigned>::iterator it = index.find(i->m_container);
+      if (it == index.end()) {
+	index[i->m_container] = (unsigned)members.size();
+	members.resize(members.size() + 1);
+	members.back().push_back(i);
+      } else
+	members[it->second].push_back(i);
     }
+  if (members.size() <= 1) {
+    if (members.size())
+      createWorkers(&members, 0, 0, 0);
+    return;
+  }
+  ocpiInfo("Creating workers in %zu local containers in parallel", members.size());
+  try {
+    OU::ThreadPool pool((unsigned)members.size() - 1, false);
+    pool.run(members.size(), 1, createWorkers, &members);
+  } catch (std::string &e) {
+    throw OU::Error("%s", e.c_str());
+  }
+}
+
+// Local launcher: do local launching for the instances managed by this launcher.
+// Do the initial connection work that can be done in this first pass.
+bool LocalLauncher::
+launch(Launcher::Members &instances, Launcher::Connections &connections) {
+  m_more = false;
+  createWorkers(instances, true);  // slaves first
+  createWorkers(instances, false); // then those whose slaves exist
   for (unsigned n = 0; n < connections.size(); n++) {
     Launcher::Connection &c = connections[n];
     c.prepare();
@@ -20,8 +20,10 @@
 
 #include "OcpiOsMisc.h"
 #include "OcpiUtilValue.h"
+#include "OcpiUtilPropertySnapshot.h"
 #include "ValueReader.h"
 #include "ValueWriter.h"
+#include "XferEvent.h"
 #include "Container.h"
 #include "ContainerPort.h"
 #include "ContainerApplication.h"
@@ -53,6 +55,7 @@ namespace OCPI {
 	m_artifact(art), m_xml(impl), m_instXml(inst), m_workerMutex(true),
 	m_controlOpPending(false), m_slaves(a_slaves), m_hasMaster(a_hasMaster),
         m_member(a_member), m_crewSize(a_crewSize), m_connectedPorts(0), m_optionalPorts(0) {
+      memset(&m_counters, 0, sizeof(m_counters));
       if (impl) {
 	const char *err = parse(impl);
 	if (err)
@@ -135,7 +138,7 @@ namespace OCPI {
     // FIXME:  would a copy-constructor of OU::Value be better for caching?
     //         most callers are construcint an OU::Value already
     //         m_cache would be a sparse OU::Value pointer vector?
-    void Worker::setPropertyValue(const OU::Property &info, const OU::Value &v) {
+    void Worker::checkWritable(const OU::Property &info) {
       if (!info.m_isWritable)
 	throw OU::Error("The '%s' property of worker '%s' is not writable",
 			info.m_name.c_str(), name().c_str());
@@ -144,14 +147,20 @@ namespace OCPI {
 			info.m_name.c_str(), name().c_str());
       if (info.m_baseType == OA::OCPI_Type)
 	throw OU::Error("Typedef properties are not settable");
-      uint8_t *cache = NULL;
-      if (!info.m_isVolatile) {
-	if (m_cache.size() <= info.m_ordinal)
-	  m_cache.resize(info.m_ordinal + 10, NULL);
-	if (!m_cache[info.m_ordinal])
-	  m_cache[info.m_ordinal] = new uint8_t[info.m_nBytes];
-	cache = m_cache[info.m_ordinal];
-      }
+    }
+    // The cache for writing a non-volatile property, created on demand
+    uint8_t *Worker::cacheFor(const OU::Property &info) {
+      if (info.m_isVolatile)
+	return NULL;
+      if (m_cache.size() <= info.m_ordinal)
+	m_cache.resize(info.m_ordinal + 10, NULL);
+      if (!m_cache[info.m_ordinal])
+	m_cache[info.m_ordinal] = new uint8_t[info.m_nBytes];
+      return m_cache[info.m_ordinal];
+    }
+    void Worker::setPropertyValue(const OU::Property &info, const OU::Value &v) {
+      checkWritable(info);
+      uint8_t *cache = cacheFor(info);
       if (info.m_baseType == OA::OCPI_Struct || info.m_isSequence || info.m_arrayRank > 0) {
 	// FIXME should we use m_dataOffset here?
 	size_t offset = info.m_offset + (info.m_isSequence ? info.m_align : 0);
@@ -328,6 +337,104 @@ namespace OCPI {
 	}
       v.unparse(value, NULL, add, hex);
     }
+    bool Worker::
+    hasPropertyValue(const OU::Property &p) const {
+      return p.m_isReadable || p.m_isParameter ||
+	(p.m_isWritable && !p.m_isVolatile && m_cache.size() > p.m_ordinal &&
+	 m_cache[p.m_ordinal]);
+    }
+    bool Worker::
+    canSetProperty(const OU::Property &p) {
+      return p.m_isWritable && p.m_baseType != OA::OCPI_Type &&
+	(!p.m_isInitial || beforeStart());
+    }
+    void Worker::
+    getPropertyImage(const OU::Property &p, std::string &image, bool uncached) {
+      if (p.m_baseType == OA::OCPI_Type)
+	throw OU::Error("Typedef properties are unsupported");
+      if (!hasPropertyValue(p))
+	throw OU::Error("The '%s' property of worker '%s' is unreadable",
+			p.m_name.c_str(), name().c_str());
+      if (p.m_readSync)
+	propertyRead(p.m_ordinal);
+      uint8_t *cache = // use cache unless we are told not to and its readable
+	(!uncached || !p.m_isReadable) && m_cache.size() > p.m_ordinal ?
+	m_cache[p.m_ordinal] : NULL;
+      size_t nElements = 0;
+      if (p.m_isSequence) {
+	nElements = cache ? *(uint32_t*)cache : getProperty32(p, 0);
+	if (nElements > p.m_sequenceLength)
+	  throw OU::Error("Worker's %s property has invalid sequence length: %zu",
+			  p.m_name.c_str(), nElements);
+      }
+      image.resize(OU::PropertySnapshot::imageLength(p, nElements));
+      uint8_t *data = (uint8_t *)&image[0];
+      if (cache)
+	memcpy(data, cache, image.size());
+      else if (p.m_baseType == OA::OCPI_Struct || p.m_isSequence || p.m_arrayRank > 0 ||
+	       p.m_baseType == OA::OCPI_String)
+	getPropertyBytes(p, p.m_offset, data, image.size(), 0,
+			 p.m_baseType == OA::OCPI_String && !p.m_isSequence && !p.m_arrayRank);
+      else
+	switch (p.m_nBits) {
+	case 8:
+	  *data = getProperty8(p, 0); break;
+	case 16:
+	  *(uint16_t *)data = getProperty16(p, 0); break;
+	case 32:
+	  *(uint32_t *)data = getProperty32(p, 0); break;
+	case 64:
+	  *(uint64_t *)data = getProperty64(p, 0); break;
+	default:;
+	}
+      if (p.m_baseType == OA::OCPI_String && !p.m_isSequence && !p.m_arrayRank)
+	image.resize(strnlen(image.c_str(), p.m_stringLength) + 1);
+    }
+    // Set from an image: the data first and then the sequence length or first word, as
+    // setPropertyValue does, so a worker sees a consistent value.
+    void Worker::
+    setPropertyImage(const OU::Property &p, const uint8_t *image, size_t length) {
+      checkWritable(p);
+      uint8_t *cache = cacheFor(p);
+      size_t nElements = 0;
+      if (p.m_isSequence) {
+	if (length < sizeof(uint32_t) ||
+	    (nElements = *(uint32_t *)image) > p.m_sequenceLength)
+	  throw OU::Error("Invalid sequence length in image for property '%s'", p.m_name.c_str());
+      }
+      bool isString = p.m_baseType == OA::OCPI_String && !p.m_isSequence && !p.m_arrayRank;
+      if (isString ? !length || length > p.m_stringLength + 1 || image[length - 1] :
+	  length != OU::PropertySnapshot::imageLength(p, nElements))
+	throw OU::Error("Wrong image length (%zu) for property '%s'", length, p.m_name.c_str());
+      if (p.m_baseType == OA::OCPI_Struct || p.m_isSequence || p.m_arrayRank > 0) {
+	size_t header = p.m_isSequence ? p.m_align : 0;
+	if (length > header)
+	  setPropertyBytes(p, p.m_offset + header, image + header, length - header);
+	if (p.m_isSequence)
+	  setProperty32(p, 0, OCPI_UTRUNCATE(uint32_t, nElements));
+      } else if (isString) {
+	uint32_t first = 0;
+	memcpy(&first, image, std::min(length, sizeof(first)));
+	if (length > 4)
+	  setPropertyBytes(p, p.m_offset + 4, image + 4, length - 4);
+	setProperty32(p, 0, first);
+      } else
+	switch (p.m_nBits) {
+	case 8:
+	  setProperty8(p, 0, *image); break;
+	case 16:
+	  setProperty16(p, 0, *(uint16_t *)image); break;
+	case 32:
+	  setProperty32(p, 0, *(uint32_t *)image); break;
+	case 64:
+	  setProperty64(p, 0, *(uint64_t *)image); break;
+	default:;
+	}
+      if (cache)
+	memcpy(cache, image, length);
+      if (p.m_writeSync)
+	propertyWritten(p.m_ordinal);
+    }
     bool Worker::getProperty(unsigned ordinal, std::string &a_name, std::string &value,
 			     bool *unreadablep, bool hex, bool *cachedp, bool uncached) {
       unsigned nProps;
@@ -336,9 +443,7 @@ namespace OCPI {
 	return false;
       OU::Property &p = props[ordinal];
       a_name = p.m_name;
-      if (p.m_isReadable || p.m_isParameter ||
-	  (p.m_isWritable && !p.m_isVolatile && m_cache.size() > p.m_ordinal &&
-	   m_cache[p.m_ordinal])) {
+      if (hasPropertyValue(p)) {
 	if (unreadablep)
 	  *unreadablep = false;
 	if (cachedp)
@@ -359,6 +464,71 @@ namespace OCPI {
       getPropertyValue(p, value, hex, false, uncached);
       return true;
     }
+    static const char
+      *workerCounterNames[] = { "runs", "not_ready", "run_time_ns", "max_run_time_ns" },
+      *portCounterNames[] = { "messages", "bytes", "blocked" };
+    static const unsigned
+      nWorkerCounters = sizeof(workerCounterNames)/sizeof(*workerCounterNames),
+      nPortCounters = sizeof(portCounterNames)/sizeof(*portCounterNames);
+    static uint64_t ticks2ns(uint64_t ticks) {
+      OCPI::OS::Time t(ticks);
+      return (uint64_t)t.seconds() * OCPI::OS::Time::nsPerSecond + t.nanoseconds();
+    }
+    unsigned Worker::
+    nCounters(const OU::Worker &impl) {
+      return nWorkerCounters + impl.nPorts() * nPortCounters;
+    }
+    void Worker::
+    counterName(const OU::Worker &impl, unsigned n, std::string &a_name) {
+      assert(n < nCounters(impl));
+      if (n < nWorkerCounters)
+	OU::format(a_name, "ocpi_%s", workerCounterNames[n]);
+      else {
+	n -= nWorkerCounters;
+	OU::format(a_name, "ocpi_%s_%s", impl.metaPort(n / nPortCounters).m_name.c_str(),
+		   portCounterNames[n % nPortCounters]);
+      }
+    }
+    bool Worker::
+    getCounter(unsigned n, std::string &a_name, std::string &value, bool *unreadablep) {
+      if (n >= nCounters(*this))
+	return false;
+      counterName(*this, n, a_name);
+      uint64_t val = 0;
+      bool unreadable = !hasCounters();
+      if (!unreadable) {
+	if (n < nWorkerCounters) {
+	  const WorkerCounters &c = m_counters;
+	  // The counters are read without locking: single values are never torn on
+	  // 64 bit platforms and are merely stale if read during a run.
+	  switch (n) {
+	  case 0: val = c.m_runs; break;
+	  case 1: val = c.m_notReady; break;
+	  case 2: val = ticks2ns(c.m_runTime); break;
+	  default: val = ticks2ns(c.m_maxRunTime);
+	  }
+	} else {
+	  n -= nWorkerCounters;
+	  Port *p = findPort(metaPort(n / nPortCounters).m_name.c_str());
+	  if (p) {
+	    const PortCounters &c = p->counters();
+	    switch (n % nPortCounters) {
+	    case 0: val = c.m_messages; break;
+	    case 1: val = c.m_bytes; break;
+	    default: val = c.m_blocked;
+	    }
+	  } else
+	    unreadable = true;
+	}
+      }
+      if (unreadable && !unreadablep)
+	throw OU::Error("Counter '%s' of worker '%s' is unavailable", a_name.c_str(),
+			name().c_str());
+      if (unreadablep)
+	*unreadablep = unreadable;
+      OU::format(value, "%" PRIu64, val);
+      return true;
+    }
     void Worker::setProperty(unsigned ordinal, OU::Value &value) {
       OU::Property &prop(property(ordinal));
       setPropertyValue(prop, value);
@@ -367,6 +537,54 @@ namespace OCPI {
       OU::Property &prop(property(ordinal));
       setPropertyValue(prop, value);
     }
+    // Values that can be batched are plain scalars and arrays, whose image is just the
+    // data in the value, and which are accessed normally in the property space.
+    static bool
+    isBatchable(const OU::Property &p, const OU::Property *firstRaw) {
+      return !p.m_isSequence && !p.m_isIndirect && p.m_baseType != OA::OCPI_String &&
+	p.m_baseType != OA::OCPI_Struct && p.m_baseType != OA::OCPI_Type &&
+	(!firstRaw || p.m_ordinal < firstRaw->m_ordinal);
+    }
+    void Worker::
+    setPropertyValues(size_t nValues, const unsigned *ordinals, const OU::Value *const *values) {
+      std::vector<uint8_t> image;       // the image of the batch being assembled
+      const OU::Property *first = NULL, // the first property in the batch
+	*last = NULL;                    // the last property in the batch
+      for (size_t n = 0; n <= nValues; n++) {
+	const OU::Property *p = n < nValues ? &property(ordinals[n]) : NULL;
+	bool batchable = p && isBatchable(*p, m_firstRaw);
+	if (first &&
+	    (!batchable || p->m_offset != first->m_offset + image.size() ||
+	     p->m_elementBytes != first->m_elementBytes ||
+	     p->m_writeError != first->m_writeError || last->m_writeSync)) {
+	  ocpiDebug("Writing %zu bytes of properties '%s' to '%s' of worker '%s'", image.size(),
+		    first->cname(), last->cname(), name().c_str());
+	  setPropertyBytes(*first, first->m_offset, &image[0], image.size(), 0);
+	  if (last->m_writeSync)
+	    propertyWritten(last->m_ordinal);
+	  first = NULL;
+	}
+	if (!p)
+	  break;
+	const OU::Value &v = *values[n];
+	if (!batchable) {
+	  setPropertyValue(*p, v);
+	  continue;
+	}
+	checkWritable(*p);
+	const uint8_t *data = p->m_arrayRank ? v.m_pUChar : &v.m_UChar;
+	size_t nBytes = p->m_arrayRank ? v.m_nTotal * p->m_elementBytes : p->m_nBytes;
+	if (!first) {
+	  first = p;
+	  image.clear();
+	}
+	last = p;
+	image.insert(image.end(), data, data + nBytes);
+	uint8_t *cache = cacheFor(*p);
+	if (cache)
+	  memcpy(cache, data, nBytes);
+      }
+    }
     // batch setting with lots of error checking - all or nothing
     void Worker::setProperties(const OA::PValue *props) {
       if (props)
@@ -461,6 +679,9 @@ namespace OCPI {
 	controlOperation(op);
 	if (ct.next != NONE)
 	  setControlState(ct.next);
+	// Container threads waiting for events must see the new state
+	if (application() && application()->container().getEventManager())
+	  DataTransfer::EventManager::wake();
       } else
 	throw
 	  OU::Error("Control operation '%s' failed on worker '%s%s%s' in state: '%s'",
@@ -472,6 +693,24 @@ namespace OCPI {
 	a->container().start();
       return false;
     }
+    // Release the worker and initialize it again (the release control operation goes back
+    // to the EXISTS state), so it can be restarted without being recreated.
+    // Input at local ports, and output held back for aggregation, is discarded in between
+    // so the next run does not see old data.
+    void Worker::reinitialize() {
+      if (getControlState() == OU::Worker::OPERATING)
+	controlOp(OU::Worker::OpStop);
+      if (getControlState() != OU::Worker::EXISTS)
+	controlOp(OU::Worker::OpRelease);
+      for (unsigned n = 0; m_ports && n < m_nPorts; n++) {
+	Port *p = findPort(metaPort(n).cname());
+	if (p) {
+	  p->discardInput();
+	  p->discardOutput();
+	}
+      }
+      controlOp(OU::Worker::OpInitialize);
+    }
     bool Worker::beforeStart() {
       return getControlState() == INITIALIZED;
     }
@@ -0,0 +1,156 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for the layout of RCC worker ports.
+ * A many-port worker context is allocated as the RCC container does, and each port goes
+ * through the per-message cycle of the container delivering a buffer, the worker
+ * consuming it and producing output, and the container advancing it.  This is timed
+ * for the current RCCPort layout and for the previous one (unaligned, with rarely used
+ * fields inline), both with one thread doing all the ports and with several threads
+ * doing interleaved ports, as the dispatch thread and task threads do.
+ *
+ * Usage: rccPortBench [ports [threads [rounds]]]
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <OcpiOsTimer.h>
+#include <OcpiOsMisc.h>
+#include <OcpiUtilThreadPool.h>
+#define WORKER_INTERNAL
+#include "RCC_Worker.h"
+
+namespace OS = OCPI::OS;
+namespace OU = OCPI::Util;
+namespace OR = OCPI::RCC;
+
+// The port layout before it was arranged by cache lines
+struct OldBuffer {
+  void *data;
+  size_t maxLength;
+  OR::RCCPartInfo *partInfo;
+  size_t length_;
+  OR::RCCOpCode opCode_;
+  size_t direct_;
+  OR::RCCBoolean isNew_;
+  void *containerPort, *portBuffer;
+};
+struct OldPort {
+  OldBuffer current;
+  struct {
+    size_t length;
+    union { OR::RCCOpCode operation, exception; } u;
+  } input, output;
+  OR::RCCPortMethod *callBack;
+  size_t connectedCrewSize;
+  OR::RCCBoolean useDefaultLength_;
+  size_t defaultLength_;
+  OR::RCCBoolean useDefaultOpCode_;
+  OR::RCCOpCode defaultOpCode_;
+  void *containerPort, *userPort, *sequence, *metaPort;
+};
+
+template <class P> struct Ports {
+  P *ports;
+  size_t nPorts, nThreads, rounds;
+  uint8_t buffer[64];
+  // One message through each port of this thread for each round
+  void operator()(size_t thread) {
+    for (size_t r = 0; r < rounds; r++) {
+      for (size_t n = thread; n < nPorts; n += nThreads) {
+	P &p = ports[n];
+	// The container delivers a buffer
+	p.current.data = buffer;
+	p.current.length_ = (r + n) & 0xfff;
+	p.current.opCode_ = (OR::RCCOpCode)r;
+	p.current.isNew_ = true;
+	const_cast<size_t &>(p.input.length) = p.current.length_;
+	const_cast<OR::RCCOpCode &>(p.input.u.operation) = p.current.opCode_;
+	// The worker consumes it and produces output
+	p.output.length = p.input.length;
+	p.output.u.operation = p.input.u.operation;
+	p.current.direct_ = 0;
+	// The container advances the port
+	if (p.containerPort && p.current.data)
+	  p.current.length_ = p.output.length;
+	p.current.data = NULL;
+      }
+      asm volatile("" ::: "memory");
+    }
+  }
+};
+
+template <class P> static void
+chunk(void *arg, size_t, size_t begin, size_t end) {
+  for (size_t t = begin; t < end; t++)
+    (*(Ports<P> *)arg)(t);
+}
+
+static double
+seconds(OS::Time t) {
+  return t.seconds() + t.nanoseconds() / 1e9;
+}
+
+// Return nanoseconds per port cycle
+template <class P> static double
+run(size_t nPorts, unsigned nThreads, size_t rounds) {
+  void *mem;
+  if (posix_memalign(&mem, RCC_CACHE_LINE_SIZE, nPorts * sizeof(P)))
+    abort();
+  memset(mem, 0, nPorts * sizeof(P));
+  Ports<P> ports;
+  ports.ports = (P *)mem;
+  ports.nPorts = nPorts;
+  ports.nThreads = nThreads;
+  ports.rounds = rounds;
+  for (size_t n = 0; n < nPorts; n++)
+    ports.ports[n].containerPort = (OR::Port *)(ports.ports + n); // any non-NULL value
+  OU::ThreadPool pool(nThreads - 1);
+  OS::Time start = OS::Time::now();
+  pool.run(nThreads, 1, chunk<P>, &ports);
+  double t = seconds(OS::Time::now() - start);
+  free(mem);
+  return t * 1e9 / ((double)rounds * (double)nPorts);
+}
+
+int main(int argc, char **argv) {
+  std::vector<unsigned> cpus;
+  OS::getProcessors(cpus);
+  size_t
+    nPorts = argc > 1 ? strtoul(argv[1], NULL, 0) : 32,
+    rounds = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000000;
+  unsigned
+    maxThreads = argc > 2 ? (unsigned)atoi(argv[2]) : (cpus.size() < 4 ? (unsigned)cpus.size() : 4);
+  if (!maxThreads)
+    maxThreads = 1;
+  printf("%zu ports, %zu rounds, RCCPort is %zu bytes (was %zu), %u processors available\n",
+	 nPorts, rounds, sizeof(OR::RCCPort), sizeof(OldPort), (unsigned)cpus.size());
+  for (unsigned nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+    double
+      oldNs = run<OldPort>(nPorts, nThreads, rounds),
+      newNs = run<OR::RCCPort>(nPorts, nThreads, rounds);
+    printf("%2u threads: previous layout %7.2f ns/message, current layout %7.2f ns/message"
+	   "  speedup %5.2f\n", nThreads, oldNs, newNs, oldNs / newNs);
+  }
+  return 0;
+}
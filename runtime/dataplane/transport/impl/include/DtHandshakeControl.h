@@ -258,10 +258,23 @@ namespace OCPI {
     uint8_t opCode;
     uint8_t end;
     uint8_t truncate;
+    uint8_t aggregate;     // data is a sequence of messages, each with an AggregateHeader
     uint32_t xferMetaData; // the compressed version when required.
     uint32_t timestamp;
   };
 
+  // Header for each message in an aggregate buffer, which packs several small messages
+  // into one transfer.  Each header is aligned on an 8 byte boundary.
+  struct AggregateHeader {
+    uint32_t length;
+    uint8_t  opCode;
+    uint8_t  pad[3];
+  };
+  // Space used by a message in an aggregate buffer
+  inline size_t aggregateSize(size_t length) {
+    return (sizeof(AggregateHeader) + length + 7) & ~(size_t)7;
+  }
+
 
   struct BufferMetaData {
     RplMetaData              ocpiMetaDataWord;      // OCPI compatible metadata word
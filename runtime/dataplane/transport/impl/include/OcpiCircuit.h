@@ -172,6 +172,13 @@ namespace OCPI {
        *********************************/
       void startBufferTransfer( Buffer* src_buf );
 
+      /**********************************
+       * Start the transfer of a run of consecutive queued buffers as one transfer
+       * when the transfer controller can do that.  Returns the number of buffers
+       * started, which is zero when they must be transferred one at a time.
+       *********************************/
+      uint32_t startQueuedRun( CU::VList& queue );
+
       /***********************************
        * This method is used to send an input buffer thru an output port with Zero copy, 
        * if possible
@@ -37,6 +37,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits>
+#include <map>
+#include <vector>
+#include <OcpiOsTimer.h>
 #include <OcpiList.h>
 #include <OcpiParentChild.h>
 #include <OcpiTimeEmit.h>
@@ -128,6 +131,8 @@ namespace OCPI {
        * Reteives the next available input buffer.
        *********************************/
       BufferUserFacet* getNextFullInputBuffer(uint8_t *&data, size_t &length, uint8_t &opcode);
+      // Is this input buffer an aggregate, holding other messages than the one presented?
+      bool isAggregated(BufferUserFacet &b);
       // For use by bridge ports
       BufferUserFacet* getNextEmptyInputBuffer(uint8_t *&data, size_t &length);
       void sendInputBuffer(BufferUserFacet &b, size_t length, uint8_t opcode);
@@ -209,7 +214,7 @@ namespace OCPI {
        * as available.
        *********************************/
       int32_t inputAvailable( Buffer* input_buf );
-      inline void releaseInputBuffer(BufferUserFacet *ib) { (void)inputAvailable(static_cast<Buffer*>(ib)); }
+      void releaseInputBuffer(BufferUserFacet *ib);
 
       /**********************************
        * Send an output buffer
@@ -217,6 +222,19 @@ namespace OCPI {
       void sendOutputBuffer(BufferUserFacet* buf, size_t length, uint8_t opcode,
 			    bool end = false, bool data = true);
 
+      /**********************************
+       * Small message aggregation on an output port: messages are packed into transport
+       * buffers, each after an AggregateHeader, and a buffer is sent when the next message
+       * does not fit, at the end of data, or when its first message has waited "timeout"
+       * microseconds.  Zero disables it.  Input ports always unpack aggregate buffers.
+       *********************************/
+      void setAggregation(uint32_t timeout);
+      // Send the partially filled aggregate buffer if it has timed out, or now if "force"
+      void flushAggregate(bool force);
+      // Discard messages not yet sent in an aggregate, keeping any open aggregate buffer
+      // (empty) since output buffers are used in order.  Returns how many were discarded.
+      unsigned discardAggregate();
+
 
       // Advanced buffer management
     protected:
@@ -248,6 +266,15 @@ namespace OCPI {
        **********************************/
       void allocateBufferResources();
 
+      // Send a buffer with the given data length (plain or aggregate)
+      void sendBuffer(Buffer *b, size_t length, uint8_t opcode, bool aggregate);
+      // Aggregation helpers for the output side
+      void sendAggregate();
+      bool placePending();
+      void sendAggregated(size_t length, uint8_t opcode, bool end);
+      // Present the next message of the aggregate input buffer being unpacked
+      Buffer *nextAggregated(uint8_t *&data, size_t &length, uint8_t &opcode);
+
       // Our intialized flag
       bool m_initialized;
 
@@ -314,6 +341,25 @@ namespace OCPI {
       uint32_t m_bufferCount;
       Buffer** m_buffers; // [MAX_BUFFERS];
 
+      // Small message aggregation, output side.  The worker writes a message either in
+      // place in a fresh buffer (m_aggDirect), or, when an aggregate buffer is open, into
+      // m_aggStaging, from where it is copied into the aggregate when sent.  Thus an open
+      // aggregate buffer is never being written by the worker and can be sent at any time.
+      bool                 m_aggregate;
+      OCPI::OS::Time       m_aggTimeout, m_aggDeadline;
+      Buffer              *m_aggBuffer;  // open aggregate buffer
+      size_t               m_aggUsed;    // bytes used in the open aggregate buffer
+      Buffer              *m_aggDirect;  // fresh buffer being written in place
+      std::vector<uint8_t> m_aggStaging;
+      bool                 m_aggPending; // a staged message is waiting for a buffer
+      size_t               m_aggPendingLength;
+      uint8_t              m_aggPendingOpCode;
+      bool                 m_aggPendingEnd;
+      // Small message aggregation, input side
+      Buffer              *m_aggInput;   // aggregate input buffer being unpacked
+      size_t               m_aggInOffset, m_aggInLength;
+      std::map<Buffer *, unsigned> m_aggInHeld; // messages not yet released per buffer
+
 
 
       /**********************************
@@ -65,6 +65,7 @@ namespace OCPI {
       FlagIsMeta,                // Flag is compressed metadata
       FlagIsCounting,            // Flag is an incrementing counter
       FlagIsMetaOptional,        // This mode is optional: FIXME have a more general scheme
+      FlagCanAggregate,          // Input port can unpack aggregated messages
       MaxOption
     };
     
@@ -171,6 +171,13 @@ namespace OCPI {
         // Destructor
         virtual ~TransferTemplateGeneratorPattern1();
 
+        // Add the meta-data and flag transfers that follow an output buffer's data
+        static void addMetaDataTransfers(DataTransfer::XferRequest &xfer,
+                                         OCPI::DataTransport::Port* s_port,
+                                         OCPI::DataTransport::Port* t_port,
+                                         PortMetaData::OutputPortBufferControlMap &output_offsets,
+                                         PortMetaData::InputPortBufferControlMap &input_offsets);
+
     protected:
 
         // Create transfers for output port
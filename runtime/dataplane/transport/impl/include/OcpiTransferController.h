@@ -33,6 +33,7 @@
 #ifndef OCPI_DataTransport_TransferController_H_
 #define OCPI_DataTransport_TransferController_H_
 
+#include <map>
 #include <OcpiUtilMisc.h>
 #include <OcpiTransferTemplate.h>
 #include <OcpiBuffer.h>
@@ -88,6 +89,14 @@ namespace OCPI {
        *********************************/
       virtual bool canTransferBufferWhileOthersAreQueued();
 
+      /**********************************
+       * This initiates one combined transfer for a run of consecutive full buffers of an
+       * output port, when the controller supports that and the buffers allow it.  Returns
+       * how many of the buffers were produced, zero meaning they must be produced one
+       * at a time.
+       *********************************/
+      virtual unsigned produceRun( Buffer** /*buffers*/, unsigned /*n*/ ) { return 0; }
+
       /**********************************
        * This method gets the next available buffer from the specified output port
        *********************************/
@@ -307,7 +316,7 @@ namespace OCPI {
     {
     public:
       TransferController1(){};
-      virtual ~TransferController1(){};
+      virtual ~TransferController1();
       TransferController1( OCPI::DataTransport::PortSet* output, OCPI::DataTransport::PortSet* input, bool whole_ss );
       virtual TransferController* createController( 
                                                    OCPI::DataTransport::PortSet* output, 
@@ -331,8 +340,19 @@ namespace OCPI {
        *********************************/
       virtual Buffer*  consume( Buffer* buffer );
 
+      /**********************************
+       * This combines the data of consecutive buffers that are contiguous at both ends
+       * into a single transfer, followed by each buffer's meta-data and flag.
+       *********************************/
+      virtual unsigned produceRun( Buffer** buffers, unsigned n );
+
     protected:
 
+      // Combined templates, created on first use, keyed by output port, output tid,
+      // input tid and number of buffers, and limited in number per input buffer.
+      enum { MAX_RUN_TEMPLATES_PER_BUFFER = 4 };
+      std::map<uint64_t, OcpiTransferTemplate*> m_runTemplates;
+
     };
 
     // This controller is used for pattern1 when either the output or input port(s) are  ActiveFlowControl
@@ -385,6 +405,11 @@ namespace OCPI {
        *********************************/
       virtual void modifyOutputOffsets( Buffer* me, Buffer* new_buffer, bool reverse );
 
+      /**********************************
+       * Buffers are produced one at a time by this controller.
+       *********************************/
+      unsigned produceRun( Buffer**, unsigned ) { return 0; }
+
       /**********************************
        * This marks the input buffer as "Empty" and informs all interested outputs that
        * the input is now available.
@@ -439,6 +464,11 @@ namespace OCPI {
        *********************************/
       virtual int produce( Buffer* buffer, bool bcast=false );
 
+      /**********************************
+       * Buffers are produced one at a time by this controller.
+       *********************************/
+      unsigned produceRun( Buffer**, unsigned ) { return 0; }
+
       /**********************************
        * Modify
        *********************************/
@@ -602,6 +632,11 @@ namespace OCPI {
          *********************************/
         virtual int produce( Buffer* buffer, bool bcast=false );
 
+        /**********************************
+         * Buffers are produced one at a time by this controller.
+         *********************************/
+        unsigned produceRun( Buffer**, unsigned ) { return 0; }
+
 
         /**********************************
          * This method gets the next available buffer from the specified input port
@@ -35,6 +35,7 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <OcpiOsTimer.h>
 #include <OcpiOsMutex.h>
 #include <OcpiParentChild.h>
@@ -42,6 +43,7 @@
 #include "XferException.h"
 #include <DtIntEventHandler.h>
 #include "XferEndPoint.h"
+#include "XferServices.h"
 #include <OcpiConnectionMetaData.h>
 #include <OcpiCircuit.h>
 #include <OcpiTransportConstants.h>
@@ -261,9 +263,21 @@ namespace OCPI {
       DataTransfer::EndPoint*  m_CSendpoint;
       ContainerComms *m_CScomms;
 
-      // Cached transfer list
-      static OCPI::Util::VList  m_cached_transfers;
-      static OCPI::Util::VList   active_transfers;
+      // Transfers for clearing remote mailboxes, reposted for each use
+      typedef std::pair<DataTransfer::EndPoint*, size_t> MailboxKey;
+      typedef std::map<MailboxKey, DataTransfer::XferRequest*> CachedTransfers;
+      CachedTransfers m_cachedTransfers;
+      // One-time transfers in flight, with the services that created them
+      typedef std::map<DataTransfer::XferRequest*, DataTransfer::XferServices*> ActiveTransfers;
+      ActiveTransfers m_activeTransfers;
+      // Completed one-time transfers, reset for reuse, by the services that created them
+      typedef std::map<DataTransfer::XferServices*, std::vector<DataTransfer::XferRequest*> >
+	TransferPool;
+      TransferPool m_transferPool;
+      DataTransfer::XferCompletionQueue m_completions;
+      void reapTransfers();
+      DataTransfer::XferRequest &getTransfer(DataTransfer::XferServices &services);
+      DataTransfer::XferServices &getServices(DataTransfer::EndPoint &remote);
 
     public:
       // Our transport global class
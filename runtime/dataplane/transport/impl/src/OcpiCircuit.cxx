@@ -1137,6 +1137,14 @@ uint32_t
 OCPI::DataTransport::Circuit::
 checkQueuedTransfers()
 {
+  // Transfers started in this pass are posted together when the pass is done, so that
+  // several buffers for the same connection can be posted at once (XferServices::postBatch)
+  DataTransfer::XferBatch batch;
+
+  // Send partially filled aggregate buffers whose time is up
+  Port *out = m_outputPs ? getOutputPort() : NULL;
+  if (out && !out->isShadow())
+    out->flushAggregate(false);
 
   uint32_t total=0;
         
@@ -1182,15 +1190,21 @@ checkQueuedTransfers()
 		buffer->getTid(), n_queued );
 #endif
                         
-      m_queuedTransfers[n].remove( buffer );
-      startBufferTransfer( buffer );
-      total--;
+      uint32_t n_run;
+      if ( n_queued > 1 && (n_run = startQueuedRun( m_queuedTransfers[n] )) ) {
+        total -= n_run;
+      } else {
+        m_queuedTransfers[n].remove( buffer );
+        startBufferTransfer( buffer );
+        total--;
+      }
     }
   }
 
   // Now check to see if there are any I/O ZCopies to deal with
   checkIOZCopyQ();
 
+  batch.post();
   return total;
 }
 
@@ -1275,6 +1289,39 @@ startBufferTransfer( Buffer* src_buf )
 }
 
 
+/**********************************
+ * Several output buffers are queued when the inputs fall behind.  When they become
+ * available, send the ones that are consecutive in one transfer rather than one each.
+ *********************************/
+uint32_t
+OCPI::DataTransport::Circuit::
+startQueuedRun( CU::VList& queue )
+{
+  if ( m_openCircuit || getQualifiedInputPortSetCount() != 1 ) {
+    return 0;
+  }
+  Buffer* run[MAX_BUFFERS];
+  uint32_t n_run;
+  for ( n_run = 0; n_run < queue.getElementCount() && n_run < MAX_BUFFERS; n_run++ ) {
+    run[n_run] = static_cast<Buffer*>(queue.getEntry(n_run));
+    if ( run[n_run]->getPort()->isShadow() || run[n_run]->getMetaData()->broadCast == 1 ) {
+      break;
+    }
+  }
+  if ( n_run < 2 ||
+       !(n_run = getQualifiedInputPortSet(0)->getTxController()->produceRun( run, n_run )) ) {
+    return 0;
+  }
+  for ( uint32_t n = 0; n < n_run; n++ ) {
+    queue.remove( run[n] );
+    run[n]->setInUse( false );
+    m_lastPortSet++;
+    m_lastPortSet = m_lastPortSet%getInputPortSetCount();
+  }
+  return n_run;
+}
+
+
 
 /***********************************
  * This method braodcasts a buffer to all of the input ports in 
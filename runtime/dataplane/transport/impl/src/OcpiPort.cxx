@@ -76,6 +76,9 @@ void Port::reset()
   m_sequence = 0;
   m_lastBufferOrd=MAXBUFORD;
   m_nextBridgeOrd=0;
+  m_aggBuffer = m_aggDirect = m_aggInput = NULL;
+  m_aggPending = false;
+  m_aggInHeld.clear();
 
   getCircuit()->release();
   // FIXME:  release actually may call the destructor on this object
@@ -186,6 +189,9 @@ Port::Port(PortMetaData* data, PortSet* ps)
     m_portSet(ps),
     m_bufferCount(ps->getBufferCount()),
     m_buffers(new Buffer*[m_bufferCount]),
+    m_aggregate(false), m_aggBuffer(NULL), m_aggUsed(0), m_aggDirect(NULL),
+    m_aggPending(false), m_aggPendingLength(0), m_aggPendingOpCode(0), m_aggPendingEnd(false),
+    m_aggInput(NULL), m_aggInOffset(0), m_aggInLength(0),
     m_zCopyBufferQ(0)
 {
   ocpiCheck(m_bufferCount <= MAX_BUFFERS);
@@ -1425,7 +1431,8 @@ bool
 Port::
 hasFullInputBuffer()
 {
-
+  if (m_aggInput)
+    return true;
   if ( getCircuit()->isCircuitOpen() ) {
     return false;
   }
@@ -1477,6 +1484,8 @@ getNextFullInputBuffer(uint8_t *&data, size_t &length, uint8_t &opcode)
 {
   Circuit *c = getCircuit();
   OU::SelfAutoMutex guard(c); // FIXME: refactor to make this a circuit method
+  if (m_aggInput)
+    return nextAggregated(data, length, opcode);
   if (!hasFullInputBuffer())
     return NULL;
   TransferController* txc = getPortSet()->getTxController();
@@ -1487,6 +1496,12 @@ getNextFullInputBuffer(uint8_t *&data, size_t &length, uint8_t &opcode)
       setEOS();
     if (buf && buf->getMetaData()->endOfCircuit)
       c->m_status = Circuit::Disconnecting;
+    if (buf->getMetaData()->ocpiMetaDataWord.aggregate) {
+      m_aggInput = buf;
+      m_aggInOffset = 0;
+      m_aggInLength = buf->getDataLength();
+      return nextAggregated(data, length, opcode);
+    }
 
     data = (uint8_t*)buf->getBuffer(); // cast off the volatile
     opcode = (uint8_t)buf->getMetaData()->ocpiMetaDataWord.opCode;
@@ -1504,6 +1519,51 @@ getNextFullInputBuffer(uint8_t *&data, size_t &length, uint8_t &opcode)
   return buf;
 }
 
+// Present the next message in the aggregate input buffer as if it were a buffer of its own.
+// The buffer is consumed when all its messages have been presented and released.
+Buffer *Port::
+nextAggregated(uint8_t *&data, size_t &length, uint8_t &opcode) {
+  Buffer *b = m_aggInput;
+  uint8_t *base = (uint8_t *)b->getBuffer(); // cast off the volatile
+  AggregateHeader &h = *(AggregateHeader *)(base + m_aggInOffset);
+  if (m_aggInOffset + aggregateSize(h.length) > m_aggInLength)
+    throw OU::Error("Aggregated message at offset %zu (length %" PRIu32 ") overruns its buffer "
+		    "(length %zu)", m_aggInOffset, h.length, m_aggInLength);
+  data = (uint8_t *)(&h + 1);
+  length = h.length;
+  opcode = h.opCode;
+  m_aggInOffset += aggregateSize(h.length);
+  if (m_aggInOffset >= m_aggInLength)
+    m_aggInput = NULL;
+  m_aggInHeld[b]++;
+  ocpiDebug("Getting aggregated message from buffer %p on port %p data %p op %u len %zu",
+	    b, this, data, opcode, length);
+  return b;
+}
+
+bool Port::
+isAggregated(BufferUserFacet &b) {
+  OU::SelfAutoMutex guard(getCircuit());
+  return m_aggInHeld.find(static_cast<Buffer*>(&b)) != m_aggInHeld.end();
+}
+
+void Port::
+releaseInputBuffer(BufferUserFacet *ib) {
+  Buffer *b = static_cast<Buffer*>(ib);
+  if (m_aggInHeld.size()) {
+    OU::SelfAutoMutex guard(getCircuit());
+    std::map<Buffer *, unsigned>::iterator it = m_aggInHeld.find(b);
+    if (it != m_aggInHeld.end()) {
+      if (--it->second)
+	return;
+      m_aggInHeld.erase(it);
+      if (b == m_aggInput) // more messages to unpack
+	return;
+    }
+  }
+  (void)inputAvailable(b);
+}
+
 // For use by bridge ports, meaning this port is passive
 BufferUserFacet* Port::
 getNextEmptyInputBuffer(uint8_t *&data, size_t &length) {
@@ -1523,6 +1583,7 @@ void Port::
 sendInputBuffer(BufferUserFacet &ib, size_t length, uint8_t opcode) {
   OU::SelfAutoMutex guard(getCircuit());
   Buffer &b = *static_cast<Buffer *>(&ib);
+  b.getMetaData()->ocpiMetaDataWord.aggregate = 0;
   b.getMetaData()->ocpiMetaDataWord.opCode = opcode;
   b.getMetaData()->ocpiMetaDataWord.length = OCPI_UTRUNCATE(uint32_t,length);
   b.markBufferFull();
@@ -1586,6 +1647,23 @@ BufferUserFacet*
 Port::
 getNextEmptyOutputBuffer(uint8_t *&data, size_t &length)
 {
+  if (m_aggregate) {
+    OU::SelfAutoMutex guard(getCircuit());
+    if (!placePending())
+      return NULL;
+    flushAggregate(false);
+    if (m_aggBuffer) {
+      // Messages go to the staging area, to be appended to the open aggregate when sent
+      data = &m_aggStaging[0];
+      length = m_aggStaging.size();
+      return m_aggBuffer;
+    }
+    if ((m_aggDirect = getNextEmptyOutputBuffer())) {
+      data = (uint8_t*)m_aggDirect->getBuffer();
+      length = m_aggDirect->getLength();
+    }
+    return m_aggDirect;
+  }
   Buffer *buf = getNextEmptyOutputBuffer();
   if (buf) {
     data = (uint8_t*)buf->getBuffer(); // cast off the volatile
@@ -1657,7 +1735,10 @@ void
 Port::
 sendZcopyInputBuffer(BufferUserFacet &buf, size_t len, uint8_t op, bool /*end*/)
 {
+  if (m_aggregate)
+    flushAggregate(true); // keep messages in order
   Buffer *src_buf = static_cast<Buffer*>(&buf);
+  src_buf->getMetaData()->ocpiMetaDataWord.aggregate = 0;
   src_buf->getMetaData()->ocpiMetaDataWord.length = (uint32_t)len;
   src_buf->getMetaData()->ocpiMetaDataWord.opCode = op;
   src_buf->getMetaData()->ocpiMetaDataWord.timestamp = 0x01234567;
@@ -1680,14 +1761,151 @@ getBufferLength()
 
 void 
 Port::
-sendOutputBuffer( BufferUserFacet* buf, size_t length, uint8_t opcode, bool /*end*/,
+sendOutputBuffer( BufferUserFacet* buf, size_t length, uint8_t opcode, bool end,
 		  bool /*data*/)
 {
   if (length > getBufferLength())
     throw OU::Error("Buffer being sent with data length (%zu) exceeding buffer length (%zu)",
 		    length, getBufferLength());
-  Buffer *b = static_cast<Buffer *>(buf);
+  if (m_aggregate)
+    sendAggregated(length, opcode, end);
+  else
+    sendBuffer(static_cast<Buffer *>(buf), length, opcode, false);
+}
+
+void Port::
+setAggregation(uint32_t timeout) {
+  OU::SelfAutoMutex guard(getCircuit());
+  flushAggregate(true);
+  if ((m_aggregate = timeout != 0)) {
+    m_aggTimeout = OS::Time(timeout / 1000000, (timeout % 1000000) * 1000);
+    m_aggStaging.resize(getBufferLength());
+    ocpiInfo("Aggregating small messages on port %p, sent after at most %" PRIu32 "us",
+	     this, timeout);
+  }
+}
+
+void Port::
+flushAggregate(bool force) {
+  if (!m_aggBuffer) // avoid locking when there is nothing to do
+    return;
+  OU::SelfAutoMutex guard(getCircuit());
+  // An open aggregate can be empty after discardAggregate, and is then kept open
+  if (m_aggBuffer && m_aggUsed && (force || OS::Time::now() >= m_aggDeadline))
+    sendAggregate();
+}
+
+unsigned Port::
+discardAggregate() {
+  OU::SelfAutoMutex guard(getCircuit());
+  unsigned n = m_aggPending ? 1 : 0;
+  m_aggPending = false;
+  if (m_aggBuffer) {
+    for (size_t offset = 0; offset < m_aggUsed; n++)
+      offset += aggregateSize(((AggregateHeader *)
+			       ((uint8_t *)m_aggBuffer->getBuffer() + offset))->length);
+    m_aggUsed = 0;
+  }
+  return n;
+}
+
+void Port::
+sendAggregate() {
+  Buffer *b = m_aggBuffer;
+  m_aggBuffer = NULL;
+  sendBuffer(b, m_aggUsed, 0, true);
+}
+
+// Put the staged message into a new buffer, either as the first message of a new aggregate,
+// or by itself if it is large or ends the data.  Return false if there is no buffer yet.
+bool Port::
+placePending() {
+  if (!m_aggPending)
+    return true;
+  Buffer *b = getNextEmptyOutputBuffer();
+  if (!b)
+    return false;
+  m_aggPending = false;
+  uint8_t *base = (uint8_t *)b->getBuffer();
+  size_t length = m_aggPendingLength;
+  if (m_aggPendingEnd || aggregateSize(length) > b->getLength() / 2) {
+    memcpy(base, &m_aggStaging[0], length);
+    sendBuffer(b, length, m_aggPendingOpCode, false);
+  } else {
+    AggregateHeader &h = *(AggregateHeader *)base;
+    h.length = OCPI_UTRUNCATE(uint32_t, length);
+    h.opCode = m_aggPendingOpCode;
+    memcpy(&h + 1, &m_aggStaging[0], length);
+    m_aggBuffer = b;
+    m_aggUsed = aggregateSize(length);
+    m_aggDeadline = OS::Time::now() + m_aggTimeout;
+  }
+  return true;
+}
+
+// Send a message that was written either in place in a fresh buffer, or in the staging area.
+// Messages larger than half a buffer are not worth aggregating and are sent by themselves.
+void Port::
+sendAggregated(size_t length, uint8_t opcode, bool end) {
+  OU::SelfAutoMutex guard(getCircuit());
+  size_t bufferLength = getBufferLength();
+  if (m_aggDirect) {
+    Buffer *b = m_aggDirect;
+    m_aggDirect = NULL;
+    assert(!m_aggBuffer);
+    if (end || aggregateSize(length) > bufferLength / 2)
+      sendBuffer(b, length, opcode, false);
+    else {
+      // This message starts a new aggregate: make room for its header
+      uint8_t *base = (uint8_t *)b->getBuffer();
+      memmove(base + sizeof(AggregateHeader), base, length);
+      AggregateHeader &h = *(AggregateHeader *)base;
+      h.length = OCPI_UTRUNCATE(uint32_t, length);
+      h.opCode = opcode;
+      m_aggBuffer = b;
+      m_aggUsed = aggregateSize(length);
+      m_aggDeadline = OS::Time::now() + m_aggTimeout;
+    }
+    return;
+  }
+  if (m_aggBuffer && !m_aggUsed) {
+    // The open aggregate is empty: this message starts it again, or is sent by itself
+    uint8_t *base = (uint8_t *)m_aggBuffer->getBuffer();
+    if (end || aggregateSize(length) > bufferLength / 2) {
+      Buffer *b = m_aggBuffer;
+      m_aggBuffer = NULL;
+      memcpy(base, &m_aggStaging[0], length);
+      sendBuffer(b, length, opcode, false);
+      return;
+    }
+    m_aggDeadline = OS::Time::now() + m_aggTimeout;
+  }
+  if (m_aggBuffer) {
+    size_t size = aggregateSize(length);
+    if (size <= bufferLength - m_aggUsed && size <= bufferLength / 2) {
+      AggregateHeader &h = *(AggregateHeader *)((uint8_t *)m_aggBuffer->getBuffer() + m_aggUsed);
+      h.length = OCPI_UTRUNCATE(uint32_t, length);
+      h.opCode = opcode;
+      memcpy(&h + 1, &m_aggStaging[0], length);
+      m_aggUsed += size;
+      if (end || bufferLength - m_aggUsed < aggregateSize(0))
+	sendAggregate();
+      return;
+    }
+    sendAggregate();
+  }
+  // The message stays in the staging area until there is a buffer for it
+  m_aggPending = true;
+  m_aggPendingLength = length;
+  m_aggPendingOpCode = opcode;
+  m_aggPendingEnd = end;
+  placePending();
+}
+
+void Port::
+sendBuffer(Buffer *b, size_t length, uint8_t opcode, bool aggregate) {
   // Put the actual opcode and data length in the meta-data
+  b->getMetaData()->ocpiMetaDataWord.aggregate = aggregate ? 1 : 0;
   b->getMetaData()->ocpiMetaDataWord.opCode = opcode;
   b->getMetaData()->ocpiMetaDataWord.length = OCPI_UTRUNCATE(uint32_t,length);
   if (!b->getMetaData()->ocpiMetaDataWord.timestamp)
@@ -489,6 +489,44 @@ TransferTemplateGeneratorPattern1::
 }
 
 
+// Add the transfers that follow the data of an output buffer to an input buffer:
+// the meta-data and then the flag that tells the input the buffer is full.
+void TransferTemplateGeneratorPattern1::
+addMetaDataTransfers(XferRequest &xfer, Port *s_port, Port *t_port,
+		     PortMetaData::OutputPortBufferControlMap &output_offsets,
+		     PortMetaData::InputPortBufferControlMap &input_offsets)
+{
+  DtOsDataTypes::Offset	metaOffset =
+    output_offsets.metaDataOffset +
+    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferMetaData);
+
+  if (t_port->getMetaData()->m_descriptor.options & (1 << FlagIsMeta))
+    xfer.copy(metaOffset + OCPI_OFFSETOF(DDT::Offset, RplMetaData, xferMetaData),
+	      input_offsets.metaDataOffset +
+	      s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, uint32_t), 
+	      sizeof(OCPI::OS::uint32_t),
+	      XferRequest::FlagTransfer);
+  else {
+    // Create the transfer that copys the output meta-data to the input meta-data
+    xfer.copy(metaOffset,
+	      input_offsets.metaDataOffset +
+	      s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferMetaData),
+	      sizeof(OCPI::OS::int64_t),
+	      XferRequest::MetaDataTransfer);
+
+    // Create the transfer that copys the output state to the remote input state
+    xfer.copy(t_port->getMetaData()->m_descriptor.options & (1 << FlagIsCounting) ?
+	      metaOffset + OCPI_OFFSETOF(DDT::Offset, RplMetaData, timestamp) :
+	      output_offsets.localStateOffset +
+	      OCPI_SIZEOF(DDT::Offset, BufferState) * MAX_PCONTRIBS +
+	      s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferState),
+	      input_offsets.localStateOffset +
+	      s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferState),
+	      sizeof(BufferState),
+	      XferRequest::FlagTransfer);
+  }
+}
+
 // Create transfers for output port for the pattern w[p] -> w[p]
 void TransferTemplateGeneratorPattern1::createOutputTransfers( Port* s_port, PortSet* input,
                                                               TransferController* cont )
@@ -573,36 +611,7 @@ void TransferTemplateGeneratorPattern1::createOutputTransfers( Port* s_port, Por
 			   input_offsets->bufferOffset,
 			   output_offsets->bufferSize,
 			   XferRequest::DataTransfer );
-
-	  DtOsDataTypes::Offset	metaOffset =
-	    output_offsets->metaDataOffset +
-	    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferMetaData);
-
-	  if (t_port->getMetaData()->m_descriptor.options & (1 << FlagIsMeta))
-	    ptransfer->copy(metaOffset + OCPI_OFFSETOF(DDT::Offset, RplMetaData, xferMetaData),
-			    input_offsets->metaDataOffset +
-			    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, uint32_t), 
-			    sizeof(OCPI::OS::uint32_t),
-			    XferRequest::FlagTransfer);
-	  else {
-	    // Create the transfer that copys the output meta-data to the input meta-data
-	    ptransfer->copy(metaOffset,
-			    input_offsets->metaDataOffset +
-			    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferMetaData),
-			    sizeof(OCPI::OS::int64_t),
-			    XferRequest::MetaDataTransfer);
-
-	    // Create the transfer that copys the output state to the remote input state
-	    ptransfer->copy(t_port->getMetaData()->m_descriptor.options & (1 << FlagIsCounting) ?
-			    metaOffset + OCPI_OFFSETOF(DDT::Offset, RplMetaData, timestamp) :
-			    output_offsets->localStateOffset +
-			    OCPI_SIZEOF(DDT::Offset, BufferState) * MAX_PCONTRIBS +
-			    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferState),
-			    input_offsets->localStateOffset +
-			    s_port->getPortId() * OCPI_SIZEOF(DDT::Offset, BufferState),
-			    sizeof(BufferState),
-			    XferRequest::FlagTransfer);
-	  }
+	  addMetaDataTransfers(*ptransfer, s_port, t_port, *output_offsets, *input_offsets);
         }
         catch( ... ) {
           FORMAT_TRANSFER_EC_RETHROW( s_port, t_port );
@@ -34,6 +34,7 @@
  */
 
 #include <OcpiTransferController.h>
+#include <OcpiTemplateGenerators.h>
 #include <OcpiCircuit.h>
 #include <OcpiPortSet.h>
 #include <OcpiBuffer.h>
@@ -631,6 +632,109 @@ int TransferController1::produce( Buffer* b, bool bcast )
   return temp->getMaxGatedSequence();
 }
 
+TransferController1::~TransferController1()
+{
+  // The transfer requests belong to their transfer services, like those of other templates
+  for (std::map<uint64_t, OcpiTransferTemplate*>::iterator it = m_runTemplates.begin();
+       it != m_runTemplates.end(); it++)
+    delete it->second;
+}
+
+/**********************************
+ * Produce a run of consecutive full output buffers into consecutive empty input
+ * buffers.  The output buffers are allocated as one block, as are the input buffers,
+ * so the data of the whole run is moved by one copy, and then each buffer's meta-data
+ * and flag are written as they would be for a single buffer.  This saves per-transfer
+ * overhead in drivers where it is high (sockets, DMA).
+ **********************************/
+unsigned TransferController1::produceRun( Buffer** buffers, unsigned n )
+{
+  if ( m_wholeOutputSet || m_input->getPortCount() != 1 || n < 2 ) {
+    return 0;
+  }
+  Port* s_port = buffers[0]->getPort();
+  Port* t_port = m_input->getPort(0);
+  unsigned s_tid = buffers[0]->getTid(), t_tid = (unsigned)m_nextTid;
+  PortMetaData::OutputPortBufferControlMap &s_first =
+    s_port->getMetaData()->m_bufferData[s_tid].outputOffsets;
+  PortMetaData::InputPortBufferControlMap &t_first =
+    t_port->getMetaData()->m_bufferData[t_tid].inputOffsets;
+  OU::ResAddr size = s_first.bufferSize;
+
+  // The run stops at the first buffer that is not consecutive, not contiguous, or that
+  // needs something other than a plain transfer.  Neither side may wrap around.
+  unsigned k;
+  for ( k = 0; k < n && s_tid + k < s_port->getBufferCount() &&
+          t_tid + k < m_input->getBufferCount(); k++ ) {
+    Buffer* b = buffers[k];
+    OcpiTransferTemplate* temp = m_templates[s_port->getPortId()][s_tid + k][0][t_tid + k][0][OUTPUT];
+    PortMetaData::OutputPortBufferControlMap &s_off =
+      s_port->getMetaData()->m_bufferData[s_tid + k].outputOffsets;
+    PortMetaData::InputPortBufferControlMap &t_off =
+      t_port->getMetaData()->m_bufferData[t_tid + k].inputOffsets;
+    if ( b->getPort() != s_port || b->getTid() != s_tid + k ||
+         b->getMetaData()->endOfStream || b->m_attachedZBuffer || b->m_zeroCopyFromBuffer ||
+         !temp || temp->m_zCopy || temp->getMaxGatedSequence() ||
+         !t_port->getBuffer(t_tid + k)->isEmpty() ||
+         s_off.bufferSize != size || t_off.bufferSize != size ||
+         s_off.bufferOffset != s_first.bufferOffset + k * size ||
+         t_off.bufferOffset != t_first.bufferOffset + k * size ) {
+      break;
+    }
+  }
+  if ( k < 2 ) {
+    return 0;
+  }
+
+  uint64_t key = ((uint64_t)s_port->getPortId() << 48) | ((uint64_t)s_tid << 32) |
+    ((uint64_t)t_tid << 16) | k;
+  std::map<uint64_t, OcpiTransferTemplate*>::iterator it = m_runTemplates.find(key);
+  OcpiTransferTemplate* temp;
+  if ( it != m_runTemplates.end() ) {
+    temp = it->second;
+  } else {
+    // Runs usually repeat with the same alignment, so only a few combinations are kept.
+    // Beyond that, the buffers go one at a time rather than growing the set without bound.
+    if ( m_runTemplates.size() >= MAX_RUN_TEMPLATES_PER_BUFFER * m_input->getBufferCount() ) {
+      return 0;
+    }
+    temp = new OcpiTransferTemplate(1);
+    DataTransfer::XferRequest* ptransfer = NULL;
+    try {
+      ptransfer =
+        s_port->getTemplate(s_port->getEndPoint(), t_port->getEndPoint()).createXferRequest();
+      ptransfer->copy( s_first.bufferOffset, t_first.bufferOffset, k * size,
+                       DataTransfer::XferRequest::DataTransfer );
+      for ( unsigned i = 0; i < k; i++ ) {
+        TransferTemplateGeneratorPattern1::
+          addMetaDataTransfers(*ptransfer, s_port, t_port,
+                               s_port->getMetaData()->m_bufferData[s_tid + i].outputOffsets,
+                               t_port->getMetaData()->m_bufferData[t_tid + i].inputOffsets);
+      }
+      temp->addTransfer( ptransfer );
+    } catch (...) {
+      // Fall back to one buffer at a time
+      ocpiInfo("Could not create a transfer for %u output buffers", k);
+      delete ptransfer;
+      delete temp;
+      return 0;
+    }
+    m_runTemplates[key] = temp;
+  }
+  ocpiDebug("Producing output buffers %u-%u to input buffers %u-%u", s_tid, s_tid + k - 1,
+            t_tid, t_tid + k - 1);
+  for ( unsigned i = 0; i < k; i++ ) {
+    buffers[i]->markBufferFull();
+    static_cast<Buffer*>(t_port->getBuffer(t_tid + i))->markBufferFull();
+  }
+  temp->produce();
+  for ( unsigned i = 0; i < k; i++ ) {
+    insert_to_list(&buffers[i]->getPendingTxList(), temp, 64, 8);
+  }
+  m_nextTid = (int32_t)((t_tid + k) % m_input->getBufferCount());
+  return k;
+}
+
 void TransferController::freeAllBuffersLocal( OCPI::DataTransport::Port* port  )
 {
   ocpiAssert( !port->isOutput() );
@@ -276,9 +276,9 @@ produce()
     }
   }
 
-  // Remote transfers
+  // Remote transfers, which may be posted with others (see Circuit::checkQueuedTransfers)
   for ( OCPI::OS::uint32_t n=0; n<n_transfers; n++ ) {
-    m_xferReq[n]->post();
+    m_xferReq[n]->postOrBatch();
   }
 
   // Now increment our gated transfer control
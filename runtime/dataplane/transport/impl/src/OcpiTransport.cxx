@@ -54,16 +54,6 @@ namespace OCPI {
   namespace DataTransport {
 static uint32_t         g_nextCircuitId=0;
 
-OU::VList   Transport::m_cached_transfers;
-OU::VList   Transport::active_transfers;
-
-struct TransferDesc_ {
-  XF::XferRequest*  xfer;
-  XF::EndPoint* loc;
-  size_t offset;
-};
-typedef struct TransferDesc_ TransferDesc;
-
 // FIXME have recursive mutex with default constructor
 // Constructors
 Transport::
@@ -184,17 +174,18 @@ Transport::~Transport()
   OU::AutoMutex guard ( m_mutex, true ); 
   uint32_t m;
 
-  for ( m=0; m<m_cached_transfers.size(); m++ ) {
-    TransferDesc* tmp_td = static_cast<TransferDesc*>(m_cached_transfers[m]);
-    delete tmp_td;
-  }
-  m_cached_transfers.destroyList();
-
-  for ( m=0; m<active_transfers.size();  m++ ) {
-    XF::XferRequest* xr = static_cast<XF::XferRequest*>(active_transfers[m]);
-    delete xr;
-  }
-  active_transfers.destroyList();
+  for (CachedTransfers::iterator it = m_cachedTransfers.begin();
+       it != m_cachedTransfers.end(); ++it)
+    delete it->second;
+  m_cachedTransfers.clear();
+  for (ActiveTransfers::iterator it = m_activeTransfers.begin();
+       it != m_activeTransfers.end(); ++it)
+    delete it->first;
+  m_activeTransfers.clear();
+  for (TransferPool::iterator it = m_transferPool.begin(); it != m_transferPool.end(); ++it)
+    for (unsigned n = 0; n < it->second.size(); n++)
+      delete it->second[n];
+  m_transferPool.clear();
 
   for ( m=0; m<m_mailbox_locks.size(); m++ ) {
     MailBoxLock* mb = static_cast<MailBoxLock*>(m_mailbox_locks[m]);
@@ -508,11 +499,10 @@ deleteCircuit(Circuit *circuit)
   m_circuits.erase(it);
   delete circuit;
   if ( m_circuits.size() == 0 ) {
-    for ( uint32_t m=0; m<m_cached_transfers.getElementCount(); m++ ) {
-      TransferDesc* tmp_td = static_cast<TransferDesc*>(m_cached_transfers[m]);
-      m_cached_transfers.remove( tmp_td );
-      delete tmp_td;
-    }
+    for (CachedTransfers::iterator ci = m_cachedTransfers.begin();
+	 ci != m_cachedTransfers.end(); ++ci)
+      delete ci->second;
+    m_cachedTransfers.clear();
   }
 }
 
@@ -543,69 +533,90 @@ void Transport::dispatch(XF::EventManager*)
 }
 
 
+// Recycle completed one-time transfers.  Cached mailbox transfers are posted to the
+// same queue but are kept in m_cachedTransfers and are simply reposted.
+void Transport::
+reapTransfers() {
+  std::vector<XF::XferRequest*> done;
+  if (!m_completions.reap(done))
+    return;
+  for (unsigned n = 0; n < done.size(); n++) {
+    ActiveTransfers::iterator it = m_activeTransfers.find(done[n]);
+    if (it == m_activeTransfers.end())
+      continue;
+    if (it->first->reset())
+      m_transferPool[it->second].push_back(it->first);
+    else
+      delete it->first;
+    m_activeTransfers.erase(it);
+  }
+}
+
+// Get an empty one-time transfer from the pool for these services, or a new one
+XF::XferRequest &Transport::
+getTransfer(XF::XferServices &services) {
+  std::vector<XF::XferRequest*> &pool = m_transferPool[&services];
+  XF::XferRequest *xr;
+  if (pool.empty())
+    xr = services.createXferRequest();
+  else {
+    xr = pool.back();
+    pool.pop_back();
+  }
+  m_activeTransfers[xr] = &services;
+  return *xr;
+}
+
+// Get the transfer services from our control endpoint to a remote one
+XF::XferServices &Transport::
+getServices(XF::EndPoint &remote) {
+  XF::XferServices *services = XF::getManager().getService(m_CSendpoint, &remote);
+  if (!services)
+    throw OU::Error("No transfer services available from \"%s\" to \"%s\"",
+		    m_CSendpoint->name().c_str(), remote.name().c_str());
+  return *services;
+}
+
 void Transport::
 clearRemoteMailbox(size_t offset, XF::EndPoint* loc )
 {
   assert(loc);
   OU::AutoMutex guard ( m_mutex, true ); 
-  TransferDesc* td=NULL;
 
 #ifdef DEBUG_L2
   ocpiDebug("Clearing remote mailbox address = %s, offset = 0x%x", loc->name(), offset );
 #endif
-
-  for ( uint32_t m=0; m<m_cached_transfers.getElementCount(); m++ ) {
-    TransferDesc* tmp_td = static_cast<TransferDesc*>(m_cached_transfers[m]);
-    if (tmp_td->loc == loc && (uint32_t)tmp_td->offset == offset) {
-      td = tmp_td;
-      while ( td->xfer->getStatus() ) {
-#ifdef DEBUG_L2
-        ocpiDebug("Request to clear the remote mailbox has not yet completed");
-#endif
-      }
-    }
+  reapTransfers();
+  CachedTransfers::iterator it = m_cachedTransfers.find(MailboxKey(loc, offset));
+  if (it != m_cachedTransfers.end() && !it->second->pending()) {
+    it->second->post(m_completions);
+    return;
   }
-
-  if (  ! td ) {
-
-    /* Attempt to get or make a transfer template */
-    XF::XferServices* ptemplate = 
-      XF::getManager().getService( m_CSendpoint, 
-                                      loc );
-    if ( ! ptemplate ) {
-      ocpiAssert(0);
-    }
-
-    XF::XferRequest* ptransfer = ptemplate->createXferRequest();
-
-    // Create the copy in the template
-
-    ptransfer->copy (
-		     OCPI_UTRUNCATE(XF::Offset, offset + sizeof(ContainerComms::RequestHeader)),
-		     OCPI_UTRUNCATE(XF::Offset, offset + sizeof(ContainerComms::RequestHeader)),
-		     sizeof(ContainerComms::MailBox) - sizeof(ContainerComms::RequestHeader),
-		     XF::XferRequest::DataTransfer );
+  XF::XferServices &services = getServices(*loc);
+  // If the cached transfer is still in progress, rather than waiting for it, use a
+  // one-time transfer, since the cleared mailbox contents are the same.
+  XF::XferRequest *ptransfer =
+    it == m_cachedTransfers.end() ? services.createXferRequest() : &getTransfer(services);
+
+  // Create the copy in the template
+
+  ptransfer->copy (
+		   OCPI_UTRUNCATE(XF::Offset, offset + sizeof(ContainerComms::RequestHeader)),
+		   OCPI_UTRUNCATE(XF::Offset, offset + sizeof(ContainerComms::RequestHeader)),
+		   sizeof(ContainerComms::MailBox) - sizeof(ContainerComms::RequestHeader),
+		   XF::XferRequest::DataTransfer );
                 
-    ptransfer->copy (
-		     OCPI_UTRUNCATE(XF::Offset, offset),
-		     OCPI_UTRUNCATE(XF::Offset, offset),
-		     sizeof(ContainerComms::RequestHeader),
-		     XF::XferRequest::FlagTransfer );
-
-    ptransfer->post();
+  ptransfer->copy (
+		   OCPI_UTRUNCATE(XF::Offset, offset),
+		   OCPI_UTRUNCATE(XF::Offset, offset),
+		   sizeof(ContainerComms::RequestHeader),
+		   XF::XferRequest::FlagTransfer );
 
-    // Cache it
-    TransferDesc *trd = new TransferDesc;
-    trd->loc = loc;
-    trd->offset = offset;
-    trd->xfer = ptransfer;
-    m_cached_transfers.push_back( trd );
+  ptransfer->post(m_completions);
 
-  }
-  else {
-    ocpiAssert( td->xfer->getStatus() == 0 );
-    td->xfer->post();
-  }
+  // Cache it
+  if (it == m_cachedTransfers.end())
+    m_cachedTransfers[MailboxKey(loc, offset)] = ptransfer;
 }
 
 void Transport::
@@ -614,30 +625,14 @@ sendOffsets( OU::VList& offsets, XF::EndPoint &remote_ep,
 {
   OU::AutoMutex guard ( m_mutex, true ); 
 
- FORSTART:
-
-  for ( uint32_t m=0; m<active_transfers.getElementCount();  m++ ) {
-    XF::XferRequest* xr = static_cast<XF::XferRequest*>(active_transfers[m]);
-    if ( xr->getStatus() == 0 ) {
-      XF::XferRequest* for_delete = xr;
-      active_transfers.remove( xr );
-      delete for_delete;
-      goto FORSTART;
-    }
-  }
-  /* Attempt to get or make a transfer template */
-  XF::XferServices* ptemplate = 
-    XF::getManager().getService( m_CSendpoint, 
-							&remote_ep );
-  if ( ! ptemplate ) {
-    ocpiAssert(0);
-  }
+  reapTransfers();
+  XF::XferServices &services = getServices(remote_ep);
 
 #ifdef DEBUG_L2
   ocpiDebug("In Transport::sendOffsets, sending %d OS::int32_ts", offsets.size() );
 #endif
 
-  XF::XferRequest* ptransfer = ptemplate->createXferRequest();
+  XF::XferRequest* ptransfer = &getTransfer(services);
 
   // We do the extra transfer first so that the other side will have the protocol when it
   // sees that the output offsets have been copied.
@@ -659,8 +654,7 @@ sendOffsets( OU::VList& offsets, XF::EndPoint &remote_ep,
 		     XF::XferRequest::None );
 
   }
-  ptransfer->post();
-  active_transfers.push_back( ptransfer );
+  ptransfer->post(m_completions);
 }
 
 /**********************************
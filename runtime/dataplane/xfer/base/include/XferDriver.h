@@ -89,6 +89,7 @@ namespace DataTransfer {
     // Allow the base class to get at the derived parent
     // To do that it needs to declare a pure virtual method
     ConcConn &parent() { return OCPI::Util::Child<ConcConn,ConcXfer>::parent(); }
+    XferServices *services() { return &parent(); }
   };
   template <class Dri>
   class RegisterTransferDriver
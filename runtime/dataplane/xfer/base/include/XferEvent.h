@@ -20,13 +20,51 @@
 
 #ifndef XFER_EVENT_H
 #define XFER_EVENT_H
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
 
 namespace DataTransfer {
-  enum ReturnStatus { EventTimeout };
+  enum ReturnStatus { EventTimeout, EventSuccess };
+
+  // A doorbell is a small page of shared memory that is owned by one process and that any
+  // process on the same host can map and ring.  Ringing it wakes the threads of the owning
+  // process that are waiting for something to arrive.  There is one per process.
+  struct Doorbell {
+    volatile uint32_t m_sequence; // incremented by each ring
+    volatile uint32_t m_sleepers; // number of threads waiting for the sequence to change
+    void ring();
+    // Wait until the sequence is no longer "snapshot", or the timeout expires.
+    // Return true if the sequence changed.
+    bool wait(uint32_t snapshot, unsigned usecs);
+    // This process's doorbell, and the file descriptor other processes can use to map it.
+    // The fd is -1 if the doorbell cannot be shared.
+    static Doorbell &local(int *fd = NULL);
+    // The doorbell of another process, or NULL if it cannot be mapped.
+    static Doorbell *remote(pid_t pid, int fd);
+  };
+
+  // Create an anonymous shared memory file of the given size.  Other processes can
+  // open it as /proc/<pid>/fd/<fd>.  Returns -1 and sets error on failure.
+  int createSharedFile(const char *name, size_t size, std::string &error);
+  // Map such a file created in another process (or this one).  Returns NULL on failure.
+  void *mapSharedFile(pid_t pid, int fd, size_t size, std::string &error);
+
+  // The event manager lets a container thread that has nothing to do sleep until a transfer
+  // rings this process's doorbell, rather than spinning.  Transfer drivers that do not ring
+  // the doorbell are still serviced since the wait is bounded.
   class EventManager {
+    uint32_t m_snapshot;
   public:
-    EventManager(int /*low_range*/, int /*high_range*/){};
-    ReturnStatus waitForEvent( int /*timeout_us*/ ){ return EventTimeout; };
+    // The longest time to wait for a doorbell when no timeout is specified
+    static const unsigned c_maxWaitUsecs = 1000;
+    EventManager(int low_range, int high_range);
+    // Note the state of the doorbell before looking for work, so that a ring that happens
+    // after looking and before waiting is not lost.
+    void arm();
+    ReturnStatus waitForEvent(int timeout_us);
+    // Wake up any threads in this process waiting for events, e.g. after control operations
+    static void wake();
   };
 }
 #endif
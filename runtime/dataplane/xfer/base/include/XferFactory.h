@@ -46,6 +46,8 @@ namespace DataTransfer {
     size_t getSMBSize() const { return m_SMBSize; }
     size_t m_SMBSize;
     size_t m_retryCount;
+    bool   m_hugePages; // back endpoint memory with huge pages when the driver can
+    int    m_numaNode;  // NUMA node for endpoint memory, -1 for no placement
     ezxml_t  m_xml; // the element that these attributes were parsed from
   };
          
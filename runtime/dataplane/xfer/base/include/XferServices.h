@@ -41,12 +41,16 @@ namespace DataTransfer {
   class XferServices;
   class XferFactory;
   class EndPoint;
+  class XferCompletionQueue;
+  class XferRequestList;
 
   // A single request to perform a data transfer, this is effectively a transfer 
   // template that is used aOCPI::OS::int32_t with a transfer service object to 
   // describe a transfer.  This base class is specialized by each transfer driver
   class XferRequest
   {
+    friend class XferCompletionQueue;
+    friend class XferRequestList;
   public:
    
     // Constructor
@@ -78,6 +82,31 @@ namespace DataTransfer {
      */
     virtual void post ();
 
+    /*
+     * Queue Data Transfer Request, unless a batch is open on this thread (see XferBatch),
+     * in which case the request is posted with the others in the batch when it closes.
+     */
+    void postOrBatch();
+
+    /*
+     * Queue Data Transfer Request, and report its completion by pushing it on the given
+     * completion queue, rather than requiring the caller to poll it.
+     */
+    void post(XferCompletionQueue &queue);
+
+    // Posted to a completion queue and not yet reported complete
+    bool pending() const { return m_pending; }
+
+    // Called by drivers when a request posted to a completion queue has completed
+    void completed();
+
+    /*
+     * Discard all copies so the (completed) request can be reused for new ones.
+     * Returns false if the driver does not support this, and the request should be
+     * deleted instead.
+     */
+    virtual bool reset();
+
     /*
      * Get Information about a Data Transfer Request
      *        Arguments:
@@ -141,11 +170,67 @@ namespace DataTransfer {
     // Perform a PIO transfer.  Default null implementation when no using default "post" method
     virtual void action_transfer(PIO_transfer, bool last=false);
     virtual void start_pio(PIO_transfer, bool last=false);
+    // The services that created this request, if known, so requests can be posted in batches
+    virtual XferServices *services() { return NULL; }
     // Destructor - Note that invoking OcpiXferServices::Release is the preferred method.
     virtual ~XferRequest ();
   private:
     XF_transfer m_thandle;                // Transfer handle returned by xfer_xx
     XF_template m_xftemplate;             // parent's template
+    XferCompletionQueue *m_queue;         // where completion is reported if posted with one
+    bool m_pending;                       // posted and not yet complete
+    XferRequestList *m_list;              // which of the queue's lists it is on, if any
+    XferRequest *m_next, *m_prev;         // links on that list
+  };
+
+  // An intrusive list of requests, linked through their own members so that adding and
+  // removing them takes constant time.  A request is on at most one list at a time.
+  class XferRequestList {
+    XferRequest *m_head, *m_tail;
+    size_t m_size;
+  public:
+    XferRequestList() : m_head(NULL), m_tail(NULL), m_size(0) {}
+    XferRequest *front() const { return m_head; }
+    XferRequest *back() const { return m_tail; }
+    size_t size() const { return m_size; }
+    void push_back(XferRequest &r);
+    void remove(XferRequest &r);
+  };
+
+  // A batch of requests whose posting is deferred while the batch is open, so that those
+  // created by the same XferServices are posted together by its postBatch method.
+  // A batch is open on the thread that constructs it, until it is posted or destroyed.
+  // Requests are added by XferRequest::postOrBatch.  When a batch is already open on the
+  // thread, a new one adds nothing and its requests go to the outer one.
+  class XferBatch {
+    friend class XferRequest;
+    bool m_open;
+    std::vector<XferRequest *> m_requests, m_group;
+    void post(XferServices *s, size_t first, size_t n, std::string &error);
+  public:
+    XferBatch();
+    // Any requests not yet posted are posted, and errors doing so are only logged
+    ~XferBatch();
+    // Post the requests added so far, and close the batch.  If posting for one service
+    // fails, those for the others are still posted before the error is thrown.
+    void post();
+  };
+
+  // A queue of completed transfer requests, to avoid scanning or spinning on requests
+  // to find the ones that have finished.  Requests posted with a queue are pushed onto it
+  // when their driver reports completion, which for synchronous (PIO) transfers is
+  // during the post.  Requests whose drivers only learn of completion when asked are
+  // polled in the order they were posted, each time the queue is reaped, until one is
+  // found still pending, which then goes to the back so the others get their turn.
+  class XferCompletionQueue {
+    friend class XferRequest;
+    XferRequestList m_completed, m_polled;
+  public:
+    // Append the completed requests to "done", returning how many there were
+    size_t reap(std::vector<XferRequest *> &done);
+    // Forget a request that is being deleted
+    void remove(XferRequest &r);
+    size_t nPolled() const { return m_polled.size(); }
   };
 
          
@@ -195,6 +280,14 @@ namespace DataTransfer {
      */
     virtual XferRequest* createXferRequest() = 0;
 
+    /*
+     * Post several requests created by this service, in order.  The default posts them
+     * one at a time, posting the rest when one fails and then throwing the first error.
+     * Drivers override this when they can post them together with fewer system calls or
+     * doorbells than one per request.
+     */
+    virtual void postBatch(XferRequest **requests, size_t nRequests);
+
     // Send the given data to destination directly - like  write(2)
     virtual void send(DtOsDataTypes::Offset offset, uint8_t *data, size_t nbytes);
     /*
@@ -0,0 +1,202 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Doorbells and the event manager that waits on them.
+// On linux the doorbell is a futex in a memfd page so that it can be rung from other
+// processes.  Elsewhere it degenerates to a bounded sleep.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <climits>
+#include <map>
+#include <sys/mman.h>
+#ifdef OCPI_OS_linux
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include "OcpiOsMutex.h"
+#include "OcpiOsDebugApi.h"
+#include "OcpiUtilAutoMutex.h"
+#include "OcpiUtilMisc.h"
+#include "XferEvent.h"
+
+namespace OU = OCPI::Util;
+namespace OS = OCPI::OS;
+namespace DataTransfer {
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 1U
+#endif
+int
+createSharedFile(const char *name, size_t size, std::string &error) {
+#if defined(OCPI_OS_linux) && defined(SYS_memfd_create)
+  int fd = (int)syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+  if (fd < 0)
+    OU::format(error, "can't create shared memory file \"%s\": %s", name, strerror(errno));
+  else if (ftruncate(fd, (off_t)size)) {
+    OU::format(error, "can't size shared memory file \"%s\" to %zu bytes: %s", name, size,
+	       strerror(errno));
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+#else
+  (void)size;
+  OU::format(error, "can't create shared memory file \"%s\": not supported", name);
+  return -1;
+#endif
+}
+
+void *
+mapSharedFile(pid_t pid, int fd, size_t size, std::string &error) {
+  int myFd = fd;
+  if (pid != getpid()) {
+    std::string path;
+    OU::format(path, "/proc/%u/fd/%d", (unsigned)pid, fd);
+    if ((myFd = open(path.c_str(), O_RDWR)) < 0) {
+      OU::format(error, "can't open shared memory file \"%s\": %s", path.c_str(),
+		 strerror(errno));
+      return NULL;
+    }
+  }
+  void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, myFd, 0);
+  if (myFd != fd)
+    close(myFd);
+  if (addr == MAP_FAILED) {
+    OU::format(error, "can't map %zu bytes of shared memory file %d of process %u: %s",
+	       size, fd, (unsigned)pid, strerror(errno));
+    return NULL;
+  }
+  return addr;
+}
+
+#ifdef OCPI_OS_linux
+static long
+futex(volatile uint32_t *addr, int op, uint32_t val, const struct timespec *ts) {
+  // Not FUTEX_PRIVATE since the doorbell is shared between processes
+  return syscall(SYS_futex, addr, op, val, ts, NULL, 0);
+}
+#endif
+
+void Doorbell::
+ring() {
+  // The full barrier in the increment orders it before reading m_sleepers, and a waiter
+  // increments m_sleepers before the kernel compares the sequence, so one of us sees the other.
+  __sync_fetch_and_add(&m_sequence, 1);
+#ifdef OCPI_OS_linux
+  if (m_sleepers)
+    futex(&m_sequence, FUTEX_WAKE, INT_MAX, NULL);
+#endif
+}
+
+bool Doorbell::
+wait(uint32_t snapshot, unsigned usecs) {
+  if (m_sequence != snapshot)
+    return true;
+#ifdef OCPI_OS_linux
+  struct timespec ts;
+  ts.tv_sec = usecs / 1000000;
+  ts.tv_nsec = (usecs % 1000000) * 1000;
+  __sync_fetch_and_add(&m_sleepers, 1);
+  futex(&m_sequence, FUTEX_WAIT, snapshot, &ts);
+  __sync_fetch_and_sub(&m_sleepers, 1);
+#else
+  usleep(usecs);
+#endif
+  return m_sequence != snapshot;
+}
+
+static OS::Mutex s_doorbellMutex;
+static Doorbell *s_localDoorbell;
+static int s_localDoorbellFd = -1;
+
+Doorbell &Doorbell::
+local(int *fd) {
+  if (!s_localDoorbell) {
+    OU::AutoMutex guard(s_doorbellMutex);
+    if (!s_localDoorbell) {
+      std::string error;
+      size_t size = (size_t)getpagesize();
+      void *addr = NULL;
+      if ((s_localDoorbellFd = createSharedFile("ocpi-doorbell", size, error)) >= 0 &&
+	  !(addr = mapSharedFile(getpid(), s_localDoorbellFd, size, error))) {
+	close(s_localDoorbellFd);
+	s_localDoorbellFd = -1;
+      }
+      if (!addr) {
+	// Without a shareable doorbell, events can only come from this process
+	ocpiInfo("Doorbell for this process cannot be shared: %s", error.c_str());
+	addr = new Doorbell;
+	memset(addr, 0, sizeof(Doorbell));
+      }
+      s_localDoorbell = (Doorbell *)addr;
+    }
+  }
+  if (fd)
+    *fd = s_localDoorbellFd;
+  return *s_localDoorbell;
+}
+
+Doorbell *Doorbell::
+remote(pid_t pid, int fd) {
+  if (pid == getpid())
+    return &local();
+  if (fd < 0)
+    return NULL;
+  // Map each remote doorbell once, and keep it until the process exits.  Failures are
+  // remembered too, so they are not retried on every transfer.
+  static std::map<std::pair<pid_t, int>, Doorbell *> s_remotes;
+  OU::AutoMutex guard(s_doorbellMutex);
+  std::pair<pid_t, int> key(pid, fd);
+  std::map<std::pair<pid_t, int>, Doorbell *>::const_iterator it = s_remotes.find(key);
+  if (it != s_remotes.end())
+    return it->second;
+  std::string error;
+  Doorbell *db = (Doorbell *)mapSharedFile(pid, fd, (size_t)getpagesize(), error);
+  if (!db)
+    ocpiInfo("Doorbell of process %u cannot be used: %s", (unsigned)pid, error.c_str());
+  s_remotes[key] = db;
+  return db;
+}
+
+EventManager::
+EventManager(int /*low_range*/, int /*high_range*/)
+  : m_snapshot(Doorbell::local().m_sequence) {
+}
+
+void EventManager::
+arm() {
+  m_snapshot = Doorbell::local().m_sequence;
+}
+
+ReturnStatus EventManager::
+waitForEvent(int timeout_us) {
+  unsigned usecs = timeout_us > 0 && (unsigned)timeout_us < c_maxWaitUsecs ?
+    (unsigned)timeout_us : c_maxWaitUsecs;
+  return Doorbell::local().wait(m_snapshot, usecs) ? EventSuccess : EventTimeout;
+}
+
+void EventManager::
+wake() {
+  Doorbell::local().ring();
+}
+}
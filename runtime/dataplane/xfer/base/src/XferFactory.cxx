@@ -134,7 +134,7 @@ getNode( ezxml_t tn, const char* name )
 // These defaults are pre-configuration
 FactoryConfig::
 FactoryConfig(size_t smbSize, size_t retryCount)
-  : m_SMBSize(3*1024*1024), m_retryCount(128)
+  : m_SMBSize(3*1024*1024), m_retryCount(128), m_hugePages(false), m_numaNode(-1)
 {
   if (smbSize)
     m_SMBSize = smbSize;
@@ -152,10 +152,17 @@ parse(FactoryConfig *parent, ezxml_t x) {
     const char *err;
     // Note we are not writing defaults here because they are set
     // in the constructor, and they need to be set even when there is no xml
-    if ((err = OX::checkAttrs(x, "load", "SMBSize", "TxRetryCount", NULL)) ||
+    size_t node;
+    bool found;
+    if ((err = OX::checkAttrs(x, "load", "SMBSize", "TxRetryCount", "HugePages", "NumaNode",
+			      NULL)) ||
 	(err = OX::getNumber(x, "SMBSize", &m_SMBSize, NULL, 0, false)) ||
-	(err = OX::getNumber(x, "TxRetryCount", &m_retryCount, NULL, 0, false)))
+	(err = OX::getNumber(x, "TxRetryCount", &m_retryCount, NULL, 0, false)) ||
+	(err = OX::getBoolean(x, "HugePages", &m_hugePages, false, false)) ||
+	(err = OX::getNumber(x, "NumaNode", &node, &found, 0, false)))
       throw std::string(err); // FIXME configuration api error exception class
+    if (found)
+      m_numaNode = (int)node;
   }
 }
 
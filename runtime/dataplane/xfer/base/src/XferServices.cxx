@@ -22,6 +22,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 #include <ezxml.h>
 #include <OcpiOsAssert.h>
 #include <OcpiOsMisc.h>
@@ -62,6 +63,111 @@ send(DtOsDataTypes::Offset /*offset*/, uint8_t */*data*/, size_t /*nbytes*/) {
   throw OU::Error("Direct send on endpoint that doesn't support it");
 }
 
+void XferServices::
+postBatch(XferRequest **requests, size_t nRequests) {
+  // Post them all even if one fails, then report the first failure
+  std::string error;
+  for (size_t n = 0; n < nRequests; n++)
+    try {
+      requests[n]->post();
+    } catch (std::string &e) {
+      if (error.empty())
+	error = e.empty() ? "Error posting transfer request" : e;
+    } catch (...) {
+      if (error.empty())
+	error = "Unknown exception posting transfer request";
+    }
+  if (!error.empty())
+    throw OU::Error("%s", error.c_str());
+}
+
+namespace {
+  pthread_once_t s_batchOnce = PTHREAD_ONCE_INIT;
+  pthread_key_t s_batchKey;
+  void makeBatchKey() {
+    pthread_key_create(&s_batchKey, NULL);
+  }
+}
+
+XferBatch::
+XferBatch()
+  : m_open(false) {
+  pthread_once(&s_batchOnce, makeBatchKey);
+  if (!pthread_getspecific(s_batchKey)) {
+    pthread_setspecific(s_batchKey, this);
+    m_open = true;
+  }
+}
+
+XferBatch::
+~XferBatch() {
+  try {
+    post();
+  } catch (std::string &e) {
+    ocpiBad("Error posting transfer batch: %s", e.c_str());
+  } catch (...) {
+    ocpiBad("Unknown exception posting transfer batch");
+  }
+}
+
+// Post some of the current group, by the services' postBatch or individually, recording
+// the first error rather than throwing it.
+void XferBatch::
+post(XferServices *s, size_t first, size_t n, std::string &error) {
+  try {
+    if (s)
+      s->postBatch(&m_group[first], n);
+    else
+      m_group[first]->post();
+  } catch (std::string &e) {
+    if (error.empty())
+      error = e.empty() ? "Error posting transfer batch" : e;
+  } catch (...) {
+    if (error.empty())
+      error = "Unknown exception posting transfer batch";
+  }
+}
+
+// Post the requests for each XferServices together, keeping their order.
+// When posting fails, the requests of the other services are still posted, and the
+// first error is thrown after all of them have been tried.
+void XferBatch::
+post() {
+  if (!m_open)
+    return;
+  pthread_setspecific(s_batchKey, NULL);
+  m_open = false;
+  std::string error;
+  for (size_t n = 0; n < m_requests.size(); n++)
+    if (m_requests[n]) {
+      XferServices *s = m_requests[n]->services();
+      m_group.clear();
+      for (size_t nn = n; nn < m_requests.size(); nn++)
+	if (m_requests[nn] && m_requests[nn]->services() == s) {
+	  m_group.push_back(m_requests[nn]);
+	  m_requests[nn] = NULL;
+	}
+      if (s && m_group.size() > 1)
+	post(s, 0, m_group.size(), error);
+      else
+	for (size_t nn = 0; nn < m_group.size(); nn++)
+	  post(NULL, nn, 1, error);
+    }
+  m_requests.clear();
+  if (!error.empty())
+    throw OU::Error("%s", error.c_str());
+}
+
+void XferRequest::
+postOrBatch() {
+  pthread_once(&s_batchOnce, makeBatchKey);
+  XferBatch *b = (XferBatch *)pthread_getspecific(s_batchKey);
+  if (b && services())
+    b->m_requests.push_back(this);
+  else
+    post();
+}
+
 // Create a transfer request
 XferRequest* XferRequest::
 copy(Offset srcoffs, Offset dstoffs, size_t nbytes, XferRequest::Flags flags) {
@@ -145,17 +251,117 @@ post() {
 	      xf_transfer->first_pio_transfer || xf_transfer->pio_transfer);
 }
 
+void XferRequest::
+post(XferCompletionQueue &queue) {
+  // Any earlier completion that was not reaped is superseded by this post
+  if (m_list)
+    m_list->remove(*this);
+  m_queue = &queue;
+  m_pending = true;
+  post();
+  // If the driver did not report completion during the post, check once, and if
+  // still not complete, let the queue poll it later.
+  if (m_pending) {
+    if (getStatus() == CompleteSuccess)
+      completed();
+    else
+      queue.m_polled.push_back(*this);
+  }
+}
+
+void XferRequest::
+completed() {
+  if (m_pending && m_queue) {
+    m_pending = false;
+    if (m_list)
+      m_list->remove(*this);
+    m_queue->m_completed.push_back(*this);
+  }
+}
+
+bool XferRequest::
+reset() {
+  if (m_thandle) {
+    (void)xfer_release (m_thandle, 0);
+    m_thandle = NULL;
+  }
+  return true;
+}
+
 XferRequest::CompletionStatus XferRequest::
 getStatus() {
   return xfer_get_status (m_thandle) == 0 ? CompleteSuccess : Pending;
 }
 
 XferRequest::
-XferRequest(XF_template temp) : m_thandle(NULL), m_xftemplate(temp) {
+XferRequest(XF_template temp)
+  : m_thandle(NULL), m_xftemplate(temp), m_queue(NULL), m_pending(false),
+    m_list(NULL), m_next(NULL), m_prev(NULL) {
 }
 XferRequest::
 ~XferRequest() {
+  if (m_list)
+    m_list->remove(*this);
   if (m_thandle)
     (void)xfer_release (m_thandle, 0);
 }
+
+void XferRequestList::
+push_back(XferRequest &r) {
+  ocpiAssert(!r.m_list);
+  r.m_list = this;
+  r.m_next = NULL;
+  r.m_prev = m_tail;
+  if (m_tail)
+    m_tail->m_next = &r;
+  else
+    m_head = &r;
+  m_tail = &r;
+  m_size++;
+}
+
+void XferRequestList::
+remove(XferRequest &r) {
+  ocpiAssert(r.m_list == this);
+  if (r.m_prev)
+    r.m_prev->m_next = r.m_next;
+  else
+    m_head = r.m_next;
+  if (r.m_next)
+    r.m_next->m_prev = r.m_prev;
+  else
+    m_tail = r.m_prev;
+  r.m_list = NULL;
+  r.m_next = r.m_prev = NULL;
+  m_size--;
+}
+
+size_t XferCompletionQueue::
+reap(std::vector<XferRequest *> &done) {
+  // Poll in posting order, stopping at the first one still pending so each reap only
+  // polls the ones that have completed plus one.  That one goes to the back so a
+  // request that is slow to complete does not hide the others.
+  for (XferRequest *r; (r = m_polled.front()); )
+    if (r->getStatus() == XferRequest::CompleteSuccess)
+      r->completed(); // moves it to m_completed
+    else {
+      if (r != m_polled.back()) {
+	m_polled.remove(*r);
+	m_polled.push_back(*r);
+      }
+      break;
+    }
+  size_t nDone = 0;
+  for (XferRequest *r; (r = m_completed.front()); nDone++) {
+    m_completed.remove(*r);
+    done.push_back(r);
+  }
+  return nDone;
+}
+
+void XferCompletionQueue::
+remove(XferRequest &r) {
+  if (r.m_list == &m_completed || r.m_list == &m_polled)
+    r.m_list->remove(r);
+}
 }
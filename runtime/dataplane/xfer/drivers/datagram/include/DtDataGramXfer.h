@@ -115,6 +115,8 @@ public:
   Socket(DGEndPoint &lep) : m_lep(lep), m_run(true), m_joined(false) {}
   virtual ~Socket();
   virtual void send(Frame &frame) = 0;
+  // Send several frames, by default one at a time
+  virtual void sendBatch(Frame **frames, unsigned nFrames);
   // return bytes read and offset in buffer to use.  Returning zero is timeout
   virtual size_t receive(uint8_t *buf, size_t &offset) = 0;
   virtual uint16_t maxPayloadSize()=0;  // Maximum message size, total bytes
@@ -162,6 +164,9 @@ public:
   OCPI::OS::int32_t unMap() { return 0;}
   //  Socket *&socketServer() { return m_socket;}
   inline void send(Frame &frame) { m_socket->send(frame); }
+  inline void sendBatch(Frame **frames, unsigned nFrames) {
+    m_socket->sendBatch(frames, nFrames);
+  }
   void start() {
     if (m_socket)
       m_socket->start();
@@ -190,6 +195,12 @@ struct Transaction {
   uint32_t            m_tid;
   std::vector<Message>   m_messages;
   inline bool init() {return m_init;}
+  // Forget the messages so the transaction can be built again by copy()
+  inline void reset() {
+    m_init = false;
+    m_nMessagesTx = m_nMessagesRx = 0;
+    m_messages.clear();
+  }
   unsigned msgCount() {return m_nMessagesTx;}
   Transaction() 
     : m_init(false), m_nMessagesTx(0), m_nMessagesRx(0) {}
@@ -232,9 +243,19 @@ public:
   }
   virtual ~XferRequest ();
   void post();
+  // Build and post the frames, or add them to "batch" to be sent later
+  void postFrames(std::vector<Frame *> *batch);
   DataTransfer::XferRequest::CompletionStatus getStatus();
   DataTransfer::XferRequest &group(DataTransfer::XferRequest* lhs);
   void modify(DtOsDataTypes::Offset new_offsets[], DtOsDataTypes::Offset old_offsets[]);
+  // The messages built by copy() can only be discarded once all have been acknowledged,
+  // since until then the frames that carry them may be resent.
+  bool reset() {
+    if (!complete())
+      return false;
+    Transaction::reset();
+    return DataTransfer::XferRequest::reset();
+  }
   XferRequest* copy(DtOsDataTypes::Offset srcoff, 
 		    DtOsDataTypes::Offset dstoff, 
 		    size_t nbytes, 
@@ -257,6 +278,7 @@ public:
   Frame &getFrame(size_t &bytes_left);
   void releaseFrame(unsigned seq);
   void post(Frame &t);
+  void postBatch(DataTransfer::XferRequest **requests, size_t nRequests);
   void processFrame(FrameHeader *frame);
   void checkAcks(uint64_t time, uint64_t timeout);
   void sendAcks(uint64_t time_now, uint64_t timeout);
@@ -283,6 +305,10 @@ private:
   std::vector<MsgTransactionRecord> m_msgTransactionRecord;
   uint64_t m_last_ack_send;
   unsigned m_frames_in_play;
+  std::vector<Frame *> m_batch; // frames of the requests being posted by postBatch
+
+  void prepare(Frame &frame);
+  void sent(Frame &frame);
 };
   }
 }
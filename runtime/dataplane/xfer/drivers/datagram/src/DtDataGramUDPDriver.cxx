@@ -158,6 +158,25 @@ namespace DataTransfer {
 	m_msghdr.msg_iovlen = frame.iovlen;
 	m_server.sendmsg(&m_msghdr, 0);
       }
+      // Send the frames with as few system calls as possible (sendmmsg)
+      void sendBatch(DG::Frame **frames, unsigned nFrames) {
+	const unsigned chunk = 32;
+	struct msghdr msgs[chunk];
+	while (nFrames) {
+	  unsigned n = nFrames < chunk ? nFrames : chunk;
+	  for (unsigned i = 0; i < n; i++) {
+	    struct msghdr &m = msgs[i];
+	    memset(&m, 0, sizeof(m));
+	    m.msg_name = &static_cast<EndPoint *>(frames[i]->endpoint)->sockaddr();
+	    m.msg_namelen = sizeof(struct sockaddr_in);
+	    m.msg_iov = (struct iovec *)frames[i]->iov;
+	    m.msg_iovlen = frames[i]->iovlen;
+	  }
+	  m_server.sendmsgs(msgs, n, 0);
+	  frames += n;
+	  nFrames -= n;
+	}
+      }
       size_t
       receive(uint8_t *buffer, size_t &offset) {
 	struct sockaddr sad;
@@ -142,17 +142,47 @@ XferServices::
 }
 
 void XferServices::
-post(Frame & frame) {
+prepare(Frame & frame) {
   frame.send_time = fasttime_getticks();
   if (frame.msg_count)
     frame.frameHdr.flags |= FRAME_FLAG_HAS_MESSAGES;
-  static_cast<SmemServices *>(&m_from.sMemServices())->send(frame);
+}
+
+void XferServices::
+sent(Frame & frame) {
   // If there is nothing to ack (no messages) in this frame, free it as soon as it is sent.
   // The "send" is required to take it and not queue it (or at least copy it).
   if (!frame.msg_count)
     frame.release();
 }
 
+void XferServices::
+post(Frame & frame) {
+  prepare(frame);
+  static_cast<SmemServices *>(&m_from.sMemServices())->send(frame);
+  sent(frame);
+}
+
+// Build the frames for all the requests, and send them together
+void XferServices::
+postBatch(XF::XferRequest **requests, size_t nRequests) {
+  m_batch.clear();
+  for (size_t n = 0; n < nRequests; n++)
+    static_cast<XferRequest *>(requests[n])->postFrames(&m_batch);
+  if (m_batch.empty())
+    return;
+  static_cast<SmemServices *>(&m_from.sMemServices())->
+    sendBatch(&m_batch[0], OCPI_UTRUNCATE(unsigned, m_batch.size()));
+  for (size_t n = 0; n < m_batch.size(); n++)
+    sent(*m_batch[n]);
+}
+
+void Socket::
+sendBatch(Frame **frames, unsigned nFrames) {
+  for (unsigned n = 0; n < nFrames; n++)
+    send(*frames[n]);
+}
+
 Frame *XferServices::  
 nextFreeFrame() {
   OCPI::Util::SelfAutoMutex guard ( this );
@@ -262,6 +292,11 @@ getFrame(size_t & bytes_left) {
 
 void XferRequest::
 post() {
+  postFrames(NULL);
+}
+
+void XferRequest::
+postFrames(std::vector<Frame *> *batch) {
   size_t bytes_left;
   uint16_t msg = 0;
   Transaction & t = *this;
@@ -302,7 +337,11 @@ post() {
       frame.msg_count++;
     }
     t.hdrPtr(msg-1)->nextMsg = false;
-    parent().post( frame );
+    if (batch) {
+      parent().prepare( frame );
+      batch->push_back( &frame );
+    } else
+      parent().post( frame );
     //      queFrame( frame );	  
   }	
 }
@@ -62,6 +62,9 @@ namespace XF = DataTransfer;
 // Create tranfer services template
 const int MAX_TX_DEPTH = 8*1024;
 const int MAX_Q_DEPTH = 4*1024;
+// Writes this small (flags, metadata) are sent inline in the work request, avoiding the
+// adapter's DMA read of host memory.  The device may reduce this when the QP is created.
+const uint32_t MAX_INLINE = 64;
 namespace DataTransfer {
   namespace OFED {
 
@@ -97,13 +100,27 @@ namespace DataTransfer {
       // Modify the source buffer offfsets
       void modify(DtOsDataTypes::Offset new_offsets[], DtOsDataTypes::Offset old_offsets[] );
 
+      // Free the work requests built by copy() once none are in flight
+      bool reset();
+
       // Data members accessible from this/derived class
     protected:
+      // Link the work request lists into the single chain that is posted
+      ibv_send_wr *chain();
+      void unchain();
+      // Free the work requests of all the lists
+      void freeWrs();
+      // Prepare to post, returning the chain or NULL if there is nothing to post
+      ibv_send_wr *prepare();
+      // The last work request in the chain
+      ibv_send_wr *chainTail();
+
       ibv_send_wr * m_wr;
       ibv_send_wr ** m_nextWr;
       ibv_send_wr * m_firstWr;
       ibv_send_wr * m_lastWr;
-      ibv_send_wr * m_badWr[3];
+      ibv_send_wr * m_chain;     // first, middle and last lists linked, when posted
+      ibv_send_wr * m_tails[3];  // the tails of those lists, to unlink them again
       int m_PCount, m_PComplete;
       XF::XferRequest::CompletionStatus m_status;
     };
@@ -126,6 +143,12 @@ namespace DataTransfer {
      // Create tranfer request object
      XF::XferRequest* createXferRequest();
 
+     // Post the chains of several requests with one ibv_post_send
+     void postBatch(XF::XferRequest **requests, size_t nRequests);
+    private:
+     static void unlinkBatch(XF::XferRequest **requests, size_t nRequests);
+    public:
+
      // Get the connection cookie
      uint64_t getConnectionCookie();
 
@@ -157,6 +180,7 @@ namespace DataTransfer {
       OCPI::OS::Mutex     m_mutex;     
       ibv_qp            * m_qp;
       uint32_t            m_tqpn;
+      uint32_t            m_maxInline; // the largest write that can be sent inline
       bool                m_finalized;
       int                 m_post_count;
       int                 m_cq_count;
@@ -220,7 +244,7 @@ namespace DataTransfer {
       // Convenience functions
       inline EndPoint * getOfedEp(){return m_ofed_ep;}
       inline Device   * getOfedDevice(){return static_cast<Device *>(m_ofed_ep->m_device);}
-      ibv_qp          * getNextQp();
+      ibv_qp          * getNextQp(uint32_t &maxInline);
       ibv_mr          *& getMr(){return m_mr;}
       ibv_cq          *& getCq(){return m_cq;}
 
@@ -635,13 +659,34 @@ namespace DataTransfer {
     XferRequest::
     ~XferRequest ()
     {
-      ibv_send_wr * wr  = m_wr;
-      while ( wr ) {
-	ibv_send_wr * next = wr->next;
-	free ( wr->sg_list);
-	free ( wr );
-	wr = next;
-      };
+      freeWrs();
+    }
+
+    void
+    XferRequest::
+    freeWrs()
+    {
+      unchain();
+      ibv_send_wr *lists[3] = { m_firstWr, m_wr, m_lastWr };
+      for ( unsigned n = 0; n < 3; n++ )
+	for ( ibv_send_wr *wr = lists[n], *next; wr; wr = next ) {
+	  next = wr->next;
+	  free ( wr->sg_list );
+	  free ( wr );
+	}
+      m_wr = m_firstWr = m_lastWr = NULL;
+      m_nextWr = NULL;
+    }
+
+    bool
+    XferRequest::
+    reset()
+    {
+      if ( m_PComplete != m_PCount )
+	return false;
+      freeWrs();
+      m_PCount = m_PComplete = 0;
+      return XF::XferRequest::reset();
     }
 
 
@@ -653,36 +698,38 @@ namespace DataTransfer {
       if ( ! m_post_count ) {
 	return;
       }
-      const int WC_COUNT=1;
+      // Reap completions in batches, until the queue is drained
+      const int WC_COUNT=16;
       ibv_wc wc[WC_COUNT];
       int c = ibv_poll_cq( m_sourceSmb->getCq(), WC_COUNT, wc );
       if ( ! c ) {
 	OCPI::OS::sleep( 0 );
 	c = ibv_poll_cq( m_sourceSmb->getCq(), WC_COUNT, wc );
       }
-      
-      m_cq_count += c;
-      int index=0;
       while ( c ) {
-	//	ocpiDebug("*** Got a completion event");
 	if ( c < 0 ) {
 	  ocpiInfo("OFED::XferServices ERROR: Couldn't poll completion Q()");
 	  throw XF::DataTransferEx( API_ERROR, "ibv_poll_cq()");
 	}
-	if ( wc[index].status == IBV_WC_SUCCESS ) {
-	  reinterpret_cast<XferRequest*>(wc[index].wr_id)->m_PComplete++;
-	  reinterpret_cast<XferRequest*>(wc[index].wr_id)->m_status = XF::XferRequest::CompleteSuccess;
-	  if ( reinterpret_cast<XferRequest*>(wc[index].wr_id)->m_PComplete ==
-	       reinterpret_cast<XferRequest*>(wc[index].wr_id)->m_PCount) {
-	    remPost( reinterpret_cast<XferRequest*>(wc[index].wr_id) );
+	m_cq_count += c;
+	for ( int index = 0; index < c; index++ ) {
+	  XferRequest *r = reinterpret_cast<XferRequest*>(wc[index].wr_id);
+	  if ( wc[index].status == IBV_WC_SUCCESS ) {
+	    r->m_PComplete++;
+	    r->m_status = XF::XferRequest::CompleteSuccess;
+	    if ( r->m_PComplete == r->m_PCount ) {
+	      remPost( r );
+	      r->completed();
+	    }
+	  }
+	  else {
+	    r->m_status = XF::XferRequest::CompleteFailure;
+	    ocpiAssert( 0 );
 	  }
 	}
-	else {
-	  reinterpret_cast<XferRequest*>(wc[index].wr_id)->m_status = XF::XferRequest::CompleteFailure;
-	  ocpiAssert( 0 );
-	}
-	index++;
-	c--;
+	if ( c < WC_COUNT )
+	  break;
+	c = ibv_poll_cq( m_sourceSmb->getCq(), WC_COUNT, wc );
       }
       
 #ifdef L1_DEBUG
@@ -697,7 +744,7 @@ namespace DataTransfer {
 
     ibv_qp  * 
     SmemServices::
-    getNextQp()
+    getNextQp(uint32_t &maxInline)
     {
       ibv_qp * qp;
       ibv_qp_init_attr iattr;
@@ -708,9 +755,16 @@ namespace DataTransfer {
       iattr.cap.max_recv_wr  = MAX_TX_DEPTH;
       iattr.cap.max_send_sge = 1;
       iattr.cap.max_recv_sge = 1;
-      iattr.cap.max_inline_data = 0;
+      iattr.cap.max_inline_data = MAX_INLINE;
       iattr.qp_type = IBV_QPT_RC;
       qp = ibv_create_qp( getOfedEp()->m_device->m_pd, &iattr);
+      if (! qp) {
+	ocpiInfo("OFED::SmemServices: device does not support inline data, creating QP without it");
+	iattr.cap.max_inline_data = 0;
+	qp = ibv_create_qp( getOfedEp()->m_device->m_pd, &iattr);
+      }
+      // The device reports the inline size it actually supports
+      maxInline = iattr.cap.max_inline_data;
       if (! qp)  {
 	ocpiInfo("OFED::XferServices ERROR: Could not create Queue Pair");
 	throw XF::DataTransferEx( RESOURCE_EXCEPTION, "completion channel Q" );	  
@@ -819,7 +873,7 @@ namespace DataTransfer {
 	  XF::XferRequest::Flags flags 
 	  )
     {
-      m_PCount++;
+      unchain();
       ibv_send_wr * wr  = (ibv_send_wr*)malloc( sizeof(ibv_send_wr) );
       memset( wr,0,sizeof( ibv_send_wr));
        ibv_sge     * sge = (ibv_sge*)malloc( sizeof(ibv_sge ) );
@@ -839,7 +893,8 @@ namespace DataTransfer {
       ocpiDebug("***** Remote vaddr = %" PRIu64 ", offset = %" DTOSDATATYPES_OFFSET_PRIu ",nbytes = %zu",
 		 wr->wr.rdma.remote_addr, dstoffs, nbytes );
       wr->wr.rdma.rkey = static_cast<EndPoint*>(&xferServices.m_targetSmb->endPoint())->m_rkey;
-      wr->send_flags = IBV_SEND_SIGNALED;
+      // Only the last work request in the posted chain is signaled: see chain()
+      wr->send_flags = nbytes <= xferServices.m_maxInline ? IBV_SEND_INLINE : 0;
 
       if (  (flags & XF::XferRequest::FlagTransfer) == XF::XferRequest::FlagTransfer ) {
 	wr->send_flags |= IBV_SEND_FENCE;
@@ -860,17 +915,34 @@ namespace DataTransfer {
       return this;
     }
 
+    // Copy a work request and its scatter/gather entry, unlinked, so that each request
+    // owns and frees its own.  Its completion identifies the owner, not the original.
+    static ibv_send_wr *
+    copyWr( const ibv_send_wr *from, XferRequest *owner )
+    {
+      ibv_send_wr *wr = (ibv_send_wr*)malloc( sizeof(ibv_send_wr) );
+      *wr = *from;
+      wr->next = NULL;
+      wr->wr_id = (uint64_t)owner;
+      if ( from->sg_list ) {
+	wr->sg_list = (ibv_sge*)malloc( sizeof(ibv_sge) );
+	*wr->sg_list = *from->sg_list;
+      }
+      return wr;
+    }
+
     // Group data transfer requests
     XF::XferRequest & 
     XferRequest::
     group (XF::XferRequest* l )
     {
       XferRequest * lhs = static_cast<XferRequest*>(l);
+      unchain();
+      lhs->unchain();
       ibv_send_wr * wr;
       ibv_send_wr * twr = lhs->m_wr;
       while ( twr ) {
-	wr = (ibv_send_wr*)malloc( sizeof(ibv_send_wr ));
-	*wr = *twr;
+	wr = copyWr( twr, this );
 	if ( m_wr ) {
 	  *m_nextWr = wr;
 	}
@@ -878,66 +950,150 @@ namespace DataTransfer {
 	  m_wr = wr;
 	}
 	m_nextWr = &wr->next;
-	twr = wr->next;
+	twr = twr->next;
       }
       if ( lhs->m_firstWr ) {
-	wr = (ibv_send_wr*)malloc( sizeof(ibv_send_wr ));
-	*wr = *lhs->m_firstWr;
+	wr = copyWr( lhs->m_firstWr, this );
 	m_firstWr->next = wr;
       }
       if ( lhs->m_lastWr ) {
-	wr = (ibv_send_wr*)malloc( sizeof(ibv_send_wr ));
-	*wr = *lhs->m_lastWr;
+	wr = copyWr( lhs->m_lastWr, this );
 	m_lastWr->next = wr;
       }
       return *this;
     }
 
 
-    // Queue data transfer request
-    void 
+    // Link the first (data), middle and last (flag) work request lists into one chain so
+    // that the whole transfer is a single post.  The RC queue pair executes them in order,
+    // so only the last needs to be signaled: its completion implies the others.
+    ibv_send_wr *
     XferRequest::
-    post ()
+    chain()
     {
-      m_PComplete = 0;
-      m_status = XF::XferRequest::Pending;
-      int err;
+      if ( m_chain )
+	return m_chain;
+      ibv_send_wr *lists[3] = { m_firstWr, m_wr, m_lastWr }, **link = &m_chain, *tail = NULL;
+      for ( unsigned n = 0; n < 3; n++ )
+	if ( lists[n] ) {
+	  *link = lists[n];
+	  for ( tail = lists[n]; ; tail = tail->next ) {
+	    tail->send_flags &= ~IBV_SEND_SIGNALED;
+	    if ( !tail->next )
+	      break;
+	  }
+	  m_tails[n] = tail;
+	  link = &tail->next;
+	}
+      if ( tail )
+	tail->send_flags |= IBV_SEND_SIGNALED;
+      m_PCount = tail ? 1 : 0;
+      return m_chain;
+    }
+
+    // Separate the lists again, before they are changed or freed
+    void
+    XferRequest::
+    unchain()
+    {
+      if ( ! m_chain )
+	return;
+      for ( unsigned n = 0; n < 3; n++ )
+	if ( m_tails[n] ) {
+	  m_tails[n]->next = NULL;
+	  m_tails[n] = NULL;
+	}
+      m_chain = NULL;
+    }
 
-      parent().addPost( this );      
+    ibv_send_wr *
+    XferRequest::
+    chainTail()
+    {
+      for ( unsigned n = 3; n > 0; n-- )
+	if ( m_tails[n-1] )
+	  return m_tails[n-1];
+      return NULL;
+    }
 
-      if ( m_firstWr ) {
+    ibv_send_wr *
+    XferRequest::
+    prepare()
+    {
+      m_PComplete = 0;
+      m_status = XF::XferRequest::Pending;
+      ibv_send_wr *wr = chain();
+      if ( wr ) {
+	parent().addPost( this );
 	parent().m_post_count++;
-	if ( (err=ibv_post_send( parent().m_qp, m_firstWr, &m_badWr[0] )) ) {
-	  OCPI::OS::sleep( 1 );	  
-	  if ( (err=ibv_post_send( parent().m_qp, m_firstWr, &m_badWr[0] )) ) {
-	    ocpiInfo("OFED::XferRequest ERROR: Couldn't post send with ibv_post_send(), %s", strerror(err));
-	    throw XF::DataTransferEx( API_ERROR, "ibv_post_send()");
-	  }
-	}
       }
+      return wr;
+    }
 
-      if ( m_wr ) {
-	parent().m_post_count++;
-	if ( (err=ibv_post_send( parent().m_qp, m_wr, &m_badWr[1] )) ) {
-	  OCPI::OS::sleep( 1 );	  
-	  if ( (err=ibv_post_send( parent().m_qp, m_wr, &m_badWr[1] )) ) {
-	    ocpiInfo("OFED::XferRequest ERROR: Couldn't post send with ibv_post_send(), %s", strerror(err));
-	    throw XF::DataTransferEx( API_ERROR, "ibv_post_send()");
-	  }
+    // Post a chain of work requests, retrying once from the one that failed, since
+    // work requests before it have been posted
+    static void
+    postChain( ibv_qp *qp, ibv_send_wr *wr )
+    {
+      int err;
+      ibv_send_wr *badWr;
+      if ( (err=ibv_post_send( qp, wr, &badWr )) ) {
+	OCPI::OS::sleep( 1 );	  
+	if ( (err=ibv_post_send( qp, badWr, &badWr )) ) {
+	  ocpiInfo("OFED::XferRequest ERROR: Couldn't post send with ibv_post_send(), %s", strerror(err));
+	  throw XF::DataTransferEx( API_ERROR, "ibv_post_send()");
 	}
       }
-      
-      if ( m_lastWr ) {	
-	parent().m_post_count++;
-	if ( (err=ibv_post_send(parent().m_qp, m_lastWr, &m_badWr[2] )) ) {
-	  OCPI::OS::sleep( 1 );	  
-	  if ( (err=ibv_post_send( parent().m_qp, m_lastWr, &m_badWr[2] )) ) {
-	    ocpiInfo("OFED::XferRequest ERROR: Couldn't post send with ibv_post_send(), %s", strerror(err));
-	    throw XF::DataTransferEx( API_ERROR, "ibv_post_send()");
-	  }
+    }
+
+    // Queue data transfer request
+    void 
+    XferRequest::
+    post ()
+    {
+      ibv_send_wr *wr = prepare();
+      if ( wr )
+	postChain( parent().m_qp, wr );
+    }
+
+    // Link the requests' chains, post them together, and separate them again.
+    // Each request's last work request is still the one signaled for it.
+    void
+    XferServices::
+    postBatch( XF::XferRequest **requests, size_t nRequests )
+    {
+      ibv_send_wr *first = NULL, *tail = NULL;
+      for ( size_t n = 0; n < nRequests; n++ ) {
+	XferRequest *r = static_cast<XferRequest*>(requests[n]);
+	ibv_send_wr *wr = r->prepare();
+	if ( wr ) {
+	  if ( tail )
+	    tail->next = wr;
+	  else
+	    first = wr;
+	  tail = r->chainTail();
 	}
       }
+      if ( ! first )
+	return;
+      try {
+	postChain( m_qp, first );
+      } catch (...) {
+	unlinkBatch( requests, nRequests );
+	throw;
+      }
+      unlinkBatch( requests, nRequests );
+    }
 
+    void
+    XferServices::
+    unlinkBatch( XF::XferRequest **requests, size_t nRequests )
+    {
+      for ( size_t n = 0; n < nRequests; n++ ) {
+	ibv_send_wr *tail = static_cast<XferRequest*>(requests[n])->chainTail();
+	if ( tail )
+	  tail->next = NULL;
+      }
     }
 
 
@@ -963,15 +1119,17 @@ namespace DataTransfer {
     XferRequest::
     XferRequest(XferServices &s)
       : XF::TransferBase<XferServices,XferRequest>(s, *this),
-	m_wr(NULL),m_nextWr(NULL),m_firstWr(NULL),m_lastWr(NULL), m_PCount(0), m_PComplete(0)
+	m_wr(NULL),m_nextWr(NULL),m_firstWr(NULL),m_lastWr(NULL), m_chain(NULL),
+	m_PCount(0), m_PComplete(0)
     {
+      m_tails[0] = m_tails[1] = m_tails[2] = NULL;
 
     }
 
     XferServices::
     XferServices(XF::EndPoint &source, XF::EndPoint &target)
       : XF::ConnectionBase<XferFactory,XferServices,XferRequest>(*this, source, target),
-	m_finalized(false), m_post_count(0), m_cq_count(0)
+	m_maxInline(0), m_finalized(false), m_post_count(0), m_cq_count(0)
     {
       OCPI::Util::AutoMutex guard ( m_mutex, true ); 
       m_sourceSmb = static_cast<SmemServices*>(&source.sMemServices());
@@ -979,7 +1137,7 @@ namespace DataTransfer {
       if ( m_sourceSmb->endPoint().name() ==  m_targetSmb->endPoint().name() ) {
 	ocpiAssert(0);
       }
-      m_qp = m_sourceSmb->getNextQp();
+      m_qp = m_sourceSmb->getNextQp(m_maxInline);
     }
 
     XF::XferRequest* 
@@ -43,7 +43,8 @@ namespace DataTransfer {
 
     // Create a mapping to a named file.
     //        Arguments:
-    //                strFilePath - Path to a file. If null, no backing store.
+    //                strFilePath - Directory for a backing file, e.g. a hugetlbfs mount.
+    //                              If null or empty, no backing store.
     //                strMapName        - Name of the mapping. Can be null.
     //                eAccess                - The type of access desired.
     //                iMaxSize        - Maximum size of mapping object.
@@ -55,13 +56,14 @@ namespace DataTransfer {
 
     // Open an existing mapping to a named file.
     //        Arguments:
+    //                strFilePath - Directory used when the mapping was created.
     //                strMapName        - Name of the mapping.
     //                eAccess                - The type of access desired.
     //        Returns:
     //                0 for success; platform dependent error code otherwise.
     //        Throws:
     //                DataTransferEx for all other exception conditions
-    virtual int OpenMapping (const char* strMapName, AccessType eAccess) = 0;
+    virtual int OpenMapping (const char* strFilePath, const char* strMapName, AccessType eAccess) = 0;
 
     // Close an existing mapping.
     //        Arguments:
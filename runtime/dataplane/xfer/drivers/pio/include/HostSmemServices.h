@@ -23,6 +23,10 @@
 
 #include "XferEndPoint.h"
 namespace DataTransfer {
-  SmemServices& createHostSmemServices(EndPoint& loc);
+  // hugePages: back the memory with a file in the hugetlbfs mount
+  // adviseHuge: otherwise advise transparent huge pages for the mapping
+  // numaNode: when creating, the NUMA node to place the memory on, or -1
+  SmemServices& createHostSmemServices(EndPoint& loc, bool hugePages = false,
+				       bool adviseHuge = false, int numaNode = -1);
 }
 #endif
@@ -31,6 +31,7 @@
  */
 #include <inttypes.h>
 #include <unistd.h>
+#include "OcpiOsMemory.h"
 #include "OcpiUtilMisc.h"
 #include "OcpiUtilSelfMutex.h"
 #include "XferEndPoint.h"
@@ -44,24 +45,44 @@ namespace XF = DataTransfer;
 namespace OCPI {
   namespace PIO {  
 
+// Endpoints whose memory is in hugetlbfs are named differently so the other side knows
+static const char pioHuge[] = "pioXferHuge";
+
 class EndPoint : public XF::EndPoint {
   friend class XferFactory;
   std::string m_smb_name;
+  bool m_hugePages;
 protected:
   EndPoint(XF::XferFactory &a_factory, const char *protoInfo, const char *eps, const char *other,
 	   bool a_local, size_t a_size, const OU::PValue *params)
-    : XF::EndPoint(a_factory, eps, other, a_local, a_size, params) { 
+    : XF::EndPoint(a_factory, eps, other, a_local, a_size, params), m_hugePages(false) { 
     static uint16_t smb_count = 0;
     if (protoInfo) {
       m_protoInfo = protoInfo;
       m_smb_name = protoInfo;
-    } else
-      OU::format(m_protoInfo, "pioXfer%d.%d", getpid(), smb_count++);
+      m_hugePages = !strncmp(protoInfo, pioHuge, sizeof(pioHuge) - 1);
+    } else {
+      // Use hugetlbfs only if it is mounted and has enough free pages, otherwise fall back
+      // to ordinary shared memory with transparent huge page advice.
+      size_t hps = OCPI::OS::hugePageSize();
+      if (a_factory.m_hugePages) {
+	if (hps && OCPI::OS::hugePageDirectory() &&
+	    OCPI::OS::freeHugePages() >= (size() + hps - 1) / hps)
+	  m_hugePages = true;
+	else
+	  ocpiInfo("PIO endpoint of %zu bytes: huge pages unavailable, using normal pages",
+		   size());
+      }
+      OU::format(m_protoInfo, "%s%d.%d", m_hugePages ? pioHuge : "pioXfer", getpid(),
+		 smb_count++);
+    }
   }
   // This method is used to allocate a transfer compatible SMB
   XF::SmemServices&
   createSmemServices() {
-    return createHostSmemServices(*this);
+    return createHostSmemServices(*this, m_hugePages,
+				  local() && !m_hugePages && factory().m_hugePages,
+				  local() ? factory().m_numaNode : -1);
   }
 };
 
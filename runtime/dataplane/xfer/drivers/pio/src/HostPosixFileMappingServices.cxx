@@ -42,6 +42,7 @@
 #include <sys/stat.h>
 #include "ocpi-config.h"
 #include "OcpiOsAssert.h"
+#include "OcpiOsMemory.h"
 #include "HostFileMappingServices.h"
 #include "OcpiUtilMisc.h"
 
@@ -57,7 +58,7 @@ namespace DataTransfer {
     size_t m_size;
   public:
     // Create a mapping to a named file.
-    //	strFilePath - Path to a file. If null, no backing store.
+    //	strFilePath - Directory for a backing file (e.g. hugetlbfs). If null, POSIX shm.
     //	strMapName	- Name of the mapping. Can be null.
     //	eAccess		- The type of access desired.
     //	iMaxSize	- Maximum size of mapping object.
@@ -69,6 +70,10 @@ namespace DataTransfer {
       if (rc == 0)
 	{
 #ifdef REAL_SHM
+	  // Files in hugetlbfs can only be sized in whole huge pages
+	  size_t hps = OCPI::OS::hugePageSize();
+	  if (!m_path.empty() && hps)
+	    iMaxSize = (iMaxSize + hps - 1) & ~(hps - 1);
 	  // Set the size of the shared area if not already large enough
 	  // Note Darwin/MacOS doesn't allow truncating it more than once, so it can't expand either
 	  struct stat statbuf;
@@ -92,12 +97,13 @@ namespace DataTransfer {
     }
 
     // Open an existing mapping to a named file.
+    //	strFilePath - Directory used when the mapping was created.
     //	strMapName	- Name of the mapping.
     //	eAccess		- The type of access desired.
     // Returns 0 for success or a platform specific error number.
-    int OpenMapping (const char* strMapName, AccessType eAccess)
+    int OpenMapping (const char* strFilePath, const char* strMapName, AccessType eAccess)
     {
-      return InitMapping (NULL, strMapName, eAccess, 0);
+      return InitMapping (strFilePath, strMapName, eAccess, 0);
     }
 
     // Close an existing mapping.
@@ -135,6 +141,10 @@ namespace DataTransfer {
       if (fRet == 0)
 	{
 #ifdef REAL_SHM
+	  // Mappings of files in hugetlbfs are whole huge pages, and must be unmapped that way
+	  size_t hps = OCPI::OS::hugePageSize();
+	  if (!m_path.empty() && hps)
+	    lLength = (lLength + hps - 1) & ~(hps - 1);
 	  iRet = mmap (NULL, lLength, iProtect, MAP_SHARED, m_fd, iOffset);
 #else
           iRet = mmap (NULL, lLength, iProtect, MAP_PRIVATE|MAP_ANON, -1, iOffset);
@@ -175,6 +185,7 @@ namespace DataTransfer {
 
   private:
     std::string m_name;
+    std::string m_path;         // backing file when not using POSIX shm
     int	m_fd;			// File descriptor
     int	m_errno;		// Last error.
     size_t m_length;		// Length of last mapping
@@ -185,7 +196,6 @@ namespace DataTransfer {
     // Common method to open shared memory
     int InitMapping (const char* strFilePath, std::string strMapName, AccessType eAccess, int iFlags)
     {
-      ( void ) strFilePath;
       // Terminate any current mapping
       TerminateMapping ();
 
@@ -198,10 +208,17 @@ namespace DataTransfer {
       }
       // A leading "/" is required.
       m_name = strMapName[0] == '/' ? strMapName : "/" + strMapName;
-      // Open a shared memory object
+      // Open a shared memory object, or a file in the given directory
 #ifdef REAL_SHM
-      m_fd = shm_open (m_name.c_str (), iOpenFlags | iFlags, 0666);
+      if (strFilePath && strFilePath[0]) {
+	m_path = strFilePath + m_name;
+	m_fd = open (m_path.c_str (), iOpenFlags | iFlags, 0666);
+      } else {
+	m_path.clear();
+	m_fd = shm_open (m_name.c_str (), iOpenFlags | iFlags, 0666);
+      }
 #else
+      (void)strFilePath;
       // Use anonymous mappings
       static int fakefd = 1000;
       m_fd = ++fakefd;
@@ -210,8 +227,8 @@ namespace DataTransfer {
       m_length = 0;
       if (m_fd == -1) {
 	  m_errno = errno;
-	  ocpiDebug("OcpiPosixFileMapping::InitMapping: shm_open of %s failed with errno %d: %s\n",
-		    m_name.c_str (), m_errno, strerror(m_errno));
+	  ocpiDebug("OcpiPosixFileMapping::InitMapping: open of %s failed with errno %d: %s\n",
+		    m_path.empty() ? m_name.c_str() : m_path.c_str(), m_errno, strerror(m_errno));
 	  return m_errno;
 	}
       m_created = iFlags == O_CREAT;
@@ -224,8 +241,12 @@ namespace DataTransfer {
     {
       if ( m_fd != -1 ) {
       ocpiDebug("shm closing %s fd %d created %d", m_name.c_str(), m_fd, m_created);
-	if (m_created)
-	  shm_unlink(m_name.c_str());
+	if (m_created) {
+	  if (m_path.empty())
+	    shm_unlink(m_name.c_str());
+	  else
+	    unlink(m_path.c_str());
+	}
 	close (m_fd);
       }
       m_fd =  -1;
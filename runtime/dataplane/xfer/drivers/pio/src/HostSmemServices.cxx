@@ -35,6 +35,7 @@
 
 #include <cstdio>
 #include <map>
+#include "OcpiOsMemory.h"
 #include "XferException.h"
 #include "XferEndPoint.h"
 #include "OcpiBaseSmemServices.h"
@@ -122,7 +123,7 @@ namespace DataTransfer {
 	  m_pSmem = new HostSmem(loc, handle, pMapper);
 	  BaseSmemServices::add(m_pSmem);
           ocpiDebug("Creating mapping of size %zu name %s", loc->size(), m_pSmem->m_name.c_str());
-          if ((rc = pMapper->CreateMapping ("", m_pSmem->m_name.c_str(),
+          if ((rc = pMapper->CreateMapping (m_hugeDir, m_pSmem->m_name.c_str(),
 					    OcpiFileMappingServices::ReadWriteAccess, loc->size())))
 	    throw OU::Error("CreatMapping failed: %u", rc);
 #else
@@ -208,7 +209,7 @@ namespace DataTransfer {
 #if 1
 	      pSmem = new HostSmem(m_location, handle, pMapper);
 	      BaseSmemServices::add(pSmem);
-              if (pMapper->OpenMapping(pSmem->m_name.c_str(),
+              if (pMapper->OpenMapping(m_hugeDir, pSmem->m_name.c_str(),
 				       OcpiFileMappingServices::AllAccess))
                 throw DataTransferEx(RESOURCE_EXCEPTION,
 				     "HostSmemServices::Attach: could not attach");
@@ -298,6 +299,8 @@ namespace DataTransfer {
           else
             {
               pSmem->m_maphandle = (void *)-1;
+              if (m_location->local())
+                placeMapping(pSmem->m_mappedva, pSmem->m_size);
             }
           pSmem->m_mappedoffset = 0;
           pSmem->m_mappedsize = pSmem->m_size;
@@ -326,6 +329,19 @@ namespace DataTransfer {
       return pva;
     }
 
+    // Apply the memory options to a new mapping we created and report what was obtained.
+    // This is done before the memory is used so the placement applies to all of it.
+    void placeMapping(void *va, size_t size)
+    {
+      bool advised = m_adviseHuge && OCPI::OS::adviseHugePages(va, size);
+      bool bound = m_numaNode >= 0 && OCPI::OS::bindMemory(va, size, (unsigned)m_numaNode);
+      ocpiInfo("Shared memory %s: %zu bytes, %s pages, NUMA node %s%s",
+               m_pSmem->m_name.c_str(), size,
+               m_hugeDir ? "huge" : advised ? "transparent huge" : "normal",
+               bound ? "preferred" : "default",
+               m_numaNode >= 0 && !bound ? " (placement unavailable)" : "");
+    }
+
     // Unmap the current mapped view.
     OCPI::OS::int32_t unMap ()
     {
@@ -409,9 +425,12 @@ namespace DataTransfer {
 
   public:
     // Ctor/dtor
-    HostSmemServices (EndPoint& cloc )
-      :BaseSmemServices(cloc)
+    HostSmemServices (EndPoint& cloc, bool hugePages, bool adviseHuge, int numaNode)
+      :BaseSmemServices(cloc), m_hugeDir(NULL), m_adviseHuge(adviseHuge), m_numaNode(numaNode)
     {
+      if (hugePages && !(m_hugeDir = OCPI::OS::hugePageDirectory()))
+        throw OU::Error("Shared memory endpoint %s requires huge pages, but none are mounted",
+                        cloc.name().c_str());
       EndPoint* loc = &cloc;
       if (cloc.local())
 	create(loc);
@@ -426,13 +445,17 @@ namespace DataTransfer {
 	delete m_pSmem;
     }
   private:
+    const char *m_hugeDir; // the hugetlbfs directory, if used
+    bool m_adviseHuge;
+    int m_numaNode;
   };
 
 
   // Platform dependent global that creates an instance
-  SmemServices& createHostSmemServices (EndPoint& loc )
+  SmemServices& createHostSmemServices (EndPoint& loc, bool hugePages, bool adviseHuge,
+                                        int numaNode)
   {
-    return *new HostSmemServices (loc);
+    return *new HostSmemServices (loc, hugePages, adviseHuge, numaNode);
   }
 
 }
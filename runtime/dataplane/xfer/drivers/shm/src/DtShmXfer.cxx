@@ -0,0 +1,191 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Abstract:
+ *   This file contains the implementation of the local shared memory transfer driver
+ *   whose transfers ring the doorbell of the process that owns the target endpoint.
+ *   Data movement is programmed I/O like the PIO driver, but the endpoint memory is an
+ *   anonymous (memfd) file that other processes map through /proc, and a container
+ *   that is waiting for events (the "polled=false" container parameter) is woken by
+ *   the flag writes rather than having to poll for them.
+ */
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "OcpiUtilMisc.h"
+#include "XferEndPoint.h"
+#include "XferDriver.h"
+#include "XferEvent.h"
+#include "XferPio.h"
+
+namespace OU = OCPI::Util;
+namespace XF = DataTransfer;
+namespace OCPI {
+  namespace SHM {
+
+class EndPoint : public XF::EndPoint {
+  friend class XferFactory;
+  friend class SmemServices;
+  pid_t m_pid;          // process that owns the memory
+  int m_fd;             // its file descriptor for the memory, in that process
+  int m_doorbellFd;     // its file descriptor for its doorbell, in that process
+  bool m_ownFd;         // we created m_fd and must close it
+  XF::Doorbell *m_doorbell;
+protected:
+  EndPoint(XF::XferFactory &a_factory, const char *protoInfo, const char *eps, const char *other,
+	   bool a_local, size_t a_size, const OU::PValue *params)
+    : XF::EndPoint(a_factory, eps, other, a_local, a_size, params),
+      m_pid(0), m_fd(-1), m_doorbellFd(-1), m_ownFd(false), m_doorbell(NULL) {
+    static unsigned smb_count = 0;
+    if (protoInfo) {
+      unsigned pid, count;
+      if (sscanf(protoInfo, "shm%u.%d.%d.%u", &pid, &m_fd, &m_doorbellFd, &count) != 4)
+	throw OU::Error("Invalid shm endpoint format in \"%s\"", protoInfo);
+      m_pid = (pid_t)pid;
+      m_protoInfo = protoInfo;
+    } else {
+      std::string name, error;
+      // Endpoints may be created by several threads at once
+      unsigned count = __sync_fetch_and_add(&smb_count, 1);
+      OU::format(name, "ocpi-shm%u", count);
+      if ((m_fd = XF::createSharedFile(name.c_str(), size(), error)) < 0)
+	throw OU::Error("Cannot create shm endpoint: %s", error.c_str());
+      m_ownFd = true;
+      m_pid = getpid();
+      XF::Doorbell::local(&m_doorbellFd);
+      OU::format(m_protoInfo, "shm%u.%d.%d.%u", (unsigned)m_pid, m_fd, m_doorbellFd, count);
+    }
+  }
+  ~EndPoint() {
+    if (m_ownFd)
+      close(m_fd);
+  }
+  XF::SmemServices &createSmemServices();
+public:
+  // The doorbell of the process that owns this endpoint, if it can be rung
+  XF::Doorbell *doorbell() {
+    if (!m_doorbell)
+      m_doorbell = XF::Doorbell::remote(m_pid, m_doorbellFd);
+    return m_doorbell;
+  }
+};
+
+// The whole endpoint is mapped at once, on first use
+class SmemServices : public XF::SmemServices {
+  EndPoint &m_shmEndPoint;
+  uint8_t *m_base;
+public:
+  SmemServices(EndPoint &ep)
+    : XF::SmemServices(ep), m_shmEndPoint(ep), m_base(NULL) {
+  }
+  ~SmemServices() {
+    if (m_base)
+      munmap(m_base, m_shmEndPoint.size());
+  }
+  void *map(DtOsDataTypes::Offset offset, size_t size) {
+    if (offset + size > m_shmEndPoint.size())
+      throw OU::Error("Invalid shm mapping: offset %" DTOSDATATYPES_OFFSET_PRIx
+		      " size %zu, endpoint size %zu", offset, size, m_shmEndPoint.size());
+    if (!m_base) {
+      std::string error;
+      if (!(m_base = (uint8_t *)XF::mapSharedFile(m_shmEndPoint.m_pid, m_shmEndPoint.m_fd,
+						  m_shmEndPoint.size(), error)))
+	throw OU::Error("Cannot map shm endpoint %s: %s", m_shmEndPoint.name().c_str(),
+			error.c_str());
+    }
+    return m_base + offset;
+  }
+};
+
+XF::SmemServices &EndPoint::
+createSmemServices() {
+  return *new SmemServices(*this);
+}
+
+class XferFactory;
+class Device : public XF::DeviceBase<XferFactory,Device> {
+  Device(const char *a_name)
+    : XF::DeviceBase<XferFactory, Device>(a_name, *this) {
+  }
+};
+
+class XferServices;
+class XferRequest : public XF::TransferBase<XferServices, XferRequest> {
+  friend class XferServices;
+protected:
+  XferRequest(XferServices &a_parent, XF_template temp)
+    : XF::TransferBase<XferServices, XferRequest>(a_parent, *this, temp) {
+  }
+  // The transfer is complete when post returns, so the target can be told right away
+  void post();
+};
+
+class XferServices : public XF::ConnectionBase<XferFactory,XferServices,XferRequest> {
+  friend class XferRequest;
+  friend class XferFactory;
+  XF_template m_xftemplate;
+  XF::Doorbell *m_doorbell;
+protected:
+  XferServices(XF::EndPoint &source, XF::EndPoint &target)
+    : XF::ConnectionBase<XferFactory, XferServices, XferRequest>(*this, source, target),
+      m_doorbell(static_cast<EndPoint &>(target).doorbell()) {
+    xfer_create(source, target, 0, &m_xftemplate);
+  }
+  ~XferServices() {
+    xfer_destroy(m_xftemplate, 0);
+  }
+  XF::XferRequest *
+  createXferRequest() {
+    return new XferRequest(*this, m_xftemplate);
+  }
+};
+
+void XferRequest::
+post() {
+  XF::XferRequest::post();
+  if (parent().m_doorbell)
+    parent().m_doorbell->ring();
+}
+
+const char *shm = "shm"; // name passed to inherited template class
+class XferFactory : public XF::DriverBase<XferFactory, Device, XferServices, shm> {
+  friend class XferServices;
+protected:
+  virtual ~XferFactory() throw () {
+  }
+  const char* getProtocol() {
+    return "ocpi-smb-shm";
+  }
+  XF::EndPoint &
+  createEndPoint(const char *protoInfo, const char *eps, const char *other, bool local,
+		 size_t size, const OCPI::Util::PValue *params) {
+    ocpiDebug("In SHM::XferFactory::createEndPoint(): %zu", m_SMBSize);
+    return *new EndPoint(*this, protoInfo, eps, other, local, size, params);
+  }
+  XF::XferServices &
+  createXferServices(XF::EndPoint &source, XF::EndPoint &target) {
+    return *new XferServices(source, target);
+  }
+};
+
+XF::RegisterTransferDriver<XferFactory> driver;
+  }
+}
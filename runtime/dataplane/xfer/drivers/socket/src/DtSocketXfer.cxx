@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <unistd.h>  // FIXME for gethostname - use OS::
 #include <deque>
+#include <vector>
 #include "OcpiOsSocket.h"
 #include "OcpiOsMisc.h"
 #include "OcpiOsAssert.h"
@@ -318,10 +319,20 @@ class XferServices
   // The handle returned by xfer_create
   XF_template        m_xftemplate;
   OS::Socket         m_socket;
+  // While posting a batch, the writes of its requests, to be sent with one sendv
+  struct Write {
+    DtOsDataTypes::Offset offset;
+    uint8_t *data;
+    size_t nbytes;
+  };
+  bool               m_batching;
+  std::vector<Write> m_writes;
+  std::vector<DataHeader> m_headers;
+  std::vector<OS::IOVec> m_iov;
 public:
   XferServices(XF::EndPoint &source, XF::EndPoint &target)
     : ConnectionBase<XferFactory,XferServices,XferRequest>
-      (*this, source, target) {
+      (*this, source, target), m_batching(false) {
     xfer_create (source, target, 0, &m_xftemplate);
     EndPoint &rsep = *static_cast<EndPoint *>(&target);
     m_socket.connect(rsep.m_ipAddress, rsep.m_portNum);
@@ -333,19 +344,53 @@ public:
     m_socket.close();
   }
   XF::XferRequest *createXferRequest();
+  // Collect the writes of all the requests, and send them, with their headers, together
+  void postBatch(XF::XferRequest **requests, size_t nRequests) {
+    m_writes.clear();
+    m_batching = true;
+    try {
+      for (size_t n = 0; n < nRequests; n++)
+	requests[n]->post();
+    } catch (...) {
+      m_batching = false;
+      throw;
+    }
+    m_batching = false;
+    m_headers.resize(m_writes.size());
+    m_iov.resize(m_writes.size() * 2);
+    for (size_t n = 0; n < m_writes.size(); n++) {
+      setHeader(m_headers[n], m_writes[n].offset, m_writes[n].nbytes);
+      m_iov[n*2].iov_base = &m_headers[n];
+      m_iov[n*2].iov_len = sizeof(DataHeader);
+      m_iov[n*2+1].iov_base = m_writes[n].data;
+      m_iov[n*2+1].iov_len = m_writes[n].nbytes;
+    }
+    if (m_iov.size())
+      m_socket.sendv(&m_iov[0], OCPI_UTRUNCATE(unsigned, m_iov.size()));
+  }
 protected:
   OS::Socket& socket(){ return m_socket; }
-  void send(DtOsDataTypes::Offset offset, uint8_t *data, size_t nbytes) {
-    DataHeader hdr;
+  void setHeader(DataHeader &hdr, DtOsDataTypes::Offset offset, size_t nbytes) {
     static uint32_t count = 0xabc00000;
     hdr.offset = offset;
     hdr.length = OCPI_UTRUNCATE(uint32_t, nbytes);
     hdr.count = count++;
     ocpiDebug("Sending IP header %zu %" PRIu32 " %" DTOSDATATYPES_OFFSET_PRIx" %" PRIx32,
 	      sizeof(DataHeader), hdr.length, hdr.offset, hdr.count);
+  }
+  void send(DtOsDataTypes::Offset offset, uint8_t *data, size_t nbytes) {
+    DataHeader hdr;
+    setHeader(hdr, offset, nbytes);
     m_socket.send((char*)&hdr, sizeof(DataHeader));
     m_socket.send((char *)data, nbytes);
   }
+  void write(DtOsDataTypes::Offset offset, uint8_t *data, size_t nbytes) {
+    if (m_batching) {
+      Write w = { offset, data, nbytes };
+      m_writes.push_back(w);
+    } else
+      send(offset, data, nbytes);
+  }
 };
 
 XF::XferServices &XferFactory::
@@ -375,7 +420,7 @@ private:
     ocpiDebug("Socket: copying %d bytes from 0x%llx to 0x%llx", transfer->nbytes,transfer->src_off,transfer->dst_off);
     ocpiDebug("source wrd 1 = %d", src1[0] );
 #endif
-    parent().send(transfer->dst_off, (uint8_t *)transfer->src_va, transfer->nbytes);
+    parent().write(transfer->dst_off, (uint8_t *)transfer->src_va, transfer->nbytes);
   }
 };
 
@@ -23,6 +23,12 @@
  *  John Miller -  12/2010
  *  Initial version
  *
+ *  With -bench, the client times the round trips and per-message output is suppressed on
+ *  both sides.  The OFED driver can be benchmarked without InfiniBand hardware using
+ *  Soft-RoCE on one host:
+ *    modprobe rdma_rxe; rdma link add rxe0 type rxe netdev <ethernet interface>
+ *    transportTest -endpoint ocpi-ofed-rdma -bench -iters 100000 &
+ *    transportTest -endpoint ocpi-ofed-rdma -bench -iters 100000 -h localhost
  */
 
 #include <stdlib.h>
@@ -240,6 +246,7 @@ public:
   int  endpoint_index;
   std::string server;
   int iters;
+  bool bench;
   bool show_drivers;
   std::string xml_config;
 private:
@@ -255,6 +262,7 @@ OcpiRccBinderConfigurator ()
     protocol_index(-1),
     endpoint_index(0),
     iters(10),
+    bench(false),
     show_drivers(false),
     xml_config("../dconf.xml")
   
@@ -290,6 +298,9 @@ OcpiRccBinderConfigurator::g_options[] = {
   { OCPI::Util::CommandLineConfiguration::OptionType::LONG,
     "iters", "Number of iterations for test loop",
     OCPI_CLC_OPT(&OcpiRccBinderConfigurator::iters), 0 },
+  { OCPI::Util::CommandLineConfiguration::OptionType::BOOLEAN,
+    "bench", "Time the round trips, without per-message output",
+    OCPI_CLC_OPT(&OcpiRccBinderConfigurator::bench), 0 },
   { OCPI::Util::CommandLineConfiguration::OptionType::NONE,
     "help", "This message",
     OCPI_CLC_OPT(&OcpiRccBinderConfigurator::help), 0 },
@@ -407,13 +418,16 @@ public:
     m_Txmem->buffers[sbid].nbytes = nbytes;
 
 
-    printf("Posting %d bytes to buffer %d,%d \n", nbytes, sbid, tbid );
+    if ( !config.bench )
+      printf("Posting %d bytes to buffer %d,%d \n", nbytes, sbid, tbid );
 
 
     m_reqs [ sbid ] [ tbid ] ->post();
 
 #ifdef DEBUG
     while (  m_reqs [ sbid ] [ tbid ] ->getStatus() != DataTransfer::XferRequest::CompleteSuccess ) {      
+      if ( config.bench )
+	continue;
       printf("Waiting for the posted message to be sent\n");
       OCPI::OS::sleep( 1000 );      
     }
@@ -430,8 +444,10 @@ public:
            OCPI::OS::sleep( 0 );
     }
     //    OCPI::OS::sleep( 1000 );          
-    printf("The full flag =%d\n", m_Rxmem->buffers[buffer_id].full_flag );
-    printf("N BYTES  =%d\n", m_Rxmem->buffers[buffer_id].nbytes );
+    if ( !config.bench ) {
+      printf("The full flag =%d\n", m_Rxmem->buffers[buffer_id].full_flag );
+      printf("N BYTES  =%d\n", m_Rxmem->buffers[buffer_id].nbytes );
+    }
     return  m_Rxmem->buffers[buffer_id].nbytes;
   }
 
@@ -498,9 +514,11 @@ public:
 
     for (;;) {
 
-      printf("*****  About to wait for message\n");
+      if ( !config.bench )
+	printf("*****  About to wait for message\n");
       int c = waitForMsg( 0 );
-      printf("Got a  message\n");
+      if ( !config.bench )
+	printf("Got a  message\n");
 
       if (  c == 0 ) {
 	printf("Received %d buffers\n", count );
@@ -511,7 +529,7 @@ public:
 	break;
       }
 
-      if ( (count%1) == 0 ) 
+      if ( !config.bench ) 
 	printf("Server: b(%d) got a message and sending it back, nbytes = %d\n", count, m_Rxmem->buffers[0].nbytes );
 
 
@@ -752,6 +770,8 @@ int main( int argc, char** argv )
       uint8_t * out_data = (uint8_t*)client.getMsgBuffer(2, true);
       uint8_t * in_data = (uint8_t*)client.getMsgBuffer(0, false);
 
+      struct timeval start, end;
+      gettimeofday( &start, NULL );
       for ( int n=0; n<config.iters; n++ ) {
 
 	for ( int y=1; y<BUFFER_SIZE; y++ ) {
@@ -793,6 +813,13 @@ int main( int argc, char** argv )
 	}
       }
 
+      gettimeofday( &end, NULL );
+      if ( config.bench && count ) {
+	double usecs = (double)(end.tv_sec - start.tv_sec) * 1e6 + (double)(end.tv_usec - start.tv_usec);
+	printf("Benchmark: %d round trips in %.0f usecs, %.2f usecs per round trip\n",
+	       count, usecs, usecs / count);
+      }
+
       // Done
       client.produce( 2,0,0);	
     }
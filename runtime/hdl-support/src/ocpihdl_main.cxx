@@ -75,7 +75,7 @@ static Function
 search, emulate, ethers, probe, testdma, admin, bram, unbram, uuid, reset, set, get, control,
   radmin, wadmin, rmeta, settime, deltatime, wdump, wreset, wunreset, wop, wwctl, wclear, wwpage,
   wread, wwrite, sendData, receiveData, receiveRDMA, sendRDMA, simulate, getxml, load, unload,
-  status;
+  status, bitstream;
 static bool verbose = false, parseable = false, hex = false, isPublic = false;
 static int log = -1;
 std::string platform, simExec;
@@ -104,6 +104,7 @@ struct Command {
   unsigned options;
 } commands [] = {
   { "admin", admin, DEVICE },
+  { "bitstream", bitstream, 0 },
   { "bram", bram, 0 },
   { "control", control, DEVICE},
   { "deltatime", deltatime, DEVICE},
@@ -188,6 +189,8 @@ usage(const char *cmd) {
 	  "                                 # generate UUID verilog file\n"
 	  "    load  <hdl-dev> <file>       # load bitstream from file\n"
 	  "    unload  <hdl-dev>            # revert device to unloaded state: no bitstream\n"
+	  "    bitstream <file> <target> [<uuid>]\n"
+	  "                                 # time the Zynq bitstream loader writing to a file or FIFO\n"
           "    getxml <hdl-dev> <file>      # Extract the xml metadata from the device into the file\n"
           "    simulate                     # run simulator inside created sim: device\n"
           "  Options: (values are either directly after the letter or in the next argument)\n"
@@ -2059,6 +2062,19 @@ load(const char **ap) {
   if (dev->load(ap[0], error))
     bad("error loading device %s", device);
 }
+// Run the Zynq bitstream loader into a stand-in for the configuration device (a file
+// or FIFO) to measure it without the hardware.  The optional uuid enables the cache.
+static void
+bitstream(const char **ap) {
+  if (!ap[0] || !ap[1])
+    bad("an input bitstream file and an output target are required with this command");
+  OS::Timer timer(true);
+  if (OH::Zynq::loadBitstream(ap[0], ap[1], ap[2], error))
+    bad("error loading bitstream %s into %s", ap[0], ap[1]);
+  OS::ElapsedTime et = timer.getElapsed();
+  printf("Loaded bitstream %s into %s in %" PRIu32 ".%06" PRIu32 " seconds\n",
+	 ap[0], ap[1], et.seconds(), et.nanoseconds() / 1000);
+}
 static void
 unload(const char **) {
   if (dev->unload(error))
@@ -52,6 +52,12 @@ namespace OCPI {
 	virtual bool found(OCPI::HDL::Device &dev, const char **excludes, bool discoveryOnly,
 			   std::string &error) = 0;
       };
+      // Load a (possibly compressed) bitstream file into the configuration device, or a
+      // file or FIFO standing in for it.  When the uuid of the artifact is given and
+      // OCPI_HDL_BITSTREAM_CACHE names a directory, the prepared (decompressed and
+      // byte swapped) bitstream is cached there for the next load.  Return true on error.
+      bool loadBitstream(const char *file, const char *target, const char *uuid,
+			 std::string &error);
     }
   }
 }
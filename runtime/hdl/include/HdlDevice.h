@@ -96,6 +96,11 @@ namespace OCPI {
       RomWord getRomWord(uint16_t n);
       virtual bool getMetadata(std::vector<char> &xml, std::string &err);
       virtual bool load(const char *name, std::string &err) = 0;
+      // Load the bitstream of an artifact with a known uuid, which the device may use
+      // to keep a prepared form of the bitstream for later loads.
+      virtual bool loadUUID(const char *name, const std::string &/*uuid*/, std::string &err) {
+	return load(name, err);
+      }
       virtual bool unload(std::string &err) = 0;
       virtual void connect() {}
       virtual bool needThread() const { return false; };
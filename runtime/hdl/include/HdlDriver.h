@@ -22,6 +22,7 @@
 #define HdlDriver_H
 
 #include <string>
+#include <vector>
 #include "HdlSimDriver.h"
 #include "HdlLSimDriver.h"
 #include "HdlBusDriver.h"
@@ -48,8 +49,18 @@ namespace OCPI {
 	virtual protected OCPI::Util::SelfMutex
     {
       const OCPI::Util::PValue *m_params; // a temporary during discovery
+      OCPI::OS::Mutex m_foundMutex;       // for devices found by concurrent bus searches
+      std::vector<Device *> *m_deferred;  // devices found, when creation is deferred
+      std::vector<std::string> m_foundNames; // devices whose containers were created
       bool setup(Device &dev, ezxml_t &config, std::string &err);
+      bool foundNow(Device &dev, const char **excludes, bool discoveryOnly, std::string &error);
+      Device *openDevice(const char *name, bool discovery, bool forLoad,
+			 const OCPI::API::PValue *params, std::string &err);
+      unsigned searchCached(const char *file, const char **exclude, unsigned &nCached);
+      unsigned searchBuses(const char **exclude, bool discoveryOnly);
+      static void searchBus(void *arg, size_t bus, size_t, size_t);
     public:
+      Driver();
       void print(const char *name, Access &access);
       // This driver method is called when container-discovery happens, to see if there
       // are any container devices supported by this driver
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <climits>
 #include <cassert>
+#include <string>
 #include "OcpiOsSocket.h"
 // These definitions must match the VHDL
 // constant max_reads_outstanding  : natural := 8;
@@ -64,6 +65,22 @@
 namespace OCPI {
   namespace HDL {
     namespace SDP {
+      // A byte stream that SDP messages are sent on or received from.
+      // Both return true on error.  Reads block until all bytes are read.
+      class Channel {
+      public:
+	virtual ~Channel() {}
+	virtual bool read(uint8_t *buf, size_t nRequested, std::string &error) = 0;
+	virtual bool write(const uint8_t *data, size_t length, std::string &error) = 0;
+      };
+      // The usual channel: a file descriptor (socket or pipe)
+      class FdChannel : public Channel {
+	int m_fd;
+      public:
+	FdChannel(int fd) : m_fd(fd) {}
+	bool read(uint8_t *buf, size_t nRequested, std::string &error);
+	bool write(const uint8_t *data, size_t length, std::string &error);
+      };
       class Header {
       public:
 	static const unsigned
@@ -148,14 +165,15 @@ namespace OCPI {
 	}
 	inline bool doRequest(OCPI::OS::Socket &s, uint8_t *data, std::string &error) {
 	  size_t length;
-	  return startRequest(s.fd(), data, length, error) ? true :
-	    endRequest(s.fd(), data, error);
+	  FdChannel c(s.fd());
+	  return startRequest(c, data, length, error) ? true :
+	    endRequest(c, data, error);
 	}
-	bool startRequest(int sendFd, uint8_t *data, size_t &length, std::string &error);
-	bool sendResponse(int sendFd, uint8_t *data, size_t &length, std::string &error);
-	bool endRequest(int recvFd, uint8_t *data, std::string &error);
-	bool getHeader(int recvFd, bool &request, std::string &error);
-	bool endRequest(Header &h, int recvFd, uint8_t *data, std::string &error);
+	bool startRequest(Channel &send, uint8_t *data, size_t &length, std::string &error);
+	bool sendResponse(Channel &send, uint8_t *data, size_t &length, std::string &error);
+	bool endRequest(Channel &recv, uint8_t *data, std::string &error);
+	bool getHeader(Channel &recv, bool &request, std::string &error);
+	bool endRequest(Header &h, Channel &recv, uint8_t *data, std::string &error);
         void respond();
       };
       bool read(int fd, uint8_t *buf, size_t nRequested, std::string &error);
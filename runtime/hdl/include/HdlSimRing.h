@@ -0,0 +1,105 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Shared memory byte rings between the local simulation server and a simulator.
+ * They carry exactly the same byte streams as the request/response/control/ack fifos,
+ * without a system call per access on either side.
+ * Each ring has one producer and one consumer.  The file is created by the server in
+ * the simulation directory and its path is given to the simulator in the environment
+ * variable named below.  The simulator side is sim_ring.c in the sdp primitive library.
+ * This file is included by C code that is linked into simulators, so it must stay C.
+ */
+#ifndef HDL_SIM_RING_H
+#define HDL_SIM_RING_H
+#include <stddef.h>
+#include <stdint.h>
+
+#define OCPI_SIM_RING_MAGIC 0x4f435352u /* "OCSR" */
+#define OCPI_SIM_RING_BYTES 65536u      /* per ring, a power of two */
+#define OCPI_SIM_RING_ENV "OCPI_HDL_SIM_RINGS"
+#define OCPI_SIM_RING_FILE "rings"
+
+// The rings, in the same directions as the fifos of the same names
+enum OcpiSimRingIndex {
+  OCPI_SIM_RING_REQUEST,  // server to sim: SDP requests and responses
+  OCPI_SIM_RING_RESPONSE, // sim to server: SDP responses and requests
+  OCPI_SIM_RING_CONTROL,  // server to sim: spin and DCP credits etc.
+  OCPI_SIM_RING_ACK,      // sim to server: spin credit acks
+  OCPI_SIM_RING_COUNT
+};
+
+// The indices are free-running and each is on its own cache line
+typedef struct {
+  volatile uint32_t head;                  // written by the producer
+  uint8_t pad0[64 - sizeof(uint32_t)];
+  volatile uint32_t tail;                  // written by the consumer
+  uint8_t pad1[64 - sizeof(uint32_t)];
+  uint8_t data[OCPI_SIM_RING_BYTES];
+} OcpiSimRing;
+
+typedef struct {
+  uint32_t magic, nRings, ringBytes;
+  int32_t serverPid;                       // so the simulator can tell when it is gone
+  uint8_t pad[64 - 4 * sizeof(uint32_t)];
+  OcpiSimRing rings[OCPI_SIM_RING_COUNT];
+} OcpiSimRings;
+
+// Initialize newly created (zeroed) rings, publishing the magic number last
+static inline void
+ocpiSimRingsInit(OcpiSimRings *r, int32_t serverPid) {
+  r->nRings = OCPI_SIM_RING_COUNT;
+  r->ringBytes = OCPI_SIM_RING_BYTES;
+  r->serverPid = serverPid;
+  __atomic_store_n(&r->magic, OCPI_SIM_RING_MAGIC, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+ocpiSimRingFilled(OcpiSimRing *r) {
+  return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - r->tail;
+}
+
+// Copy up to n bytes into the ring, returning how many fit
+static inline size_t
+ocpiSimRingPut(OcpiSimRing *r, const uint8_t *data, size_t n) {
+  uint32_t head = r->head, room =
+    OCPI_SIM_RING_BYTES - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+  size_t i;
+  if (n > room)
+    n = room;
+  for (i = 0; i < n; i++)
+    r->data[(head + i) & (OCPI_SIM_RING_BYTES - 1)] = data[i];
+  __atomic_store_n(&r->head, head + (uint32_t)n, __ATOMIC_RELEASE);
+  return n;
+}
+
+// Copy up to n bytes out of the ring, returning how many there were
+static inline size_t
+ocpiSimRingGet(OcpiSimRing *r, uint8_t *buf, size_t n) {
+  uint32_t tail = r->tail, filled = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+  size_t i;
+  if (n > filled)
+    n = filled;
+  for (i = 0; i < n; i++)
+    buf[i] = r->data[(tail + i) & (OCPI_SIM_RING_BYTES - 1)];
+  __atomic_store_n(&r->tail, tail + (uint32_t)n, __ATOMIC_RELEASE);
+  return n;
+}
+#endif
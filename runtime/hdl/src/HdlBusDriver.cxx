@@ -27,10 +27,19 @@
   */
 #include <stdint.h>
 #include <errno.h>
+#include <algorithm>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 #include "zlib.h"
 #include "ocpi-config.h"
+#include "OcpiOsSemaphore.h"
+#include "OcpiOsThreadManager.h"
+#include "OcpiOsTimer.h"
+#include "OcpiUtilMisc.h"
 #include "HdlZynq.h"
 #include "HdlBusDriver.h"
 #ifdef OCPI_OS_macos
@@ -42,6 +51,248 @@
    namespace HDL {
      namespace Zynq {
        namespace OU = OCPI::Util;
+       namespace OS = OCPI::OS;
+
+       // Scan the buffer and identify the start of the sync pattern
+       static uint8_t *findsync(uint8_t *buf, size_t len) {
+	 static uint8_t startup[] = {
+	   0xff, 0xff, 0xff, 0xff,
+	   0xff, 0xff, 0xff, 0xff, 
+	   0xff, 0xff, 0xff, 0xff,
+	   0xff, 0xff, 0xff, 0xff, 
+	   0xff, 0xff, 0xff, 0xff,
+	   0xff, 0xff, 0xff, 0xff, 
+	   0xff, 0xff, 0xff, 0xff,
+	   0xff, 0xff, 0xff, 0xff, 
+	   0x00, 0x00, 0x00, 0xbb,
+	   0x11, 0x22, 0x00, 0x44,
+	   0xff, 0xff, 0xff, 0xff, 
+	   0xff, 0xff, 0xff, 0xff, 
+	   0xaa, 0x99, 0x55, 0x66};
+	 uint8_t *p8 = startup;
+	 for (uint8_t *u8 = buf; u8 < buf + len; u8++)
+	   if (*u8 == *p8++) {
+	     if (p8 >= startup+sizeof(startup))
+	       return u8 + 1 - sizeof(startup);
+	   } else {
+	     p8 = startup;
+	     if (*u8 == *p8) p8++;
+	   }
+	 return 0;
+       }
+
+       // Byte swap the 32 bit words of the buffer in place
+       static void swapWords(uint8_t *buf, size_t len) {
+	 size_t n = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	 for (; n + 16 <= len; n += 16)
+	   vst1q_u8(buf + n, vrev32q_u8(vld1q_u8(buf + n)));
+#endif
+	 for (uint32_t *p32 = (uint32_t *)(buf + n); n < len; n += 4, p32++)
+	   *p32 = OU::swap32(*p32);
+       }
+
+       // Write all of a buffer, in smaller pieces if the device cannot take it at once.
+       // Return true on error
+       static bool writeAll(int fd, const uint8_t *buf, size_t len, size_t &chunk) {
+	 while (len) {
+	   ssize_t n = ::write(fd, buf, std::min(len, chunk));
+	   if (n < 0 && errno == ENOMEM && chunk > 8*1024)
+	     chunk /= 2;
+	   else if (n < 0 && errno == EINTR)
+	     continue;
+	   else if (n <= 0)
+	     return true;
+	   else {
+	     buf += n;
+	     len -= (size_t)n;
+	   }
+	 }
+	 return false;
+       }
+
+       // The bitstream loading pipeline.  A reader thread decompresses (or reads the cached,
+       // already prepared bitstream) and byte swaps into a ring of large buffers, while the
+       // caller writes filled buffers to the target.  Everything that can fail before the
+       // target is opened is done first, since just opening the device resets the PL.
+       struct Loader {
+	 static const unsigned c_nBuffers = 3;
+	 static const size_t c_bufferSize = 1024*1024;
+	 struct Buffer {
+	   uint32_t data[c_bufferSize/sizeof(uint32_t)]; // aligned for swapping
+	   size_t length;
+	   bool eof, failed;            // failed: m_error is set
+	 } *m_buffers;
+	 int m_fd;                      // the bitstream or cached file
+	 gzFile m_gz;                   // when decompressing
+	 size_t m_first;                // data already in the first buffer
+	 OS::Semaphore m_free, m_full;
+	 volatile bool m_abort;
+	 std::string m_error;           // reader thread error, read after a failed buffer
+	 Loader()
+	   : m_buffers(new Buffer[c_nBuffers]), m_fd(-1), m_gz(NULL), m_first(0),
+	     m_free(c_nBuffers), m_full(0), m_abort(false) {
+	 }
+	 ~Loader() {
+	   if (m_gz)
+	     gzclose(m_gz);
+	   else if (m_fd >= 0)
+	     ::close(m_fd);
+	   delete [] m_buffers;
+	 }
+	 // Open the cached bitstream, which starts at the sync pattern and is already swapped
+	 bool openCached(const char *cached) {
+	   if ((m_fd = ::open(cached, O_RDONLY)) < 0)
+	     return true;
+	   ocpiInfo("Loading the prepared bitstream cached in \"%s\"", cached);
+	   return false;
+	 }
+	 // Open the bitstream and read up to the sync pattern before byte swapping
+	 bool open(const char *file, std::string &error) {
+	   uint8_t *buf = (uint8_t *)m_buffers[0].data, *p8;
+	   int n, zerror;
+	   if ((m_fd = ::open(file, O_RDONLY)) < 0)
+	     return OU::eformat(error, "Can't open bitstream file '%s' for reading: %s(%d)",
+				file, strerror(errno), errno);
+	   if ((m_gz = ::gzdopen(m_fd, "rb")) == NULL)
+	     return OU::eformat(error, "Can't open compressed bitstream file '%s' for : %s(%u)",
+				file, strerror(errno), errno);
+	   if ((n = ::gzread(m_gz, buf, 8*1024)) <= 0)
+	     return OU::eformat(error, "Error reading initial bitstream buffer: %s(%u/%d)",
+				gzerror(m_gz, &zerror), errno, n);
+	   if (!(p8 = findsync(buf, (size_t)n)))
+	     return OU::eformat(error, "Can't find sync pattern in compressed bit file");
+	   m_first = (size_t)(buf + n - p8);
+	   if (p8 != buf)
+	     memmove(buf, p8, m_first);
+	   return false;
+	 }
+	 // Fill a buffer, returning the number of bytes or -1 on error
+	 ssize_t fill(uint8_t *buf, size_t len) {
+	   size_t total = 0;
+	   while (total < len) {
+	     int n, zerror;
+	     if (m_gz) {
+	       if ((n = ::gzread(m_gz, buf + total, (unsigned)(len - total))) < 0) {
+		 OU::format(m_error, "Error reading compressed bitstream: %s(%u/%d)",
+			    gzerror(m_gz, &zerror), errno, n);
+		 return -1;
+	       }
+	     } else if ((n = (int)::read(m_fd, buf + total, len - total)) < 0) {
+	       if (errno == EINTR)
+		 continue;
+	       OU::format(m_error, "Error reading cached bitstream: %s(%u)",
+			  strerror(errno), errno);
+	       return -1;
+	     }
+	     if (n == 0)
+	       break;
+	     total += (size_t)n;
+	   }
+	   return (ssize_t)total;
+	 }
+	 static void reader(void *arg) { ((Loader *)arg)->reader(); }
+	 void reader() {
+	   for (unsigned n = 0; ; n = (n + 1) % c_nBuffers) {
+	     Buffer &b = m_buffers[n];
+	     m_free.wait();
+	     if (m_abort)
+	       return;
+	     size_t first = m_first; // data read by open() for the first buffer
+	     m_first = 0;
+	     ssize_t len = fill((uint8_t *)b.data + first, c_bufferSize - first);
+	     b.length = first + (len < 0 ? 0 : (size_t)len);
+	     b.eof = len < (ssize_t)(c_bufferSize - first);
+	     if ((b.failed = len < 0 || (b.length & 3) != 0)) {
+	       if (len >= 0)
+		 m_error = "Bitstream data is not a multiple of 4 bytes";
+	     } else if (m_gz)
+	       swapWords((uint8_t *)b.data, b.length);
+	     m_full.post();
+	     if (b.eof || b.failed)
+	       return;
+	   }
+	 }
+       };
+
+       bool
+       loadBitstream(const char *file, const char *target, const char *uuid,
+		     std::string &error) {
+	 OS::Timer timer(true);
+	 Loader loader;
+	 // The optional cache directory holds bitstreams that are already decompressed and
+	 // byte swapped, named by the UUID of their artifact.  Remove the files to reclaim space.
+	 const char *cacheDir = getenv("OCPI_HDL_BITSTREAM_CACHE");
+	 std::string cached, temp;
+	 struct stat fs, cs;
+	 if (uuid && uuid[0] && cacheDir && cacheDir[0]) {
+	   OU::format(cached, "%s/%s.bin", cacheDir, uuid);
+	   if (stat(file, &fs) == 0 && stat(cached.c_str(), &cs) == 0 &&
+	       cs.st_mtime >= fs.st_mtime && cs.st_size && !loader.openCached(cached.c_str()))
+	     cached.clear();
+	   else
+	     OU::format(temp, "%s.%u", cached.c_str(), (unsigned)getpid());
+	 }
+	 if (loader.m_fd < 0 && loader.open(file, error))
+	   return true;
+	 OS::ThreadManager thread;
+	 try {
+	   thread.start(Loader::reader, &loader);
+	 } catch (std::string &e) {
+	   return OU::eformat(error, "Can't start the bitstream reading thread: %s", e.c_str());
+	 }
+	 int tfd = -1, cfd = -1;
+	 if ((tfd = ::open(target, O_WRONLY|O_TRUNC)) < 0) // truncating stand-in files
+	   OU::format(error, "Can't open %s for bitstream loading: %s(%d)",
+		      target, strerror(errno), errno);
+	 else if (temp.size() &&
+		  (cfd = ::open(temp.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666)) < 0)
+	   ocpiInfo("Could not create the bitstream cache file \"%s\": %s",
+		    temp.c_str(), strerror(errno));
+	 uint64_t total = 0;
+	 size_t chunk = Loader::c_bufferSize;
+	 for (unsigned n = 0; error.empty(); n = (n + 1) % Loader::c_nBuffers) {
+	   Loader::Buffer &b = loader.m_buffers[n];
+	   loader.m_full.wait();
+	   if (b.failed) {
+	     error = loader.m_error;
+	     break;
+	   }
+	   if (writeAll(tfd, (uint8_t *)b.data, b.length, chunk))
+	     OU::format(error, "Error writing to %s for bitstream loading: %s(%u/%zu)",
+			target, strerror(errno), errno, b.length);
+	   else if (cfd >= 0 && writeAll(cfd, (uint8_t *)b.data, b.length, chunk)) {
+	     ocpiInfo("Could not write the bitstream cache file \"%s\": %s",
+		      temp.c_str(), strerror(errno));
+	     ::close(cfd);
+	     ::unlink(temp.c_str());
+	     cfd = -1;
+	   }
+	   total += b.length;
+	   if (b.eof)
+	     break;
+	   loader.m_free.post();
+	 }
+	 if (error.size()) { // stop the reader if it is waiting for a buffer
+	   loader.m_abort = true;
+	   loader.m_free.post();
+	 }
+	 thread.join();
+	 if (cfd >= 0) {
+	   if (::close(cfd) || error.size() || rename(temp.c_str(), cached.c_str()))
+	     ::unlink(temp.c_str());
+	   else
+	     ocpiInfo("Cached the prepared bitstream in \"%s\"", cached.c_str());
+	 }
+	 if (tfd >= 0 && ::close(tfd) && error.empty())
+	   OU::format(error, "Error closing %s: %s(%u)", target, strerror(errno), errno);
+	 if (error.size())
+	   return true;
+	 OS::ElapsedTime et = timer.getElapsed();
+	 ocpiInfo("Loaded %" PRIu64 " bitstream bytes from \"%s\" into %s in %" PRIu32 ".%03" PRIu32
+		  " seconds", total, file, target, et.seconds(), et.nanoseconds() / 1000000);
+	 return false;
+       }
 
        class Device
 	 : public OCPI::HDL::Device {
@@ -148,143 +399,18 @@
 	    (1 << OCPI::RDT::ActiveMessage) | (1 << OCPI::RDT::FlagIsMetaOptional);
 	}
 
-	// Scan the buffer and identify the start of the sync pattern
-	static uint8_t *findsync(uint8_t *buf, size_t len) {
-	  static uint8_t startup[] = {
-	    0xff, 0xff, 0xff, 0xff,
-	    0xff, 0xff, 0xff, 0xff, 
-	    0xff, 0xff, 0xff, 0xff,
-	    0xff, 0xff, 0xff, 0xff, 
-	    0xff, 0xff, 0xff, 0xff,
-	    0xff, 0xff, 0xff, 0xff, 
-	    0xff, 0xff, 0xff, 0xff,
-	    0xff, 0xff, 0xff, 0xff, 
-	    0x00, 0x00, 0x00, 0xbb,
-	    0x11, 0x22, 0x00, 0x44,
-	    0xff, 0xff, 0xff, 0xff, 
-	    0xff, 0xff, 0xff, 0xff, 
-	    0xaa, 0x99, 0x55, 0x66};
-	  uint8_t *p8 = startup;
-	  for (uint8_t *u8 = buf; u8 < buf + len; u8++)
-	    if (*u8 == *p8++) {
-	      if (p8 >= startup+sizeof(startup))
-		return u8 + 1 - sizeof(startup);
-	    } else {
-	      p8 = startup;
-	      if (*u8 == *p8) p8++;
-	    }
-	  return 0;
-	}
-
 	// Load a bitstream
 	bool
 	load(const char *fileName, std::string &error) {
+	  return loadUUID(fileName, "", error);
+	}
+	bool
+	loadUUID(const char *fileName, const std::string &uuid, std::string &error) {
 	  ocpiDebug("Loading file \"%s\" on zynq FPGA", fileName);
-	  struct Xld { // struct allocated on the stack for easy cleanup
-	    int xfd, bfd;
-	    gzFile gz;
-	    uint8_t buf[8*1024];
-	    int zerror;
-	    size_t len;
-	    int n;
-	    void cleanup() { // used for constructor catch cleanup and in destructor
-	      if (xfd >= 0) ::close(xfd);
-	      if (bfd >= 0) ::close(bfd);
-	      if (gz) gzclose(gz);
-	    }
-	    Xld(const char *file, std::string &a_error) : xfd(-1), bfd(-1), gz(NULL) {
-	      // Open the device LAST since just opening it will do bad things
-	      uint8_t *p8;
-	      if ((bfd = ::open(file, O_RDONLY)) < 0)
-		OU::format(a_error, "Can't open bitstream file '%s' for reading: %s(%d)",
-			   file, strerror(errno), errno);
-	      else if ((gz = ::gzdopen(bfd, "rb")) == NULL)
-		OU::format(a_error, "Can't open compressed bitstream file '%s' for : %s(%u)",
-			   file, strerror(errno), errno);
-	      // Read up to the sync pattern before byte swapping
-	      else if ((n = ::gzread(gz, buf, sizeof(buf))) <= 0)
-		OU::format(a_error, "Error reading initial bitstream buffer: %s(%u/%d)",
-			   gzerror(gz, &zerror), errno, n);
-	      else if (!(p8 = findsync(buf, sizeof(buf))))
-		OU::format(a_error, "Can't find sync pattern in compressed bit file");
-	      else {
-		len = buf + sizeof(buf) - p8;
-		if (p8 != buf)
-		  memcpy(buf, p8, len);
-		// We've done as much as we can before opening the device, which
-		// does bad things to the Zynq PL
-		if ((xfd = ::open("/dev/xdevcfg", O_RDWR)) < 0)
-		  OU::format(a_error, "Can't open /dev/xdevcfg for bitstream loading: %s(%d)",
-			     strerror(errno), errno);
-	      }
-	    }
-	    ~Xld() {
-	      cleanup();
-	    }
-	    int gzread(uint8_t *&argBuf, std::string &a_error) {
-	      if ((n = ::gzread(gz, buf + len, (unsigned)(sizeof(buf) - len))) < 0)
-		OU::format(a_error, "Error reading compressed bitstream: %s(%u/%d)",
-			   gzerror(gz, &zerror), errno, n);
-	      else {
-		n += OCPI_UTRUNCATE(int, len);
-		len = 0;
-		argBuf = buf; 
-	      }
-	      return n;
-	    }
-	    uint32_t readConfigReg(unsigned /*reg*/) {
-	      // write the "read config register" frame.
-	      // read back the value
-	      return 0;
-	    }
-	  };
-	  Xld xld(fileName, error);
-	  if (!error.empty())
+	  if (loadBitstream(fileName, "/dev/xdevcfg", uuid.c_str(), error))
 	    return true;
-	  do {
-	    uint8_t *buf;
-	    int n = xld.gzread(buf, error);
-	    if (n < 0)
-	      return true;
-	    if (n & 3)
-	      return OU::eformat(error, "Bitstream data in is '%s' not a multiple of 4 bytes",
-				 fileName);
-	    if (n == 0)
-	      break;
-	    uint32_t *p32 = (uint32_t*)buf;
-	    for (unsigned nn = n; nn; nn -= 4, p32++)
-	      *p32 = OU::swap32(*p32);
-	    if (write(xld.xfd, buf, n) <= 0)
-	      return OU::eformat(error,
-				 "Error writing to /dev/xdevcfg for bitstream loading: %s(%u/%d)",
-				 strerror(errno), errno, n);
-	  } while (1);
-	  if (::close(xld.xfd))
-	    return OU::eformat(error, "Error closing /dev/xdevcfg: %s(%u)",
-			       strerror(errno), errno);
-	  xld.xfd = -1;
 	  ocpiDebug("Loading complete, testing for programming done and initialization");
 	  return isProgrammed(error) ? init(error) : true;
-#if 0
-	  // We have written all the data from the file to the device.
-	  // Now we can retrieve status registers
-	  const uint32_t
-	    c_opencpi = 0xdd9fda7a,
-	    c_statmask = 0x12345678,
-	    c_statvalue = 0x12345678;
-	  uint32_t
-	    stat = xld.readConfigReg(7),
-	    axss = xld.readConfigReg(9);
-	  // Check stat for good value
-	  if ((stat & c_statmask) != c_statvalue)
-	    throw OU::Error("After loading, the configuration status register was 0x%x,"
-			    " but should be 0x%x (masked with 0x%x)",
-			    stat, c_statvalue, c_statmask);
-	  // Check axss for our special value 0xdd9fda7a
-	  if (axss != c_opencpi)
-	    throw OU::Error("After loading, the USR_ACCESS code was not correct: 0x%x - should be 0x%x",
-			    axss, c_opencpi);
-#endif
 	}
 	bool
 	unload(std::string &error) {
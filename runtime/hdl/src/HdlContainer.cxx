@@ -175,7 +175,7 @@ namespace OCPI {
 	  // If the device needs a container background thread, make sure its started.
 	  c.start();
 	  std::string error;
-	  if (c.hdlDevice().load(name().c_str(), error))
+	  if (c.hdlDevice().loadUUID(name().c_str(), lart.uuid(), error))
 	    throw OU::Error("loading %s on HDL device %s: %s",
 			    name().c_str(), c.name().c_str(), error.c_str());
 	  if (!c.hdlDevice().isLoadedUUID(lart.uuid()))
@@ -22,6 +22,11 @@
  * This file contains driver-level code that does not know about the guts of the 
  * container class.
  */
+#include <algorithm>
+#include <fstream>
+#include "OcpiOsFileSystem.h"
+#include "OcpiUtilAutoMutex.h"
+#include "OcpiUtilThreadPool.h"
 #include "ContainerManager.h"
 #include "HdlContainer.h"
 #include "HdlDriver.h"
@@ -36,11 +41,30 @@ namespace OCPI {
 
     const char *hdl = "hdl";
 
+    Driver::
+    Driver()
+      : m_params(NULL), m_deferred(NULL) {
+    }
+
     OCPI::HDL::Device *Driver::
     open(const char *name, bool discovery, bool forLoad, const OA::PValue *params,
 	 std::string &err) {
       parent().parent().configureOnce();
       lock();
+      Device *dev = openDevice(name, discovery, forLoad, params, err);
+      ezxml_t config;
+      if (!dev || (forLoad && !strncasecmp("pl:", name, 3)))
+	return dev;
+      if (!setup(*dev, config, err))
+	return dev;
+      delete dev;
+      return NULL;
+    }
+
+    // Open the device for a name, without configuring it
+    OCPI::HDL::Device *Driver::
+    openDevice(const char *name, bool discovery, bool forLoad, const OA::PValue *params,
+	       std::string &err) {
       // FIXME: obviously this should be registered and dispatched nicely..
       bool pci = false, ether = false, sim = false, bus = false, lsim = false;
       const char *which = name;
@@ -72,19 +96,12 @@ namespace OCPI {
 	OU::format(err, "Missing device name after prefix \"%s\"", name);
 	return NULL;
       }
-      Device *dev =
+      return
 	pci ? PCI::Driver::open(which, params, err) : 
 	bus ? Zynq::Driver::open(which, forLoad, params, err) : 
 	ether ? Ether::Driver::open(which, discovery, params, err) :
 	sim ? Sim::Driver::open(which, discovery, params, err) : 
 	lsim ? LSim::Driver::open(which, params, err) : NULL;
-      ezxml_t config;
-      if (forLoad && bus)
-	return dev;
-      if (dev && !setup(*dev, config, err))
-	return dev;
-      delete dev;
-      return NULL;
     }
 
     void Driver::
@@ -98,14 +115,30 @@ namespace OCPI {
     // Return true if error or if we otherwise discarded the device
     // Assuming we are called possibly multiple times from a give driver's search method,
     // record the first error seen.
+    // When the buses are being searched concurrently, the device is just recorded here,
+    // and its container is created after all the searches are done.
     bool Driver::
     found(Device &dev, const char **excludes, bool discoveryOnly, std::string &error) {
+      if (m_deferred) {
+	error.clear();
+	OU::AutoMutex guard(m_foundMutex);
+	m_deferred->push_back(&dev);
+	return false;
+      }
+      return foundNow(dev, excludes, discoveryOnly, error);
+    }
+
+    bool Driver::
+    foundNow(Device &dev, const char **excludes, bool discoveryOnly, std::string &error) {
       ezxml_t config;
       error.clear();
       if (excludes)
 	for (const char **ap = excludes; *ap; ap++)
 	  if (!strcasecmp(*ap, dev.name().c_str()))
 	    goto out;
+      for (unsigned n = 0; n < m_foundNames.size(); n++)
+	if (!strcasecmp(m_foundNames[n].c_str(), dev.name().c_str()))
+	  goto out; // already found via the discovery cache
       if (!setup(dev, config, error)) {
 	bool printOnly = false;
 	if ((OU::findBool(m_params, "printOnly", printOnly) && printOnly))
@@ -115,8 +148,10 @@ namespace OCPI {
 	  if (dev.m_verbose)
 	    dev.print();
 #endif
-	  if (!discoveryOnly)
+	  if (!discoveryOnly) {
+	    m_foundNames.push_back(dev.name());
 	    createContainer(dev, config, m_params); // no errors?
+	  }
 	  return false;
 	}
       }
@@ -125,41 +160,156 @@ namespace OCPI {
       return true;
     } 
 
+    // The order in which the bus types are searched, and their containers created
+    static const char *buses[] = { "PL:", "Ether:", "PCI:", "sim:", "lsim:", NULL };
+    static unsigned busOrder(Device *dev) {
+      unsigned n;
+      for (n = 0; buses[n]; n++)
+	if (!strncasecmp(buses[n], dev->name().c_str(), strlen(buses[n])))
+	  break;
+      return n;
+    }
+    static bool busLess(Device *a, Device *b) {
+      return busOrder(a) < busOrder(b);
+    }
+
+    struct BusSearch {
+      Driver *driver;
+      const char **exclude;
+      bool discoveryOnly;
+      std::string errors[5];
+    };
+    // Search one type of bus: a chunk function for the thread pool
+    void Driver::
+    searchBus(void *arg, size_t bus, size_t, size_t) {
+      BusSearch &bs = *(BusSearch *)arg;
+      Driver &d = *bs.driver;
+      std::string &error = bs.errors[bus];
+      try {
+	switch (bus) {
+	case 0:
+	  d.Zynq::Driver::search(d.m_params, bs.exclude, bs.discoveryOnly, error); break;
+	case 1:
+	  d.Ether::Driver::search(d.m_params, bs.exclude, bs.discoveryOnly, false, error); break;
+	case 2:
+	  d.PCI::Driver::search(d.m_params, bs.exclude, bs.discoveryOnly, error); break;
+	case 3:
+	  d.Sim::Driver::search(d.m_params, bs.exclude, bs.discoveryOnly, true, error); break;
+	case 4:
+	  d.LSim::Driver::search(d.m_params, bs.exclude, bs.discoveryOnly, error); break;
+	}
+      } catch (std::string &e) {
+	error = e;
+      } catch (...) {
+	error = "unexpected exception";
+      }
+    }
+
+    // Search all the bus types at once, since several of them wait for network or
+    // simulator responses.  Containers are then created in the same order as if the
+    // buses were searched one after another, so container ordinals do not change.
+    unsigned Driver::
+    searchBuses(const char **exclude, bool discoveryOnly) {
+      static const char *names[] = { "Zynq", "ethernet", "PCI", "SIM/UDP", "LSIM" };
+      std::vector<Device *> devices;
+      BusSearch bs;
+      bs.driver = this;
+      bs.exclude = exclude;
+      bs.discoveryOnly = discoveryOnly;
+      m_deferred = &devices;
+      try {
+	OU::ThreadPool pool(4, false);
+	pool.run(5, 1, searchBus, &bs);
+      } catch (std::string &e) {
+	bs.errors[0] = e;
+      }
+      m_deferred = NULL;
+      for (unsigned n = 0; n < 5; n++)
+	if (bs.errors[n].size())
+	  ocpiBad("In HDL Container driver, got %s search error: %s", names[n],
+		  bs.errors[n].c_str());
+      std::stable_sort(devices.begin(), devices.end(), busLess);
+      unsigned count = 0;
+      std::string error;
+      for (unsigned n = 0; n < devices.size(); n++)
+	if (!foundNow(*devices[n], exclude, discoveryOnly, error))
+	  count++;
+	else if (error.size())
+	  ocpiBad("In HDL Container driver, error setting up device: %s", error.c_str());
+      return count;
+    }
+
+    // Simulators come and go with their processes, so they are always searched for
+    static bool isCacheable(const std::string &name) {
+      return strncasecmp(name.c_str(), "sim:", 4) && strncasecmp(name.c_str(), "lsim:", 5);
+    }
+
+    // Probe the devices found by an earlier search, as recorded in the cache file.
+    // Each is probed directly, which avoids waiting for responses on empty buses.
+    // Excluded devices are not probed or counted.
+    unsigned Driver::
+    searchCached(const char *file, const char **exclude, unsigned &nCached) {
+      std::ifstream in(file);
+      std::string name;
+      unsigned count = 0;
+      nCached = 0;
+      while (std::getline(in, name))
+	if (name.size() && isCacheable(name)) {
+	  bool excluded = false;
+	  for (const char **ap = exclude; ap && *ap; ap++)
+	    if (!strcasecmp(*ap, name.c_str()))
+	      excluded = true;
+	  if (excluded)
+	    continue;
+	  nCached++;
+	  std::string error;
+	  Device *dev = openDevice(name.c_str(), true, false, m_params, error);
+	  if (dev && !foundNow(*dev, exclude, false, error))
+	    count++;
+	  else
+	    ocpiInfo("HDL device \"%s\" from the discovery cache was not found%s%s",
+		     name.c_str(), error.size() ? ": " : "", error.c_str());
+	}
+      return count;
+    }
+
     unsigned Driver::
     search(const OA::PValue *params, const char **exclude, bool discoveryOnly) {
       OU::SelfAutoMutex x(this); // protect m_params etc.
-      unsigned count = 0;
       m_params = params;
       // Note that the default here is to DO discovery, i.e. to disablediscovery
       // the variable must be set and set to 0
       const char *env;
       if ((env = getenv("OCPI_ENABLE_HDL_DISCOVERY")) && env[0] == '0')
 	return 0;
-      std::string error;
-      count += Zynq::Driver::search(params, exclude, discoveryOnly, error);
-      if (error.size()) {
-	ocpiBad("In HDL Container driver, got Zynq search error: %s", error.c_str());
-	error.clear();
-      }
-      count += Ether::Driver::search(params, exclude, discoveryOnly, false, error);
-      if (error.size()) {
-	ocpiBad("In HDL Container driver, got ethernet search error: %s", error.c_str());
-	error.clear();
-      }
-      count += PCI::Driver::search(params, exclude, discoveryOnly, error);
-      if (error.size()) {
-	ocpiBad("In HDL Container driver, got PCI search error: %s", error.c_str());
-	error.clear();
-      }
-      count += Sim::Driver::search(params, exclude, discoveryOnly, true, error);
-      if (error.size()) {
-	ocpiBad("In HDL Container driver, got SIM/UDP search error: %s", error.c_str());
-	error.clear();
+      // The optional discovery cache file lists the devices found by the last full search.
+      // If all of them are still there, the full search is skipped.  Remove the file
+      // to force a full search, e.g. when devices are added.
+      const char *cache = getenv("OCPI_HDL_DISCOVERY_CACHE");
+      bool printOnly = false;
+      OU::findBool(params, "printOnly", printOnly);
+      bool useCache = cache && cache[0] && !discoveryOnly && !printOnly;
+      unsigned count = 0, nCached = 0;
+      m_foundNames.clear();
+      if (useCache && OS::FileSystem::exists(cache)) {
+	count = searchCached(cache, exclude, nCached);
+	// An empty cache is a miss, since it may just mean no devices were there before
+	if (nCached && count == nCached) {
+	  ocpiInfo("HDL discovery used the %u devices in the discovery cache \"%s\"",
+		   count, cache);
+	  return count;
+	}
       }
-      count += LSim::Driver::search(params, exclude, discoveryOnly, error);
-      if (error.size()) {
-	ocpiBad("In HDL Container driver, got LSIM search error: %s", error.c_str());
-	error.clear();
+      // The devices already found from the cache are skipped by the full search (see
+      // foundNow), so it only counts the others.
+      count += searchBuses(exclude, discoveryOnly);
+      if (useCache) {
+	std::ofstream out(cache);
+	for (unsigned n = 0; n < m_foundNames.size(); n++)
+	  if (isCacheable(m_foundNames[n]))
+	    out << m_foundNames[n] << std::endl;
+	if (!out.good())
+	  ocpiInfo("Could not write the HDL discovery cache file \"%s\"", cache);
       }
       return count;
     }
@@ -22,6 +22,8 @@
 #include <unistd.h>
 #include <assert.h>
 #include <sys/stat.h>   // for mkdir and mkfifo
+#include <sys/mman.h>
+#include <sched.h>
 #include <signal.h>
 #include <errno.h>
 #include <queue>
@@ -36,6 +38,7 @@
 #include "OcpiTransport.h"
 #include "LibrarySimple.h"
 #include "HdlSdp.h"
+#include "HdlSimRing.h"
 #include "HdlLSimDriver.h"
 #include "HdlDriver.h"
 #include "HdlContainer.h"
@@ -53,7 +56,7 @@ namespace OCPI {
       namespace DT = DataTransfer;
 
       // Our named pipes.
-struct Fifo {
+struct Fifo : public SDP::Channel {
   std::string m_name;
   int m_rfd, m_wfd;
   bool m_read;
@@ -108,11 +111,127 @@ struct Fifo {
     ocpiDebug("Starting to flush any state from previous simulation run for %s",
 	      m_name.c_str());
     while (ioctl(m_rfd, FIONREAD, &n) >= 0 && n > 0 &&
-	   ((r = read(m_rfd, buf, sizeof(buf))) > 0 ||
+	   ((r = ::read(m_rfd, buf, sizeof(buf))) > 0 ||
 	    (r < 0 && errno == EINTR)))
       ;
     ocpiDebug("Ending flush of any state from previous simulation run");
   }
+  bool read(uint8_t *buf, size_t nRequested, std::string &error) {
+    return SDP::read(m_rfd, buf, nRequested, error);
+  }
+  bool write(const uint8_t *data, size_t length, std::string &error) {
+    ssize_t w = ::write(m_wfd, data, length);
+    return w == (ssize_t)length ? false :
+      OU::eformat(error, "write to fifo %s failed: %zd/%zu %s (%d)", m_name.c_str(), w,
+		  length, strerror(errno), errno);
+  }
+};
+
+// How long to wait for the simulator to make progress on a ring, or to ack spin credits,
+// before deciding it is hung
+static const unsigned c_simTimeoutUsecs = 30000000;
+
+// One of the shared memory rings, usable wherever a fifo is used.
+// Waiting spins briefly and then yields, since the other side is a running simulator,
+// but gives up when the simulator process has exited or no progress is made before
+// the timeout.
+struct Ring : public SDP::Channel {
+  OcpiSimRing *m_ring;
+  const char *m_name;
+  const pid_t &m_pid; // the simulator process, zero when there is none
+  Ring(const char *a_name, const pid_t &a_pid) : m_ring(NULL), m_name(a_name), m_pid(a_pid) {}
+  // Wait a while for the other side.  Return true with an error when we should give up.
+  // This only looks at the process without reaping it, since that is for the container.
+  bool
+  wait(unsigned &n, OS::Timer &timer, unsigned timeoutUsecs, std::string &error) {
+    if (++n < 1000)
+      return false;
+    sched_yield();
+    if (n & 0x3ff)
+      return false;
+    siginfo_t info;
+    info.si_pid = 0;
+    if (!m_pid ||
+	(waitid(P_PID, (id_t)m_pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid))
+      return OU::eformat(error, "simulator process exited while waiting on ring %s", m_name);
+    OS::ElapsedTime et = timer.getElapsed();
+    if ((uint64_t)et.seconds() * 1000000 + et.nanoseconds() / 1000 >= timeoutUsecs)
+      return OU::eformat(error, "simulator made no progress on ring %s for %u seconds",
+			 m_name, timeoutUsecs / 1000000);
+    return false;
+  }
+  bool ready() const {
+    return m_ring && ocpiSimRingFilled(m_ring) != 0;
+  }
+  bool read(uint8_t *buf, size_t nRequested, std::string &error) {
+    OS::Timer timer(true);
+    for (unsigned n = 0; nRequested; ) {
+      size_t got = ocpiSimRingGet(m_ring, buf, nRequested);
+      if (got) {
+	buf += got;
+	nRequested -= got;
+	n = 0;
+	timer.restart();
+      } else if (wait(n, timer, c_simTimeoutUsecs, error))
+	return true;
+    }
+    return false;
+  }
+  bool write(const uint8_t *data, size_t length, std::string &error) {
+    OS::Timer timer(true);
+    for (unsigned n = 0; length; ) {
+      size_t put = ocpiSimRingPut(m_ring, data, length);
+      if (put) {
+	data += put;
+	length -= put;
+	n = 0;
+	timer.restart();
+      } else if (wait(n, timer, c_simTimeoutUsecs, error))
+	return true;
+    }
+    return false;
+  }
+  void flush() {
+    uint8_t buf[256];
+    ocpiDebug("Flushing any state from previous simulation run for ring %s", m_name);
+    if (m_ring)
+      while (ocpiSimRingGet(m_ring, buf, sizeof(buf)))
+	;
+  }
+};
+
+// The file in the simulation directory that holds all the rings
+struct Rings {
+  std::string m_name;
+  OcpiSimRings *m_rings;
+  Rings(const std::string &a_name) : m_name(a_name), m_rings(NULL) {}
+  ~Rings() {
+    close();
+  }
+  bool open(std::string &error) {
+    int fd = ::open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
+      return OU::eformat(error, "can't create ring file %s (%s %d)", m_name.c_str(),
+			 strerror(errno), errno);
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, sizeof(OcpiSimRings)) == 0)
+      p = mmap(NULL, sizeof(OcpiSimRings), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return OU::eformat(error, "can't map ring file %s (%s %d)", m_name.c_str(),
+			 strerror(errno), errno);
+    m_rings = (OcpiSimRings *)p;
+    ocpiSimRingsInit(m_rings, (int32_t)getpid());
+    ocpiDebug("Ring file %s created and mapped", m_name.c_str());
+    return false;
+  }
+  void close() {
+    if (m_rings) {
+      munmap(m_rings, sizeof(OcpiSimRings));
+      m_rings = NULL;
+      unlink(m_name.c_str());
+    }
+  }
 };
 
 class Device
@@ -148,6 +267,11 @@ class Device
   // This fifo is for control responses from the sim to us.
   // Currently this is simply an "ack" for spincredits.
   Fifo m_ack;
+  // When using shared memory instead of the fifos, these carry the same streams
+  bool m_useRings;
+  Rings m_rings;
+  Ring m_reqRing, m_respRing, m_ctlRing, m_ackRing;
+  SDP::Channel *m_reqChannel, *m_respChannel, *m_ctlChannel;
   int m_maxFd;
   fd_set m_alwaysSet;
   pid_t m_pid;
@@ -184,6 +308,12 @@ class Device
   bool m_dump, m_spinning;
   unsigned m_sleepUsecs, m_simTicks;
   uint8_t m_spinCount;
+  // Adaptive spin credits (opt-in): current credit and what happened during it.
+  // The traffic flags are set by the sim reader and host threads and are only accessed
+  // atomically.
+  bool m_adaptiveSpin;
+  unsigned m_simTraffic, m_hostTraffic;
+  uint8_t m_credit;
   uint64_t m_cumTicks;
   OS::Timer m_spinTimer;
   OU::UuidString m_textUUID;
@@ -213,13 +343,31 @@ protected:
       m_resp(simDir + "/response", true),
       m_ctl(simDir + "/control", false),
       m_ack(simDir + "/ack", false),
+      m_useRings(false), m_rings(simDir + "/" OCPI_SIM_RING_FILE), m_reqRing("request", m_pid),
+      m_respRing("response", m_pid), m_ctlRing("control", m_pid), m_ackRing("ack", m_pid),
+      m_reqChannel(&m_req), m_respChannel(&m_resp), m_ctlChannel(&m_ctl),
       m_maxFd(-1), m_pid(0), m_exited(false), m_stopped(false), m_dcp(0), m_respLeft(0),
       m_simDir(simDir), m_platform(a_platform), m_script(script), m_dump(dump), m_spinning(false),
       m_sleepUsecs(sleepUsecs), m_simTicks(simTicks), m_spinCount(spinCount),
+      m_adaptiveSpin(false), m_simTraffic(0), m_hostTraffic(0), m_credit(spinCount),
       m_cumTicks(0), /* m_metadata(NULL), m_xml(NULL),*/ m_firstRun(true), m_lastTicks(0) {
     if (error.length())
       return;
     FD_ZERO(&m_alwaysSet);
+    const char *transport = getenv("OCPI_HDL_SIM_TRANSPORT");
+    OU::findString(params, "simTransport", transport);
+    if (transport) {
+      if (!strcasecmp(transport, "shm"))
+	m_useRings = true;
+      else if (strcasecmp(transport, "fifo")) {
+	OU::format(error, "Invalid simulator transport \"%s\": must be \"fifo\" or \"shm\"",
+		   transport);
+	return;
+      }
+    }
+    if (getenv("OCPI_HDL_SIM_ADAPTIVE_SPIN"))
+      m_adaptiveSpin = true;
+    OU::findBool(params, "adaptiveSpin", m_adaptiveSpin);
     initAdmin(*(OH::OccpAdminRegisters *)m_admin, m_platform.c_str(), m_uuid, &m_textUUID);
     if (m_verbose) {
       fprintf(stderr, "Simulation HDL device %s for %s (UUID %s, dir %s, ticks %u)\n",
@@ -259,6 +407,18 @@ protected:
     ocpiDebug("initFifos resp %d ack %d nfds %d", m_resp.m_rfd, m_ack.m_rfd, m_maxFd);
     addFd(m_resp.m_rfd, true);
     addFd(m_ack.m_rfd, false);
+    // The fifos are still created for simulators that only know about them
+    if (m_useRings) {
+      if (m_rings.open(error))
+	return true;
+      m_reqRing.m_ring = &m_rings.m_rings->rings[OCPI_SIM_RING_REQUEST];
+      m_respRing.m_ring = &m_rings.m_rings->rings[OCPI_SIM_RING_RESPONSE];
+      m_ctlRing.m_ring = &m_rings.m_rings->rings[OCPI_SIM_RING_CONTROL];
+      m_ackRing.m_ring = &m_rings.m_rings->rings[OCPI_SIM_RING_ACK];
+      m_reqChannel = &m_reqRing;
+      m_respChannel = &m_respRing;
+      m_ctlChannel = &m_ctlRing;
+    }
     return false;
   }
   // We assume all sim platforms use SDP
@@ -384,6 +544,8 @@ protected:
 	    dup2(fd, 2) < 0)
 	  _exit(10 + errno);
 	assert(fd > 2);
+	if (m_useRings)
+	  setenv(OCPI_SIM_RING_ENV, (dir + m_rings.m_name).c_str(), 1);
 	if (execl("/bin/sh", "/bin/sh", "--noprofile", "-c", cmd.c_str(), NULL))
 	  _exit(10 + errno);
       }
@@ -401,7 +563,7 @@ protected:
     uint8_t msg[2];
     msg[0] = m_dump ? DUMP_ON : DUMP_OFF;
     msg[1] = 0;
-    ocpiCheck(write(m_ctl.m_wfd, msg, 2) == 2);
+    ocpiCheck(!m_ctlChannel->write(msg, 2, err));
 #endif
     // Improve the odds of an immediate error giving a good error message by letting the sim run
     ocpiInfo("Waiting for simulator to start before issuing any more credits.");
@@ -422,6 +584,10 @@ protected:
     ocpiDebug("Flushing all session state");
     m_req.flush();  // FIXME: could this steal partial requests and get things out of sync?
     m_resp.flush(); // FIXME: should we wait for the request fifo to clear?
+    if (m_useRings) {
+      m_reqRing.flush();
+      m_respRing.flush();
+    }
     m_exec.clear();
     while (!m_respQueue.empty())
       m_respQueue.pop();
@@ -442,7 +608,9 @@ protected:
       msg[0] = TERMINATE;
       msg[1] = 0;
       ocpiInfo("Telling the simulator process (%u) to stop", m_pid);
-      ocpiCheck(write(m_ctl.m_wfd, msg, 2) == 2);
+      if (m_ctlChannel->write(msg, 2, error))
+	ocpiInfo("Could not tell the simulator to stop: %s", error.c_str());
+      error.clear();
       ocpiInfo("Waiting for simulator process to exit");
       mywait(true, error);
       if (m_pid && killpg(m_pid, SIGTERM) == 0) {
@@ -450,6 +618,8 @@ protected:
 	killpg(m_pid, SIGKILL);
       }
       m_ctl.flush();
+      if (m_useRings)
+	m_ctlRing.flush();
       if (error.size())
 	ocpiBad("Error when shutting down simulator: %s", error.c_str());
       m_dcp = 0;
@@ -458,24 +628,64 @@ protected:
     m_exited = false;
     flush();
   }
+  // Size the next spin credit from the work pending in the sim.  The sim only reads the
+  // control channel when its spin credit is exhausted, so a large credit delays the DCP
+  // credits that let it read our next request.  Thus when we have sent requests, use
+  // the configured credit.  When the sim is producing SDP traffic on its own, double the
+  // credit (up to the 8 bit maximum) to take fewer ack round trips, and when nothing is
+  // happening decay back toward the configured credit.
+  uint8_t
+  spinCredit() {
+    if (!m_adaptiveSpin)
+      return m_spinCount;
+    bool
+      simTraffic = __sync_fetch_and_and(&m_simTraffic, 0) != 0,
+      hostTraffic = __sync_fetch_and_and(&m_hostTraffic, 0) != 0;
+    if (hostTraffic || !m_respQueue.empty())
+      m_credit = m_spinCount;
+    else if (simTraffic)
+      m_credit = OCPI_UTRUNCATE(uint8_t, std::min(2u * m_credit, (unsigned)UINT8_MAX));
+    else
+      m_credit = std::max(m_spinCount, OCPI_UTRUNCATE(uint8_t, m_credit / 2));
+    return m_credit;
+  }
   bool
   spin(std::string &error) {
     if (!m_spinning) {
       uint8_t msg[2];
       msg[0] = SPIN_CREDIT;
-      msg[1] = m_spinCount;
-      ssize_t w = write(m_ctl.m_wfd, msg, 2);
-      if (w != 2) {
-	OU::format(error, "spin control write to sim failed. w %zd", w);
+      msg[1] = spinCredit();
+      if (m_ctlChannel->write(msg, 2, error)) {
+	error = "spin control write to sim failed: " + error;
 	return true;
       }
-      ocpiDebug("Sent spin for %u", m_spinCount);
-      m_cumTicks += m_spinCount;
+      ocpiDebug("Sent spin for %u", msg[1]);
+      m_cumTicks += msg[1];
       m_spinTimer.restart();
       m_spinning = true;
     }
     return false;
   }
+  // Wait for the sim to put something in a ring, spinning first since in the shared memory
+  // case the sim is usually quick to respond, then sleeping with backoff up to "usecs".
+  // Return true when there is something.
+  bool
+  ringWait(bool ack, unsigned usecs) {
+    OS::Timer timer(true);
+    unsigned sleep = 1;
+    for (unsigned n = 0; ; n++) {
+      if (m_respRing.ready() || (ack && m_ackRing.ready()))
+	return true;
+      if (n < 1000)
+	continue;
+      OS::ElapsedTime et = timer.getElapsed();
+      if ((uint64_t)et.seconds() * 1000000 + et.nanoseconds() / 1000 >= usecs)
+	return false;
+      usleep(sleep);
+      if (sleep < 1000)
+	sleep *= 2;
+    }
+  }
   // Read a single character '1' from the sim process
   //   Return failure (true) if sim process exits
   //   Use select (with timeout) to probe for readiness
@@ -484,10 +694,36 @@ protected:
   ack(std::string &error) {
     // setup file descriptors for select
     fd_set fds;
-    const int timeoutUsecs = 30000000; // number of micro seconds to wait
+    const unsigned timeoutUsecs = c_simTimeoutUsecs; // number of micro seconds to wait
     struct timeval timeout; // set the timeout for the timed read
     timeout.tv_sec = timeoutUsecs / 1000000;
     timeout.tv_usec =  timeoutUsecs % 1000000;
+    if (m_useRings) {
+      // Wait for the ack, giving up if the sim exits or does not ack within the timeout
+      OS::Timer timer(true);
+      unsigned sleep = 1;
+      for (unsigned n = 0; !m_ackRing.ready(); n++) {
+	if (n < 1000)
+	  continue;
+	if (mywait(false, error))
+	  return true; // process ended
+	OS::ElapsedTime et = timer.getElapsed();
+	if ((uint64_t)et.seconds() * 1000000 + et.nanoseconds() / 1000 >= timeoutUsecs)
+	  return OU::eformat(error, "No ack from the simulator in %u seconds",
+			     timeoutUsecs / 1000000);
+	usleep(sleep);
+	if (sleep < 1000)
+	  sleep *= 2;
+      }
+      uint8_t c;
+      if (m_ackRing.read(&c, 1, error))
+	return true;
+      if (c != '1')
+	return OU::eformat(error, "Unexpected: ack read from sim failed. c %d", c);
+      ocpiDebug("Sim sent ACK. Tick count at %" PRIu64, m_cumTicks);
+      m_spinning = false;
+      return false;
+    }
     // Continue to try select/read until we read 1 byte, a non-eintr error occurs or sim process exits
     while (true) {
       FD_ZERO(&fds);
@@ -530,8 +766,8 @@ protected:
     msg[0] = DCP_CREDIT;
     msg[1] = OCPI_UTRUNCATE(uint8_t, credit & 0xff);
     msg[2] = OCPI_UTRUNCATE(uint8_t, credit >> 8);
-    if (write(m_ctl.m_wfd, msg, 3) != 3) {
-      error = "write error to control fifo";
+    if (m_ctlChannel->write(msg, 3, error)) {
+      error = "write error to control channel: " + error;
       return true;
     }
     if (!m_dcp && spin(error))
@@ -551,6 +787,20 @@ protected:
   doit(std::string &error) {
     if (m_pid && mywait(false, error))
       return true;
+    if (m_useRings) {
+      if (!ringWait(m_dcp != 0, m_sleepUsecs)) {
+	printTime("ring wait timeout");
+	return false;
+      }
+      if (m_respRing.ready() && doResponse(error))
+	return true;
+      if (m_dcp && m_ackRing.ready()) {
+	printTime("Received ACK indication");
+	if (ack(error) || spin(error))
+	  return true;
+      }
+      return false;
+    }
     fd_set fds[1];
     *fds = m_alwaysSet;
     if (m_dcp)                    // only do this after SOME control op
@@ -601,9 +851,10 @@ protected:
     if (m_respLeft == 0) {
       OH::SDP::Header h;
       bool request;
-      if (h.getHeader(m_resp.m_rfd, request, error))
+      if (h.getHeader(*m_respChannel, request, error))
 	return true;
       if (request) {
+	__sync_fetch_and_or(&m_simTraffic, 1);
 	bool writing = h.get_op() == OH::SDP::Header::WriteOp;
 	XferServices &xfs = writing ? m_writeServices : m_readServices;
 	uint64_t whole_addr = h.getWholeByteAddress();
@@ -612,7 +863,7 @@ protected:
 	myassert(mbox < xfs.size() && xfs[mbox]);
 	if (writing) {
 	  myassert(h.getLength() <= sizeof(m_sdpDataBuf));
-	  if (h.endRequest(h, m_resp.m_rfd, m_sdpDataBuf, error))
+	  if (h.endRequest(h, *m_respChannel, m_sdpDataBuf, error))
 	    return true;
 	  xfs[mbox]->send(OCPI_UTRUNCATE(DtOsDataTypes::Offset, whole_addr),
 			  m_sdpDataBuf, h.getLength());
@@ -627,7 +878,7 @@ protected:
       } else {
 	myassert(!m_respQueue.empty());
 	Request &r = *m_respQueue.front();
-	if (r.header.endRequest(h, m_resp.m_rfd, r.data, error))
+	if (r.header.endRequest(h, *m_respChannel, r.data, error))
 	  return true;
 	r.sem.post();
 	m_respQueue.pop();
@@ -649,7 +900,8 @@ protected:
     msg[0] = TERMINATE;
     msg[1] = 0;
     w2("Telling the simulator process (pid %u) to exit.\n", m_pid);
-    (void)write(m_ctl.m_wfd, msg, 2);
+    std::string error;
+    (void)m_ctlChannel->write(msg, 2, error);
   }
 
   // FIXME: signal safety even if we are just terminating anyway...
@@ -686,6 +938,7 @@ public:
       m_resp.close();
       m_ctl.close();
       m_ack.close();
+      m_rings.close();
       ocpiDebug("Removing sim directory: %s", m_simDir.c_str());
       std::string cmd;
       OU::format(cmd, "rm -r -f %s > /dev/null 2>&1", m_simDir.c_str());
@@ -895,8 +1148,9 @@ public:
     {
       OU::AutoMutex m(m_sdpSendMutex);
       bad = response ?
-	h.sendResponse(m_req.m_wfd, data, rlen, error) :
-	h.startRequest(m_req.m_wfd, data, rlen, error);
+	h.sendResponse(*m_reqChannel, data, rlen, error) :
+	h.startRequest(*m_reqChannel, data, rlen, error);
+      __sync_fetch_and_or(&m_hostTraffic, 1);
     }
     // FIXME: is this a dead lock?  should we send the credit first?
     if (bad || sendCredit(rlen, error)) {
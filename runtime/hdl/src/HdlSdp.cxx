@@ -83,17 +83,21 @@ namespace OCPI {
 	} while (error.empty() && nRequested);
 	return !error.empty();
       }
-
-      static bool write(int fd, uint8_t *data, size_t length, std::string &error) {
+      bool FdChannel::
+      read(uint8_t *buf, size_t nRequested, std::string &error) {
+	return SDP::read(m_fd, buf, nRequested, error);
+      }
+      bool FdChannel::
+      write(const uint8_t *data, size_t length, std::string &error) {
 	ssize_t r, len = (ssize_t)length;
-	return (r = ::write(fd, (char *)data, length)) == len ? false :
+	return (r = ::write(m_fd, (const char *)data, length)) == len ? false :
 		OU::eformat(error,
 			    "Error writing SDP response data to simulator: %zd/%zd %s %d",
 			    r, len, strerror(errno), errno);
       }
       static uint8_t zero[Header::dword_bytes];
       bool Header::
-      startRequest(int sendFd, uint8_t *data, size_t &length, std::string &error) {
+      startRequest(Channel &send, uint8_t *data, size_t &length, std::string &error) {
 	ocpiDebug("Start request %p is:    op %u count %zu xid %u node %u lead %u trail %u",
 		  this, get_op(), get_count(), get_xid(), get_node(), get_lead(), get_trail());
         if (OS::logGetLevel() >= OCPI_LOG_DEBUG) {
@@ -102,20 +106,20 @@ namespace OCPI {
 	    fprintf(stderr, " 0x%08x", ((uint32_t*)m_header)[n]);
 	  fprintf(stderr, "\n");
 	}
-	if (write(sendFd, m_bytes, sizeof(m_bytes), error))
+	if (send.write(m_bytes, sizeof(m_bytes), error))
 	  return true;
 	length = sizeof(m_bytes);
 	if (get_op() == WriteOp) {
 	  if (get_lead()) {
-	    if (write(sendFd, zero, get_lead(), error))
+	    if (send.write(zero, get_lead(), error))
 	      return true;
 	    length += get_lead();
 	  }
-	  if (write(sendFd, data, m_actualByteLength, error))
+	  if (send.write(data, m_actualByteLength, error))
 	    return true;
 	  length += m_actualByteLength;
 	  if (get_trail()) {
-	    if (write(sendFd, zero, get_trail(), error))
+	    if (send.write(zero, get_trail(), error))
 	      return true;
 	    length += get_trail();
 	  }
@@ -130,7 +134,7 @@ namespace OCPI {
 	return false;
       }
       bool Header::
-      sendResponse(int sendFd, uint8_t *data, size_t &length, std::string &error) {
+      sendResponse(Channel &send, uint8_t *data, size_t &length, std::string &error) {
 	set_op(ResponseOp);
 	ocpiDebug("Start response %p is:    op %u count %zu xid %u node %u lead %u trail %u",
 		  this, get_op(), get_count(), get_xid(), get_node(), get_lead(), get_trail());
@@ -140,19 +144,19 @@ namespace OCPI {
 	    fprintf(stderr, " 0x%08x", ((uint32_t*)m_header)[n]);
 	  fprintf(stderr, "\n");
 	}
-	if (write(sendFd, m_bytes, sizeof(m_bytes), error))
+	if (send.write(m_bytes, sizeof(m_bytes), error))
 	  return true;
 	length = sizeof(m_bytes);
 	if (get_lead()) {
-	  if (write(sendFd, zero, get_lead(), error))
+	  if (send.write(zero, get_lead(), error))
 	    return true;
 	  length += get_lead();
 	}
-	if (write(sendFd, data, m_actualByteLength, error))
+	if (send.write(data, m_actualByteLength, error))
 	  return true;
 	length += m_actualByteLength;
 	if (get_trail()) {
-	  if (write(sendFd, zero, get_trail(), error))
+	  if (send.write(zero, get_trail(), error))
 	    return true;
 	  length += get_trail();
 	}
@@ -166,10 +170,10 @@ namespace OCPI {
 	return false;
       }
       bool Header::
-      getHeader(int recvFd, bool &request, std::string &error) {
+      getHeader(Channel &recv, bool &request, std::string &error) {
 	ocpiDebug("Getting incoming SDP header");
 	size_t hlen = header_ndws * dword_bytes;
-	if (read(recvFd, (uint8_t *)m_header, hlen, error))
+	if (recv.read((uint8_t *)m_header, hlen, error))
 	  return true;
 	ocpiDebug("Received header: op %u count %zu xid %u node %u lead %u trail %u addr 0x%x"
 		  " extaddr 0x%x whole 0x%" PRIx64,
@@ -182,7 +186,7 @@ namespace OCPI {
       }
       // Given a response that is in a header already, finish it
       bool Header::
-      endRequest(Header &h, int recvFd, uint8_t *data, std::string &error) {
+      endRequest(Header &h, Channel &recv, uint8_t *data, std::string &error) {
 	ocpiDebug("Received SDP header: %x %x", h.m_header[0], h.m_header[1]);
 	if (h.get_op() == ReadOp ||
 	    h.get_count() != get_count() ||
@@ -202,9 +206,9 @@ namespace OCPI {
 		  get_op(), get_count(), get_xid(), get_node(), get_lead(), get_trail());
 	std::string err;
 	uint8_t junk[dword_bytes];
-	if (get_lead() && read(recvFd, junk, get_lead(), err))
+	if (get_lead() && recv.read(junk, get_lead(), err))
 	  return OU::eformat(error, "Bad SDP response padding to read request: %s", err.c_str());
-	if (read(recvFd, data, m_actualByteLength, err))
+	if (recv.read(data, m_actualByteLength, err))
 	  return OU::eformat(error, "Bad SDP response data to read request: %s", err.c_str());
 	if (OS::logGetLevel() >= OCPI_LOG_DEBUG) {
 	  fprintf(stderr, "Received Data (%zu): ", m_actualByteLength);
@@ -212,19 +216,19 @@ namespace OCPI {
 	    fprintf(stderr, " %02x", data[n]);
 	  fprintf(stderr, "\n");
 	}
-	if (get_trail() && read(recvFd, junk, get_trail(), err))
+	if (get_trail() && recv.read(junk, get_trail(), err))
 	  return OU::eformat(error, "Bad SDP response padding to read request: %s", err.c_str());
 	return false;
 	
       }
       bool Header::
-      endRequest(int recvFd, uint8_t *data, std::string &error) {
+      endRequest(Channel &recv, uint8_t *data, std::string &error) {
 	if (get_op() == WriteOp)
 	  return false;
 	assert(get_op() == ReadOp);
 	Header h;
 	bool request;
-	return h.getHeader(recvFd, request, error) || endRequest(h, recvFd, data, error);
+	return h.getHeader(recv, request, error) || endRequest(h, recv, data, error);
       }
     }
   }
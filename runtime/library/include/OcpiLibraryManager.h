@@ -116,6 +116,8 @@ namespace OCPI {
     public:
       static char *getMetadata(const char *name, std::time_t &mtime, uint64_t &length,
 			       size_t &metaLength);
+      // Write out any metadata newly added to the cache named by OCPI_LIBRARY_METADATA_CACHE
+      static void saveMetadataCache();
     protected:
       Artifact();
       virtual ~Artifact();
@@ -123,6 +125,8 @@ namespace OCPI {
       void getFileMetadata(const char *name);
       const char *setFileMetadata(const char *name, char *metadata, std::time_t mtime,
 				  uint64_t length, size_t metaLength);
+      const char *setXmlMetadata(const char *name, std::time_t mtime, uint64_t length,
+				 size_t metaLength);
     public:
       void configure(ezxml_t x = NULL);
       // Can this artifact run on something with these capabilities?
@@ -0,0 +1,85 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCPI_LIBRARY_METADATA_CACHE_H
+#define OCPI_LIBRARY_METADATA_CACHE_H
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "ezxml.h"
+#include "OcpiOsMutex.h"
+
+namespace OCPI {
+  namespace Library {
+    // A host-wide cache of pre-parsed artifact metadata, enabled by setting the
+    // OCPI_LIBRARY_METADATA_CACHE environment variable to a file name.  Each entry holds an
+    // ezxml image of an artifact's metadata (or records that the file has none), keyed by the
+    // identity of the artifact file.  The cache file is mapped read-only and shared, so
+    // processes scanning the same libraries neither read nor parse the metadata in each
+    // artifact, and share the memory holding it.  When artifacts are found that the cache
+    // does not have, it is rewritten and renamed into place, keeping entries whose artifact
+    // files are unchanged.  Files are identified by device, inode, size and modification
+    // time to the nanosecond, so an artifact rewritten within a second is not mistaken.
+    class MetadataCache {
+    public:
+      static const uint32_t c_magic = 0x43444d4f, c_version = 2; // "OMDC"
+      // The layout of the file: the header, the sorted entries, the names and the images
+      struct Header {
+	uint32_t magic, version, nEntries, pad;
+	uint64_t size;
+      };
+      struct Entry { // sorted by dev and ino.  Offsets are from the start of the file.
+	uint64_t dev, ino, mtime, mtimeNs, length, metaLength, name, image, imageLength;
+	bool matches(const struct stat &info) const;
+	bool operator<(const Entry &other) const {
+	  return dev < other.dev || (dev == other.dev && ino < other.ino);
+	}
+	bool operator==(const Entry &other) const {
+	  return dev == other.dev && ino == other.ino;
+	}
+      };
+    private:
+      OCPI::OS::Mutex m_mutex;
+      std::string m_file;
+      const char *m_map;  // never unmapped since documents refer to it
+      const Header *m_header;
+      const Entry *m_entries;
+      struct Pending : Entry {
+	std::string m_name;
+	const void *m_image;
+      };
+      std::vector<Pending> m_pending;
+    public:
+      // An empty or NULL file name disables the cache
+      MetadataCache(const char *file);
+      ~MetadataCache();
+      bool enabled() const { return !m_file.empty(); }
+      // Return true if the file is in the cache, setting xml to its metadata, or to NULL if
+      // it has none.
+      bool find(const struct stat &info, ezxml_t &xml, size_t &metaLength);
+      // Remember a file's metadata for the next save(), which may be none (NULL)
+      void add(const char *name, const struct stat &info, size_t metaLength, ezxml_t xml);
+      // Rewrite the cache with the new entries, and any existing ones whose files are unchanged
+      void save();
+    };
+  }
+}
+#endif
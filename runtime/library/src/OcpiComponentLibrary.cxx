@@ -50,12 +50,9 @@ namespace OCPI {
 	: public OL::ArtifactBase<Library, Artifact> {
 	friend class Library;
       public:
-	Artifact(Library &lib, const char *a_name, char *metadata, std::time_t a_mtime,
-		 uint64_t a_length, size_t metaLength, const OA::PValue *)
+	Artifact(Library &lib, const char *a_name, const OA::PValue *)
 	  : ArtifactBase<Library,Artifact>(lib, *this, a_name) {
-	  const char *err = setFileMetadata(a_name, metadata, a_mtime, a_length, metaLength);
-	  if (err)
-	    throw OU::Error("Error processing metadata from artifact file: %s: %s", a_name, err);
+	  getFileMetadata(a_name);
 	}
       };
 
@@ -81,13 +78,7 @@ namespace OCPI {
 	}
 	OCPI::Library::Artifact *
 	addArtifact(const char *url, const OCPI::API::PValue *params) {
-	  std::time_t mtime;
-	  uint64_t length;
-	  size_t metaLength;
-	  char *metadata = OCPI::Library::Artifact::getMetadata(url, mtime, length, metaLength);
-	  if (!metadata)
-	    throw OU::Error(20, "Cannot open or retrieve metadata from file \"%s\"", url);
-	  Artifact *a = new Artifact(*this, url, metadata, mtime, length, metaLength, params);
+	  Artifact *a = new Artifact(*this, url, params);
 	  a->configure(); // FIXME: there could be config info in the platform.xml
 	  // FIXME: return NULL if this doesn't look like an artifact we can support?
 	  return a;
@@ -164,6 +155,8 @@ namespace OCPI {
 	      throw;
 	    }
 	    free(cp);
+	    // Write out metadata found in this search for the next process to use
+	    OL::Artifact::saveMetadataCache();
 	  }
 	  return n;
 	}
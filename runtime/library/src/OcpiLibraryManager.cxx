@@ -22,12 +22,15 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <climits>
 #include <set>
 #include "ocpi-config.h"
 #include "OcpiUtilException.h"
 #include "OcpiLibraryManager.h"
+#include "OcpiLibraryMetadataCache.h"
 #include "LibrarySimple.h"
 #include "OcpiComponentLibrary.h"
 #include "OcpiOsAssert.h"
@@ -300,6 +303,15 @@ namespace OCPI {
       ezxml_free(m_xml);
       delete [] m_metadata;
     }
+    // Map the last "tail" bytes of a file, returning a pointer to them or NULL on failure.
+    static const char *
+    mapTail(int fd, off_t fileLength, off_t tail, void *&map, size_t &mapLength) {
+      static const off_t pageMask = (off_t)sysconf(_SC_PAGESIZE) - 1;
+      off_t start = (fileLength - tail) & ~pageMask;
+      mapLength = (size_t)(fileLength - start);
+      map = mmap(NULL, mapLength, PROT_READ, MAP_SHARED, fd, start);
+      return map == MAP_FAILED ? NULL : (const char *)map + (fileLength - tail - start);
+    }
     // static utility function
     // Get the metadata from the end of the file.
     // The length of the appended file is appended on a line starting with X
@@ -328,48 +340,72 @@ namespace OCPI {
       char buf[64/3+4]; // octal + \r + \n + null
       const size_t bufsize = sizeof(buf)-1; // Ensure trailing null character
       buf[bufsize] = '\0';
-      off_t fileLength, second, third;
-      if ((fileLength = lseek(fd, 0, SEEK_END)) != -1 &&
-	  // I have no idea why the off_t caste below is required,
-	  // but without it, the small negative number is not sign extended...
-	  // on MACOS gcc v4.0.1 with 64 bit off_t
-	  (second = lseek(fd, -(off_t)bufsize, SEEK_CUR)) != -1 &&
-	  (third = read(fd, buf, bufsize)) == (ssize_t)bufsize) {
+      // The end of the file is mapped rather than read, so that only the pages holding the
+      // metadata are touched, and usually the same mapping has both the length and the metadata
+      const off_t c_tail = 64*1024;
+      off_t fileLength = info.st_size;
+      void *map;
+      size_t mapLength;
+      if (fileLength >= (off_t)bufsize &&
+	  mapTail(fd, fileLength, std::min(fileLength, c_tail), map, mapLength)) {
+	const char *end = (const char *)map + mapLength;
+	memcpy(buf, end - bufsize, bufsize);
 	for (char *cp = &buf[bufsize-1]; cp >= buf; cp--)
 	  if (*cp == 'X' && isdigit(cp[1])) {
-	    char *end;
-	    long l = strtol(cp + 1, &end, 10);
+	    char *lend;
+	    long l = strtol(cp + 1, &lend, 10);
 	    off_t n = (off_t)l;
 	    // strtoll error reporting is truly bizarre
-	    if (l != LONG_MAX && l > 0 && cp[1] && isspace(*end)) {
+	    if (l != LONG_MAX && l > 0 && cp[1] && isspace(*lend)) {
 	      metaLength = n + (&buf[bufsize] - cp);
-	      off_t metaStart = fileLength - metaLength;
-	      if (lseek(fd, metaStart, SEEK_SET) != -1) {
-		data = new char[n + 1];
-		if (read(fd, data, n) == n)
+	      if ((off_t)metaLength <= fileLength) {
+		const char *meta = end - metaLength;
+		if (meta < (const char *)map) { // metadata larger than the first mapping
+		  munmap(map, mapLength);
+		  meta = mapTail(fd, fileLength, (off_t)metaLength, map, mapLength);
+		}
+		if (meta) {
+		  data = new char[n + 1];
+		  memcpy(data, meta, n);
 		  data[n] = '\0';
-		else {
-		  delete [] data;
-		  data = 0;
 		}
 	      }
 	    }
 	    break;
 	  }
+	if (map != MAP_FAILED)
+	  munmap(map, mapLength);
       }
       (void) close(fd);
       return data;
     }
 
+    namespace {
+      MetadataCache &metadataCache() {
+	static MetadataCache cache(getenv("OCPI_LIBRARY_METADATA_CACHE"));
+	return cache;
+      }
+    }
+    void Artifact::
+    saveMetadataCache() {
+      metadataCache().save();
+    }
+
     // Given metadata in string form, parse it up, shortly after construction
     // The ownership of metadat is passed in here.
     const char *Artifact::
     setFileMetadata(const char *a_name, char *metadata, std::time_t a_mtime, uint64_t a_length,
 		    size_t metaLength) {
       m_metadata = metadata; // take ownership in all cases
-      const char *err = OE::ezxml_parse_str(metadata, strlen(metadata), m_xml);
+      const char *err = OE::ezxml_parse_str(metadata, strlen(metadata), m_xml, true);
       if (err)
 	return OU::esprintf("error parsing artifact metadata from \"%s\": %s", a_name, err);
+      return setXmlMetadata(a_name, a_mtime, a_length, metaLength);
+    }
+    // Check and register the already parsed metadata
+    const char *Artifact::
+    setXmlMetadata(const char *a_name, std::time_t a_mtime, uint64_t a_length,
+		   size_t metaLength) {
       char *xname = ezxml_name(m_xml);
       if (!xname || strcasecmp("artifact", xname))
 	return OU::esprintf("invalid metadata in binary/artifact file \"%s\": no <artifact>",
@@ -386,13 +422,28 @@ namespace OCPI {
     }
     void Artifact::
     getFileMetadata(const char *a_name) {
-      std::time_t l_mtime;
-      uint64_t l_length;
+      MetadataCache &cache = metadataCache();
+      struct stat info;
+      bool cacheable = cache.enabled() && !stat(a_name, &info) && S_ISREG(info.st_mode);
       size_t metaLength;
-      char *metadata = getMetadata(a_name, l_mtime, l_length, metaLength);
-      if (!metadata)
-	throw OU::Error(20, "Cannot open or retrieve metadata from file \"%s\"", a_name);
-      const char *err = setFileMetadata(a_name, metadata, l_mtime, l_length, metaLength);
+      const char *err;
+      if (cacheable && cache.find(info, m_xml, metaLength)) {
+	if (!m_xml)
+	  throw OU::Error(20, "Cannot open or retrieve metadata from file \"%s\"", a_name);
+	err = setXmlMetadata(a_name, info.st_mtime, (uint64_t)info.st_size, metaLength);
+      } else {
+	std::time_t l_mtime;
+	uint64_t l_length;
+	char *metadata = getMetadata(a_name, l_mtime, l_length, metaLength);
+	if (!metadata) {
+	  if (cacheable)
+	    cache.add(a_name, info, 0, NULL);
+	  throw OU::Error(20, "Cannot open or retrieve metadata from file \"%s\"", a_name);
+	}
+	// The image is taken before anything can change the document
+	if (!(err = setFileMetadata(a_name, metadata, l_mtime, l_length, metaLength)) && cacheable)
+	  cache.add(a_name, info, metaLength, m_xml);
+      }
       if (err)
 	throw OU::Error("Error processing metadata from artifact file: %s: %s", a_name, err);
     }
@@ -0,0 +1,188 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <cstdio>
+#include <algorithm>
+#include "OcpiOsDebug.h"
+#include "OcpiUtilMisc.h"
+#include "OcpiUtilAutoMutex.h"
+#include "OcpiLibraryMetadataCache.h"
+
+namespace OU = OCPI::Util;
+
+namespace OCPI {
+  namespace Library {
+    namespace {
+      inline uint64_t mtimeNs(const struct stat &info) {
+#ifdef OCPI_OS_macos
+	return (uint64_t)info.st_mtimespec.tv_nsec;
+#else
+	return (uint64_t)info.st_mtim.tv_nsec;
+#endif
+      }
+    }
+    bool MetadataCache::Entry::
+    matches(const struct stat &info) const {
+      return dev == (uint64_t)info.st_dev && ino == (uint64_t)info.st_ino &&
+	mtime == (uint64_t)info.st_mtime && mtimeNs == ::OCPI::Library::mtimeNs(info) &&
+	length == (uint64_t)info.st_size;
+    }
+    MetadataCache::
+    MetadataCache(const char *file)
+      : m_file(file ? file : ""), m_map(NULL), m_header(NULL), m_entries(NULL) {
+      if (m_file.empty())
+	return;
+      int fd = open(file, O_RDONLY);
+      struct stat info;
+      void *map;
+      if (fd < 0 || fstat(fd, &info) || info.st_size < (off_t)sizeof(Header) ||
+	  (map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0)) ==
+	  MAP_FAILED)
+	ocpiInfo("Artifact metadata cache \"%s\" is absent or unreadable", file);
+      else {
+	const Header *h = (const Header *)map;
+	if (h->magic != c_magic || h->version != c_version ||
+	    h->size != (uint64_t)info.st_size ||
+	    h->nEntries > (h->size - sizeof(Header)) / sizeof(Entry)) {
+	  ocpiInfo("Artifact metadata cache \"%s\" is invalid and will be replaced", file);
+	  munmap(map, (size_t)info.st_size);
+	} else {
+	  m_map = (const char *)map;
+	  m_header = h;
+	  m_entries = (const Entry *)(h + 1);
+	  ocpiDebug("Artifact metadata cache \"%s\" has %u entries", file, h->nEntries);
+	}
+      }
+      if (fd >= 0)
+	close(fd);
+    }
+    MetadataCache::
+    ~MetadataCache() {
+      for (unsigned n = 0; n < m_pending.size(); n++)
+	free((void *)m_pending[n].m_image);
+    }
+    bool MetadataCache::
+    find(const struct stat &info, ezxml_t &xml, size_t &metaLength) {
+      if (!m_header)
+	return false;
+      Entry key;
+      key.dev = info.st_dev;
+      key.ino = info.st_ino;
+      const Entry *end = m_entries + m_header->nEntries,
+	*e = std::lower_bound(m_entries, end, key);
+      if (e == end || !e->matches(info) ||
+	  e->image > m_header->size || e->imageLength > m_header->size - e->image)
+	return false;
+      xml = NULL;
+      if (e->imageLength && !(xml = ezxml_parse_image(m_map + e->image, e->imageLength)))
+	return false;
+      metaLength = e->metaLength;
+      return true;
+    }
+    void MetadataCache::
+    add(const char *name, const struct stat &info, size_t metaLength, ezxml_t xml) {
+      size_t len = 0;
+      void *image = NULL;
+      if (xml && !(image = ezxml_image(xml, &len)))
+	return;
+      OU::AutoMutex guard(m_mutex);
+      m_pending.resize(m_pending.size() + 1);
+      Pending &p = m_pending.back();
+      p.dev = info.st_dev;
+      p.ino = info.st_ino;
+      p.mtime = (uint64_t)info.st_mtime;
+      p.mtimeNs = ::OCPI::Library::mtimeNs(info);
+      p.length = (uint64_t)info.st_size;
+      p.metaLength = metaLength;
+      p.imageLength = len;
+      p.m_name = name;
+      p.m_image = image;
+    }
+    void MetadataCache::
+    save() {
+      OU::AutoMutex guard(m_mutex);
+      if (m_file.empty() || m_pending.empty())
+	return;
+      std::vector<Pending> entries(m_pending);
+      for (unsigned n = 0; m_header && n < m_header->nEntries; n++) {
+	const Entry &e = m_entries[n];
+	struct stat info;
+	const char *name = m_map + e.name;
+	if (e.name < m_header->size && memchr(name, 0, m_header->size - e.name) &&
+	    e.image <= m_header->size && e.imageLength <= m_header->size - e.image &&
+	    !stat(name, &info) && e.matches(info)) {
+	  entries.resize(entries.size() + 1);
+	  Pending &p = entries.back();
+	  (Entry &)p = e;
+	  p.m_name = name;
+	  p.m_image = m_map + e.image;
+	}
+      }
+      // New entries come first so they survive removing duplicates
+      std::stable_sort(entries.begin(), entries.end());
+      entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+      Header h;
+      h.magic = c_magic;
+      h.version = c_version;
+      h.nEntries = (uint32_t)entries.size();
+      h.pad = 0;
+      size_t offset = sizeof(h) + entries.size() * sizeof(Entry);
+      for (unsigned n = 0; n < entries.size(); n++) {
+	entries[n].name = offset;
+	offset += entries[n].m_name.length() + 1;
+      }
+      for (unsigned n = 0; n < entries.size(); n++) {
+	offset = OU::roundUp(offset, 8);
+	entries[n].image = offset;
+	offset += entries[n].imageLength;
+      }
+      h.size = offset;
+      std::vector<char> buf((size_t)h.size, 0);
+      memcpy(&buf[0], &h, sizeof(h));
+      for (unsigned n = 0; n < entries.size(); n++) {
+	Pending &p = entries[n];
+	memcpy(&buf[sizeof(h) + n * sizeof(Entry)], (Entry *)&p, sizeof(Entry));
+	memcpy(&buf[p.name], p.m_name.c_str(), p.m_name.length() + 1);
+	if (p.imageLength)
+	  memcpy(&buf[p.image], p.m_image, p.imageLength);
+      }
+      std::string temp;
+      OU::format(temp, "%s.%u", m_file.c_str(), (unsigned)getpid());
+      FILE *f = fopen(temp.c_str(), "w");
+      if (!f || fwrite(&buf[0], buf.size(), 1, f) != 1 || fclose(f) ||
+	  rename(temp.c_str(), m_file.c_str())) {
+	ocpiInfo("Could not write artifact metadata cache \"%s\": %s", m_file.c_str(),
+		 strerror(errno));
+	if (f)
+	  unlink(temp.c_str());
+      } else
+	ocpiInfo("Wrote artifact metadata cache \"%s\" with %zu entries", m_file.c_str(),
+		 entries.size());
+      for (unsigned n = 0; n < m_pending.size(); n++)
+	free((void *)m_pending[n].m_image);
+      m_pending.clear();
+    }
+  }
+}
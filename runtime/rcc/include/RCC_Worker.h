@@ -36,6 +36,7 @@
 #include "OcpiContainerRunConditionApi.h"
 #ifdef __cplusplus
 
+#include <vector>
 #include "OcpiContainerApi.h" // For proxy slaves
 #endif
 #if defined (WIN32)
@@ -144,7 +145,8 @@ typedef char      RCCChar;
 typedef uint64_t  RCCTime;
 
 // do compile time checks for float, double, and char
-#define RCC_VERSION 1
+// RCC_VERSION is incremented when the layout of the structures shared with workers changes
+#define RCC_VERSION 2
 #define RCC_NO_EXCEPTION (0)
 #define RCC_SYSTEM_EXCEPTION (1)
 #define RCC_NO_ORDINAL ((RCCOrdinal)(-1))
@@ -181,24 +183,49 @@ typedef RCCResult RCCPortMethod(RCCWorker *_this,
    size_t right;
  } RCCPartInfo;
 
+/*
+ * Ports are laid out so that the state used on every run is packed into whole cache
+ * lines and each port starts on its own line.  Ports used by different threads then do
+ * not share lines, and rarely used, container-private port state is kept elsewhere.
+ */
+#define RCC_CACHE_LINE_SIZE 64
+#if defined(__GNUC__)
+#define RCC_CACHE_ALIGNED __attribute__((aligned(RCC_CACHE_LINE_SIZE)))
+#else
+#define RCC_CACHE_ALIGNED
+#endif
+
 typedef struct {
   void *data;
   size_t maxLength;
-  RCCPartInfo *partInfo;
 
   /* private member for container use */
   size_t length_;
-  RCCOpCode opCode_;
   size_t direct_;
-  RCCBoolean isNew_; // hook for upper level initializations
+  RCCPartInfo *partInfo;
 #ifdef WORKER_INTERNAL
   OCPI::RCC::Port *containerPort;
   OCPI::API::ExternalBuffer *portBuffer;
 #else
   void *id_, *id1_;
 #endif
+  RCCOpCode opCode_;
+  RCCBoolean isNew_; // hook for upper level initializations
 } RCCBuffer;
 
+#ifdef WORKER_INTERNAL
+// Port state that is only used by the container, and rarely
+typedef struct {
+  RCCUserPort *userPort;
+  OCPI::Util::Member *sequence;
+  OCPI::Util::Port *metaPort;
+  size_t defaultLength_;
+  RCCBoolean useDefaultLength_; // for C++, use the length field as default
+  RCCBoolean useDefaultOpCode_; // for C++, use the opcode field as default
+  RCCOpCode defaultOpCode_;
+} RCCPortCold;
+#endif
+
 struct RCCPort {
   RCCBuffer current;
 
@@ -219,19 +246,13 @@ struct RCCPort {
   RCCPortMethod *callBack;
   size_t connectedCrewSize;
   /* Used by the container */
-  RCCBoolean useDefaultLength_; // for C++, use the length field as default
-  size_t defaultLength_;
-  RCCBoolean useDefaultOpCode_; // for C++, use the length field as default
-  RCCOpCode defaultOpCode_;
 #ifdef WORKER_INTERNAL
   OCPI::RCC::Port *containerPort;
-  RCCUserPort *userPort;
-  OCPI::Util::Member *sequence;
-  OCPI::Util::Port *metaPort;
+  RCCPortCold *cold_;
 #else
-  void *containerPort, *userPort, *sequence, *metaPort;
+  void *containerPort, *cold_;
 #endif
-};
+} RCC_CACHE_ALIGNED;
 
 typedef struct {
   void *args[3];
@@ -249,17 +270,18 @@ typedef struct {
   RCCResult (*setError)(const char *, ...);
 } RCCContainer;
 
+// The fields used on every run come first
 struct RCCWorker {
   void * RCC_CONST         properties;
-  void * RCC_CONST       * RCC_CONST memories;
   void * RCC_CONST         memory;
-  RCC_CONST RCCContainer   container;
   RCCRunCondition        * runCondition;
   RCCPortMask              connectedPorts;
+  RCCBoolean               firstRun;
+  RCC_CONST RCCContainer   container;
+  void * RCC_CONST       * RCC_CONST memories;
   char                   * errorString;
   size_t                   member;
   size_t                   crewSize;
-  RCCBoolean               firstRun;
   RCCPort                  ports[1];
 };
 
@@ -293,6 +315,7 @@ typedef struct {
 typedef struct {
   size_t size, memSize, *memSizes, propertySize;
   RCCPortInfo *portInfo;
+  unsigned version; // RCC_VERSION of the worker: last, so older workers leave it zero
 } RCCWorkerInfo;
 
 typedef struct {
@@ -468,6 +491,44 @@ typedef struct {
    // optional output arg is max per message for this member.
    size_t memberItemTotal(uint64_t totalItems, size_t maxPerMessage = 0,
                           size_t *perMessage = NULL);
+   // Data-parallel loops on the container's compute thread pool, which this thread joins.
+   // The range [0, n) is split into chunks of "grain" items (zero for a default that
+   // balances the threads, or cacheGrain(sizeof(item)) for chunks that fit in the cache).
+   // Chunks run concurrently, so each must only write its own part of any output.
+   typedef void Chunk(void *arg, size_t chunk, size_t begin, size_t end);
+   void parallelFor(size_t n, size_t grain, Chunk *fn, void *arg);
+   size_t parallelChunks(size_t n, size_t grain = 0);
+   static size_t cacheGrain(size_t itemSize);
+   // body(begin, end) is called for each chunk.  The body may be a lambda or other
+   // temporary, and is called as const.
+   template <class Body> void parallelFor(size_t n, const Body &body, size_t grain = 0) {
+     parallelFor(n, grain, forChunk<Body>, (void *)&body);
+   }
+   // body(begin, end) returns the result for each chunk, and the results are folded in
+   // chunk order with combine(a, b), starting with identity
+   template <class T, class Body, class Combine>
+   T parallelReduce(size_t n, T identity, const Body &body, Combine combine,
+		    size_t grain = 0) {
+     if (!n)
+       return identity;
+     std::vector<T> partials(parallelChunks(n, grain), identity);
+     ReduceArgs<T, Body> args = { body, &partials[0] };
+     parallelFor(n, grain, reduceChunk<T, Body>, &args);
+     T result = identity;
+     for (size_t c = 0; c < partials.size(); c++)
+       result = combine(result, partials[c]);
+     return result;
+   }
+ private:
+   template <class Body> static void forChunk(void *arg, size_t, size_t begin, size_t end) {
+     (*(const Body *)arg)(begin, end);
+   }
+   template <class T, class Body> struct ReduceArgs { const Body &body; T *partials; };
+   template <class T, class Body>
+   static void reduceChunk(void *arg, size_t chunk, size_t begin, size_t end) {
+     ReduceArgs<T, Body> &args = *(ReduceArgs<T, Body> *)arg;
+     args.partials[chunk] = args.body(begin, end);
+   }
  protected:
    bool m_first;
    RCCWorker &m_rcc;
@@ -38,7 +38,9 @@
 #endif
 #include "RCC_Worker.h"
 
+#include <map>
 #include "OcpiOsLoadableModule.h"
+#include "OcpiUtilMisc.h"
 
 #include "ContainerManager.h"
 
@@ -69,6 +71,9 @@ namespace OCPI {
 	
         OCPI::OS::LoadableModule m_loader;
 	RCCEntryTable           *m_entryTable;
+	// Index of the entry table by worker name, built when the artifact is loaded
+	typedef std::map<const char *, RCCEntryTable *, OCPI::Util::ConstCharComp> Dispatches;
+	Dispatches               m_dispatches;
 	bool                     m_open;
         int                      m_workerCount;
 
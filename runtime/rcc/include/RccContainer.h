@@ -37,6 +37,7 @@
 
 #include "pthread_workqueue.h"
 #include "OcpiOsSemaphore.h"
+#include "OcpiUtilThreadPool.h"
 #include "RccApplication.h"
 #include "RccDriver.h"
 
@@ -72,6 +73,10 @@ namespace OCPI {
       static const int LOW_PRI_Q = 0;
       static const int HIGH_PRI_Q = 1;
       static pthread_workqueue_t m_workqueues[WORKQUEUE_COUNT]; 
+      // The pool for data-parallel loops in workers, created when first used
+      OCPI::Util::ThreadPool *m_threadPool;
+      unsigned m_computeThreads;
+      bool m_pinThreads;
 
     public:
       friend class Port;
@@ -93,11 +98,14 @@ namespace OCPI {
 	throw (OCPI::Util::EmbeddedException);
       OCPI::Container::Artifact &
       createArtifact(OCPI::Library::Artifact &lart, const OCPI::API::PValue *artifactParams);
+      void *prefetchArtifact(OCPI::Library::Artifact &lart);
+      void releasePrefetch(void *handle);
 
       // worker task management
       void addTask( void (*workitem_func)(void *), void * args );
       void addTask( RCCUserTask * task );
       bool join( bool block, OCPI::OS::Semaphore & sem );
+      OCPI::Util::ThreadPool &threadPool();
 
       //      void start(DataTransfer::EventManager* event_manager) throw();
       //      void stop(DataTransfer::EventManager* event_manager) throw();
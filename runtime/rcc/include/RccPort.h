@@ -95,6 +95,18 @@ namespace OCPI {
       createExternal(const char *extName, bool provider,
 		     const OCPI::Util::PValue *extParams,
 		     const OCPI::Util::PValue *connParams);
+    private:
+      // Set the length and opcode of a new output buffer to their defaults
+      void initOutput() {
+	m_rccPort.output.length = 
+	  m_rccPort.cold_->useDefaultLength_ ? m_rccPort.cold_->defaultLength_ : 
+	  m_rccPort.current.maxLength;
+	m_rccPort.current.opCode_ =
+	  m_rccPort.cold_->useDefaultOpCode_ ? m_rccPort.cold_->defaultOpCode_ :
+	  m_rccPort.output.u.operation;
+	m_rccPort.current.length_ = m_rccPort.output.length;
+	m_rccPort.current.direct_ = 0;
+      }
     public:
       // These methods are called in one place from the worker from C, hence public and inline
       bool requestRcc(size_t max = 0) {
@@ -107,14 +119,7 @@ namespace OCPI {
 	  if (isOutput()) {
 	    if ((m_buffer = getBuffer(data, m_rccPort.current.maxLength))) {
 	      m_rccPort.current.data = (void*)data;
-	      m_rccPort.output.length = 
-		m_rccPort.useDefaultLength_ ? m_rccPort.defaultLength_ : 
-		m_rccPort.current.maxLength;
-	      m_rccPort.current.opCode_ =
-		m_rccPort.useDefaultOpCode_ ? m_rccPort.defaultOpCode_ :
-		m_rccPort.output.u.operation;
-	      m_rccPort.current.length_ = m_rccPort.output.length;
-	      m_rccPort.current.direct_ = 0;
+	      initOutput();
 	    }
 	  } else {
 	    bool end;
@@ -194,6 +199,26 @@ namespace OCPI {
 	return false;
       }
 
+      // Drop the worker's current input buffer along with any queued behind it
+      unsigned discardInput() {
+	if (isInput() && m_buffer) {
+	  m_rccPort.current.data = NULL;
+	  m_buffer = NULL;
+	  m_wantsBuffer = true;
+	}
+	return OCPI::Container::Port::discardInput();
+      }
+
+      // An output buffer held by the worker is kept, since it is empty, but presented to
+      // the worker as new
+      unsigned discardOutput() {
+	if (isOutput() && m_buffer) {
+	  initOutput();
+	  m_rccPort.current.isNew_ = true;
+	}
+	return OCPI::Container::Port::discardOutput();
+      }
+
       void sendRcc(RCCBuffer &buffer) {
 	ocpiAssert(buffer.portBuffer && buffer.containerPort);
 	try {
@@ -180,6 +180,7 @@ namespace OCPI {
       // Mutable since this is a side effect of clearing the worker-set error when reported
       mutable char     *m_errorString;         // error string set via "setError"
     protected:
+      bool hasCounters() const { return true; }
       OCPI::Container::Worker &getSlave(unsigned i);
       RCCPort &portInit() { return m_context->ports[m_portInit++]; }
       inline uint8_t * getPropertyVaddr() const { return  (uint8_t*)m_context->properties; }
@@ -195,9 +196,6 @@ namespace OCPI {
       OCPI::OS::Timer m_runTimer;
       OCPI::OS::Time  m_lastRun;
 
-      // Debug/stats
-      uint64_t worker_run_count;
-
       // Pointer into actual RCC worker binary for its dispatch struct
       OCPI::DataTransport::Transport &m_transport;
 
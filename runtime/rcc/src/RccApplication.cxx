@@ -65,13 +65,15 @@ Artifact(Container &c, OCPI::Library::Artifact &lart, const OA::PValue *props)
     OU::format(err, "Worker DLL entry point not found: %s", entryPoint);
     throw err;
   }
+  for (RCCEntryTable *et = m_entryTable; et->name; et++)
+    m_dispatches.insert(Dispatches::value_type(et->name, et));
 }
 
 RCCEntryTable *Artifact::
 getDispatch(const char *implName) {
-  for (RCCEntryTable *et = m_entryTable; et->name; et++)
-    if (!strcmp(et->name, implName))
-      return et;
+  Dispatches::const_iterator it = m_dispatches.find(implName);
+  if (it != m_dispatches.end())
+    return it->second;
   std::string error;
   OU::format(error, "Worker \"%s\" not found in artifact file \"%s\" (found",
 	     implName, name().c_str());
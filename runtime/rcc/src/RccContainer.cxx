@@ -57,10 +57,19 @@ getEventManager()
 
 class Driver;
 Container::
-Container(const char *a_name, const OA::PValue* /* params */)
+Container(const char *a_name, const OA::PValue* params)
   throw ( OU::EmbeddedException )
-  : OC::ContainerBase<Driver,Container,Application,Artifact>(*this, a_name)
+  : OC::ContainerBase<Driver,Container,Application,Artifact>(*this, a_name, NULL, params),
+    m_threadPool(NULL), m_computeThreads(0), m_pinThreads(true)
 {
+  // By default the compute pool has a thread for each processor except the one we run on
+  std::vector<unsigned> cpus;
+  OCPI::OS::getProcessors(cpus);
+  m_computeThreads = (unsigned)cpus.size() - 1;
+  OA::ULong ul;
+  if (OU::findULong(params, "computeThreads", ul))
+    m_computeThreads = ul;
+  OU::findBool(params, "pinThreads", m_pinThreads);
   const char *system = OU::getSystemId().c_str();
   m_model = "rcc";
   addTransport("ocpi-dma-pio", system, OR::ActiveMessage, OR::ActiveMessage,
@@ -71,6 +80,9 @@ Container(const char *a_name, const OA::PValue* /* params */)
   addTransport("ocpi-smb-pio", system, OR::ActiveMessage, OR::ActiveMessage,
 	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive),
 	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive));
+  addTransport("ocpi-smb-shm", system, OR::ActiveMessage, OR::ActiveMessage,
+	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive),
+	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive));
   addTransport("ocpi-scif-dma", system, OR::ActiveMessage, OR::ActiveMessage,
 	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive),
 	       (1 << OR::ActiveFlowControl) | (1 << OR::ActiveMessage) | (1 << OR::Passive));
@@ -124,6 +136,23 @@ createArtifact(OCPI::Library::Artifact &lart, const OA::PValue *artifactParams)
   return *new Artifact(*this, lart, artifactParams);
 }
 
+// Loading the module ahead of time makes the Artifact's own load just a reference to it.
+void *Container::
+prefetchArtifact(OCPI::Library::Artifact &lart) {
+  std::string error;
+  void *handle = OCPI::OS::LoadableModule::load(lart.name().c_str(), false, error);
+  if (handle)
+    ocpiInfo("Prefetched RCC worker artifact %s", lart.name().c_str());
+  else
+    ocpiInfo("Prefetching RCC worker artifact failed: %s", error.c_str());
+  return handle;
+}
+
+void Container::
+releasePrefetch(void *handle) {
+  OCPI::OS::LoadableModule::unload(handle);
+}
+
 
 /**********************************
  * Destructor
@@ -139,6 +168,24 @@ Container::
   // We need to shut down the apps and workers since they
   // depend on artifacts and transport.
   OU::Parent<Application>::deleteChildren();
+  delete m_threadPool;
+}
+
+// Created on first use, normally in our own thread, so that the pool threads are
+// placed on the processors this container's thread is allowed to use.
+// The pointer is published with release ordering so other threads that see it also
+// see the constructed pool.
+OU::ThreadPool &Container::
+threadPool() {
+  OU::ThreadPool *pool = __atomic_load_n(&m_threadPool, __ATOMIC_ACQUIRE);
+  if (!pool) {
+    OU::SelfAutoMutex guard(this);
+    if (!(pool = m_threadPool)) {
+      pool = new OU::ThreadPool(m_computeThreads, m_pinThreads);
+      __atomic_store_n(&m_threadPool, pool, __ATOMIC_RELEASE);
+    }
+  }
+  return *pool;
 }
 
 
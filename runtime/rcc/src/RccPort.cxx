@@ -51,16 +51,16 @@ namespace OCPI {
       // FIXME: deep copy params?
       // Initialize rccPort with aspects based on metadata
       if (pmd.nOperations() <= 1) {
-	m_rccPort.useDefaultOpCode_ = true;
+	m_rccPort.cold_->useDefaultOpCode_ = true;
 	if (pmd.nOperations() == 1) {
-	  m_rccPort.useDefaultLength_ = true;
+	  m_rccPort.cold_->useDefaultLength_ = true;
 	  OU::Operation &o = pmd.operations()[0];
 	  if (o.nArgs()) {
-	    m_rccPort.defaultLength_ = pmd.m_minBufferSize;
+	    m_rccPort.cold_->defaultLength_ = pmd.m_minBufferSize;
 	    if (o.nArgs() > 1) {
 	      OU::Member &m = o.args()[o.nArgs() - 1];
 	      if (m.isSequence())
-		m_rccPort.sequence = &m;
+		m_rccPort.cold_->sequence = &m;
 	    }
 	  }
 	}
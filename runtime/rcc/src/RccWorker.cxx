@@ -19,6 +19,8 @@
  */
 
 #include <climits>
+#include <new>
+#include <stdlib.h>
 #include "OcpiTimeEmitCategories.h"
 #include "RccApplication.h"
 #include "RccPort.h"
@@ -42,7 +44,7 @@ Worker(Application & app, Artifact *art, const char *a_name, ezxml_t impl, ezxml
     m_entry(art ? art->getDispatch(ezxml_cattr(impl, "name")) : NULL), m_user(NULL),
     m_dispatch(NULL), m_portInit(0), m_context(NULL), m_mutex(app.container()),
     m_runCondition(NULL), m_errorString(NULL), enabled(false), hasRun(false),
-    sourcePortCount(0), targetPortCount(0), m_nPorts(nPorts()), worker_run_count(0),
+    sourcePortCount(0), targetPortCount(0), m_nPorts(nPorts()),
     m_transport(app.parent().getTransport()), m_taskSem(0)
 {
    memset(&m_info, 0, sizeof(m_info));
@@ -66,6 +68,7 @@ Worker(Application & app, Artifact *art, const char *a_name, ezxml_t impl, ezxml
      setControlMask(mask);
    }
    if (m_dispatch) {
+     m_info.version = m_dispatch->version;
      m_info.memSize = m_dispatch->memSize;
      m_info.memSizes = m_dispatch->memSizes;
      m_info.portInfo = m_dispatch->portInfo;
@@ -158,7 +161,7 @@ Worker::
   delete[] (char*)m_context->memory;
   if (m_dispatch && m_context->properties)
     delete[] (char*)m_context->properties;
-  delete[] m_context;
+  free(m_context);
   if (m_errorString)
     free(m_errorString);
   while (!m_testPmds.empty()) {
@@ -261,6 +264,11 @@ rccTake(RCCPort *rccPort, RCCBuffer *oldBuffer, RCCBuffer *newBuffer)
  {
    RCCDispatch *wd = m_dispatch;
 
+   // A worker built against a different RCC_Worker.h would see a different layout.
+   // C workers have it in the dispatch, and C++ workers set it in the info.
+   if (m_info.version != RCC_VERSION)
+     throw OU::Error("worker version (%u) differs from the container's RCC version (%u): "
+		     "the worker must be rebuilt", m_info.version, RCC_VERSION);
    // check masks for bad bits
    if (m_nPorts) {
      if (wd && m_nPorts != wd->numInputs + wd->numOutputs)
@@ -295,9 +303,17 @@ rccTake(RCCPort *rccPort, RCCBuffer *oldBuffer, RCCBuffer *newBuffer)
 
    // Now after error checking we start to allocate resources
    // Create our context
-   size_t clen = sizeof(RCCWorker) + m_nPorts * sizeof(RCCPort);
-   m_context = (RCCWorker *)new char[clen];
+   // The context is cache line aligned so that each port is on its own lines, and the
+   // container's rarely used per-port state follows the ports.
+   size_t
+     plen = sizeof(RCCWorker) + m_nPorts * sizeof(RCCPort),
+     clen = plen + m_nPorts * sizeof(RCCPortCold);
+   void *context;
+   if (posix_memalign(&context, RCC_CACHE_LINE_SIZE, clen))
+     throw std::bad_alloc();
+   m_context = (RCCWorker *)context;
    memset(m_context, 0, clen);
+   RCCPortCold *cold = (RCCPortCold *)((char *)m_context + plen);
    m_context->member = member();
    m_context->crewSize = crewSize();
    m_context->firstRun = true;
@@ -313,9 +329,10 @@ rccTake(RCCPort *rccPort, RCCBuffer *oldBuffer, RCCBuffer *newBuffer)
      m_context->ports[n].current.data = NULL;
      m_context->ports[n].current.maxLength = 0;
      m_context->ports[n].callBack = 0;
-     m_context->ports[n].userPort = NULL;
-     m_context->ports[n].sequence = NULL;
-     m_context->ports[n].metaPort = &getPorts()[n];
+     m_context->ports[n].cold_ = &cold[n];
+     cold[n].userPort = NULL;
+     cold[n].sequence = NULL;
+     cold[n].metaPort = &getPorts()[n];
    }
 
    // Create our memory spaces
@@ -546,8 +563,10 @@ run(bool &anyone_run) {
     // First do the checks that don't depend on port readiness.
     if (m_runCondition->shouldRun(m_runTimer, timedOut, dont))
       break;
-    else if (dont)
+    else if (dont) {
+      m_counters.m_notReady++;
       return;
+    }
     // Start out assuming optional unconnected ports are "ready"
     RCCPortMask readyMask = optionalPorts() & ~m_context->connectedPorts;
     // Only examine connected ports that are in the run condition
@@ -557,15 +576,19 @@ run(bool &anyone_run) {
     for (unsigned n = m_nPorts; n; n--, rccPort++, portBit <<= 1)
       if ((portBit & relevantMask) && rccPort->containerPort->checkReady())
 	readyMask |= portBit;
-    if (!readyMask)
+    if (!readyMask) {
+      m_counters.m_notReady++;
       return;
+    }
     // See if any of our masks are satisfied
     RCCPortMask *pmp, pm = 0;
     for (pmp = m_runCondition->m_portMasks; (pm = *pmp); pmp++)
       if ((pm & readyMask) == (pm & ~(RCC_ALL_PORTS << m_nPorts)))
 	break;
-    if (!pm)
+    if (!pm) {
+      m_counters.m_notReady++;
       return;
+    }
   } while (0);
   assert(enabled);
   if (!m_dispatch || m_dispatch->run) {
@@ -578,8 +601,14 @@ run(bool &anyone_run) {
     OCPI_EMIT_REGISTER_FULL_VAR( "Worker Run", OCPI::Time::Emit::DT_u, 1, OCPI::Time::Emit::State, wre ); \
     OCPI_EMIT_STATE_CAT_NR_(wre, 1, OCPI_EMIT_CAT_WORKER_DEV, OCPI_EMIT_CAT_WORKER_DEV_RUN_TIME);
     ocpiDebug("Running worker \"%s/%s\"", name().c_str(), OU::Worker::cname());
+    OS::Time runStart = OS::Time::now();
     RCCResult rc = m_dispatch ?
       m_dispatch->run(m_context, timedOut, &newRunCondition) : m_user->run(timedOut);
+    uint64_t runTime = (OS::Time::now() - runStart).bits();
+    m_counters.m_runTime += runTime;
+    if (runTime > m_counters.m_maxRunTime)
+      m_counters.m_maxRunTime = runTime;
+    m_counters.m_runs++;
     OCPI_EMIT_STATE_CAT_NR_(wre, 0, OCPI_EMIT_CAT_WORKER_DEV, OCPI_EMIT_CAT_WORKER_DEV_RUN_TIME);
     m_context->firstRun = false;
     if (m_user)
@@ -633,7 +662,6 @@ run(bool &anyone_run) {
 				  OU::ApplicationRecoverable : OU::ApplicationFatal);
 	}
       }
-    worker_run_count++;
   }
 }
 
@@ -1081,6 +1109,26 @@ OCPI_CONTROL_OPS
      //     return c->join( block, m_worker.m_taskSem );
    }
 
+   size_t RCCUserWorker::
+   parallelChunks(size_t n, size_t grain) {
+     return m_worker.parent().parent().threadPool().nChunks(n, grain);
+   }
+
+   void RCCUserWorker::
+   parallelFor(size_t n, size_t grain, Chunk *fn, void *arg) {
+     try {
+       m_worker.parent().parent().threadPool().run(n, grain, fn, arg);
+     } catch (std::string &e) {
+       throw OU::Error("Error in parallel loop of worker \"%s\": %s",
+		       m_worker.name().c_str(), e.c_str());
+     }
+   }
+
+   size_t RCCUserWorker::
+   cacheGrain(size_t itemSize) {
+     return OU::ThreadPool::cacheGrain(itemSize);
+   }
+
    // Default worker methods
    RCCResult RCCUserWorker::initialize() { return RCC_OK;}
    RCCResult RCCUserWorker::start() { return RCC_OK;}
@@ -1130,7 +1178,7 @@ OCPI_CONTROL_OPS
    RCCUserPort()
      : m_rccPort(((Worker *)pthread_getspecific(Driver::s_threadKey))->portInit()) {
      m_rccBuffer = &m_rccPort.current;
-     m_rccPort.userPort = this;
+     m_rccPort.cold_->userPort = this;
    };
    // C++ specific buffer initialization.  When C is better integrated, can be common.
    // Opcode is initialized so we can both detect mismatches (opcode vs opcode-specific
@@ -1144,16 +1192,16 @@ OCPI_CONTROL_OPS
    }
    void RCCUserPort::
    checkOpCode(RCCUserBuffer &buf, unsigned a_opCode, bool setting) const {
-     if (m_rccPort.metaPort->operations() && a_opCode >= m_rccPort.metaPort->m_nOperations)
+     if (m_rccPort.cold_->metaPort->operations() && a_opCode >= m_rccPort.cold_->metaPort->m_nOperations)
        throw OU::Error("invalid to access opcode %u on port \"%s\"", a_opCode,
-		       m_rccPort.metaPort->m_name.c_str());
-     if (m_rccPort.metaPort->m_provider && setting)
+		       m_rccPort.cold_->metaPort->m_name.c_str());
+     if (m_rccPort.cold_->metaPort->m_provider && setting)
        throw OU::Error("invalid to modify opcode (to %u) on input port \"%s\"", a_opCode,
-		       m_rccPort.metaPort->m_name.c_str());
+		       m_rccPort.cold_->metaPort->m_name.c_str());
      if (buf.m_rccBuffer->isNew_) {
-       buf.initBuffer(!m_rccPort.metaPort->m_provider);
-       if (!m_rccPort.metaPort->m_provider && m_rccPort.metaPort->operations()) {
-	 OU::Operation &op = m_rccPort.metaPort->operations()[a_opCode];
+       buf.initBuffer(!m_rccPort.cold_->metaPort->m_provider);
+       if (!m_rccPort.cold_->metaPort->m_provider && m_rccPort.cold_->metaPort->operations()) {
+	 OU::Operation &op = m_rccPort.cold_->metaPort->operations()[a_opCode];
 	 ocpiDebug("Implicit length for op %u set to %zu", a_opCode, op.defaultLength());
 	 size_t l_length = op.defaultLength(); // Could be using a non-zero default length
 	 if (op.m_nArgs > 1) {
@@ -1167,7 +1215,7 @@ OCPI_CONTROL_OPS
      } else if (buf.m_opCodeSet && a_opCode != buf.m_rccBuffer->opCode_)
        throw OU::Error("opcode accessor for %u used when port opcode set to %u",
 		       a_opCode, buf.m_rccBuffer->opCode_);
-     if (!m_rccPort.metaPort->m_provider) {
+     if (!m_rccPort.cold_->metaPort->m_provider) {
        buf.m_opCodeSet = true;
        buf.m_rccBuffer->opCode_ = OCPI_UTRUNCATE(uint8_t, a_opCode);
      }
@@ -1254,19 +1302,19 @@ OCPI_CONTROL_OPS
    advance(size_t maxlength) {
      assert(m_rccPort.containerPort);
      if (m_rccPort.containerPort->isOutput()) {
-       if (!m_opCodeSet && !m_rccPort.useDefaultOpCode_)
+       if (!m_opCodeSet && !m_rccPort.cold_->useDefaultOpCode_)
 	 throw
 	   OU::Error("port \"%s\" advanced without setting opcode or setting default opcode",
 		     m_rccPort.containerPort->name().c_str());
        if (!m_lengthSet && !m_resized) {
-	 if (!m_rccPort.useDefaultLength_)
+	 if (!m_rccPort.cold_->useDefaultLength_)
 	   throw OU::Error("port \"%s\" advanced without setting length or resizing sequence",
 			   m_rccPort.containerPort->name().c_str());
 	 // If we are allowed to default the length due to there being only one operation
 	 // and the last argument is a sequence that is not the first argument, make sure
 	 // to set the embedded sequence length to maintain the integrity of the message
-	 if (m_rccPort.sequence) {
-	   const OU::Member &m = *m_rccPort.sequence;
+	 if (m_rccPort.cold_->sequence) {
+	   const OU::Member &m = *m_rccPort.cold_->sequence;
 	   *(uint32_t *)((uint8_t*)m_rccPort.current.data + m.m_offset) =
 	     OCPI_UTRUNCATE(uint32_t,
 			    (m_rccPort.current.length_ - (m.m_offset + m.m_align)) /
@@ -1309,32 +1357,32 @@ OCPI_CONTROL_OPS
    }
    void RCCUserPort::
    shouldBeOutput() const {
-     if (m_rccPort.metaPort->m_provider)
+     if (m_rccPort.cold_->metaPort->m_provider)
        throw OU::Error("Port \"%s\" is an input port, opcode or length cannot be set", 
-		       m_rccPort.metaPort->m_name.c_str());
+		       m_rccPort.cold_->metaPort->m_name.c_str());
    }
    void RCCUserPort::
    setDefaultLength(size_t a_length) {
      shouldBeOutput();
-     m_rccPort.defaultLength_ = a_length;
-     m_rccPort.useDefaultLength_ = true;
+     m_rccPort.cold_->defaultLength_ = a_length;
+     m_rccPort.cold_->useDefaultLength_ = true;
    }
 
    void RCCUserPort::
    setDefaultOpCode(RCCOpCode a_opCode) {
      shouldBeOutput();
-     if (a_opCode >= m_rccPort.metaPort->nOperations() && m_rccPort.metaPort->operations())
+     if (a_opCode >= m_rccPort.cold_->metaPort->nOperations() && m_rccPort.cold_->metaPort->operations())
        throw OU::Error("Opcode %u is not allowed for port %s: maximum is %zu",
-		       a_opCode, m_rccPort.metaPort->m_name.c_str(),
-		       m_rccPort.metaPort->nOperations() - 1);
-     m_rccPort.defaultOpCode_ = a_opCode;
-     m_rccPort.useDefaultOpCode_ = true;
+		       a_opCode, m_rccPort.cold_->metaPort->m_name.c_str(),
+		       m_rccPort.cold_->metaPort->nOperations() - 1);
+     m_rccPort.cold_->defaultOpCode_ = a_opCode;
+     m_rccPort.cold_->useDefaultOpCode_ = true;
      // If there is a protocol, setting the default opcode sets the default size,
      // including any sequence being zero length.
-     if (m_rccPort.metaPort->operations()) {
-       OU::Operation &op = m_rccPort.metaPort->operations()[a_opCode];
+     if (m_rccPort.cold_->metaPort->operations()) {
+       OU::Operation &op = m_rccPort.cold_->metaPort->operations()[a_opCode];
        ocpiDebug("Default length for op %u is %zu", a_opCode, op.defaultLength());
-       if (!m_rccPort.useDefaultLength_)
+       if (!m_rccPort.cold_->useDefaultLength_)
 	 setDefaultLength(op.defaultLength());
      }
    }
@@ -36,6 +36,7 @@ namespace OCPI {
     class Launcher : public OCPI::Container::Launcher {
       int m_fd;              // socket fd
       bool m_sending;        // Is next phase to send something?
+      bool m_received;       // Has exchange() received the response for the next work()?
       std::string m_request; // xml text request being constructed
       std::vector<char> m_response;      // char buffer of received response
       ezxml_t m_rx;          // parsed xml of received response
@@ -63,12 +64,15 @@ namespace OCPI {
       void emitConnection(const Launcher::Members &members, Launcher::Connection &c);
       void emitConnectionUpdate(unsigned nConn, const char *iname, std::string &sinfo);
       void loadArtifact(ezxml_t ax); // Just push the bytes down the pipe, getting a response for each.
+      void receiveLaunching();
       void updateConnection(ezxml_t cx);
     public:
       bool
 	wait(unsigned remoteInstance, OCPI::OS::ElapsedTime timeout),
 	launch(Launcher::Members &members, Launcher::Connections &connections),
 	work(Launcher::Members &members, Launcher::Connections &connections);
+      void exchange();
+      bool exchanges() const { return !m_sending && !m_received; }
       OCPI::Util::Worker::ControlState getState(unsigned remoteInstance);
       void
 	controlOp(unsigned remoteInstance, OU::Worker::ControlOperation),
@@ -94,6 +94,12 @@ class Worker
     v.unparse(val);
     m_launcher.setPropertyValue(m_remoteInstance, &p - properties(), val);
   }
+  // Property bytes are not accessible here, so values are sent one at a time
+  void setPropertyValues(size_t nValues, const unsigned *ordinals,
+			 const OU::Value *const *values) {
+    for (size_t n = 0; n < nValues; n++)
+      setPropertyValue(property(ordinals[n]), *values[n]);
+  }
   bool wait(OS::Timer *t) {
     return m_launcher.wait(m_remoteInstance, t ? t->getRemaining() : 0);
   }
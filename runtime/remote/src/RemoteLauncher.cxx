@@ -42,7 +42,7 @@ namespace OCPI {
 
 Launcher::
 Launcher(OS::Socket &socket)
-  : m_fd(socket.fd()), m_sending(false), m_rx(NULL) {
+  : m_fd(socket.fd()), m_sending(false), m_received(false), m_rx(NULL) {
 }
 
 Launcher::
@@ -345,6 +345,24 @@ launch(Launcher::Members &instances, Launcher::Connections &connections) {
   send();
   return m_more = true; // more to do
 }
+// Receive the response to a launch or update request, and send any artifacts that the
+// server asks for.  Only this launcher's own state is touched here.
+void Launcher::
+receiveLaunching() {
+  receive();
+  if (strcasecmp(OX::ezxml_tag(m_rx),"launching"))
+    throw OU::Error("Unexpected response from container server \"%s\": %s",
+		    m_name.c_str(), OX::ezxml_tag(m_rx));
+  for (ezxml_t ax = ezxml_child(m_rx, "artifact"); ax; ax = ezxml_cnext(ax))
+    loadArtifact(ax); // Just push the bytes down the pipe, getting a response for each.
+}
+void Launcher::
+exchange() {
+  if (exchanges()) {
+    receiveLaunching();
+    m_received = true;
+  }
+}
 // Here we process a response from launch request.
 // We get here because we "asked for more".
 // We in fact ping-pong between receiving responses and sending requests
@@ -387,10 +405,9 @@ work(Launcher::Members &instances, Launcher::Connections &connections) {
     if (m_more)
       send();
   } else {
-    receive();
-    assert(!strcasecmp(OX::ezxml_tag(m_rx),"launching"));
-    for (ezxml_t ax = ezxml_child(m_rx, "artifact"); ax; ax = ezxml_cnext(ax))
-      loadArtifact(ax); // Just push the bytes down the pipe, getting a response for each.
+    if (!m_received)
+      receiveLaunching();
+    m_received = false;
     for (ezxml_t cx = ezxml_child(m_rx, "connection"); cx; cx = ezxml_cnext(cx))
       updateConnection(cx);
     m_more = ezxml_cattr(m_rx, "done") == NULL;
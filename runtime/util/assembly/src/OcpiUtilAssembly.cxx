@@ -43,7 +43,7 @@ namespace OCPI {
         size_t len = strlen(cp);
         m_copy = new char[len + 1];
         strcpy(m_copy, cp);
-        err = OE::ezxml_parse_str(m_copy, len, m_xml);
+        err = OE::ezxml_parse_str(m_copy, len, m_xml, true);
       } else
         err = OE::ezxml_parse_file(file, m_xml);
       if (err || (err = parse(NULL, extraTopAttrs, extraInstAttrs, params)))
@@ -54,7 +54,7 @@ namespace OCPI {
       : m_xmlOnly(false), m_isImpl(false) {
       m_copy = new char[string.size() + 1];
       strcpy(m_copy, string.c_str());
-      const char *err = OE::ezxml_parse_str(m_copy, string.size(), m_xml);
+      const char *err = OE::ezxml_parse_str(m_copy, string.size(), m_xml, true);
       if (err || (err = parse(NULL, extraTopAttrs, extraInstAttrs, params)))
         throw Error("%s", err);
     }
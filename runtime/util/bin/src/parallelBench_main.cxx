@@ -0,0 +1,150 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for the thread pool used by RCC workers' parallelFor/parallelReduce.
+ * The kernel is a complex mixer followed by a real-tap FIR, as in a channelizer,
+ * run over one buffer with 0..N pool threads and compared against the serial result.
+ *
+ * Usage: parallelBench [samples [taps [maxThreads [iterations]]]]
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <OcpiOsTimer.h>
+#include <OcpiOsMisc.h>
+#include <OcpiUtilThreadPool.h>
+
+namespace OS = OCPI::OS;
+namespace OU = OCPI::Util;
+
+struct Kernel {
+  const float *in;   // interleaved I/Q, with taps-1 samples of history in front
+  float *out;        // interleaved I/Q
+  const float *taps;
+  size_t nTaps;
+  float phaseInc;
+  // Mix and filter samples [begin, end)
+  void operator()(size_t begin, size_t end) {
+    for (size_t n = begin; n < end; n++) {
+      float accI = 0, accQ = 0;
+      for (size_t t = 0; t < nTaps; t++) {
+	size_t s = n + nTaps - 1 - t;
+	float ph = phaseInc * (float)s, c = cosf(ph), sn = sinf(ph);
+	float i = in[2*s], q = in[2*s+1];
+	accI += taps[t] * (i * c - q * sn);
+	accQ += taps[t] * (i * sn + q * c);
+      }
+      out[2*n] = accI;
+      out[2*n+1] = accQ;
+    }
+  }
+};
+
+static void
+chunk(void *arg, size_t, size_t begin, size_t end) {
+  (*(Kernel *)arg)(begin, end);
+}
+
+struct Energy {
+  const float *out;
+  double operator()(size_t begin, size_t end) const {
+    double e = 0;
+    for (size_t n = begin; n < end; n++)
+      e += out[2*n] * out[2*n] + out[2*n+1] * out[2*n+1];
+    return e;
+  }
+};
+
+static void
+energyChunk(void *arg, size_t c, size_t begin, size_t end) {
+  std::pair<Energy *, double *> &p = *(std::pair<Energy *, double *> *)arg;
+  p.second[c] = (*p.first)(begin, end);
+}
+
+static double
+seconds(OS::Time t) {
+  return t.seconds() + t.nanoseconds() / 1e9;
+}
+
+int main(int argc, char **argv) {
+  size_t
+    nSamples = argc > 1 ? strtoul(argv[1], NULL, 0) : 1024*1024,
+    nTaps = argc > 2 ? strtoul(argv[2], NULL, 0) : 32;
+  std::vector<unsigned> cpus;
+  OS::getProcessors(cpus);
+  unsigned
+    maxThreads = argc > 3 ? (unsigned)atoi(argv[3]) : (unsigned)cpus.size() - 1,
+    iterations = argc > 4 ? (unsigned)atoi(argv[4]) : 5;
+  std::vector<float> in(2 * (nSamples + nTaps - 1)), taps(nTaps), ref(2 * nSamples),
+    out(2 * nSamples);
+  srand(1);
+  for (size_t n = 0; n < in.size(); n++)
+    in[n] = (float)rand() / (float)RAND_MAX - 0.5f;
+  for (size_t t = 0; t < nTaps; t++)
+    taps[t] = 1.0f / (float)nTaps;
+  Kernel k = { &in[0], &ref[0], &taps[0], nTaps, 0.01f };
+  OS::Time start = OS::Time::now();
+  for (unsigned i = 0; i < iterations; i++)
+    k(0, nSamples);
+  double serial = seconds(OS::Time::now() - start) / iterations;
+  printf("%zu samples, %zu taps, %u processors available\n", nSamples, nTaps,
+	 (unsigned)cpus.size());
+  printf("serial:                %8.3f ms  %8.2f Msamples/s\n", serial * 1e3,
+	 (double)nSamples / serial / 1e6);
+  int ret = 0;
+  for (unsigned nThreads = 0; nThreads <= maxThreads; nThreads = nThreads ? nThreads * 2 : 1) {
+    OU::ThreadPool pool(nThreads);
+    k.out = &out[0];
+    for (unsigned g = 0; g < 2; g++) {
+      // The FIR reads nTaps samples of I/Q for each output
+      size_t grain = g ? OU::ThreadPool::cacheGrain(2 * sizeof(float) * nTaps) : 0;
+      memset(&out[0], 0, out.size() * sizeof(float));
+      start = OS::Time::now();
+      for (unsigned i = 0; i < iterations; i++)
+	pool.run(nSamples, grain, chunk, &k);
+      double t = seconds(OS::Time::now() - start) / iterations;
+      bool same = !memcmp(&out[0], &ref[0], out.size() * sizeof(float));
+      printf("%2u threads, %s grain: %8.3f ms  %8.2f Msamples/s  speedup %5.2f%s\n",
+	     nThreads, g ? "cache  " : "default", t * 1e3, (double)nSamples / t / 1e6, serial / t,
+	     same ? "" : "  MISMATCH");
+      if (!same)
+	ret = 1;
+    }
+    // Reduction: output energy, summed in chunk order
+    Energy e = { &out[0] };
+    std::vector<double> partials(pool.nChunks(nSamples, 0));
+    std::pair<Energy *, double *> arg(&e, &partials[0]);
+    pool.run(nSamples, 0, energyChunk, &arg);
+    double sum = 0, check = 0;
+    for (size_t c = 0; c < partials.size(); c++)
+      sum += partials[c];
+    for (size_t c = 0, grain = pool.defaultGrain(nSamples); c < partials.size(); c++)
+      check += e(c * grain, (c + 1) * grain > nSamples ? nSamples : (c + 1) * grain);
+    if (fabs(sum - check) > 1e-9 * fabs(check)) {
+      printf("%2u threads: reduction MISMATCH %g vs %g\n", nThreads, sum, check);
+      ret = 1;
+    }
+  }
+  return ret;
+}
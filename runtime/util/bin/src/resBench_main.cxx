@@ -0,0 +1,144 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stress benchmark for the endpoint memory allocator (MemBlockMgr).
+ * Each simulated port allocates what a transport port does when it is created
+ * (buffers, state, metadata and control blocks with their alignments), and a random
+ * fraction of ports are torn down and recreated, as when applications come and go.
+ * Every allocation is checked against all others for overlap.
+ *
+ * Usage: resBench [maxPorts [churn%% [seed]]]
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include <OcpiOsTimer.h>
+#include <OcpiRes.h>
+
+namespace OS = OCPI::OS;
+namespace OU = OCPI::Util;
+
+struct Alloc { size_t size; unsigned align; };
+// Roughly what a port allocates for two buffers
+static const Alloc portAllocs[] = {
+  { 2048, 16 }, { 2048, 16 },  // buffers
+  { 16, 8 }, { 16, 8 },        // buffer state
+  { 32, 8 }, { 32, 8 },        // metadata
+  { 256, 64 },                 // port descriptor/control
+  { 8, 8 }, { 8, 8 },          // shadow state
+};
+static const unsigned nPortAllocs = sizeof(portAllocs) / sizeof(portAllocs[0]);
+
+static double
+seconds(OS::Time t) {
+  return t.seconds() + t.nanoseconds() / 1e9;
+}
+
+// Allocated ranges, for overlap checking: start -> end
+typedef std::map<OU::ResAddr, size_t> Ranges;
+
+static bool
+allocPort(OU::MemBlockMgr &m, Ranges &ranges, OU::ResAddr *addrs, unsigned &nOps) {
+  for (unsigned a = 0; a < nPortAllocs; a++, nOps++) {
+    const Alloc &al = portAllocs[a];
+    if (m.alloc(al.size, al.align, addrs[a]))
+      return false;
+    if (addrs[a] & (al.align - 1)) {
+      printf("Misaligned address 0x%" PRIx32 " for alignment %u\n", addrs[a], al.align);
+      exit(1);
+    }
+    Ranges::iterator next = ranges.lower_bound(addrs[a]);
+    if ((next != ranges.end() && next->first < addrs[a] + al.size) ||
+	(next != ranges.begin() && (--next)->second > addrs[a])) {
+      printf("Overlapping allocation at 0x%" PRIx32 "\n", addrs[a]);
+      exit(1);
+    }
+    ranges[addrs[a]] = addrs[a] + al.size;
+  }
+  return true;
+}
+
+static void
+freePort(OU::MemBlockMgr &m, Ranges &ranges, OU::ResAddr *addrs, unsigned &nOps) {
+  for (unsigned a = 0; a < nPortAllocs; a++, nOps++) {
+    if (m.free(addrs[a])) {
+      printf("Free of 0x%" PRIx32 " failed\n", addrs[a]);
+      exit(1);
+    }
+    ranges.erase(addrs[a]);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned
+    maxPorts = argc > 1 ? (unsigned)atoi(argv[1]) : 8192,
+    churn = argc > 2 ? (unsigned)atoi(argv[2]) : 50;
+  srand(argc > 3 ? (unsigned)atoi(argv[3]) : 1);
+  size_t portBytes = 0;
+  for (unsigned a = 0; a < nPortAllocs; a++)
+    portBytes += portAllocs[a].size + portAllocs[a].align;
+  printf("%8s %12s %12s %10s %10s %8s %8s\n", "ports", "setup us/op", "churn us/op",
+	 "used", "peak", "free blks", "frag%");
+  for (unsigned nPorts = 64; nPorts <= maxPorts; nPorts *= 2) {
+    OU::MemBlockMgr m(0, nPorts * portBytes);
+    std::vector<OU::ResAddr> addrs(nPorts * nPortAllocs);
+    Ranges ranges;
+    unsigned nOps = 0;
+    OS::Time start = OS::Time::now();
+    for (unsigned p = 0; p < nPorts; p++)
+      if (!allocPort(m, ranges, &addrs[p * nPortAllocs], nOps)) {
+	printf("Initial allocation failed for port %u of %u\n", p, nPorts);
+	return 1;
+      }
+    double setup = seconds(OS::Time::now() - start) / nOps;
+    // Tear down and recreate a random subset of ports, in random order
+    std::vector<unsigned> victims;
+    for (unsigned p = 0; p < nPorts; p++)
+      if ((unsigned)rand() % 100 < churn)
+	victims.push_back(p);
+    nOps = 0;
+    start = OS::Time::now();
+    for (size_t v = 0; v < victims.size(); v++)
+      freePort(m, ranges, &addrs[victims[v] * nPortAllocs], nOps);
+    for (size_t v = victims.size(); v > 0; v--)
+      if (!allocPort(m, ranges, &addrs[victims[v - 1] * nPortAllocs], nOps)) {
+	printf("Reallocation failed for port %u of %u\n", victims[v - 1], nPorts);
+	return 1;
+      }
+    double churned = nOps ? seconds(OS::Time::now() - start) / nOps : 0;
+    OU::MemBlockMgr::Stats s;
+    m.stats(s);
+    printf("%8u %12.3f %12.3f %10zu %10zu %8zu %8.1f\n", nPorts, setup * 1e6, churned * 1e6,
+	   s.used, s.peakUsed, s.nFree, s.fragmentation() * 100);
+    // Everything must coalesce back into one block
+    for (unsigned p = 0; p < nPorts; p++)
+      freePort(m, ranges, &addrs[p * nPortAllocs], nOps);
+    m.stats(s);
+    if (s.used || s.nFree != 1 || s.largestFree != s.total) {
+      printf("Pool did not coalesce: %zu used, %zu free blocks, largest %zu of %zu\n",
+	     s.used, s.nFree, s.largestFree, s.total);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -233,6 +233,8 @@ namespace OCPI {
       // The discovery happens in a second pass to make sure everything is configured before
       // anything is discovered so that one driver's discovery can depend on another type of
       // driver's configuration.
+      // Managers discover one after another, since one manager's discovery may use
+      // another's drivers.  Parallelism is only used within a driver's own search.
       for (Manager *m = firstChild(); m; m = m->nextChild())
 	if (m->shouldDiscover()) {
 	  ocpiDebug("Performing discovery for the %s manager", m->name().c_str());
@@ -224,7 +224,8 @@ namespace OCPI {
       inline char *ezxml_content(ezxml_t x) { return x->txt; }
       extern const char
 	*ezxml_parse_file(const char *file, ezxml_t &xml),
-	*ezxml_parse_str(char *string, size_t len, ezxml_t &xml),
+	// arena: allocate the document in blocks freed together (see ::ezxml_parse_str_arena)
+	*ezxml_parse_str(char *string, size_t len, ezxml_t &xml, bool arena = false),
 	*ezxml_tag(ezxml_t xml),
 	*checkTag(ezxml_t xml, const char *tag, const char *fmt, ...)
 	__attribute__((format(printf, 3, 4))),
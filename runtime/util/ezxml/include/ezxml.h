@@ -41,6 +41,7 @@ extern "C" {
 #define EZXML_DUP     0x20 // attribute name and value are strduped
 
 typedef struct ezxml *ezxml_t;
+struct ezxml_index;
 struct ezxml {
     char *name;      // tag name
     char **attr;     // tag attributes { name, value, name, value, ... NULL }
@@ -52,6 +53,7 @@ struct ezxml {
     ezxml_t child;   // head of sub tag list, NULL if none
     ezxml_t parent;  // parent tag, NULL if current tag is root tag
     short flags;     // additional information
+    struct ezxml_index *index; // lookup tables, built on demand in arena documents
 };
 
 // Given a string of xml data and its length, parses it and creates an ezxml
@@ -60,6 +62,27 @@ struct ezxml {
 // pass in the copy. Returns NULL on failure.
 ezxml_t ezxml_parse_str(char *s, size_t len);
 
+// Like ezxml_parse_str(), but for large documents that are searched a lot. All
+// tags and attribute lists are allocated from one arena, tag and attribute
+// names are interned, and tags with many attributes or children get hash
+// indexes for ezxml_attr(), ezxml_cattr(), ezxml_child() and ezxml_cchild()
+// when first searched. The whole document is freed at once by ezxml_free() on
+// the root tag; freeing any other tag of such a document does nothing.
+ezxml_t ezxml_parse_str_arena(char *s, size_t len);
+
+// Returns a malloced image of the given document and sets *len to its length.
+// An image holds the tags, attributes and character content in one position
+// independent block of memory that can be saved and shared, and turned back
+// into a document by ezxml_parse_image() without parsing. Returns NULL if the
+// document has processing instructions or DTD default attributes, which an
+// image does not keep.
+void *ezxml_image(ezxml_t xml, size_t *len);
+
+// Returns an arena document (see ezxml_parse_str_arena()) for the given image,
+// or NULL if it is not a valid image. The document's strings are those in the
+// image, which is not modified but must remain until the document is freed.
+ezxml_t ezxml_parse_image(const void *image, size_t len);
+
 // A wrapper for ezxml_parse_str() that accepts a file descriptor. First
 // attempts to mem map the file. Failing that, reads the file into memory.
 // Returns NULL on failure.
@@ -756,10 +756,10 @@ namespace OCPI {
 	return NULL;
       }
       const char *
-      ezxml_parse_str(char *string, size_t len, ezxml_t &xml) {
+      ezxml_parse_str(char *string, size_t len, ezxml_t &xml, bool arena) {
 	if (!len)
 	  len = strlen(string);
-	if (!(xml = ::ezxml_parse_str(string, len)))
+	if (!(xml = arena ? ::ezxml_parse_str_arena(string, len) : ::ezxml_parse_str(string, len)))
 	  return "Could not parse xml string";
 	else if (ezxml_error(xml)[0]) {
 	  const char *err = OU::esprintf("error parsing xml string': %s", ezxml_error(xml));
@@ -794,7 +794,7 @@ namespace OCPI {
 	}
 	ocpiLog(9, "Received XML===========================\n%s\nEND XML==========", &buf[0]);
 	const char *err;
-	if ((err = ezxml_parse_str(&buf[0], len, rx))) {
+	if ((err = ezxml_parse_str(&buf[0], len, rx, true))) {
 	  OU::format(error, "xml parsing error: %s", err);
 	  return true;
 	}
@@ -58,6 +58,35 @@
 #define EZXML_WS   "\t\r\n "  // whitespace
 #define EZXML_ERRL 128        // maximum error string length
 
+// Flags used only inside arena documents (see ezxml_parse_str_arena())
+#define EZXML_ARENA  0x100 // tag belongs to an arena document and is allocated in it
+#define EZXML_ATTRA  0x200 // attribute list is allocated in the arena, names interned
+#define EZXML_NAMEI  0x400 // tag name is interned
+#define EZXML_SMALL  0x800 // too few attributes and children to be worth indexing
+
+#define EZXML_BLOCK     16384   // size of the first arena block, later ones double
+#define EZXML_BLOCKMAX  1048576 // ...up to this size
+#define EZXML_INDEXMIN  8       // number of attributes or children worth indexing
+#define EZXML_ALIGN(n)  (((n) + 7) & ~(size_t)7)
+#define EZXML_IHASH(n)  (((unsigned *)(n))[-1]) // hash stored before interned names
+
+struct ezxml_block {      // a block of arena memory
+    struct ezxml_block *next;
+    size_t size, used;
+};
+
+struct ezxml_slot {       // an entry in a hash index of a tag
+    unsigned hash;        // case insensitive hash of the name
+    int attr;             // index of attribute name in attr list, -1 if empty
+    ezxml_t child;        // first child with this name
+};
+
+struct ezxml_index {      // hash indexes of the attributes and children of a tag
+    struct ezxml_index *next; // all indexes of the document, freed with it
+    struct ezxml_slot *attrs, *children; // NULL if not indexed
+    unsigned amask, cmask; // table sizes minus one
+};
+
 typedef struct ezxml_root *ezxml_root_t;
 struct ezxml_root {       // additional data for the root tag
     struct ezxml xml;     // is a super-struct built on top of ezxml struct
@@ -72,13 +101,192 @@ struct ezxml_root {       // additional data for the root tag
     char ***pi;           // processing instructions
     short standalone;     // non-zero if <?xml standalone="yes"?>
     char err[EZXML_ERRL]; // error string
+    struct ezxml_block *arena; // arena blocks, NULL if not an arena document
+    short dirty;          // arena tags have memory outside the arena
+    char **sattr;         // reused space for attribute lists being parsed
+    size_t nsattr;
+    char *smem;           // reused space for their lists of malloced values
+    size_t nsmem;
+    char **names;         // hash table of interned names
+    size_t nnames, snames;
+    struct ezxml_index *indexes; // list of indexes built for this document
 };
 
 char *EZXML_NIL[] = { NULL }; // empty, null terminated array of strings
 
+// returns the root tag of the document containing the given tag
+static ezxml_root_t ezxml_root(ezxml_t xml)
+{
+    while (xml->parent) xml = xml->parent;
+    return (ezxml_root_t)xml;
+}
+
+// allocates memory from the arena of an arena document
+static void *ezxml_alloc(ezxml_root_t root, size_t size)
+{
+    struct ezxml_block *b = root->arena;
+    size_t bs;
+
+    size = EZXML_ALIGN(size);
+    if (b->used + size > b->size) { // start a new block
+        bs = b->size < EZXML_BLOCKMAX ? b->size * 2 : b->size;
+        if (bs < size) bs = size;
+        b = malloc(EZXML_ALIGN(sizeof(struct ezxml_block)) + bs);
+        b->next = root->arena;
+        b->size = bs;
+        b->used = 0;
+        root->arena = b;
+    }
+    b->used += size;
+    return (char *)b + EZXML_ALIGN(sizeof(struct ezxml_block)) + b->used - size;
+}
+
+// case insensitive hash of a name
+static unsigned ezxml_hash(const char *s)
+{
+    unsigned h = 2166136261u;
+
+    for (; *s; s++) h = (h ^ (unsigned)tolower((unsigned char)*s)) * 16777619u;
+    return h;
+}
+
+// returns the document's single copy of a name, stored after its hash
+static char *ezxml_intern(ezxml_root_t root, const char *name)
+{
+    unsigned h = ezxml_hash(name);
+    size_t i, j, size;
+    char **names, *n;
+
+    if (root->nnames * 2 >= root->snames) { // grow and rehash the table
+        size = root->snames ? root->snames * 2 : 256;
+        names = calloc(size, sizeof(char *));
+        for (i = 0; i < root->snames; i++)
+            if ((n = root->names[i])) {
+                for (j = EZXML_IHASH(n) & (size - 1); names[j]; j = (j + 1) & (size - 1));
+                names[j] = n;
+            }
+        free(root->names);
+        root->names = names;
+        root->snames = size;
+    }
+    for (i = h & (root->snames - 1); (n = root->names[i]);
+         i = (i + 1) & (root->snames - 1))
+        if (EZXML_IHASH(n) == h && ! strcmp(n, name)) return n;
+    n = (char *)ezxml_alloc(root, sizeof(unsigned) + strlen(name) + 1) +
+        sizeof(unsigned);
+    EZXML_IHASH(n) = h;
+    root->nnames++;
+    return root->names[i] = strcpy(n, name);
+}
+
+// Builds the hash indexes of a tag in an arena document, when it has enough
+// attributes or children. Documents may be searched by several threads, so the
+// index is built privately and then published.
+static struct ezxml_index *ezxml_build_index(ezxml_t xml)
+{
+    ezxml_root_t root = ezxml_root(xml);
+    struct ezxml_index *idx;
+    struct ezxml_slot *sl;
+    unsigned nattrs = 0, nchildren = 0, asize = 0, csize = 0, i, h;
+    ezxml_t c;
+
+    while (xml->attr[nattrs * 2]) nattrs++;
+    for (c = xml->child; c; c = c->ordered) nchildren++;
+    if (nattrs >= EZXML_INDEXMIN) for (asize = 2; asize < nattrs * 2; asize *= 2);
+    if (nchildren >= EZXML_INDEXMIN) for (csize = 2; csize < nchildren * 2; csize *= 2);
+    if (! asize && ! csize) {
+        xml->flags |= EZXML_SMALL;
+        return NULL;
+    }
+    idx = malloc(sizeof(*idx) + (asize + csize) * sizeof(struct ezxml_slot));
+    sl = (struct ezxml_slot *)(idx + 1);
+    for (i = 0; i < asize + csize; i++) {
+        sl[i].attr = -1;
+        sl[i].child = NULL;
+    }
+    idx->attrs = asize ? sl : NULL;
+    idx->children = csize ? sl + asize : NULL;
+    idx->amask = asize - 1;
+    idx->cmask = csize - 1;
+    for (i = 0; asize && i < nattrs * 2; i += 2) { // in order, so first is found first
+        h = (xml->flags & EZXML_ATTRA) ? EZXML_IHASH(xml->attr[i])
+                                       : ezxml_hash(xml->attr[i]);
+        for (sl = idx->attrs + (h & idx->amask); sl->attr >= 0;
+             sl = idx->attrs + ((sl - idx->attrs + 1) & idx->amask));
+        sl->hash = h;
+        sl->attr = (int)i;
+    }
+    // the ordered list, since ezxml_cut() can leave the sibling lists stale
+    for (c = xml->child; csize && c; c = c->ordered) {
+        h = (c->flags & EZXML_NAMEI) ? EZXML_IHASH(c->name) : ezxml_hash(c->name);
+        for (sl = idx->children + (h & idx->cmask);
+             sl->child && (sl->hash != h || strcmp(c->name, sl->child->name));
+             sl = idx->children + ((sl - idx->children + 1) & idx->cmask));
+        if (sl->child) continue; // only the first tag with each name
+        sl->hash = h;
+        sl->child = c;
+    }
+    if (! __sync_bool_compare_and_swap(&xml->index, NULL, idx)) { // lost the race
+        free(idx);
+        return xml->index;
+    }
+    do idx->next = root->indexes;
+    while (! __sync_bool_compare_and_swap(&root->indexes, idx->next, idx));
+    return idx;
+}
+
+// returns the hash indexes of a tag, or NULL if it does not have any
+static struct ezxml_index *ezxml_index(ezxml_t xml)
+{
+    struct ezxml_index *idx;
+
+    if (! (xml->flags & EZXML_ARENA) || (xml->flags & EZXML_SMALL)) return NULL;
+    idx = __atomic_load_n(&xml->index, __ATOMIC_ACQUIRE);
+    return idx ? idx : ezxml_build_index(xml);
+}
+
+// forgets the indexes of a tag whose attributes or children are changing
+static void ezxml_unindex(ezxml_t xml)
+{
+    xml->index = NULL; // it is freed with the document
+    xml->flags &= ~EZXML_SMALL;
+}
+
+// returns the position of the given attribute's name in the attribute list, or
+// -1 if not found, using strcmp() or strcasecmp()
+static int ezxml_find_attr(ezxml_t xml, const char *attr,
+                           int (*cmp)(const char *, const char *))
+{
+    struct ezxml_index *idx = ezxml_index(xml);
+    struct ezxml_slot *sl;
+    unsigned h;
+    int i = 0;
+
+    if (idx && idx->attrs) {
+        h = ezxml_hash(attr);
+        for (sl = idx->attrs + (h & idx->amask); sl->attr >= 0;
+             sl = idx->attrs + ((sl - idx->attrs + 1) & idx->amask))
+            if (sl->hash == h && ! cmp(attr, xml->attr[sl->attr])) return sl->attr;
+        return -1;
+    }
+    while (xml->attr[i] && cmp(attr, xml->attr[i])) i += 2;
+    return xml->attr[i] ? i : -1;
+}
+
 // returns the first child tag with the given name or NULL if not found
 ezxml_t ezxml_child(ezxml_t xml, const char *name)
 {
+    struct ezxml_index *idx = (xml) ? ezxml_index(xml) : NULL;
+    struct ezxml_slot *sl;
+    unsigned h;
+
+    if (idx && idx->children) {
+        h = ezxml_hash(name);
+        for (sl = idx->children + (h & idx->cmask); sl->child;
+             sl = idx->children + ((sl - idx->children + 1) & idx->cmask))
+            if (sl->hash == h && ! strcmp(name, sl->child->name)) return sl->child;
+        return NULL;
+    }
     xml = (xml) ? xml->child : NULL;
     while (xml && strcmp(name, xml->name)) xml = xml->sibling;
     return xml;
@@ -99,8 +307,8 @@ const char *ezxml_attr(ezxml_t xml, const char *attr)
     ezxml_root_t root = (ezxml_root_t)xml;
 
     if (! xml || ! xml->attr) return NULL;
-    while (xml->attr[i] && strcmp(attr, xml->attr[i])) i += 2;
-    if (xml->attr[i]) return xml->attr[i + 1]; // found attribute
+    if ((i = ezxml_find_attr(xml, attr, strcmp)) >= 0)
+        return xml->attr[i + 1]; // found attribute
 
     while (root->xml.parent) root = (ezxml_root_t)root->xml.parent; // root tag
     for (i = 0; root->attr[i] && strcmp(xml->name, root->attr[i][0]); i++);
@@ -237,15 +445,39 @@ char *ezxml_decode(char *s, char **ent, char t)
     return r;
 }
 
+// copies an attribute list being parsed into the arena, interning the names
+static char **ezxml_arena_attr(ezxml_root_t root, char **attr)
+{
+    int l = 0, i;
+    char **a;
+
+    if (attr == EZXML_NIL) return attr;
+    while (attr[l]) l += 2;
+    a = ezxml_alloc(root, (size_t)(l + 2) * sizeof(char *) + (size_t)l / 2 + 1);
+    for (i = 0; i < l; i += 2) {
+        a[i] = ezxml_intern(root, attr[i]);
+        a[i + 1] = attr[i + 1];
+    }
+    a[l] = NULL;
+    a[l + 1] = memcpy(a + l + 2, attr[l + 1], (size_t)l / 2 + 1); // which are malloced
+    return a;
+}
+
 // called when parser finds start of new tag
 void ezxml_open_tag(ezxml_root_t root, char *name, char **attr)
 {
     ezxml_t xml = root->cur;
 
+    if (root->arena) {
+        name = ezxml_intern(root, name);
+        attr = ezxml_arena_attr(root, attr);
+    }
     if (xml->name) xml = ezxml_add_child(xml, name, strlen(xml->txt));
     else xml->name = name; // first open tag
 
     xml->attr = attr;
+    if (root->arena)
+        xml->flags |= EZXML_NAMEI | (attr != EZXML_NIL ? EZXML_ATTRA : 0);
     root->cur = xml; // update tag insertion point
 }
 
@@ -472,8 +704,9 @@ char *ezxml_str2utf8(char **s, size_t *len)
     return *s = realloc(u, *len = l);
 }
 
-// frees a tag attribute list
-void ezxml_free_attr(char **attr) {
+// frees the malloced names and values of a tag attribute list, and the list
+// itself unless it is in an arena
+static void ezxml_free_attrs(char **attr, int lists) {
     int i = 0;
     char *m;
 
@@ -484,14 +717,41 @@ void ezxml_free_attr(char **attr) {
         if (m[i] & EZXML_NAMEM) free(attr[i * 2]);
         if (m[i] & EZXML_TXTM) free(attr[(i * 2) + 1]);
     }
-    free(m);
-    free(attr);
+    if (lists) {
+        free(m);
+        free(attr);
+    }
 }
 
-// parse the given xml string and return an ezxml structure
-ezxml_t ezxml_parse_str(char *s, size_t len)
+// frees a tag attribute list
+void ezxml_free_attr(char **attr) {
+    ezxml_free_attrs(attr, 1);
+}
+
+// Makes room for the next attribute in the list being parsed, l being the
+// index of its name. Arena documents build the list in reused space, which
+// ezxml_open_tag() copies into the arena.
+static char **ezxml_grow_attr(ezxml_root_t root, char **attr, int l)
+{
+    if (! root->arena) {
+        attr = (l) ? realloc(attr, (l + 4) * sizeof(char *))
+                   : malloc(4 * sizeof(char *)); // allocate space
+        attr[l + 3] = (l) ? realloc(attr[l + 1], (l / 2) + 2)
+                          : malloc(2); // mem for list of maloced vals
+        return attr;
+    }
+    if ((size_t)l + 4 > root->nsattr)
+        root->sattr = realloc(root->sattr,
+                              (root->nsattr = 2 * ((size_t)l + 4)) * sizeof(char *));
+    if ((size_t)l / 2 + 2 > root->nsmem)
+        root->smem = realloc(root->smem, root->nsmem = (size_t)l + 4);
+    root->sattr[l + 3] = root->smem;
+    return root->sattr;
+}
+
+// parse the given xml string into the given new root
+static ezxml_t ezxml_parse(ezxml_root_t root, char *s, size_t len)
 {
-    ezxml_root_t root = (ezxml_root_t)ezxml_new(NULL);
     char q, e, *d, **attr, **a = NULL; // initialize a to avoid compile warning
     int l, i, j;
 
@@ -525,10 +785,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                 for (i = 0; (a = root->attr[i]) && strcmp(a[0], d); i++);
 
             for (l = 0; *s && *s != '/' && *s != '>'; l += 2) { // new attrib
-                attr = (l) ? realloc(attr, (l + 4) * sizeof(char *))
-                           : malloc(4 * sizeof(char *)); // allocate space
-                attr[l + 3] = (l) ? realloc(attr[l + 1], (l / 2) + 2)
-                                  : malloc(2); // mem for list of maloced vals
+                attr = ezxml_grow_attr(root, attr, l);
                 strcpy(attr[l + 3] + (l / 2), " "); // value is not malloced
                 attr[l + 2] = NULL; // null terminate list
                 attr[l + 1] = ""; // temporary attribute value
@@ -543,15 +800,17 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                         while (*s && *s != q) s++;
                         if (*s) *(s++) = '\0'; // null terminate attribute val
                         else {
-                            ezxml_free_attr(attr);
+                            ezxml_free_attrs(attr, ! root->arena);
                             return ezxml_err(root, d, "missing %c", q);
                         }
 
                         for (j = 1; a && a[j] && strcmp(a[j], attr[l]); j +=3);
                         attr[l + 1] = ezxml_decode(attr[l + 1], root->ent, (a
                                                    && a[j]) ? *a[j + 2] : ' ');
-                        if (attr[l + 1] < d || attr[l + 1] > s)
+                        if (attr[l + 1] < d || attr[l + 1] > s) {
                             attr[l + 3][l / 2] = EZXML_TXTM; // value malloced
+                            root->dirty = 1;
+                        }
                     }
                 }
                 while (isspace(*s)) s++;
@@ -560,7 +819,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
             if (*s == '/') { // self closing tag
                 *(s++) = '\0';
                 if ((*s && *s != '>') || (! *s && e != '>')) {
-                    if (l) ezxml_free_attr(attr);
+                    if (l) ezxml_free_attrs(attr, ! root->arena);
                     return ezxml_err(root, d, "missing >");
                 }
                 ezxml_open_tag(root, d, attr);
@@ -572,7 +831,7 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
                 *s = q;
             }
             else {
-                if (l) ezxml_free_attr(attr);
+                if (l) ezxml_free_attrs(attr, ! root->arena);
                 return ezxml_err(root, d, "missing >");
             }
         }
@@ -625,6 +884,277 @@ ezxml_t ezxml_parse_str(char *s, size_t len)
     else return ezxml_err(root, d, "unclosed tag <%s>", root->cur->name);
 }
 
+// parse the given xml string and return an ezxml structure
+ezxml_t ezxml_parse_str(char *s, size_t len)
+{
+    return ezxml_parse((ezxml_root_t)ezxml_new(NULL), s, len);
+}
+
+// initializes a new root tag
+static ezxml_root_t ezxml_init_root(ezxml_root_t root, const char *name)
+{
+    static char *ent[] = { "lt;", "&#60;", "gt;", "&#62;", "quot;", "&#34;",
+                           "apos;", "&#39;", "amp;", "&#38;", NULL };
+    memset(root, '\0', sizeof(struct ezxml_root));
+    root->xml.name = (char *)name;
+    root->cur = &root->xml;
+    strcpy(root->err, root->xml.txt = "");
+    root->ent = memcpy(malloc(sizeof(ent)), ent, sizeof(ent));
+    root->attr = root->pi = (char ***)(root->xml.attr = EZXML_NIL);
+    return root;
+}
+
+// returns a new, empty arena document
+static ezxml_root_t ezxml_new_arena(void)
+{
+    struct ezxml_block *b =
+        malloc(EZXML_ALIGN(sizeof(struct ezxml_block)) + EZXML_BLOCK);
+    ezxml_root_t root = (ezxml_root_t)
+        ((char *)b + EZXML_ALIGN(sizeof(struct ezxml_block)));
+
+    b->next = NULL;
+    b->size = EZXML_BLOCK;
+    b->used = EZXML_ALIGN(sizeof(struct ezxml_root)); // the root itself
+    ezxml_init_root(root, NULL);
+    root->arena = b;
+    root->xml.flags = EZXML_ARENA;
+    return root;
+}
+
+// parse the given xml string into an arena document
+ezxml_t ezxml_parse_str_arena(char *s, size_t len)
+{
+    return ezxml_parse(ezxml_new_arena(), s, len);
+}
+
+// Document images start with a header, followed by a table of tags in document
+// order, a table of attribute lists, and the strings. Each string is preceded
+// by its ezxml_hash() so that names in an image work as interned names.
+#define EZXML_IMAGE_MAGIC   0x697a7865 // "exzi"
+#define EZXML_IMAGE_VERSION 1
+
+struct ezxml_image_hdr {
+    unsigned magic, version;
+    unsigned ntags;       // the first tag is the root
+    unsigned nwords;      // size of the attribute table
+    unsigned size;        // size of the whole image
+};
+
+struct ezxml_image_tag {  // strings are offsets in the image
+    unsigned name, txt;
+    unsigned attrs;       // index of the attribute list in the table, plus one
+    unsigned parent;      // index of the parent tag
+    unsigned off;         // offset in the parent's character content
+};
+
+struct ezxml_image_buf {  // an image being built
+    char *s;
+    size_t len, max;
+    unsigned ntags, nwords, *words;
+    struct ezxml_image_tag *tags;
+    unsigned *strs;       // hash table of string offsets, to share them
+    size_t nstrs, sstrs;
+};
+
+// counts the tags and attribute table words of the given tags and their children
+static void ezxml_image_count(ezxml_t xml, unsigned *ntags, unsigned *nwords)
+{
+    int l;
+
+    for (; xml; xml = xml->ordered) {
+        for (l = 0; xml->attr[l]; l += 2);
+        if (l) *nwords += 1 + (unsigned)l;
+        (*ntags)++;
+        ezxml_image_count(xml->child, ntags, nwords);
+    }
+}
+
+// adds a string to the image being built, returning its offset
+static unsigned ezxml_image_str(struct ezxml_image_buf *b, const char *str)
+{
+    unsigned h = ezxml_hash(str), o;
+    size_t i, j, size, l = strlen(str) + 1;
+
+    if (b->nstrs * 2 >= b->sstrs) { // grow and rehash the table
+        unsigned *strs = calloc(size = b->sstrs ? b->sstrs * 2 : 1024,
+                                sizeof(unsigned));
+        for (i = 0; i < b->sstrs; i++)
+            if ((o = b->strs[i])) {
+                for (j = EZXML_IHASH(b->s + o) & (size - 1); strs[j];
+                     j = (j + 1) & (size - 1));
+                strs[j] = o;
+            }
+        free(b->strs);
+        b->strs = strs;
+        b->sstrs = size;
+    }
+    for (i = h & (b->sstrs - 1); (o = b->strs[i]); i = (i + 1) & (b->sstrs - 1))
+        if (EZXML_IHASH(b->s + o) == h && ! strcmp(b->s + o, str)) return o;
+    size = (sizeof(unsigned) + l + sizeof(unsigned) - 1) & ~(sizeof(unsigned) - 1);
+    while (b->len + size > b->max) b->s = realloc(b->s, b->max *= 2);
+    o = (unsigned)(b->len + sizeof(unsigned));
+    memset(b->s + b->len, 0, size);
+    *(unsigned *)(b->s + b->len) = h;
+    memcpy(b->s + o, str, l);
+    b->len += size;
+    b->nstrs++;
+    return b->strs[i] = o;
+}
+
+// adds the given tags and their children to the image being built
+static void ezxml_image_tags(struct ezxml_image_buf *b, ezxml_t xml,
+                             unsigned parent)
+{
+    struct ezxml_image_tag t;
+    unsigned n, w;
+    int l;
+
+    for (; xml; xml = xml->ordered) {
+        t.name = ezxml_image_str(b, xml->name);
+        t.txt = ezxml_image_str(b, xml->txt);
+        t.parent = parent;
+        t.off = (unsigned)xml->off;
+        for (l = 0; xml->attr[l]; l += 2);
+        if ((t.attrs = l ? b->nwords + 1 : 0)) {
+            w = b->nwords;
+            b->nwords += 1 + (unsigned)l;
+            b->words[w] = (unsigned)l / 2;
+            for (l = 0; xml->attr[l]; l++)
+                b->words[w + 1 + (unsigned)l] = ezxml_image_str(b, xml->attr[l]);
+        }
+        b->tags[n = b->ntags++] = t;
+        ezxml_image_tags(b, xml->child, n);
+    }
+}
+
+// returns a malloced image of the given document
+void *ezxml_image(ezxml_t xml, size_t *len)
+{
+    ezxml_root_t root;
+    struct ezxml_image_buf b;
+    struct ezxml_image_hdr h;
+    unsigned ntags = 0, nwords = 0;
+    size_t tables;
+
+    if (! xml) return NULL;
+    root = ezxml_root(xml);
+    if (root->pi[0] || root->attr[0] || root->err[0]) return NULL;
+    ezxml_image_count(&root->xml, &ntags, &nwords);
+    memset(&b, 0, sizeof(b));
+    // the tables are built separately since the strings grow the buffer
+    b.tags = malloc(ntags * sizeof(struct ezxml_image_tag));
+    b.words = malloc((nwords + 1) * sizeof(unsigned));
+    tables = sizeof(h) + ntags * sizeof(struct ezxml_image_tag) +
+             nwords * sizeof(unsigned);
+    b.s = malloc(b.max = tables + 4096);
+    b.len = tables;
+    ezxml_image_tags(&b, &root->xml, 0);
+    while (b.len + sizeof(unsigned) > b.max) b.s = realloc(b.s, b.max *= 2);
+    memset(b.s + b.len, 0, sizeof(unsigned)); // so all strings end inside
+    b.len += sizeof(unsigned);
+    h.magic = EZXML_IMAGE_MAGIC;
+    h.version = EZXML_IMAGE_VERSION;
+    h.ntags = ntags;
+    h.nwords = nwords;
+    h.size = (unsigned)b.len;
+    memcpy(b.s, &h, sizeof(h));
+    memcpy(b.s + sizeof(h), b.tags, ntags * sizeof(struct ezxml_image_tag));
+    memcpy(b.s + sizeof(h) + ntags * sizeof(struct ezxml_image_tag), b.words,
+           nwords * sizeof(unsigned));
+    free(b.tags);
+    free(b.words);
+    free(b.strs);
+    *len = b.len;
+    return b.s;
+}
+
+// returns an arena document for the given image
+ezxml_t ezxml_parse_image(const void *image, size_t len)
+{
+    const struct ezxml_image_hdr *h = image;
+    const struct ezxml_image_tag *t = (const struct ezxml_image_tag *)(h + 1);
+    const unsigned *w = (const unsigned *)(t + (len >= sizeof(*h) ? h->ntags : 0));
+    char *s = (char *)image;
+    ezxml_root_t root;
+    ezxml_t xml = NULL, *tags, *last, *tail, cur, prev;
+    unsigned n, i, a;
+    char **attr;
+
+    if (len < sizeof(*h) || h->magic != EZXML_IMAGE_MAGIC ||
+        h->version != EZXML_IMAGE_VERSION || h->size != len || ! h->ntags ||
+        (len - sizeof(*h)) / sizeof(*t) < h->ntags ||
+        (len - sizeof(*h) - h->ntags * sizeof(*t)) / sizeof(unsigned) < h->nwords ||
+        s[len - 1]) return NULL;
+    // Check that offsets are inside the image, and names are aligned with room
+    // for their hash, so that damaged images are refused. All strings end
+    // inside since the image ends with a null.
+    for (n = 0; n < h->ntags; n++)
+        if (t[n].name < sizeof(*h) || t[n].name >= len || t[n].txt >= len ||
+            t[n].name % sizeof(unsigned) ||
+            (n && t[n].parent >= n) ||
+            (t[n].attrs && (t[n].attrs > h->nwords ||
+                            w[t[n].attrs - 1] > (h->nwords - t[n].attrs) / 2)))
+            return NULL;
+    for (n = 0; n < h->nwords; n++)
+        if (w[n] >= len) return NULL;
+    root = ezxml_new_arena();
+    root->s = s;
+    root->e = s + len;
+    // each tag, its last child, and the last tag in its list of tags with the
+    // same name when it is the first
+    tags = malloc(h->ntags * 3 * sizeof(ezxml_t));
+    last = tags + h->ntags;
+    tail = last + h->ntags;
+    if (h->ntags > 1) {
+        xml = ezxml_alloc(root, (h->ntags - 1) * sizeof(struct ezxml));
+        memset(xml, 0, (h->ntags - 1) * sizeof(struct ezxml));
+    }
+    for (n = 0; n < h->ntags; n++, t++) {
+        tags[n] = tail[n] = n ? xml++ : &root->xml;
+        last[n] = NULL;
+        tags[n]->name = s + t->name;
+        tags[n]->txt = s + t->txt;
+        tags[n]->off = t->off;
+        tags[n]->flags = EZXML_ARENA | EZXML_NAMEI;
+        tags[n]->attr = EZXML_NIL;
+        if (t->attrs) {
+            a = w[t->attrs - 1] * 2;
+            attr = ezxml_alloc(root, (a + 2) * sizeof(char *) + a / 2 + 1);
+            for (i = 0; i < a; i++)
+                if ((attr[i] = s + w[t->attrs + i]) < s + sizeof(*h) ||
+                    w[t->attrs + i] % sizeof(unsigned)) {
+                    ezxml_free(&root->xml); // a name without room for its hash
+                    free(tags);
+                    return NULL;
+                }
+            attr[a] = NULL;
+            attr[a + 1] = memset(attr + a + 2, ' ', a / 2); // none malloced
+            attr[a + 1][a / 2] = '\0';
+            tags[n]->attr = attr;
+            tags[n]->flags |= EZXML_ATTRA;
+        }
+        if (! n) continue;
+        // Link the tag after its parent's last child, and after the last tag
+        // with its name, since tags come in document order.
+        cur = tags[n]->parent = tags[t->parent];
+        if (last[t->parent]) last[t->parent]->ordered = tags[n];
+        else cur->child = tags[n];
+        last[t->parent] = tags[n];
+        for (cur = cur->child, prev = NULL; cur && cur != tags[n] &&
+             cur->name != tags[n]->name && strcmp(cur->name, tags[n]->name);
+             prev = cur, cur = cur->sibling);
+        if (! cur || cur == tags[n]) { // first with this name
+            if (prev) prev->sibling = tags[n];
+        }
+        else { // cur is the first, which is not the root
+            i = (unsigned)(cur - tags[1]) + 1;
+            tail[i] = tail[i]->next = tags[n];
+        }
+    }
+    free(tags);
+    return &root->xml;
+}
+
 // Wrapper for ezxml_parse_str() that accepts a file stream. Reads the entire
 // stream into memory and then parses it. For xml files, use ezxml_parse_file()
 // or ezxml_parse_fd()
@@ -841,16 +1371,40 @@ char *ezxml_toxml(ezxml_t xml)
     return realloc(s, len + 1);
 }
 
+// frees the memory that tags of an arena document have outside the arena
+static void ezxml_free_outside(ezxml_t xml)
+{
+    for (; xml; xml = xml->ordered) {
+        ezxml_free_outside(xml->child);
+        ezxml_free_attrs(xml->attr, ! (xml->flags & EZXML_ATTRA));
+        if ((xml->flags & EZXML_TXTM)) free(xml->txt); // character content
+        if ((xml->flags & EZXML_NAMEM)) free(xml->name); // tag name
+    }
+}
+
 // free the memory allocated for the ezxml structure
 void ezxml_free(ezxml_t xml)
 {
     ezxml_root_t root = (ezxml_root_t)xml;
+    struct ezxml_block *b, *nb;
+    struct ezxml_index *idx, *nidx;
     int i, j;
     char **a, *s;
 
     if (! xml) return;
-    ezxml_free(xml->child);
-    ezxml_free(xml->ordered);
+    if ((xml->flags & EZXML_ARENA) && xml->parent) { // freed with its root
+        ezxml_t cur = xml->parent->child;
+        while (cur && cur != xml) cur = cur->ordered;
+        if (! cur && ezxml_root(xml)->dirty) { // cut: its root can no longer reach it
+            xml->ordered = NULL;
+            ezxml_free_outside(xml);
+        }
+        return;
+    }
+    if (! (xml->flags & EZXML_ARENA)) {
+        ezxml_free(xml->child);
+        ezxml_free(xml->ordered);
+    }
 
     if (! xml->parent) { // free root tag allocations
         for (i = 10; root->ent[i]; i += 2) // 0 - 9 are default entites (<>&"')
@@ -878,6 +1432,21 @@ void ezxml_free(ezxml_t xml)
         if (root->u) free(root->u); // utf8 conversion
     }
 
+    if ((xml->flags & EZXML_ARENA)) { // the root of an arena document
+        if (root->dirty) ezxml_free_outside(xml);
+        for (idx = root->indexes; idx; idx = nidx) {
+            nidx = idx->next;
+            free(idx);
+        }
+        free(root->sattr);
+        free(root->smem);
+        free(root->names);
+        for (b = root->arena; b; b = nb) { // the root itself is in the last one
+            nb = b->next;
+            free(b);
+        }
+        return;
+    }
     ezxml_free_attr(xml->attr); // tag attributes
     if ((xml->flags & EZXML_TXTM)) free(xml->txt); // character content
     if ((xml->flags & EZXML_NAMEM)) free(xml->name); // tag name
@@ -894,16 +1463,7 @@ const char *ezxml_error(ezxml_t xml)
 // returns a new empty ezxml structure with the given root tag name
 ezxml_t ezxml_new(const char *name)
 {
-    static char *ent[] = { "lt;", "&#60;", "gt;", "&#62;", "quot;", "&#34;",
-                           "apos;", "&#39;", "amp;", "&#38;", NULL };
-    ezxml_root_t root = (ezxml_root_t)memset(malloc(sizeof(struct ezxml_root)),
-                                             '\0', sizeof(struct ezxml_root));
-    root->xml.name = (char *)name;
-    root->cur = &root->xml;
-    strcpy(root->err, root->xml.txt = "");
-    root->ent = memcpy(malloc(sizeof(ent)), ent, sizeof(ent));
-    root->attr = root->pi = (char ***)(root->xml.attr = EZXML_NIL);
-    return &root->xml;
+    return &ezxml_init_root(malloc(sizeof(struct ezxml_root)), name)->xml;
 }
 
 // inserts an existing tag into an ezxml structure
@@ -914,6 +1474,7 @@ ezxml_t ezxml_insert(ezxml_t xml, ezxml_t dest, size_t off)
     xml->next = xml->sibling = xml->ordered = NULL;
     xml->off = off;
     xml->parent = dest;
+    ezxml_unindex(dest);
 
     if ((head = dest->child)) { // already have sub tags
         if (head->off <= off) { // not first subtag
@@ -955,8 +1516,11 @@ ezxml_t ezxml_add_child(ezxml_t xml, const char *name, size_t off)
     ezxml_t child;
 
     if (! xml) return NULL;
-    child = (ezxml_t)memset(malloc(sizeof(struct ezxml)), '\0',
+    child = (ezxml_t)memset((xml->flags & EZXML_ARENA)
+                            ? ezxml_alloc(ezxml_root(xml), sizeof(struct ezxml))
+                            : malloc(sizeof(struct ezxml)), '\0',
                             sizeof(struct ezxml));
+    child->flags = xml->flags & EZXML_ARENA;
     child->name = (char *)name;
     child->attr = EZXML_NIL;
     child->txt = "";
@@ -979,14 +1543,26 @@ ezxml_t ezxml_set_txt(ezxml_t xml, const char *txt)
 ezxml_t ezxml_set_attr(ezxml_t xml, const char *name, const char *value)
 {
     int l = 0, c;
+    char **a;
 
     if (! xml) return NULL;
+    if ((xml->flags & EZXML_ATTRA)) { // copy the list out of the arena to change it
+        for (c = 0; xml->attr[c]; c += 2);
+        a = memcpy(malloc((size_t)(c + 2) * sizeof(char *)), xml->attr,
+                   (size_t)(c + 1) * sizeof(char *));
+        a[c + 1] = strcpy(malloc((size_t)c / 2 + 1), xml->attr[c + 1]);
+        xml->attr = a;
+        xml->flags &= ~EZXML_ATTRA;
+        ezxml_root(xml)->dirty = 1;
+    }
+    ezxml_unindex(xml);
     while (xml->attr[l] && strcmp(xml->attr[l], name)) l += 2;
     if (! xml->attr[l]) { // not found, add as new attribute
         if (! value) return xml; // nothing to do
         if (xml->attr == EZXML_NIL) { // first attribute
             xml->attr = malloc(4 * sizeof(char *));
             xml->attr[1] = strdup(""); // empty list of malloced names/vals
+            ezxml_root(xml)->dirty = 1; // so an arena document frees the list
         }
         else xml->attr = realloc(xml->attr, (l + 4) * sizeof(char *));
 
@@ -1026,7 +1602,12 @@ ezxml_t ezxml_set_attr(ezxml_t xml, const char *name, const char *value)
 // sets a flag for the given tag and returns the tag
 ezxml_t ezxml_set_flag(ezxml_t xml, short flag)
 {
-    if (xml) xml->flags |= flag;
+    if (xml) {
+        xml->flags |= flag;
+        if ((xml->flags & EZXML_ARENA) &&
+            (flag & (EZXML_NAMEM | EZXML_TXTM | EZXML_DUP)))
+            ezxml_root(xml)->dirty = 1; // memory outside the arena to free
+    }
     return xml;
 }
 
@@ -1039,8 +1620,15 @@ ezxml_t ezxml_cut(ezxml_t xml)
     if (xml->next) xml->next->sibling = xml->sibling; // patch sibling list
 
     if (xml->parent) { // not root tag
+        ezxml_unindex(xml->parent);
         cur = xml->parent->child; // find head of subtag list
-        if (cur == xml) xml->parent->child = xml->ordered; // first subtag
+        if (cur == xml) { // first subtag
+            xml->parent->child = xml->ordered;
+            if (xml->next && xml->ordered != xml->next) { // keep its name listed
+                xml->next->sibling = xml->ordered->sibling;
+                xml->ordered->sibling = xml->next;
+            }
+        }
         else { // not first subtag
             while (cur->ordered != xml) cur = cur->ordered;
             cur->ordered = cur->ordered->ordered; // patch ordered list
@@ -1068,6 +1656,21 @@ ezxml_t ezxml_cut(ezxml_t xml)
 // CASE INSENSTIVE
 ezxml_t ezxml_cchild(ezxml_t xml, const char *name)
 {
+    struct ezxml_index *idx = (xml) ? ezxml_index(xml) : NULL;
+    struct ezxml_slot *sl;
+    ezxml_t found = NULL;
+    unsigned h;
+
+    if (idx && idx->children) {
+        h = ezxml_hash(name);
+        for (sl = idx->children + (h & idx->cmask); sl->child;
+             sl = idx->children + ((sl - idx->children + 1) & idx->cmask))
+            if (sl->hash == h && ! strcasecmp(name, sl->child->name)) {
+                if (found) { found = NULL; break; } // names differing in case
+                found = sl->child;
+            }
+        if (found || ! sl->child) return found;
+    }
     xml = (xml) ? xml->child : NULL;
     while (xml && strcasecmp(name, xml->name)) xml = xml->ordered;
     return xml;
@@ -1087,8 +1690,8 @@ const char *ezxml_cattr(ezxml_t xml, const char *attr)
     ezxml_root_t root = (ezxml_root_t)xml;
 
     if (! xml || ! xml->attr) return NULL;
-    while (xml->attr[i] && strcasecmp(attr, xml->attr[i])) i += 2;
-    if (xml->attr[i]) return xml->attr[i + 1]; // found attribute
+    if ((i = ezxml_find_attr(xml, attr, strcasecmp)) >= 0)
+        return xml->attr[i + 1]; // found attribute
 
     while (root->xml.parent) root = (ezxml_root_t)root->xml.parent; // root tag
     for (i = 0; root->attr[i] && strcasecmp(xml->name, root->attr[i][0]); i++);
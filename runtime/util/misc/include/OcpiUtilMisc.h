@@ -82,6 +82,10 @@
 #define OCPI_OFFSETOF(utype, stype, member)				\
   ((utype)OCPI::Util::utruncate((uint64_t)&((stype *)0)->member, sizeof(utype)))
 #endif
+// Used to pad data written by one thread so it does not share a cache line with other data
+#ifndef OCPI_CACHE_LINE_SIZE
+#define OCPI_CACHE_LINE_SIZE 64
+#endif
 
 namespace OCPI {
   namespace Util {
@@ -26,7 +26,12 @@
 #include <limits>
 #include <cfloat>
 #include <cerrno>
+#include <map>
+#include <vector>
 #include <gmpxx.h>
+#include "OcpiOsMutex.h"
+#include "OcpiOsDebugApi.h"
+#include "OcpiUtilAutoMutex.h"
 #include "OcpiUtilMisc.h"
 #include "OcpiUtilEzxml.h"
 #include "OcpiUtilValue.h"
@@ -148,7 +153,7 @@ void
 int64_2_mpf(int64_t i64, mpf_class &number) {
   mpz_class z = (int32_t)(i64 >> 32);
   z <<= 32;
-  z |= (int32_t)(i64 & 0xffffffff);
+  z |= (uint32_t)(i64 & 0xffffffff); // low word must not sign-extend
   mpz2mpf(z, number);
 }
 void
@@ -161,6 +166,49 @@ uint64_2_mpf(uint64_t u64, mpf_class &number) {
 inline bool mpf2bool(const mpf_class &number) {
   return number.get_mpf_t()->_mp_size != 0; // don't depend on cxx11
 }
+// Fixed-width arithmetic for the common case of integer values, returning false on overflow
+// so that the caller can use GMP instead.
+inline bool
+addInt(int64_t a, int64_t b, int64_t &r) {
+  if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+    return false;
+  r = a + b;
+  return true;
+}
+inline bool
+subInt(int64_t a, int64_t b, int64_t &r) {
+  if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b))
+    return false;
+  r = a - b;
+  return true;
+}
+inline bool
+mulInt(int64_t a, int64_t b, int64_t &r) {
+  if (a == 0 || b == 0) {
+    r = 0;
+    return true;
+  }
+  if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN))
+    return false;
+  int64_t p = (int64_t)((uint64_t)a * (uint64_t)b);
+  if (p / b != a)
+    return false;
+  r = p;
+  return true;
+}
+inline bool
+powInt(int64_t b, int64_t e, int64_t &r) {
+  if (e < 0)
+    return false;
+  r = 1;
+  while (e) {
+    if ((e & 1) && !mulInt(r, b, r))
+      return false;
+    if ((e >>= 1) && !mulInt(b, b, b))
+      return false;
+  }
+  return true;
+}
 } // anonymous namespace
 
 
@@ -168,13 +216,64 @@ namespace OCPI {
 namespace Util {
 // Supply value argument for constants
 struct ExprToken;
+struct Lexed;
+// Numeric values are int64_t when they are integers that fit, and are only converted to
+// GMP floating point when they do not, or when an operation on them would overflow or
+// produce a non-integer.
 class ExprValue::Internal {
+  mpf_class  *m_mpf; // the number when it is not m_int
 public:
-  mpf_class   m_number;
+  int64_t     m_int;
+  bool        m_isInt;
   std::string m_string;
   bool        m_isString;
   bool        m_usesVariable;
-  Internal() : m_number(0, 64), m_isString(false), m_usesVariable(false) {
+  Internal() : m_mpf(NULL), m_int(0), m_isInt(true), m_isString(false), m_usesVariable(false) {
+  }
+  Internal(const Internal &other) : m_mpf(NULL) {
+    *this = other;
+  }
+  ~Internal() {
+    delete m_mpf;
+  }
+  Internal &operator=(const Internal &other) {
+    if (this != &other) {
+      m_int = other.m_int;
+      m_isInt = other.m_isInt;
+      if (!m_isInt) {
+	if (!m_mpf)
+	  m_mpf = new mpf_class(0, 64);
+	*m_mpf = *other.m_mpf;
+      }
+      m_string = other.m_string;
+      m_isString = other.m_isString;
+      m_usesVariable = other.m_usesVariable;
+    }
+    return *this;
+  }
+  void setInt(int64_t i) {
+    m_isInt = true;
+    m_int = i;
+  }
+  // The number as a GMP value, converting it if necessary
+  mpf_class &number() {
+    if (!m_mpf)
+      m_mpf = new mpf_class(0, 64);
+    if (m_isInt) {
+      int64_2_mpf(m_int, *m_mpf);
+      m_isInt = false;
+    }
+    return *m_mpf;
+  }
+  const mpf_class &number() const {
+    return const_cast<Internal *>(this)->number();
+  }
+  bool isTrue() const {
+    return m_isInt ? m_int != 0 : mpf2bool(*m_mpf);
+  }
+  static int compare(Internal &a, Internal &b) {
+    return a.m_isInt && b.m_isInt ? (a.m_int > b.m_int) - (a.m_int < b.m_int) :
+      cmp(a.number(), b.number());
   }
   static OU::ExprValue::Internal fdummy;
   // Numbers can express base by 0[digit] octal, or 0t, 0b, 0x for decimal, binary, hex
@@ -213,6 +312,18 @@ public:
     end = cp;
     return NULL;
   }
+  // Convert integer digits without GMP, returning false if they do not fit
+  static bool
+  getInt(const char *start, const char *end, unsigned base, uint32_t multiply, int64_t &i) {
+    i = 0;
+    for (const char *cp = start; cp < end; cp++) {
+      unsigned digit =
+	(unsigned)(isdigit(*cp) ? *cp - '0' : tolower(*cp) - 'a' + 10);
+      if (digit >= base || !mulInt(i, base, i) || !addInt(i, digit, i))
+	return false;
+    }
+    return mulInt(i, multiply, i);
+  }
   const char *
   lex(const char *&cp, const char *last, const char *&start, const char *&end, OpCode &op) {
     m_isString = false;
@@ -242,7 +353,7 @@ public:
 	  return "missing close quote on string";
 	end = cp++;
 	op = OpConstant;
-	m_string.assign(start, end - start);
+	m_string.assign(start, (size_t)(end - start));
 	m_isString = true;
 	break;
       }
@@ -254,8 +365,17 @@ public:
 	const char *err;
 	if ((err = getNumber(cp, last, mstart, end, mbase, mmult, true, 10)))
 	  return err;
+	const char *mend = end - (mmult == 1 ? 0 : 1);
+	if ((cp >= last || (*cp != 'e' && *cp != 'E' && *cp != '@')) &&
+	    !memchr(mstart, '.', (size_t)(mend - mstart)) &&
+	    getInt(mstart, mend, mbase, mmult, m_int)) {
+	  m_isInt = true;
+	  op = OpConstant;
+	  cp = end;
+	  break;
+	}
 	std::string mpf;
-	mpf.assign(mstart, (end - mstart) - (mmult == 1 ? 0 : 1));
+	mpf.assign(mstart, (size_t)(mend - mstart));
 	if (cp < last && (*cp == 'e' || *cp == 'E' || *cp == '@')) {
 	  mpf += *cp++;
 	  if (cp < last && (*cp == '-' || *cp == '+'))
@@ -280,9 +400,9 @@ public:
 	  ul *= emult;
 	  OU::formatAdd(mpf, "%lu", ul);
 	}
-	if (m_number.set_str(mpf, -mbase))
+	if (number().set_str(mpf, -mbase))
 	  return OU::esprintf("invalid numeric constant: '%s'", mpf.c_str());
-	m_number *= mmult;
+	number() *= mmult;
 	op = OpConstant;
 	cp = end;
 	break;
@@ -316,12 +436,13 @@ public:
     if (m_isString)
       s = m_string;
     else
-      mpfString(m_number, s);
+      mpfString(number(), s);
     return s.c_str();
   }
   const char
   *reduce(ExprToken *start, ExprToken *&end, bool parens = false),
-    *parse(const char *buf, const char *end, ExprToken *&tokens, const IdentResolver *resolve);
+    *parse(const char *buf, const char *end, ExprToken *&tokens, const IdentResolver *resolve),
+    *parse(Lexed &lexed, ExprToken *&tokens, const IdentResolver *resolve);
 };
 
 struct ExprToken {
@@ -330,7 +451,7 @@ struct ExprToken {
   ExprValue::Internal value;
   void string2Number() {
     if (op == OpConstant && value.m_isString) {
-      value.m_number = value.m_string.size() ? 1 : 0;
+      value.setInt(value.m_string.size() ? 1 : 0);
       value.m_isString = false;
     }
   }
@@ -352,21 +473,24 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
     if (op < end->op && end->op != OpEnd) // don't reduce further if forcing op is tighter
       break;
     bool b;
+    int64_t i;
     switch (op) {
     case OpTilde:
       // If it is an integer, then complement it
-      if (ceil(t->value.m_number) != t->value.m_number)
-	return "tilde operator on non-integer value";
-      {
-	mpz_class i(t->value.m_number);
-	i = ~i;
-	t[-1].value.m_number = i;
+      if (t->value.m_isInt)
+	t[-1].value.setInt(~t->value.m_int);
+      else {
+	if (ceil(t->value.number()) != t->value.number())
+	  return "tilde operator on non-integer value";
+	mpz_class z(t->value.number());
+	z = ~z;
+	t[-1].value.number() = z;
       }
       break;
     case OpNot:
-      b = t->value.m_isString ? t->value.m_string.size() != 0 : t->value.m_number != 0;
+      b = t->value.m_isString ? t->value.m_string.size() != 0 : t->value.isTrue();
       t[-1].op = OpConstant;
-      t[-1].value.m_number = b ? 1 : 0;
+      t[-1].value.setInt(b ? 1 : 0);
       t[-1].value.m_isString = false;
       break;
     case OpUPlus: // not useful for anything
@@ -375,7 +499,10 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
       break;
     case OpUMinus:
       t[-1].op = OpConstant;
-      t[-1].value.m_number = - t->value.m_number;
+      if (t->value.m_isInt && t->value.m_int != INT64_MIN)
+	t[-1].value.setInt(-t->value.m_int);
+      else
+	t[-1].value.number() = - t->value.number();
       break;
     case OpPlus:
       if (t[-2].op != OpConstant)
@@ -384,60 +511,84 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
 	return "mixing strings and numbers";
       if (t->value.m_isString)
 	t[-2].value.m_string += t->value.m_string;
+      else if (t[-2].value.m_isInt && t->value.m_isInt &&
+	       addInt(t[-2].value.m_int, t->value.m_int, i))
+	t[-2].value.setInt(i);
       else
-	t[-2].value.m_number += t->value.m_number;
+	t[-2].value.number() += t->value.number();
       t--;
       break;
     case OpPow:
       if (t[-2].op != OpConstant)
 	return "expression syntax";
-      mpf_pow_ui(t[-2].value.m_number.get_mpf_t(), t[-2].value.m_number.get_mpf_t(),
-		 t->value.m_number.get_ui());
+      if (t[-2].value.m_isInt && t->value.m_isInt &&
+	  powInt(t[-2].value.m_int, t->value.m_int, i))
+	t[-2].value.setInt(i);
+      else
+	mpf_pow_ui(t[-2].value.number().get_mpf_t(), t[-2].value.number().get_mpf_t(),
+		   t->value.number().get_ui());
       t--;
       break;
 
-#define NumOp(tokenOp, opn)				\
-      case tokenOp:					\
-	if (t[-2].op != OpConstant)			\
-	  return "expression syntax";			\
-	t[-2].value.m_number opn t->value.m_number;	\
-	t--;						\
+#define NumOp(tokenOp, opn, intOk)					\
+      case tokenOp:							\
+	if (t[-2].op != OpConstant)					\
+	  return "expression syntax";					\
+	if (t[-2].value.m_isInt && t->value.m_isInt && (intOk))	\
+	  t[-2].value.setInt(i);					\
+	else								\
+	  t[-2].value.number() opn t->value.number();			\
+	t--;								\
 	break
-      NumOp(OpMinus, -=);
-      NumOp(OpMult, *=);
-      NumOp(OpDiv, /=);
+      NumOp(OpMinus, -=, subInt(t[-2].value.m_int, t->value.m_int, i));
+      NumOp(OpMult, *=, mulInt(t[-2].value.m_int, t->value.m_int, i));
+      // Integer division is only used when it is exact
+      NumOp(OpDiv, /=, t->value.m_int && !(t[-2].value.m_int == INT64_MIN && t->value.m_int == -1) &&
+	    t[-2].value.m_int % t->value.m_int == 0 && (i = t[-2].value.m_int / t->value.m_int, true));
       // These are operations that must be converted to integers
-#define BinOp(tokenOp, op)						\
+#define BinOp(tokenOp, op, intOk)					\
       case tokenOp: {							\
+	if (t[-2].value.m_isInt && t->value.m_isInt && (intOk)) {	\
+	  t[-2].value.setInt(i);					\
+	  t--;								\
+	  break;							\
+	}								\
 	mpz_class op1, op2;						\
 	const char *err;						\
-	if ((err = mpf2mpz(t[-2].value.m_number, op1)) ||		\
-	    (err = mpf2mpz(t[0].value.m_number, op2)))			\
+	if ((err = mpf2mpz(t[-2].value.number(), op1)) ||		\
+	    (err = mpf2mpz(t[0].value.number(), op2)))			\
 	  return err;							\
 	op1 op op2;							\
-	mpf_set_z(t[-2].value.m_number.get_mpf_t(), op1.get_mpz_t());	\
+	mpf_set_z(t[-2].value.number().get_mpf_t(), op1.get_mpz_t());	\
 	t--;								\
 	break;								\
       }
-      BinOp(OpMod, %=);
-      BinOp(OpXor, ^=);
-      BinOp(OpBor, |=);
-      BinOp(OpBand, &=);
-#define ShiftOp(tokenOp, op)						\
+      BinOp(OpMod, %=, t->value.m_int && t->value.m_int != -1 &&
+	    (i = t[-2].value.m_int % t->value.m_int, true));
+      BinOp(OpXor, ^=, (i = t[-2].value.m_int ^ t->value.m_int, true));
+      BinOp(OpBor, |=, (i = t[-2].value.m_int | t->value.m_int, true));
+      BinOp(OpBand, &=, (i = t[-2].value.m_int & t->value.m_int, true));
+#define ShiftOp(tokenOp, op, intOk)					\
       case tokenOp: {							\
+	if (t[-2].value.m_isInt && t->value.m_isInt &&			\
+	    t->value.m_int >= 0 && t->value.m_int < 63 && (intOk)) {	\
+	  t[-2].value.setInt(i);					\
+	  t--;								\
+	  break;							\
+	}								\
 	mpz_class op1, op2;						\
 	const char *err;						\
-	if ((err = mpf2mpz(t[-2].value.m_number, op1)) ||		\
-	    (err = mpf2mpz(t[0].value.m_number, op2)))			\
+	if ((err = mpf2mpz(t[-2].value.number(), op1)) ||		\
+	    (err = mpf2mpz(t[0].value.number(), op2)))			\
 	  return err;							\
 	unsigned long int ui = op2.get_ui();				\
 	op1 op ui;							\
-	mpf_set_z(t[-2].value.m_number.get_mpf_t(), op1.get_mpz_t());	\
+	mpf_set_z(t[-2].value.number().get_mpf_t(), op1.get_mpz_t());	\
 	t--;								\
       }									\
 	break
-      ShiftOp(OpSl, <<=);
-      ShiftOp(OpSr, >>=);
+      ShiftOp(OpSl, <<=, mulInt(t[-2].value.m_int, (int64_t)1 << t->value.m_int, i));
+      ShiftOp(OpSr, >>=, (i = t[-2].value.m_int >> t->value.m_int, true));
 #define CmpOp(tokenOp, cop)					\
       case tokenOp:						\
 	if (t[-2].op != OpConstant)				\
@@ -446,8 +597,8 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
 	  return "cannot compare strings and numbers";		\
 	b = t[-2].value.m_isString ?				\
 	  t[-2].value.m_string cop t->value.m_string :		\
-	  t[-2].value.m_number cop t->value.m_number;		\
-	t[-2].value.m_number = b ? 1 : 0;			\
+	  compare(t[-2].value, t->value) cop 0;			\
+	t[-2].value.setInt(b ? 1 : 0);				\
 	t[-2].value.m_isString = false;				\
 	t--;							\
 	break;
@@ -461,15 +612,15 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
     case OpLand:
       t[-2].string2Number();
       t[0].string2Number();
-      t[-2].value.m_number = op == OpLor ?
-	mpf2bool(t[-2].value.m_number) || mpf2bool(t[0].value.m_number) :
-	mpf2bool(t[-2].value.m_number) && mpf2bool(t[0].value.m_number);
+      t[-2].value.setInt(op == OpLor ?
+			 t[-2].value.isTrue() || t[0].value.isTrue() :
+			 t[-2].value.isTrue() && t[0].value.isTrue());
       t--;
       break;
     case OpCond1: // we must have encountered the ":".  Implement right-to-left associativity.
       if (t < start + 2 || t[+1].op != OpCond2 || t[-2].op <= OpEnd || parens)
 	return "bad conditional operator syntax";
-      if (mpf2bool(t[-2].value.m_number)) { // true conditional, leave residue
+      if (t[-2].value.isTrue()) { // true conditional, leave residue
 	t[-2] = t[0]; // save good value as LHS of colon operator
 	t[-1] = t[1]; // convert ? to :
 	end = t - 1;
@@ -494,24 +645,93 @@ reduce(ExprToken *start, ExprToken *&end, bool parens) {
   return NULL;
 }
 
+// Expressions are lexed once, and the tokens are kept, keyed by the expression text.
+// Expressions without identifiers are also only evaluated once.
+struct Lexed {
+  std::string text;          // the token pointers point into this
+  std::vector<ExprToken> tokens;
+  bool constant;             // no identifiers (other than true and false)
+  bool haveValue;            // value of a constant expression was evaluated
+  ExprValue::Internal value;
+  Lexed(const char *buf, const char *end)
+    : text(buf, end - buf), constant(true), haveValue(false) {}
+  const char *lex() {
+    const char *cp = text.c_str(), *end = cp + text.length(), *err;
+    do {
+      ExprToken t;
+      if ((err = t.value.lex(cp, end, t.start, t.end, t.op)))
+	return err;
+      if (t.op == OpIdent && (t.end - t.start != 4 || strncasecmp(t.start, "true", 4)) &&
+	  (t.end - t.start != 5 || strncasecmp(t.start, "false", 5)))
+	constant = false;
+      tokens.push_back(t);
+    } while (tokens.back().op != OpEnd);
+    return NULL;
+  }
+};
+typedef std::map<std::string, Lexed *> LexedMap;
+static LexedMap lexedMap;
+static OCPI::OS::Mutex lexedMutex;
+const size_t maxLexed = 10000; // a limit in case expressions are being generated
+
+// Get the tokens for the expression.  If the cache is full, they are returned in
+// a new Lexed that the caller must delete.
+static const char *
+getLexed(const char *buf, const char *end, Lexed *&lexed, bool &owned) {
+  OU::AutoMutex guard(lexedMutex);
+  std::string text(buf, end - buf);
+  LexedMap::iterator it = lexedMap.find(text);
+  if (it != lexedMap.end()) {
+    lexed = it->second;
+    owned = false;
+    return NULL;
+  }
+  Lexed *l = new Lexed(buf, end);
+  const char *err;
+  if ((err = l->lex())) {
+    delete l;
+    return err;
+  }
+  if ((owned = lexedMap.size() >= maxLexed))
+    l->constant = false;
+  else
+    lexedMap[text] = l;
+  lexed = l;
+  return NULL;
+}
+
 const char *ExprValue::Internal::
 parse(const char *buf, const char *end, ExprToken *&tokens, const IdentResolver *resolver) {
-  OpCode op;
-  unsigned nTokens = 0, nParens = 0;
-  const char *cp, *dummy;
   const char *err;
-  Internal dumval;
+  Lexed *lexed;
+  bool owned;
   
   pthread_once(&once, init);
-  for (cp = buf; !(err = dumval.lex(cp, end, dummy, dummy, op)) && op != OpEnd; nTokens++)
-    ;
-  if (err)
+  if ((err = getLexed(buf, end, lexed, owned)))
     return err;
+  if (lexed->constant) {
+    OU::AutoMutex guard(lexedMutex);
+    if (lexed->haveValue) {
+      *this = lexed->value;
+      return NULL;
+    }
+  }
+  err = parse(*lexed, tokens, resolver);
+  if (owned)
+    delete lexed;
+  return err;
+}
+
+const char *ExprValue::Internal::
+parse(Lexed &lexed, ExprToken *&tokens, const IdentResolver *resolver) {
+  OpCode op;
+  unsigned nParens = 0;
+  const char *err;
   bool usesVariable = false;
-  ExprToken *lpar = 0, *t = tokens = new ExprToken[++nTokens];
-  cp = buf;
+  ExprToken *lpar = 0, *t = tokens = new ExprToken[lexed.tokens.size()];
+  const ExprToken *next = &lexed.tokens[0];
   do {
-    t->value.lex(cp, end, t->start, t->end, t->op); // can ignore errors in second pass
+    *t = *next++;
     switch ((op = t->op)) {
     case OpConstant:
       // These values are set in lex()
@@ -522,11 +742,11 @@ parse(const char *buf, const char *end, ExprToken *&tokens, const IdentResolver
 	if (!strcasecmp(sym.c_str(), "false")) {
 	  t->op = OpConstant;
 	  t->value.m_isString = false;
-	  t->value.m_number = 0;
+	  t->value.setInt(0);
 	} else if (!strcasecmp(sym.c_str(), "true")) {
 	  t->op = OpConstant;
 	  t->value.m_isString = false;
-	  t->value.m_number = 1;
+	  t->value.setInt(1);
 	} else if (!resolver)
 	  return "no symbols are available for this expression";
 	else {
@@ -595,6 +815,11 @@ parse(const char *buf, const char *end, ExprToken *&tokens, const IdentResolver
   } while (op != OpEnd);
   *this = tokens[0].value;
   m_usesVariable = usesVariable;
+  if (lexed.constant) {
+    OU::AutoMutex guard(lexedMutex);
+    lexed.value = *this;
+    lexed.haveValue = true;
+  }
   return NULL;
 }
 
@@ -607,9 +832,11 @@ const char *evalExpression(const char *start, ExprValue &val, const IdentResolve
   const char *err = v->parse(start, end, tokens, resolver);
   delete [] tokens;
   v->setInternal(val);
-  std::string s;
-  ocpiLog(20, "Evaluating expression: %.*s err: \"%s\" value: \"%s\"",
-  	    (int)(end - start), start, err ? err : "", val.getString(s));
+  if (OCPI::OS::logWillLog(20)) {
+    std::string s;
+    ocpiLog(20, "Evaluating expression: %.*s err: \"%s\" value: \"%s\"",
+	    (int)(end - start), start, err ? err : "", val.getString(s));
+  }
   return
     err ? esprintf("when parsing expression \"%.*s\": %s", (int)(end-start), start, err) :
     NULL;
@@ -707,7 +934,7 @@ void ExprValue::setNumber(int64_t i) {
   if (!m_internal)
     m_internal = new Internal;
   m_internal->m_isString = false;
-  int64_2_mpf(i, m_internal->m_number);
+  m_internal->setInt(i);
 }
 
 // Extract and convert the almost-untyped ExprValue into the typed OU::Value
@@ -725,17 +952,57 @@ getTypedValue(Value &v, size_t index) const {
     // Handle integral types
     if (!isNumber())
       return "Non-numeric expression value invalid for numeric type";
-    if (!isSigned && sgn(m_internal->m_number) < 0)
+    if (!isSigned && (m_internal->m_isInt ? m_internal->m_int < 0 :
+		      sgn(m_internal->number()) < 0))
       return "Negative expression value assigned to unsigned type";
+    if (m_internal->m_isInt && v.m_vt->m_baseType != OA::OCPI_ULongLong &&
+	v.m_vt->m_baseType != OA::OCPI_LongLong) {
+      // Range check without GMP for the common case
+      int64_t i = m_internal->m_int;
+      bool bad = false;
+      switch (v.m_vt->m_baseType) {
+#define RANGE_INT(pretty,x)						\
+      case OA::OCPI_##pretty:						\
+	if (i < std::numeric_limits<OA::x>::min() ||			\
+	    i > std::numeric_limits<OA::x>::max())			\
+	  bad = true;							\
+	else								\
+	  (items ? v.m_p##x[index] : v.m_##x) = (OA::x)i;		\
+	break
+	RANGE_INT(Char,Char);
+	RANGE_INT(UChar,UChar);
+	RANGE_INT(Short,Short);
+	RANGE_INT(UShort,UShort);
+	RANGE_INT(Long,Long);
+	RANGE_INT(ULong,ULong);
+      case OA::OCPI_Enum:
+	if ((uint64_t)i >= v.m_vt->m_nEnums)
+	  bad = true;
+	else
+	  (items ? v.m_pULong[index] : v.m_ULong) = (OA::ULong)i;
+	break;
+      default:;
+      }
+      if (bad)
+	return esprintf("Expression value (%s) is out of range for %s type properties",
+			getString(s), baseTypeNames[v.m_vt->m_baseType]);
+      break;
+    } else if (m_internal->m_isInt) {
+      if (v.m_vt->m_baseType == OA::OCPI_LongLong)
+	(items ? v.m_pLongLong[index] : v.m_LongLong) = (OA::LongLong)m_internal->m_int;
+      else
+	(items ? v.m_pULongLong[index] : v.m_ULongLong) = (OA::ULongLong)m_internal->m_int;
+      break;
+    }
     {
       mpz_class z;
-      if ((err = mpf2mpz(m_internal->m_number, z)))
+      if ((err = mpf2mpz(m_internal->number(), z)))
 	return err;
       if (z < mpz_min[v.m_vt->m_baseType] ||
 	  z > mpz_max[v.m_vt->m_baseType] ||
 	  (v.m_vt->m_baseType == OA::OCPI_Enum && z >= v.m_vt->m_nEnums))
 	return esprintf("Expression value (%s) is out of range for %s type properties",
-			mpfString(m_internal->m_number, s), baseTypeNames[v.m_vt->m_baseType]);
+			mpfString(m_internal->number(), s), baseTypeNames[v.m_vt->m_baseType]);
       mpz_class tmp = z & (uint32_t)-1;
       uint32_t low32 = (uint32_t)tmp.get_ui();
       tmp = z >>= 32;
@@ -763,7 +1030,7 @@ getTypedValue(Value &v, size_t index) const {
     break; // done with integral types
   case OA::OCPI_Bool:
     (items ? v.m_pBool[index] : v.m_Bool) = 
-      isNumber() ? m_internal->m_number != 0 : !m_internal->m_string.empty();
+      isNumber() ? m_internal->isTrue() : !m_internal->m_string.empty();
     break;
   case OA::OCPI_String:
     if (isNumber())
@@ -776,20 +1043,20 @@ getTypedValue(Value &v, size_t index) const {
   case OA::OCPI_Float:
     if (!isNumber())
       return "A string value cannot be assigned to a float property";
-    if (m_internal->m_number < -std::numeric_limits<float>::max() ||
-	m_internal->m_number > std::numeric_limits<float>::max())
+    if (m_internal->number() < -std::numeric_limits<float>::max() ||
+	m_internal->number() > std::numeric_limits<float>::max())
       return esprintf("Value %s out of range for type: float",
-		      mpfString(m_internal->m_number, s));
-    (items ? v.m_pFloat[index] : v.m_Float) = (float)m_internal->m_number.get_d();
+		      mpfString(m_internal->number(), s));
+    (items ? v.m_pFloat[index] : v.m_Float) = (float)m_internal->number().get_d();
     break;
   case OA::OCPI_Double:
     if (!isNumber())
       return "A string value cannot be assigned to a double property";
-    if (m_internal->m_number < -std::numeric_limits<double>::max() ||
-	m_internal->m_number > std::numeric_limits<double>::max())
+    if (m_internal->number() < -std::numeric_limits<double>::max() ||
+	m_internal->number() > std::numeric_limits<double>::max())
       return esprintf("Value %s out of range for type: double",
-		      mpfString(m_internal->m_number, s));
-    (items ? v.m_pDouble[index] : v.m_Double) = m_internal->m_number.get_d();
+		      mpfString(m_internal->number(), s));
+    (items ? v.m_pDouble[index] : v.m_Double) = m_internal->number().get_d();
     break;
   default:;
   }
@@ -803,17 +1070,22 @@ const char *ExprValue::setFromTypedValue(const Value &v) {
   m_internal->m_isString = false;
   m_internal->m_usesVariable = false;
   switch (v.m_vt->m_baseType) {
-  case OA::OCPI_Bool: m_internal->m_number = v.m_Bool ? 1 : 0; break;
-  case OA::OCPI_UChar: m_internal->m_number = v.m_UChar; break;
-  case OA::OCPI_UShort: m_internal->m_number = v.m_UShort; break;
-  case OA::OCPI_ULong: m_internal->m_number = v.m_ULong; break;
-  case OA::OCPI_Char: m_internal->m_number = v.m_Char; break;
-  case OA::OCPI_Short: m_internal->m_number = v.m_Short; break;
-  case OA::OCPI_Long: m_internal->m_number = v.m_Long; break;
-  case OA::OCPI_LongLong: int64_2_mpf(v.m_LongLong, m_internal->m_number); break;
-  case OA::OCPI_ULongLong: uint64_2_mpf(v.m_ULongLong, m_internal->m_number); break;
-  case OA::OCPI_Float: m_internal->m_number = v.m_Float; break;
-  case OA::OCPI_Double: m_internal->m_number = v.m_Double; break;
+  case OA::OCPI_Bool: m_internal->setInt(v.m_Bool ? 1 : 0); break;
+  case OA::OCPI_UChar: m_internal->setInt(v.m_UChar); break;
+  case OA::OCPI_UShort: m_internal->setInt(v.m_UShort); break;
+  case OA::OCPI_ULong: m_internal->setInt(v.m_ULong); break;
+  case OA::OCPI_Char: m_internal->setInt(v.m_Char); break;
+  case OA::OCPI_Short: m_internal->setInt(v.m_Short); break;
+  case OA::OCPI_Long: m_internal->setInt(v.m_Long); break;
+  case OA::OCPI_LongLong: m_internal->setInt(v.m_LongLong); break;
+  case OA::OCPI_ULongLong:
+    if (v.m_ULongLong <= INT64_MAX)
+      m_internal->setInt((int64_t)v.m_ULongLong);
+    else
+      uint64_2_mpf(v.m_ULongLong, m_internal->number());
+    break;
+  case OA::OCPI_Float: m_internal->number() = v.m_Float; break;
+  case OA::OCPI_Double: m_internal->number() = v.m_Double; break;
   case OA::OCPI_String:
     m_internal->m_isString = true;
     m_internal->m_string = v.m_String;
@@ -837,8 +1109,13 @@ bool ExprValue::isVariable() const {
 int64_t ExprValue::getNumber() const {
   if (!m_numberSet) {
     assert(!m_internal->m_isString);
+    if (m_internal->m_isInt) {
+      m_numberSet = true;
+      m_number = m_internal->m_int;
+      return m_number;
+    }
     mpz_class z;
-    ocpiCheck(mpf2mpz(m_internal->m_number, z) == NULL);
+    ocpiCheck(mpf2mpz(m_internal->number(), z) == NULL);
     m_numberSet = true;
     m_number = z.get_si();
   }
@@ -0,0 +1,80 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Binary snapshots of property values.
+ *
+ * A snapshot holds, for each property, its qualified name (instance.property), a type
+ * descriptor (the XML of the property's data type), and the property's value as a raw
+ * "image": the bytes of the property as laid out in a worker's property space, starting at
+ * the property's offset, and only as long as the current value needs (e.g. the sequence
+ * length word and the current elements, or a string and its null).
+ * Images are read and written in bulk, avoiding the text conversion that the normal
+ * property dump and restore do for every value.
+ *
+ * The file format is in host byte order:
+ *   "OCPISNAP", uint32 version, uint32 number of entries, then for each entry:
+ *   uint32 length + name, uint32 length + type XML, uint32 length + image.
+ */
+#ifndef OCPI_UTIL_PROPERTY_SNAPSHOT_H
+#define OCPI_UTIL_PROPERTY_SNAPSHOT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "OcpiUtilProperty.h"
+
+namespace OCPI {
+  namespace Util {
+    class PropertySnapshot {
+    public:
+      struct Entry {
+	std::string m_name;  // instance.property
+	std::string m_type;  // the XML type descriptor
+	std::string m_image; // the raw bytes
+      };
+      typedef std::vector<Entry> Entries;
+      static const uint32_t c_version = 1;
+    private:
+      Entries m_entries;
+    public:
+      const Entries &entries() const { return m_entries; }
+      void clear() { m_entries.clear(); }
+      // Add an entry, with the image already in the entry's string
+      Entry &add(const char *name, const Property &p);
+      const char
+	*save(const char *file) const,
+	*load(const char *file),
+	// Convert all entries to the text form written by the "dumpFile" application option:
+	// one "instance property value" line per entry
+	*toText(std::string &out, bool hex = false) const;
+      // The type descriptor for a property
+      static void typeDescriptor(const Property &p, std::string &type);
+      // Reconstruct a property (for its type only) from a type descriptor
+      static const char *parseType(const std::string &type, Property &p);
+      // The number of bytes in the image of a property's value, given its sequence length
+      static size_t imageLength(const Property &p, size_t nElements);
+      // Convert an image to the text form of its value
+      static const char *unparse(Property &p, const uint8_t *image, size_t length,
+				 std::string &value, bool hex = false);
+    };
+  }
+}
+#endif
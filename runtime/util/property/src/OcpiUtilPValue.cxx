@@ -85,6 +85,14 @@ namespace OCPI {
       PVBool("polled"),
       PVULong("bufferCount"),
       PVULong("bufferSize"),
+      PVBool("hugePages"),
+      PVULong("numaNode"),
+      PVULong("spinUsecs"),
+      PVULong("yieldUsecs"),
+      PVULong("blockUsecs"),
+      PVULong("aggregate"),
+      PVULong("computeThreads"),
+      PVBool("pinThreads"),
       PVUChar("index"),
       PVString("interconnect"),
       PVString("adapter"),
@@ -0,0 +1,210 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <cassert>
+#include "OcpiUtilEzxml.h"
+#include "OcpiUtilMisc.h"
+#include "OcpiUtilValue.h"
+#include "ValueWriter.h"
+#include "OcpiUtilPropertySnapshot.h"
+
+namespace OCPI {
+  namespace Util {
+    namespace OA = OCPI::API;
+    namespace OE = OCPI::Util::EzXml;
+    static const char c_magic[8] = { 'O', 'C', 'P', 'I', 'S', 'N', 'A', 'P' };
+
+    PropertySnapshot::Entry &PropertySnapshot::
+    add(const char *name, const Property &p) {
+      m_entries.resize(m_entries.size() + 1);
+      Entry &e = m_entries.back();
+      e.m_name = name;
+      typeDescriptor(p, e.m_type);
+      return e;
+    }
+
+    void PropertySnapshot::
+    typeDescriptor(const Property &p, std::string &type) {
+      // The access attributes are irrelevant, but one is needed to parse it as a property
+      Property &mp = const_cast<Property &>(p); // the print methods are not const
+      type.clear();
+      mp.printAttrs(type, "property", 0, true);
+      type += " readable='true'";
+      mp.printChildren(type, "property", 0);
+    }
+
+    const char *PropertySnapshot::
+    parseType(const std::string &type, Property &p) {
+      std::string copy(type); // parsing modifies the buffer
+      ezxml_t x;
+      const char *err = OE::ezxml_parse_str(&copy[0], copy.size(), x);
+      if (!err) {
+	err = p.parse(x, false, 0);
+	ezxml_free(x);
+      }
+      return err;
+    }
+
+    size_t PropertySnapshot::
+    imageLength(const Property &p, size_t nElements) {
+      if (p.m_baseType == OA::OCPI_Struct || p.m_isSequence || p.m_arrayRank > 0)
+	return (p.m_isSequence ? p.m_align : 0) +
+	  p.m_nItems * (p.m_isSequence ? nElements : 1) * p.m_elementBytes;
+      return p.m_baseType == OA::OCPI_String ? p.m_stringLength + 1 : p.m_nBytes;
+    }
+
+    // This follows the decoding in Container::Worker::getPropertyValue.
+    const char *PropertySnapshot::
+    unparse(Property &p, const uint8_t *image, size_t length, std::string &value, bool hex) {
+      Value v(p);
+      if (p.m_baseType == OA::OCPI_Type)
+	return "typedef properties are unsupported";
+      if (p.m_baseType == OA::OCPI_Struct || p.m_isSequence || p.m_arrayRank > 0) {
+	v.m_nTotal = p.m_nItems;
+	if (p.m_isSequence) {
+	  if (length < sizeof(uint32_t))
+	    return "image too short for sequence length";
+	  v.m_nElements = *(uint32_t *)image;
+	  if (v.m_nElements > p.m_sequenceLength)
+	    return esprintf("invalid sequence length: %zu", v.m_nElements);
+	  v.m_nTotal *= v.m_nElements;
+	}
+	if (length < imageLength(p, v.m_nElements))
+	  return "image too short for value";
+	if (p.m_baseType == OA::OCPI_String) {
+	  size_t elength = roundUp(p.m_stringLength + 1, 4);
+	  const uint8_t *data = image + (p.m_isSequence ? p.m_align : 0);
+	  v.m_stringSpaceLength = v.m_nTotal * elength;
+	  v.m_stringNext = v.m_stringSpace = new char[v.m_stringSpaceLength];
+	  char **sp = new char *[v.m_nTotal];
+	  v.m_pString = (const char **)sp;
+	  for (unsigned n = 0; n < v.m_nTotal; n++, data += elength) {
+	    sp[n] = v.m_stringNext;
+	    memcpy(v.m_stringNext, data, elength);
+	    v.m_stringNext[p.m_stringLength] = '\0';
+	    v.m_stringNext += elength;
+	  }
+	} else if (v.m_nTotal) {
+	  // Copy to aligned storage for the writer
+	  size_t wlength = imageLength(p, v.m_nElements);
+	  std::vector<uint64_t> data((wlength + 7) / 8);
+	  memcpy(&data[0], image, wlength);
+	  const uint8_t *tmp = (const uint8_t *)&data[0];
+	  Value *vp = NULL;
+	  ValueWriter writer(&vp, 1);
+	  p.write(writer, tmp, wlength, true);
+	  vp->unparse(value, NULL, false, hex);
+	  delete vp;
+	  return NULL;
+	}
+      } else if (p.m_baseType == OA::OCPI_String) {
+	v.m_stringSpace = new char[p.m_stringLength + 1];
+	v.m_String = v.m_stringSpace;
+	size_t n = std::min(length, p.m_stringLength + 1);
+	memcpy(v.m_stringSpace, image, n);
+	v.m_stringSpace[n ? n - 1 : 0] = '\0';
+      } else if (length < p.m_nBytes)
+	return "image too short for value";
+      else
+	memcpy(&v.m_UChar, image, p.m_nBytes);
+      v.unparse(value, NULL, false, hex);
+      return NULL;
+    }
+
+    static bool
+    put(FILE *f, const std::string &s) {
+      uint32_t n = OCPI_UTRUNCATE(uint32_t, s.size());
+      return fwrite(&n, sizeof(n), 1, f) != 1 || (n && fwrite(s.data(), n, 1, f) != 1);
+    }
+
+    static bool
+    get(FILE *f, std::string &s) {
+      uint32_t n;
+      if (fread(&n, sizeof(n), 1, f) != 1)
+	return true;
+      s.resize(n);
+      return n && fread(&s[0], n, 1, f) != 1;
+    }
+
+    const char *PropertySnapshot::
+    save(const char *file) const {
+      FILE *f = fopen(file, "wb");
+      if (!f)
+	return esprintf("can't create snapshot file \"%s\": %s", file, strerror(errno));
+      uint32_t hdr[2] = { c_version, OCPI_UTRUNCATE(uint32_t, m_entries.size()) };
+      bool bad =
+	fwrite(c_magic, sizeof(c_magic), 1, f) != 1 || fwrite(hdr, sizeof(hdr), 1, f) != 1;
+      for (Entries::const_iterator it = m_entries.begin(); !bad && it != m_entries.end(); ++it)
+	bad = put(f, it->m_name) || put(f, it->m_type) || put(f, it->m_image);
+      if (fclose(f) || bad)
+	return esprintf("error writing snapshot file \"%s\"", file);
+      return NULL;
+    }
+
+    const char *PropertySnapshot::
+    load(const char *file) {
+      FILE *f = fopen(file, "rb");
+      if (!f)
+	return esprintf("can't open snapshot file \"%s\": %s", file, strerror(errno));
+      char magic[sizeof(c_magic)];
+      uint32_t hdr[2];
+      const char *err = NULL;
+      m_entries.clear();
+      if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, c_magic, sizeof(magic)) ||
+	  fread(hdr, sizeof(hdr), 1, f) != 1)
+	err = esprintf("file \"%s\" is not a property snapshot", file);
+      else if (hdr[0] != c_version)
+	err = esprintf("snapshot file \"%s\" has version 0x%x, expected %u (or other byte order)",
+		       file, hdr[0], c_version);
+      else {
+	m_entries.resize(hdr[1]);
+	for (Entries::iterator it = m_entries.begin(); !err && it != m_entries.end(); ++it)
+	  if (get(f, it->m_name) || get(f, it->m_type) || get(f, it->m_image))
+	    err = esprintf("snapshot file \"%s\" is truncated", file);
+      }
+      fclose(f);
+      if (err)
+	m_entries.clear();
+      return err;
+    }
+
+    const char *PropertySnapshot::
+    toText(std::string &out, bool hex) const {
+      const char *err;
+      std::string value;
+      for (Entries::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+	Property p;
+	if ((err = parseType(it->m_type, p)) ||
+	    (err = unparse(p, (const uint8_t *)it->m_image.data(), it->m_image.size(), value,
+			   hex)))
+	  return esprintf("for snapshot entry \"%s\": %s", it->m_name.c_str(), err);
+	std::string name(it->m_name);
+	for (unsigned i = 0; i < name.size(); i++)
+	  if (name[i] == '.')
+	    name[i] = ' ';
+	formatAdd(out, "%s %s\n", name.c_str(), value.c_str());
+      }
+      return NULL;
+    }
+  }
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Convert binary property snapshot files (written by ocpirun --snapshot-file) to text
+
+#include <cstdio>
+#include <string>
+#include "OcpiUtilException.h"
+#include "OcpiUtilMisc.h"
+#include "OcpiUtilPropertySnapshot.h"
+
+namespace OU = OCPI::Util;
+
+#define OCPI_OPTIONS_HELP \
+"This program converts binary property snapshot files to text.\n"\
+"Usage is: ocpisnapshot [<options>] <snapshot-file> [<text-file>]\n"\
+"The text, written to standard output if no text file is given, is the same as\n"\
+"that written by the dump-file option of ocpirun.\n"
+
+#define OCPI_OPTIONS \
+    CMD_OPTION(hex,        x, Bool,   0, "print numeric property values in hex, not decimal") \
+    CMD_OPTION(types,      t, Bool,   0, "print the type descriptor of each property value") \
+    CMD_OPTION(log_level,  l, ULong,  0, "<log-level>\n" \
+	                               "set log level during execution, overriding OCPI_LOG_LEVEL")
+
+#include "CmdOption.h"
+
+static int mymain(const char **argv) {
+  if (options.argvCount() < 1 || options.argvCount() > 2) {
+    options.usage();
+    return 1;
+  }
+  OU::PropertySnapshot snap;
+  std::string text;
+  const char *err;
+  if ((err = snap.load(argv[0])) || (err = snap.toText(text, options.hex())))
+    throw OU::Error("%s", err);
+  if (options.types())
+    for (OU::PropertySnapshot::Entries::const_iterator it = snap.entries().begin();
+	 it != snap.entries().end(); ++it) {
+      std::string type(it->m_type); // one line per entry
+      for (size_t n = 0; n < type.size(); n++)
+	if (type[n] == '\n')
+	  type[n] = ' ';
+      OU::formatAdd(text, "# %s: %s (%zu bytes)\n", it->m_name.c_str(), type.c_str(),
+		    it->m_image.size());
+    }
+  if (argv[1]) {
+    if ((err = OU::string2File(text, argv[1])))
+      throw OU::Error("Error writing text file: %s", err);
+  } else
+    fputs(text.c_str(), stdout);
+  return 0;
+}
@@ -35,9 +35,23 @@ namespace OCPI {
 
     typedef ResAddr ResAddrType; // backwards compatibility
     struct ResPool;
+    // Manager of a range of addresses, with best-fit allocation and address-ordered
+    // coalescing of free blocks, both O(log n) in the number of blocks.
     class MemBlockMgr
     {
     public:
+      // Occupancy and fragmentation statistics
+      struct Stats {
+	size_t total, used, peakUsed;  // bytes
+	size_t nAllocated, nFree;      // current number of blocks
+	size_t largestFree;            // largest free block in bytes
+	size_t nAllocs, nFrees, nFailures;
+	// Fraction of free space that is not in the largest free block: 0 is unfragmented
+	double fragmentation() const {
+	  size_t avail = total - used;
+	  return avail ? 1.0 - (double)largestFree / (double)avail : 0;
+	}
+      };
       MemBlockMgr(ResAddr start, size_t size)
         throw( std::bad_alloc );
       ~MemBlockMgr()
@@ -46,6 +60,7 @@ namespace OCPI {
         throw( std::bad_alloc );
       int free(ResAddr  addr )
         throw( std::bad_alloc );
+      void stats(Stats &s) const;
 
 
     private:
@@ -19,9 +19,17 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+/*
+ * The free blocks are kept both in address order, to coalesce a freed block with its
+ * neighbors, and in (size, address) order, to find the smallest block that fits.
+ * Allocated blocks are kept by the address returned to the caller, which is aligned.
+ * Any space skipped for alignment stays free.
+ */
 #include <inttypes.h>
-#include <list>
+#include <map>
+#include <set>
 #include <cstdio>
+#include <cstring>
 #include "OcpiOsDataTypes.h"
 #include "OcpiOsAssert.h"
 #include "OcpiUtilMisc.h"
@@ -29,53 +37,51 @@
 
 namespace OCPI {
   namespace Util {
-    struct Block {
-      ResPool*                 rp;
-      size_t                   size;
-      ResAddrType  addr;
-      ResAddrType  aligned_addr;      
-      Block( ResPool* rpp, size_t s, ResAddrType adr,  ResAddrType a_adr)
-        :rp(rpp),size(s),addr(adr),aligned_addr(a_adr){}
-      int operator<(const Block& rhs)const;
-    };
+    typedef std::map<ResAddr, size_t> BlockMap;            // address -> size
+    typedef std::set<std::pair<size_t, ResAddr> > SizeSet; // (size, address)
     struct ResPool {
-      OCPI::Util::ResAddrType  start_off;
-      size_t  total_size, used;
-      std::list<Block> free_list;
-      std::list<Block> alloc_list;
-      bool             sort_by_size;
-      ResPool():sort_by_size(true){}
-      void defrag();
+      ResAddr  start_off;
+      BlockMap free_by_addr, allocated;
+      SizeSet  free_by_size;
+      MemBlockMgr::Stats stats;
+      void addFree(ResAddr addr, size_t size);
+      void removeFree(BlockMap::iterator it);
     };
-    int Block::operator<(const Block& rhs)const
-    {
-      if ( rp->sort_by_size ) {
-        if ( this->size < rhs.size ) return 1;
+
+    void ResPool::
+    addFree(ResAddr addr, size_t size) {
+      // Merge with the following block, then with the preceding one
+      BlockMap::iterator next = free_by_addr.lower_bound(addr);
+      if (next != free_by_addr.end() && addr + size == next->first) {
+	size += next->second;
+	BlockMap::iterator it = next++;
+	removeFree(it);
       }
-      else {
-        if ( this->addr < rhs.addr ) return 1;
+      if (next != free_by_addr.begin()) {
+	BlockMap::iterator prev = next;
+	if ((--prev)->first + prev->second == addr) {
+	  addr = prev->first;
+	  size += prev->second;
+	  removeFree(prev);
+	}
       }
-      return 0;
+      free_by_addr.insert(next, BlockMap::value_type(addr, size));
+      free_by_size.insert(std::make_pair(size, addr));
+    }
+
+    void ResPool::
+    removeFree(BlockMap::iterator it) {
+      free_by_size.erase(std::make_pair(it->second, it->first));
+      free_by_addr.erase(it);
     }
   }
 }
 
-#ifndef NDEBUG
-static void dumpList( std::list<OCPI::Util::Block>& list )
-{
-
 #ifdef DEBUG_LISTS
-  std::list<OCPI::Util::Block>::iterator it;
-  for ( it=list.begin(); it !=list.end(); it++ ) {
-    ocpiDebug("addr = %" PRIx32 ", aligned_addr = %" PRIx32 ", size = %zu", 
-	      (*it).addr, 
-	      (*it).aligned_addr, 
-	      (*it).size );
-  }
-#else
-  (void)list;
-#endif
-
+static void dumpMap(const char *what, OCPI::Util::BlockMap &map) {
+  ocpiDebug("%s:", what);
+  for (OCPI::Util::BlockMap::iterator it = map.begin(); it != map.end(); ++it)
+    ocpiDebug("addr = %" PRIx32 ", size = %zu", it->first, it->second);
 }
 #endif
 
@@ -85,150 +91,106 @@ ALIGN(OCPI::Util::ResAddrType addr, unsigned int alignment) {
   return alignment ? (addr + alignment - 1) & ~(alignment - 1) : addr;
 }
 
-
-void OCPI::Util::ResPool::defrag()
-{
-  sort_by_size = false;
-  bool not_done;
-  do {
-    not_done=false;
-    free_list.sort();
-    std::list<Block>::iterator it1, it2;
-    it1=it2=free_list.begin();
-    it2++;
-    for ( ; it2 !=free_list.end(); it2++, it1++ ) {
-      if ( ((*it1).addr+(*it1).size) == (*it2).addr ) {
-        (*it1).size += (*it2).size;
-        free_list.erase(it2);
-        not_done=true;
-        break;
-      }
-    }
-  }
-  while ( not_done );
-  sort_by_size = true;  
-
-#ifdef DEBUG_LISTS
-  ocpiDebug("defrag: Alloc list");
-  dumpList(alloc_list);
-  ocpiDebug("defrag: Free list");
-  dumpList(free_list);
-#endif
-
-}
-
-
 int OCPI::Util::MemBlockMgr::
 alloc(size_t nbytes, unsigned int alignment, OCPI::Util::ResAddrType& req_addr)
   throw(std::bad_alloc) 
 {
-
+  Stats &st = m_pool->stats;
   if (nbytes > 2000000) {
     ocpiInfo("Allocating large mem %zuK in %p %zu of %zu used",
-	     nbytes/1024, this, m_pool->used, m_pool->total_size);
+	     nbytes/1024, this, st.used, st.total);
     // OCPI::OS::dumpStack(std::cerr);
   }
 #ifdef DEBUG_LISTS
-  ocpiDebug("alloc: Alloc list");
-  dumpList(m_pool->alloc_list);
-  ocpiDebug("alloc: Free list");
-  dumpList(m_pool->free_list);
+  dumpMap("alloc: Allocated", m_pool->allocated);
+  dumpMap("alloc: Free", m_pool->free_by_addr);
 #endif
-
-  m_pool->free_list.sort();
-  for (unsigned retry = 2; retry; retry--) {
-    for (std::list<Block>::iterator it = m_pool->free_list.begin(); it !=m_pool->free_list.end();
-	 ++it) {
-      ResAddr taddr = (*it).addr;
-      req_addr = ALIGN(taddr, alignment);
-      size_t skip = req_addr - taddr;
-      if (skip >= (*it).size)
-	continue;
-      size_t size = (*it).size - skip; // size net of alignment
-      if (size < nbytes)
-	continue;
-      if (size > nbytes) {
-        (*it).addr = OCPI_UTRUNCATE(ResAddrType, req_addr + nbytes);
-	nbytes += skip; // number of bytes taken out of this block
-        (*it).size -= nbytes;
-        m_pool->alloc_list.push_back(Block(m_pool, nbytes, taddr, req_addr));
-      } else { // size matches
-	nbytes = (*it).size;
-        (*it).aligned_addr = req_addr;
-        m_pool->alloc_list.push_back(*it);
-        m_pool->free_list.erase(it);      
-      }
-      m_pool->used += nbytes;
-      //ocpiDebug("**** Alloc of %zu Returning address = %" OCPI_UTIL_RESADDR_PRIx ", %" 
-      //          OCPI_UTIL_RESADDR_PRIx " used %zu", nbytes, taddr, req_addr, m_pool->used);
-      return 0;
-    }
-    m_pool->defrag();  
+  if (!nbytes)
+    nbytes = 1; // every allocation needs a distinct address
+  // Best fit: the smallest block that fits whatever its alignment.  Any block at least
+  // nbytes + alignment - 1 long holds an aligned nbytes, so the first candidate fits.
+  SizeSet::iterator it =
+    m_pool->free_by_size.lower_bound(std::make_pair(nbytes + (alignment ? alignment - 1 : 0),
+						    0u));
+  if (it != m_pool->free_by_size.end()) {
+    ResAddr taddr = it->second;
+    size_t tsize = it->first;
+    req_addr = ALIGN(taddr, alignment);
+    size_t skip = req_addr - taddr;
+    ocpiAssert(skip < tsize && tsize - skip >= nbytes);
+    m_pool->removeFree(m_pool->free_by_addr.find(taddr));
+    if (skip)
+      m_pool->addFree(taddr, skip);
+    if (tsize - skip > nbytes)
+      m_pool->addFree(OCPI_UTRUNCATE(ResAddr, req_addr + nbytes), tsize - skip - nbytes);
+    m_pool->allocated[req_addr] = nbytes;
+    st.used += nbytes;
+    if (st.used > st.peakUsed)
+      st.peakUsed = st.used;
+    st.nAllocs++;
+    //ocpiDebug("**** Alloc of %zu Returning address = %" OCPI_UTIL_RESADDR_PRIx
+    //          " used %zu", nbytes, req_addr, st.used);
+    return 0;
   }
-
-#ifndef NDEBUG
-  ocpiDebug("alloc2: Alloc list");
-  dumpList(m_pool->alloc_list);
-  ocpiDebug("alloc2: xoFree list");
-  dumpList(m_pool->free_list);
+  st.nFailures++;
+#ifdef DEBUG_LISTS
+  dumpMap("alloc failed: Allocated", m_pool->allocated);
+  dumpMap("alloc failed: Free", m_pool->free_by_addr);
 #endif
-
   return -1;
 }
 
-
 int OCPI::Util::MemBlockMgr::free( OCPI::Util::ResAddrType addr )
   throw( std::bad_alloc ) 
 {
-
-  std::list<Block>::iterator it;
-  for ( it=m_pool->alloc_list.begin(); it !=m_pool->alloc_list.end(); it++ ) {
-    if ( (*it).aligned_addr == addr )  {
-
+  BlockMap::iterator it = m_pool->allocated.find(addr);
+  if (it == m_pool->allocated.end()) {
+    ocpiAssert(0);
+    return -1;
+  }
+  size_t size = it->second;
+  Stats &st = m_pool->stats;
 #ifndef NDEBUG
-      if ( (*it).size > 2000000 ) {
-	ocpiInfo("Freeing large mem %zuK in %p %zu of %zu used",
-		 (*it).size/1024, this, m_pool->used, m_pool->total_size);
-	//        OCPI::OS::dumpStack (std::cerr);
-      }
-#ifdef DEBUG_LISTS
-      ocpiDebug("free: Alloc list");
-      dumpList(m_pool->alloc_list);
-      ocpiDebug("free: Free list");
-      dumpList(m_pool->free_list);
-#endif
-#endif
-
-
-      m_pool->used -= (*it).size;
-      m_pool->free_list.push_back( Block( m_pool, (*it).size, addr, addr ) );
-      m_pool->alloc_list.erase( it );
-      m_pool->defrag();  
-      // ocpiDebug("**** Free of = %" OCPI_UTIL_RESADDR_PRIx " used %zu", addr, m_pool->used);
-      return 0;
-    }
+  if (size > 2000000) {
+    ocpiInfo("Freeing large mem %zuK in %p %zu of %zu used",
+	     size/1024, this, st.used, st.total);
+    //        OCPI::OS::dumpStack (std::cerr);
   }
+#endif
+  m_pool->allocated.erase(it);
+  m_pool->addFree(addr, size);
+  st.used -= size;
+  st.nFrees++;
+  // ocpiDebug("**** Free of = %" OCPI_UTIL_RESADDR_PRIx " used %zu", addr, st.used);
+  return 0;
+}
 
-  ocpiAssert(0);
-return -1;
+void OCPI::Util::MemBlockMgr::
+stats(Stats &s) const {
+  s = m_pool->stats;
+  s.nAllocated = m_pool->allocated.size();
+  s.nFree = m_pool->free_by_addr.size();
+  s.largestFree =
+    m_pool->free_by_size.empty() ? 0 : m_pool->free_by_size.rbegin()->first;
 }
 
 OCPI::Util::MemBlockMgr::MemBlockMgr(OCPI::Util::ResAddrType start, size_t size )
   throw( std::bad_alloc ) 
 {
-  
   m_pool = new OCPI::Util::ResPool;
-  m_pool->total_size = size;
-  m_pool->used = 0;
-  m_pool->free_list.push_back( Block( m_pool, size, start, start ) );
+  m_pool->start_off = start;
+  memset(&m_pool->stats, 0, sizeof(m_pool->stats));
+  m_pool->stats.total = size;
+  if (size)
+    m_pool->addFree(start, size);
 }
 
 
 OCPI::Util::MemBlockMgr::~MemBlockMgr()
   throw()
 {
-  ocpiDebug("Memory pool is using %zu of %zu on deletion", m_pool->used, m_pool->total_size);
+  ocpiDebug("Memory pool is using %zu of %zu (peak %zu) in %zu blocks on deletion",
+	    m_pool->stats.used, m_pool->stats.total, m_pool->stats.peakUsed,
+	    m_pool->allocated.size());
   delete m_pool;
 }
-
-
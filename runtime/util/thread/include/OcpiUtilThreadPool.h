@@ -0,0 +1,141 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// -*- c++ -*-
+
+#ifndef OCPI_UTIL_THREAD_POOL_H__
+#define OCPI_UTIL_THREAD_POOL_H__
+
+/**
+ * \file
+ * \brief A fixed pool of threads for data-parallel loops.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <OcpiOsMutex.h>
+#include <OcpiOsSemaphore.h>
+#include <OcpiOsThreadManager.h>
+
+namespace OCPI {
+  namespace Util {
+
+    /**
+     * \brief Thread pool for splitting a loop over a range into chunks.
+     *
+     * The range [0, n) is split into chunks of "grain" items, which are
+     * claimed by the pool threads and the calling thread until none are
+     * left.  The call returns when all chunks are done.  Threads are
+     * created once and kept waiting between loops, optionally each pinned
+     * to its own processor from those the creating thread may run on.
+     *
+     * One loop runs at a time: concurrent callers are serialized.  A loop
+     * started by a chunk of this pool runs entirely in that chunk's thread.
+     */
+
+    class ThreadPool {
+    public:
+      /**
+       * The function called for each chunk, with the chunk index and the
+       * range of items [begin, end) in that chunk.
+       */
+      typedef void Chunk(void *arg, size_t chunk, size_t begin, size_t end);
+
+      /**
+       * Constructor.  Starts the threads.
+       *
+       * \param[in] nThreads The number of threads in addition to the caller.
+       *                     Zero means run every loop in the caller.
+       * \param[in] pin      Pin each thread to its own processor.  The first
+       *                     processor available is left for the caller.
+       */
+
+      ThreadPool (unsigned nThreads, bool pin = true)
+        throw (std::string);
+
+      /**
+       * Destructor.  Stops the threads.
+       */
+
+      ~ThreadPool ()
+        throw ();
+
+      /**
+       * The grain that run() uses for a range of n items when given zero:
+       * a few chunks per thread so that uneven chunks balance out.
+       */
+
+      size_t defaultGrain (size_t n) const
+        throw ();
+
+      /**
+       * The number of chunks that run() will use.
+       */
+
+      size_t nChunks (size_t n, size_t grain) const
+        throw ();
+
+      /**
+       * The number of items of the given size that fit in a chunk sized
+       * for the processor's data cache, for loops that stream through
+       * buffers.
+       */
+
+      static size_t cacheGrain (size_t itemSize)
+        throw ();
+
+      /**
+       * Run the function on all chunks of the range [0, n), in parallel.
+       *
+       * \param[in] n     The number of items.
+       * \param[in] grain The number of items per chunk, or zero for defaultGrain().
+       * \throw std::string The first exception thrown by the function as
+       *                    a string, after all chunks are done.
+       */
+
+      void run (size_t n, size_t grain, Chunk *fn, void *arg)
+        throw (std::string);
+
+      unsigned nThreads () const { return (unsigned)m_threads.size(); }
+
+    private:
+      static void thread (void *opaque);
+      void work ();
+
+      OCPI::OS::Mutex m_mutex;           // serializes callers of run()
+      OCPI::OS::Semaphore m_start, m_done;
+      std::vector<OCPI::OS::ThreadManager *> m_threads;
+      std::vector<unsigned> m_cpus;      // processor for each thread, if pinned
+      volatile unsigned m_nextCpu;       // index into m_cpus claimed by each new thread
+      bool m_terminate;
+      // The current loop
+      Chunk *m_fn;
+      void *m_arg;
+      size_t m_n, m_grain, m_nChunks;
+      volatile size_t m_next;            // next chunk to be claimed
+      OCPI::OS::Mutex m_errorMutex;
+      std::string m_error;               // first error from a chunk
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <pthread.h>
+#include <string>
+#include <OcpiOsAssert.h>
+#include <OcpiOsMisc.h>
+#include "OcpiUtilThreadPool.h"
+
+namespace OCPI {
+  namespace Util {
+    namespace OS = OCPI::OS;
+
+    // Each thread records the pool whose chunks it is running, so that a loop started
+    // from inside a chunk runs in that thread rather than waiting for the pool.
+    namespace {
+      pthread_once_t s_runningOnce = PTHREAD_ONCE_INIT;
+      pthread_key_t s_runningKey;
+      void makeRunningKey() {
+	pthread_key_create(&s_runningKey, NULL);
+      }
+    }
+
+    ThreadPool::
+    ThreadPool(unsigned a_nThreads, bool pin)
+      throw (std::string)
+      : m_start(0), m_done(0), m_nextCpu(0), m_terminate(false), m_fn(NULL), m_arg(NULL),
+	m_n(0), m_grain(0), m_nChunks(0), m_next(0) {
+      pthread_once(&s_runningOnce, makeRunningKey);
+      if (pin) {
+	std::vector<unsigned> cpus;
+	OS::getProcessors(cpus);
+	// Leave the first processor for the caller when there are enough of them
+	for (unsigned n = 0; n < a_nThreads; n++)
+	  m_cpus.push_back(cpus[(n + (cpus.size() > a_nThreads ? 1 : 0)) % cpus.size()]);
+      }
+      for (unsigned n = 0; n < a_nThreads; n++) {
+	m_threads.push_back(new OS::ThreadManager);
+	m_threads.back()->start(thread, this);
+      }
+      ocpiInfo("Thread pool started with %u threads%s", a_nThreads,
+	       pin ? ", each pinned to a processor" : "");
+    }
+
+    ThreadPool::
+    ~ThreadPool()
+      throw () {
+      m_mutex.lock();
+      m_terminate = true;
+      for (unsigned n = 0; n < m_threads.size(); n++)
+	m_start.post();
+      for (unsigned n = 0; n < m_threads.size(); n++) {
+	m_threads[n]->join();
+	delete m_threads[n];
+      }
+      m_mutex.unlock();
+    }
+
+    size_t ThreadPool::
+    defaultGrain(size_t n) const
+      throw () {
+      size_t chunks = 4 * (m_threads.size() + 1);
+      return n > chunks ? (n + chunks - 1) / chunks : 1;
+    }
+
+    size_t ThreadPool::
+    nChunks(size_t n, size_t grain) const
+      throw () {
+      if (!grain)
+	grain = defaultGrain(n);
+      return (n + grain - 1) / grain;
+    }
+
+    size_t ThreadPool::
+    cacheGrain(size_t itemSize)
+      throw () {
+      long cache = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+      cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+      // Use half the cache, leaving room for what the loop writes and other state
+      size_t bytes = (cache > 0 ? (size_t)cache : 256*1024) / 2;
+      return itemSize && bytes > itemSize ? bytes / itemSize : 1;
+    }
+
+    void ThreadPool::
+    thread(void *opaque) {
+      ThreadPool &pool = *(ThreadPool *)opaque;
+      if (pool.m_cpus.size()) {
+	unsigned cpu = pool.m_cpus[__sync_fetch_and_add(&pool.m_nextCpu, 1)];
+	if (!OS::runOnProcessor(cpu))
+	  ocpiInfo("Thread pool thread could not be pinned to processor %u", cpu);
+      }
+      pthread_setspecific(s_runningKey, &pool);
+      while (true) {
+	pool.m_start.wait();
+	if (pool.m_terminate)
+	  break;
+	pool.work();
+	pool.m_done.post();
+      }
+    }
+
+    // Claim and run chunks until there are none left.
+    void ThreadPool::
+    work() {
+      size_t chunk;
+      while ((chunk = __sync_fetch_and_add(&m_next, 1)) < m_nChunks) {
+	size_t begin = chunk * m_grain, end = begin + m_grain;
+	try {
+	  m_fn(m_arg, chunk, begin, end > m_n ? m_n : end);
+	} catch (std::string &e) {
+	  m_errorMutex.lock();
+	  if (m_error.empty())
+	    m_error = e;
+	  m_errorMutex.unlock();
+	} catch (...) {
+	  m_errorMutex.lock();
+	  if (m_error.empty())
+	    m_error = "unknown exception in thread pool chunk";
+	  m_errorMutex.unlock();
+	}
+      }
+    }
+
+    void ThreadPool::
+    run(size_t n, size_t grain, Chunk *fn, void *arg)
+      throw (std::string) {
+      if (!n)
+	return;
+      if (!grain)
+	grain = defaultGrain(n);
+      size_t chunks = (n + grain - 1) / grain;
+      // Don't bother waking threads for a single chunk, and run a loop nested in one of
+      // our chunks in the thread running that chunk, since the pool is busy
+      if (chunks == 1 || m_threads.empty() || pthread_getspecific(s_runningKey) == this) {
+	for (size_t c = 0, begin = 0; c < chunks; c++, begin += grain)
+	  fn(arg, c, begin, begin + grain > n ? n : begin + grain);
+	return;
+      }
+      m_mutex.lock();
+      m_fn = fn;
+      m_arg = arg;
+      m_n = n;
+      m_grain = grain;
+      m_nChunks = chunks;
+      m_next = 0;
+      m_error.clear();
+      // Wake only as many threads as there are chunks beyond the caller's first
+      size_t nWake = chunks - 1 < m_threads.size() ? chunks - 1 : m_threads.size();
+      for (size_t t = 0; t < nWake; t++)
+	m_start.post();
+      void *outer = pthread_getspecific(s_runningKey);
+      pthread_setspecific(s_runningKey, this);
+      work();
+      pthread_setspecific(s_runningKey, outer);
+      for (size_t t = 0; t < nWake; t++)
+	m_done.wait();
+      std::string error = m_error;
+      m_mutex.unlock();
+      if (!error.empty())
+	throw error;
+    }
+  }
+}
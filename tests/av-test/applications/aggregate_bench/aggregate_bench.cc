@@ -0,0 +1,141 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measure the throughput of small messages sent through a worker in a remote container,
+ * so its output reaches this process over a transport connection, first as one message
+ * per transport buffer and then with the "aggregate" parameter on the worker's output.
+ * Messages are sent and received in the same loop, as fast as the connections allow.
+ *
+ * Usage: aggregate_bench <server-address> [<messages> [<message-bytes>]]
+ *   e.g. 127.0.0.1:17171 for a local ocpiserve.  The defaults are 100000 and 32.
+ */
+
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/time.h>
+#include "OcpiApi.hh"
+
+namespace OA = OCPI::API;
+
+static const char *appXml =
+  "<application>"
+  "  <instance component='accumulator' name='acc'/>"
+  "  <external instance='acc' port='in'/>"
+  "  <external instance='acc' port='out'/>"
+  "</application>";
+
+static double
+now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
+// Return the messages per second received, or zero with an error
+static double
+run(const char *server, const char *aggregate, unsigned nMessages, size_t size,
+    std::string &err) {
+  std::string container("acc=");
+  container += server;
+  container += "/rcc0";
+  OA::PValue params[] = {
+    OA::PVString("server", server),
+    OA::PVString("container", container.c_str()),
+    OA::PVString("aggregate", aggregate ? aggregate : ""),
+    OA::PVEnd
+  };
+  if (!aggregate)
+    params[2] = OA::PVEnd;
+  OA::Application app(appXml, params);
+  app.initialize();
+  OA::ExternalPort
+    &in = app.getPort("in"),
+    &out = app.getPort("out");
+  app.start();
+  unsigned nSent = 0, nReceived = 0;
+  double start = now(), progress = start;
+  while (nReceived < nMessages) {
+    OA::ExternalBuffer *b;
+    uint8_t *data, opCode;
+    size_t length;
+    bool end, moved = false;
+    if (nSent < nMessages && (b = in.getBuffer(data, length))) {
+      memset(data, 0, size);
+      ((uint32_t *)data)[0] = nSent++;
+      b->put(size);
+      moved = true;
+    }
+    if ((b = out.getBuffer(data, length, opCode, end))) {
+      if (length != size) {
+	err = "a message of the wrong length was received";
+	break;
+      }
+      b->release();
+      nReceived++;
+      moved = true;
+    }
+    double t = now();
+    if (moved)
+      progress = t;
+    else if (t - progress > 5) {
+      err = "no messages moved for 5 seconds";
+      break;
+    }
+  }
+  double elapsed = now() - start;
+  app.stop();
+  return err.empty() ? nMessages / elapsed : 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "Usage is: aggregate_bench <server-address> [<messages> [<bytes>]]\n");
+    return 1;
+  }
+  unsigned nMessages = argc > 2 ? (unsigned)atoi(argv[2]) : 100000;
+  size_t size = argc > 3 ? (size_t)atoi(argv[3]) : 32;
+  if (!nMessages || size < sizeof(uint32_t) || size % sizeof(uint32_t)) {
+    fprintf(stderr, "aggregate_bench: the message size must be a non-zero multiple of 4\n");
+    return 1;
+  }
+  try {
+    std::string err;
+    double
+      single = run(argv[1], NULL, nMessages, size, err),
+      aggregated = err.empty() ? run(argv[1], "acc=out=1000", nMessages, size, err) : 0;
+    if (err.size()) {
+      fprintf(stderr, "aggregate_bench FAILED: %s\n", err.c_str());
+      return 1;
+    }
+    printf("%u messages of %zu bytes:\n"
+	   "  one per buffer: %12.0f messages/s\n"
+	   "  aggregated:     %12.0f messages/s (%.1fx)\n",
+	   nMessages, size, single, aggregated, aggregated / single);
+    return 0;
+  } catch (std::string &e) {
+    fprintf(stderr, "aggregate_bench FAILED: exception: %s\n", e.c_str());
+  }
+  return 1;
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Send small messages through a worker in a remote container, so its output reaches
+ * this process over a transport connection, with the "aggregate" parameter on the
+ * worker's output port.  Each message received (unpacked from an aggregate) is forwarded
+ * to the worker's input with ExternalPort::put, and the output of both passes is checked.
+ *
+ * Usage: aggregate_test <server-address>, e.g. 127.0.0.1:17171 for a local ocpiserve
+ */
+
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "OcpiApi.hh"
+
+namespace OA = OCPI::API;
+
+static const char *appXml =
+  "<application>"
+  "  <instance component='accumulator' name='acc'/>"
+  "  <external instance='acc' port='in'/>"
+  "  <external instance='acc' port='out'/>"
+  "</application>";
+
+static const unsigned nMessages = 8, nValues = 4;
+
+static bool
+send(OA::ExternalPort &port, const uint32_t *values) {
+  OA::ExternalBuffer *b;
+  uint8_t *data;
+  size_t length;
+  for (unsigned n = 0; !(b = port.getBuffer(data, length)); n++) {
+    if (n >= 5000)
+      return false;
+    usleep(1000);
+  }
+  for (unsigned n = 0; n < nValues; n++)
+    ((uint32_t *)data)[n] = values[n];
+  b->put(nValues * sizeof(uint32_t));
+  return true;
+}
+
+// Receive a message, appending its values, and either release it or forward it
+static bool
+receive(OA::ExternalPort &port, std::vector<uint32_t> &values, OA::ExternalPort *forward) {
+  OA::ExternalBuffer *b;
+  uint8_t *data, opCode;
+  size_t length;
+  bool end;
+  for (unsigned n = 0; !(b = port.getBuffer(data, length, opCode, end)); n++) {
+    if (n >= 5000)
+      return false;
+    usleep(1000);
+  }
+  const uint32_t *p = (const uint32_t *)data;
+  values.insert(values.end(), p, p + length / sizeof(uint32_t));
+  if (forward)
+    forward->put(*b);
+  else
+    b->release();
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage is: aggregate_test <server-address>\n");
+    return 1;
+  }
+  try {
+    std::string container("acc=");
+    container += argv[1];
+    container += "/rcc0";
+    OA::PValue params[] = {
+      OA::PVString("server", argv[1]),
+      OA::PVString("container", container.c_str()),
+      OA::PVString("aggregate", "acc=out=100000"),
+      OA::PVEnd
+    };
+    OA::Application app(appXml, params);
+    app.initialize();
+    OA::ExternalPort
+      &in = app.getPort("in"),
+      &out = app.getPort("out");
+    app.start();
+    // The first pass sends counting values, and forwards the output back to the input
+    std::vector<uint32_t> input, first, second;
+    for (uint32_t n = 0; n < nMessages * nValues; n++)
+      input.push_back(n);
+    std::string err;
+    for (unsigned n = 0; err.empty() && n < nMessages; n++)
+      if (!send(in, &input[n * nValues]))
+	err = "timed out sending a message";
+    for (unsigned n = 0; err.empty() && n < nMessages; n++)
+      if (!receive(out, first, &in))
+	err = "timed out receiving or forwarding a message";
+    for (unsigned n = 0; err.empty() && n < nMessages; n++)
+      if (!receive(out, second, NULL))
+	err = "timed out receiving a forwarded message";
+    app.stop();
+    // The worker's output is the running sum of its input
+    std::vector<uint32_t> expected;
+    uint32_t sum = 0;
+    for (unsigned n = 0; n < input.size(); n++)
+      expected.push_back(sum += input[n]);
+    for (unsigned n = 0; n < input.size(); n++)
+      expected.push_back(sum += expected[n]);
+    first.insert(first.end(), second.begin(), second.end());
+    if (err.empty() && first != expected)
+      err = "the messages received are not the running sum of the messages sent";
+    if (err.size()) {
+      fprintf(stderr, "aggregate_test FAILED: %s\n", err.c_str());
+      return 1;
+    }
+    app.finish();
+    fprintf(stderr, "aggregate_test PASSED\n");
+    return 0;
+  } catch (std::string &e) {
+    fprintf(stderr, "aggregate_test FAILED: exception: %s\n", e.c_str());
+  }
+  return 1;
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Run an application twice with a warm reset (OA::Application::reset) between the runs,
+ * and check that the second run is not affected by the first:  the worker's own state,
+ * a property value changed during the first run, and output left unconsumed at the end
+ * of the first run must all be gone.
+ */
+
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "OcpiApi.hh"
+
+namespace OA = OCPI::API;
+
+static const char *appXml =
+  "<application>"
+  "  <instance component='accumulator' name='acc'>"
+  "    <property name='offset' value='1'/>"
+  "  </instance>"
+  "  <external instance='acc' port='in'/>"
+  "  <external instance='acc' port='out'/>"
+  "</application>";
+
+static const unsigned nMessages = 3, nValues = 4;
+
+// Send a message with the values first, first+1, ...
+static bool
+send(OA::ExternalPort &port, uint32_t first) {
+  OA::ExternalBuffer *b;
+  uint8_t *data;
+  size_t length;
+  for (unsigned n = 0; !(b = port.getBuffer(data, length)); n++) {
+    if (n >= 5000)
+      return false;
+    usleep(1000);
+  }
+  uint32_t *values = (uint32_t *)data;
+  for (unsigned n = 0; n < nValues; n++)
+    values[n] = first + n;
+  b->put(nValues * sizeof(uint32_t));
+  return true;
+}
+
+// Receive a message, appending its values
+static bool
+receive(OA::ExternalPort &port, std::vector<uint32_t> &values) {
+  OA::ExternalBuffer *b;
+  uint8_t *data, opCode;
+  size_t length;
+  bool end;
+  for (unsigned n = 0; !(b = port.getBuffer(data, length, opCode, end)); n++) {
+    if (n >= 5000)
+      return false;
+    usleep(1000);
+  }
+  const uint32_t *p = (const uint32_t *)data;
+  values.insert(values.end(), p, p + length / sizeof(uint32_t));
+  b->release();
+  return true;
+}
+
+// Run the application, collecting the output for the same input each time
+static std::string
+runOnce(OA::Application &app, OA::ExternalPort &in, OA::ExternalPort &out,
+	std::vector<uint32_t> &values, bool leaveOutput) {
+  std::string offset;
+  app.getProperty("acc", "offset", offset);
+  if (offset != "1")
+    return "the offset property is " + offset + " rather than its initial value of 1";
+  app.start();
+  for (unsigned n = 0; n < nMessages; n++)
+    if (!send(in, n * nValues) || !receive(out, values))
+      return "timed out sending or receiving a message";
+  if (leaveOutput) {
+    // Change the property, and leave a message for the reset to discard
+    app.setProperty("acc", "offset", "100");
+    if (!send(in, 0))
+      return "timed out sending the extra message";
+    usleep(100000);
+  }
+  app.stop();
+  return "";
+}
+
+int main(int, char **) {
+  try {
+    OA::Application app(appXml);
+    app.initialize();
+    OA::ExternalPort
+      &in = app.getPort("in"),
+      &out = app.getPort("out");
+    std::vector<uint32_t> first, second;
+    std::string err = runOnce(app, in, out, first, true);
+    if (err.empty()) {
+      app.reset();
+      err = runOnce(app, in, out, second, false);
+    }
+    if (err.empty() && first != second)
+      err = "the output after the reset is not the same as before it";
+    if (err.empty() && (first.size() != nMessages * nValues ||
+			first.back() != (nMessages * nValues) * (nMessages * nValues + 1) / 2))
+      err = "the output is not the running sum of the input";
+    if (err.size()) {
+      fprintf(stderr, "warm_reset_test FAILED: %s\n", err.c_str());
+      return 1;
+    }
+    app.finish();
+    fprintf(stderr, "warm_reset_test PASSED\n");
+    return 0;
+  } catch (std::string &e) {
+    fprintf(stderr, "warm_reset_test FAILED: exception: %s\n", e.c_str());
+  }
+  return 1;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The running sum is a member of the worker object, so it is only started again when the
+ * application is reset because initialize() clears it.
+ */
+
+#include "accumulator-worker.hh"
+
+using namespace OCPI::RCC; // for easy access to RCC data types and constants
+using namespace AccumulatorWorkerTypes;
+
+class AccumulatorWorker : public AccumulatorWorkerBase {
+  uint32_t m_sum;
+public:
+  AccumulatorWorker() : m_sum(0) {}
+private:
+  RCCResult initialize() {
+    m_sum = 0;
+    return RCC_OK;
+  }
+  RCCResult run(bool /*timedout*/) {
+    size_t n = in.length() / sizeof(uint32_t);
+    const uint32_t *x = (const uint32_t *)in.data();
+    uint32_t *y = (uint32_t *)out.data();
+    for (size_t i = 0; i < n; i++)
+      y[i] = m_sum += x[i] + properties().offset;
+    out.setLength(n * sizeof(uint32_t));
+    return RCC_ADVANCE;
+  }
+};
+
+ACCUMULATOR_START_INFO
+// Insert any static info assignments here (memSize, memSizes, portInfo)
+// e.g.: info.memSize = sizeof(MyMemoryStruct);
+ACCUMULATOR_END_INFO
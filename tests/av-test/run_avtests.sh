@@ -37,6 +37,31 @@ odev build application multislave_test
 echo Running the multislave_test application
 (cd applications/multislave_test &&
   OCPI_LIBRARY_PATH=../../:$OCPI_LIBRARY_PATH ./target-$OCPI_TARGET_DIR/multislave_test)
+echo Building the warm_reset_test application
+odev build application warm_reset_test
+echo Running the warm_reset_test application
+(cd applications/warm_reset_test &&
+  OCPI_LIBRARY_PATH=../../:$OCPI_LIBRARY_PATH ./target-$OCPI_TARGET_DIR/warm_reset_test)
+echo Building the aggregate_test application
+odev build application aggregate_test
+echo Running the aggregate_test application with a local server for the remote container
+(cd applications/aggregate_test &&
+  export OCPI_LIBRARY_PATH=../../:$OCPI_LIBRARY_PATH &&
+  artifacts=$(mktemp -d -t aggregate_test.XXXXX) &&
+  { $OCPI_CDK_DIR/$OCPI_TOOL_DIR/bin/ocpiserve -O -p 17171 -D $artifacts -r & } &&
+  server=$! && sleep 2 &&
+  ./target-$OCPI_TARGET_DIR/aggregate_test 127.0.0.1:17171; rc=$?;
+  kill $server; exit $rc)
+echo Building the aggregate_bench application
+odev build application aggregate_bench
+echo Measuring small message throughput with and without aggregation
+(cd applications/aggregate_bench &&
+  export OCPI_LIBRARY_PATH=../../:$OCPI_LIBRARY_PATH &&
+  artifacts=$(mktemp -d -t aggregate_bench.XXXXX) &&
+  { $OCPI_CDK_DIR/$OCPI_TOOL_DIR/bin/ocpiserve -O -p 17172 -D $artifacts -r & } &&
+  server=$! && sleep 2 &&
+  ./target-$OCPI_TARGET_DIR/aggregate_bench 127.0.0.1:17172; rc=$?;
+  kill $server; exit $rc)
 echo Building the aci_property_test_app application
 odev build application aci_property_test_app
 echo Running the aci_property_test_app application
@@ -0,0 +1,254 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "ezxml.h"
+#include "OcpiLibraryMetadataCache.h"
+
+namespace OL = OCPI::Library;
+
+namespace
+{
+  class TestOcpiLibraryMetadataCache : public ::testing::Test
+  {
+  protected:
+    std::string m_dir, m_cache;
+    void SetUp ( )
+    {
+      char dir[] = "/tmp/test-metadata-cache.XXXXXX";
+      ASSERT_TRUE( mkdtemp ( dir ) != NULL );
+      m_dir = dir;
+      m_cache = m_dir + "/cache";
+    }
+    void TearDown ( )
+    {
+      std::string cmd = "rm -rf " + m_dir;
+      EXPECT_EQ( 0, system ( cmd.c_str ( ) ) );
+    }
+    // Write a file, returning its name
+    std::string write ( const char *name, const std::string &contents )
+    {
+      std::string file = m_dir + "/" + name;
+      FILE *f = fopen ( file.c_str ( ), "w" );
+      EXPECT_TRUE( f != NULL );
+      if ( f )
+      {
+        fwrite ( contents.data ( ), contents.length ( ), 1, f );
+        fclose ( f );
+      }
+      return file;
+    }
+    std::vector<char> read ( )
+    {
+      std::vector<char> buf;
+      FILE *f = fopen ( m_cache.c_str ( ), "r" );
+      EXPECT_TRUE( f != NULL );
+      if ( f )
+      {
+        char c[4096];
+        size_t n;
+        while ( ( n = fread ( c, 1, sizeof ( c ), f ) ) )
+          buf.insert ( buf.end ( ), c, c + n );
+        fclose ( f );
+      }
+      return buf;
+    }
+    void rewrite ( const std::vector<char> &buf, size_t len )
+    {
+      FILE *f = fopen ( m_cache.c_str ( ), "w" );
+      ASSERT_TRUE( f != NULL );
+      if ( len )
+        fwrite ( &buf[0], len, 1, f );
+      fclose ( f );
+    }
+  };
+
+  const char metadata[] =
+    "<artifact uuid='1234' os='linux'><worker name='w1' language='c'>"
+    "<property name='p1' type='ulong'/></worker><worker name='w2'/>text</artifact>";
+
+  struct stat info ( const std::string &file )
+  {
+    struct stat s;
+    EXPECT_EQ( 0, stat ( file.c_str ( ), &s ) );
+    return s;
+  }
+
+  std::string xml ( ezxml_t x )
+  {
+    char *s = ezxml_toxml ( x );
+    std::string ret = s;
+    free ( s );
+    return ret;
+  }
+
+  // Fill a cache file with an artifact that has metadata and one that has none
+  void fill ( const std::string &cache, const std::string &withMeta,
+              const std::string &withoutMeta )
+  {
+    char *copy = strdup ( metadata );
+    ezxml_t x = ezxml_parse_str_arena ( copy, strlen ( copy ) );
+    OL::MetadataCache c ( cache.c_str ( ) );
+    c.add ( withMeta.c_str ( ), info ( withMeta ), 123, x );
+    c.add ( withoutMeta.c_str ( ), info ( withoutMeta ), 0, NULL );
+    c.save ( );
+    ezxml_free ( x );
+    free ( copy );
+  }
+
+  // Test 1: Entries saved are found by a later cache, until their files change
+  TEST_F( TestOcpiLibraryMetadataCache, test_1 )
+  {
+    std::string a = write ( "a", "artifact a" ), b = write ( "b", "artifact b" );
+    {
+      OL::MetadataCache c ( NULL );
+      EXPECT_FALSE( c.enabled ( ) );
+    }
+    {
+      OL::MetadataCache c ( m_cache.c_str ( ) ); // absent
+      ezxml_t x;
+      size_t metaLength;
+      EXPECT_TRUE( c.enabled ( ) );
+      EXPECT_FALSE( c.find ( info ( a ), x, metaLength ) );
+      c.save ( ); // nothing to save
+      EXPECT_NE( 0, access ( m_cache.c_str ( ), F_OK ) );
+    }
+    fill ( m_cache, a, b );
+    char *copy = strdup ( metadata );
+    ezxml_t parsed = ezxml_parse_str ( copy, strlen ( copy ) );
+    {
+      OL::MetadataCache c ( m_cache.c_str ( ) );
+      ezxml_t x = NULL;
+      size_t metaLength = 0;
+      ASSERT_TRUE( c.find ( info ( a ), x, metaLength ) );
+      ASSERT_TRUE( x != NULL );
+      EXPECT_EQ( 123u, metaLength );
+      EXPECT_EQ( xml ( parsed ), xml ( x ) );
+      EXPECT_STREQ( "1234", ezxml_cattr ( x, "UUID" ) );
+      EXPECT_STREQ( "w2", ezxml_attr ( ezxml_next ( ezxml_child ( x, "worker" ) ), "name" ) );
+      ezxml_free ( x );
+      EXPECT_TRUE( c.find ( info ( b ), x, metaLength ) );
+      EXPECT_TRUE( x == NULL );
+      EXPECT_FALSE( c.find ( info ( m_dir ), x, metaLength ) );
+      // A rewritten file is not found, and an unchanged one is kept by the next save
+      write ( "b", "artifact b, rewritten" );
+      EXPECT_FALSE( c.find ( info ( b ), x, metaLength ) );
+      std::string d = write ( "d", "artifact d" );
+      c.add ( d.c_str ( ), info ( d ), 0, NULL );
+      c.save ( );
+    }
+    {
+      OL::MetadataCache c ( m_cache.c_str ( ) );
+      ezxml_t x = NULL;
+      size_t metaLength = 0;
+      ASSERT_TRUE( c.find ( info ( a ), x, metaLength ) );
+      EXPECT_EQ( xml ( parsed ), xml ( x ) );
+      ezxml_free ( x );
+      EXPECT_FALSE( c.find ( info ( b ), x, metaLength ) );
+      EXPECT_TRUE( c.find ( info ( m_dir + "/d" ), x, metaLength ) );
+    }
+    ezxml_free ( parsed );
+    free ( copy );
+  }
+
+  // Test 2: Truncated caches, and caches with damaged headers, are refused and replaced
+  TEST_F( TestOcpiLibraryMetadataCache, test_2 )
+  {
+    std::string a = write ( "a", "artifact a" ), b = write ( "b", "artifact b" );
+    fill ( m_cache, a, b );
+    std::vector<char> good = read ( );
+    ASSERT_GT( good.size ( ), sizeof ( OL::MetadataCache::Header ) );
+    ezxml_t x;
+    size_t metaLength;
+    for ( size_t len = 0; len < good.size ( ); len++ )
+    {
+      rewrite ( good, len );
+      OL::MetadataCache c ( m_cache.c_str ( ) );
+      EXPECT_FALSE( c.find ( info ( a ), x, metaLength ) ) << "truncated to " << len;
+    }
+    OL::MetadataCache::Header h;
+    memcpy ( &h, &good[0], sizeof ( h ) );
+    for ( unsigned n = 0; n < 4; n++ )
+    {
+      std::vector<char> bad ( good );
+      OL::MetadataCache::Header &bh = *( OL::MetadataCache::Header* ) &bad[0];
+      switch ( n )
+      {
+        case 0: bh.magic++; break;
+        case 1: bh.version++; break;
+        case 2: bh.size--; break;
+        case 3: // more entries than fit
+          bh.nEntries = ( uint32_t ) ( ( h.size - sizeof ( h ) ) /
+                                       sizeof ( OL::MetadataCache::Entry ) + 1 );
+          break;
+      }
+      rewrite ( bad, bad.size ( ) );
+      OL::MetadataCache c ( m_cache.c_str ( ) );
+      EXPECT_FALSE( c.find ( info ( a ), x, metaLength ) ) << "header damage " << n;
+      // It is replaced by the next save
+      std::string d = write ( "d", "artifact d" );
+      c.add ( d.c_str ( ), info ( d ), 0, NULL );
+      c.save ( );
+      OL::MetadataCache c2 ( m_cache.c_str ( ) );
+      EXPECT_TRUE( c2.find ( info ( d ), x, metaLength ) ) << "header damage " << n;
+      EXPECT_FALSE( c2.find ( info ( a ), x, metaLength ) ) << "header damage " << n;
+    }
+  }
+
+  // Test 3: Entries whose images are outside the cache or damaged are not found
+  TEST_F( TestOcpiLibraryMetadataCache, test_3 )
+  {
+    std::string a = write ( "a", "artifact a" ), b = write ( "b", "artifact b" );
+    fill ( m_cache, a, b );
+    std::vector<char> good = read ( );
+    OL::MetadataCache::Header &h = *( OL::MetadataCache::Header* ) &good[0];
+    ASSERT_EQ( 2u, h.nEntries );
+    OL::MetadataCache::Entry *entries = ( OL::MetadataCache::Entry* ) ( &h + 1 ),
+      *e = entries[0].imageLength ? &entries[0] : &entries[1];
+    ezxml_t x;
+    size_t metaLength;
+    for ( unsigned n = 0; n < 4; n++ )
+    {
+      std::vector<char> bad ( good );
+      OL::MetadataCache::Entry &be =
+        *( OL::MetadataCache::Entry* ) ( &bad[0] + ( ( char* ) e - &good[0] ) );
+      switch ( n )
+      {
+        case 0: be.image = h.size + 8; break;
+        case 1: be.imageLength = h.size - be.image + 1; break;
+        case 2: be.imageLength--; break;
+        case 3: bad[be.image]++; break; // the image's magic number
+      }
+      rewrite ( bad, bad.size ( ) );
+      OL::MetadataCache c ( m_cache.c_str ( ) );
+      EXPECT_FALSE( c.find ( info ( a ), x, metaLength ) ) << "entry damage " << n;
+      // The entry for the file without metadata is still good
+      EXPECT_TRUE( c.find ( info ( b ), x, metaLength ) ) << "entry damage " << n;
+    }
+  }
+} // End: namespace<unnamed>
@@ -0,0 +1,137 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "cover.h"
+
+namespace
+{
+  class TestOcpigenCover : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // The full product of the values of the columns
+  std::vector<CoverRow> product ( const std::vector<CoverRow> &values )
+  {
+    std::vector<CoverRow> rows ( 1 );
+    for ( size_t c = 0; c < values.size ( ); c++ )
+    {
+      std::vector<CoverRow> next;
+      for ( size_t r = 0; r < rows.size ( ); r++ )
+        for ( size_t v = 0; v < values[c].size ( ); v++ )
+        {
+          next.push_back ( rows[r] );
+          next.back ( ).push_back ( values[c][v] );
+        }
+      rows.swap ( next );
+    }
+    return rows;
+  }
+
+  // Check that every combination of "strength" column values in any row is in a chosen row
+  void expectCovered ( const std::vector<CoverRow> &rows, const std::vector<bool> &chosen,
+                       size_t strength )
+  {
+    CoverTuples all, covered;
+    for ( size_t r = 0; r < rows.size ( ); r++ )
+    {
+      coverTuples ( rows[r], 0, strength, "", all );
+      if ( chosen[r] )
+        coverTuples ( rows[r], 0, strength, "", covered );
+    }
+    EXPECT_EQ( all, covered );
+  }
+
+  size_t count ( const std::vector<bool> &chosen )
+  {
+    size_t n = 0;
+    for ( size_t r = 0; r < chosen.size ( ); r++ )
+      n += chosen[r] ? 1 : 0;
+    return n;
+  }
+
+  TEST( TestOcpigenCover, test_1 ) // pairwise coverage of four binary properties
+  {
+    std::vector<CoverRow> values ( 4, CoverRow ( ) );
+    for ( size_t c = 0; c < values.size ( ); c++ )
+    {
+      values[c].push_back ( "0" );
+      values[c].push_back ( "1" );
+    }
+    std::vector<CoverRow> rows = product ( values );
+    ASSERT_EQ( 16u, rows.size ( ) );
+    std::vector<bool> chosen = coverRows ( rows, 2 );
+    ASSERT_EQ( rows.size ( ), chosen.size ( ) );
+    expectCovered ( rows, chosen, 2 );
+    // Each pair of columns has 4 value combinations, so at least 4 rows are needed
+    EXPECT_GE( count ( chosen ), 4u );
+    EXPECT_LE( count ( chosen ), 8u );
+    // Ties go to the earliest row
+    EXPECT_TRUE( chosen[0] );
+  }
+
+  TEST( TestOcpigenCover, test_2 ) // three-way coverage of mixed properties
+  {
+    std::vector<CoverRow> values ( 5, CoverRow ( ) );
+    const char *v[] = { "a", "b", "c" };
+    for ( size_t c = 0; c < values.size ( ); c++ )
+      values[c].assign ( v, v + ( c % 2 ? 2 : 3 ) );
+    std::vector<CoverRow> rows = product ( values );
+    ASSERT_EQ( 108u, rows.size ( ) );
+    std::vector<bool> chosen = coverRows ( rows, 3 );
+    expectCovered ( rows, chosen, 3 );
+    EXPECT_GE( count ( chosen ), 18u );
+    EXPECT_LT( count ( chosen ), rows.size ( ) );
+    // Pairwise needs no more rows than three-way
+    EXPECT_LE( count ( coverRows ( rows, 2 ) ), count ( chosen ) );
+  }
+
+  TEST( TestOcpigenCover, test_3 ) // combinations only occurring in pruned rows are not needed
+  {
+    std::vector<CoverRow> rows;
+    const char *r[][3] = { { "0", "0", "0" }, { "0", "1", "1" }, { "1", "0", "1" },
+                           { "1", "1", "0" }, { "1", "1", "1" } };
+    for ( size_t n = 0; n < 5; n++ )
+      rows.push_back ( CoverRow ( r[n], r[n] + 3 ) );
+    std::vector<bool> chosen = coverRows ( rows, 2 );
+    expectCovered ( rows, chosen, 2 );
+    // The first four rows cover all pairs, so the last is not chosen
+    EXPECT_EQ( 4u, count ( chosen ) );
+    EXPECT_FALSE( chosen[4] );
+  }
+
+  TEST( TestOcpigenCover, test_4 ) // strengths that leave every row
+  {
+    std::vector<CoverRow> values ( 3, CoverRow ( ) );
+    for ( size_t c = 0; c < values.size ( ); c++ )
+    {
+      values[c].push_back ( "x" );
+      values[c].push_back ( "y" );
+    }
+    std::vector<CoverRow> rows = product ( values );
+    EXPECT_EQ( rows.size ( ), count ( coverRows ( rows, 0 ) ) );
+    EXPECT_EQ( rows.size ( ), count ( coverRows ( rows, 3 ) ) );
+    EXPECT_EQ( rows.size ( ), count ( coverRows ( rows, 4 ) ) );
+    EXPECT_EQ( 0u, coverRows ( std::vector<CoverRow> ( ), 2 ).size ( ) );
+  }
+} // End: namespace<unnamed>
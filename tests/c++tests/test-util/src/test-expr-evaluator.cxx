@@ -0,0 +1,161 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "OcpiExprEvaluator.h"
+
+namespace OU = OCPI::Util;
+
+namespace
+{
+  class TestOcpiExprEvaluator : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // The value of an expression as a string, or the error
+  std::string eval ( const std::string &expr )
+  {
+    OU::ExprValue v;
+    std::string s;
+    const char *err = OU::evalExpression ( expr.c_str ( ), v );
+    if ( err )
+      return std::string ( "error: " ) + err;
+    v.getString ( s );
+    return s;
+  }
+
+  // The value of an expression whose result is an integer that fits in int64_t
+  int64_t number ( const std::string &expr )
+  {
+    OU::ExprValue v;
+    const char *err = OU::evalExpression ( expr.c_str ( ), v );
+    EXPECT_TRUE( err == NULL ) << "for " << expr << ": " << err;
+    EXPECT_TRUE( err || v.isNumber ( ) ) << "for " << expr;
+    return err ? 0 : v.getNumber ( );
+  }
+
+  // The operand as a GMP floating point value rather than an int64_t, by multiplying it
+  // by a literal that is not an integer
+  std::string gmp ( const std::string &operand )
+  {
+    return "(" + operand + " * 1.0)";
+  }
+
+  // Integer operands are evaluated with int64_t arithmetic unless that would overflow or
+  // be inexact.  The result must be the same as with GMP.
+  void expectSameAsGmp ( const std::string &a, const std::string &op, const std::string &b )
+  {
+    std::string fast = eval ( a + " " + op + " " + b );
+    EXPECT_EQ( eval ( gmp ( a ) + " " + op + " " + gmp ( b ) ), fast )
+      << "for " << a << " " << op << " " << b;
+    EXPECT_EQ( eval ( a + " " + op + " " + gmp ( b ) ), fast )
+      << "for " << a << " " << op << " " << b << " with only the right side in GMP";
+  }
+
+  // Operands with values near zero and at the int64_t limits.  Unary minus is only
+  // accepted at the start of an expression, so negative operands are differences.
+  const char *operands[] =
+  {
+    "0", "1", "2", "3", "7", "(0 - 1)", "(0 - 2)", "(0 - 7)", "2147483647", "2147483648",
+    "4294967295", "4294967296", "(0 - 2147483648)", "(0 - 2147483649)", "6442450944",
+    "4611686018427387904", "9223372036854775807", "(0 - 9223372036854775807)",
+    "(0 - 9223372036854775807 - 1)", NULL
+  };
+
+  // Results that do not fit in int64_t are formatted by GMP, in exponent notation
+  TEST( TestOcpiExprEvaluator, test_1 ) // overflow at the int64_t limits
+  {
+    EXPECT_EQ( INT64_MAX, number ( "9223372036854775806 + 1" ) );
+    EXPECT_EQ( INT64_MIN, number ( "0 - 9223372036854775807 - 1" ) );
+    EXPECT_EQ( "9.223372036854775808e18", eval ( "9223372036854775807 + 1" ) );
+    EXPECT_EQ( "-9.223372036854775809e18", eval ( "0 - 9223372036854775807 - 2" ) );
+    EXPECT_EQ( "1.8446744073709551614e19", eval ( "9223372036854775807 * 2" ) );
+    EXPECT_EQ( "9.223372036854775808e18", eval ( "0 - (0 - 9223372036854775807 - 1)" ) );
+    EXPECT_EQ( 4611686018427387904, number ( "2 ** 62" ) );
+    EXPECT_EQ( "9.223372036854775808e18", eval ( "2 ** 63" ) );
+    const char *ops[] = { "+", "-", "*", NULL };
+    for ( const char **a = operands; *a; a++ )
+      for ( const char **b = operands; *b; b++ )
+        for ( const char **op = ops; *op; op++ )
+          expectSameAsGmp ( *a, *op, *b );
+  }
+
+  TEST( TestOcpiExprEvaluator, test_2 ) // division and mod with negative operands
+  {
+    EXPECT_EQ( -4, number ( "(0 - 8) / 2" ) );
+    EXPECT_EQ( 4, number ( "(0 - 8) / (0 - 2)" ) );
+    // Inexact division is not integer division
+    EXPECT_EQ( "-3.5e0", eval ( "(0 - 7) / 2" ) );
+    EXPECT_EQ( "9.223372036854775808e18", eval ( "(0 - 9223372036854775807 - 1) / (0 - 1)" ) );
+    // Mod truncates toward zero, as in C
+    EXPECT_EQ( -1, number ( "(0 - 7) % 2" ) );
+    EXPECT_EQ( 1, number ( "7 % (0 - 2)" ) );
+    EXPECT_EQ( -1, number ( "(0 - 7) % (0 - 2)" ) );
+    EXPECT_EQ( 0, number ( "(0 - 9223372036854775807 - 1) % (0 - 1)" ) );
+    const char *ops[] = { "/", "%", NULL };
+    for ( const char **a = operands; *a; a++ )
+      for ( const char **b = operands; *b; b++ )
+        if ( strcmp ( *b, "0" ) )
+          for ( const char **op = ops; *op; op++ )
+            expectSameAsGmp ( *a, *op, *b );
+  }
+
+  TEST( TestOcpiExprEvaluator, test_3 ) // shifts and bitwise operators
+  {
+    EXPECT_EQ( 4611686018427387904, number ( "1 << 62" ) );
+    EXPECT_EQ( "9.223372036854775808e18", eval ( "1 << 63" ) );
+    EXPECT_EQ( "1.3835058055282163712e19", eval ( "3 << 62" ) );
+    EXPECT_EQ( -4611686018427387904, number ( "(0 - 1) << 62" ) );
+    // Right shifts of negative values round toward minus infinity
+    EXPECT_EQ( -4, number ( "(0 - 7) >> 1" ) );
+    EXPECT_EQ( -1, number ( "(0 - 1) >> 62" ) );
+    const char *counts[] = { "0", "1", "31", "32", "33", "61", "62", "63", "64", NULL };
+    for ( const char **a = operands; *a; a++ )
+      for ( const char **n = counts; *n; n++ )
+      {
+        expectSameAsGmp ( *a, "<<", *n );
+        expectSameAsGmp ( *a, ">>", *n );
+      }
+    const char *ops[] = { "&", "|", "^", NULL };
+    for ( const char **a = operands; *a; a++ )
+      for ( const char **b = operands; *b; b++ )
+        for ( const char **op = ops; *op; op++ )
+          expectSameAsGmp ( *a, *op, *b );
+  }
+
+  TEST( TestOcpiExprEvaluator, test_4 ) // int64_t values converted to GMP keep their low word
+  {
+    // Adding a fraction converts the integer to GMP
+    EXPECT_EQ( "2.1474836485e9", eval ( "2147483648 + 0.5" ) );
+    EXPECT_EQ( "4.2949672955e9", eval ( "4294967295 + 0.5" ) );
+    EXPECT_EQ( "6.4424509445e9", eval ( "0x180000000 + 0.5" ) );
+    EXPECT_EQ( "-2.1474836485e9", eval ( "(0 - 2147483648) - 0.5" ) );
+    EXPECT_EQ( "-1.5e0", eval ( "(0 - 1) - 0.5" ) );
+    EXPECT_EQ( "9.223372036854775807e18", eval ( "0x7fffffffffffffff * 1.0" ) );
+    EXPECT_EQ( "-9.223372036854775808e18", eval ( "(0 - 0x7fffffffffffffff - 1) * 1.0" ) );
+    for ( const char **a = operands; *a; a++ )
+      EXPECT_EQ( eval ( *a ), eval ( gmp ( *a ) ) ) << "for " << *a;
+  }
+} // End: namespace<unnamed>
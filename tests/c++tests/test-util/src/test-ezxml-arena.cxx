@@ -0,0 +1,212 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "OcpiOsThreadManager.h"
+#include "ezxml.h"
+
+namespace
+{
+  class TestEzxmlArena : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // Enough attributes and children on the top tag that the arena document indexes it
+  const unsigned N = 12;
+
+  std::string document ( )
+  {
+    std::string s = "<top";
+    for ( unsigned n = 0; n < N; n++ )
+      s += " a" + std::to_string ( n ) + "='v" + std::to_string ( n ) + "'";
+    s += " Mixed='m'>text";
+    for ( unsigned n = 0; n < N; n++ )
+      s += "<c" + std::to_string ( n ) + " x='" + std::to_string ( n ) + "'>t" +
+        std::to_string ( n ) + "</c" + std::to_string ( n ) + ">";
+    s += "<c3 x='again'/><Upper/><empty/>more</top>";
+    return s;
+  }
+
+  // A document parsed from its own copy of the text, which it keeps until it is freed
+  struct Doc
+  {
+    char *text;
+    ezxml_t xml;
+    Doc ( bool arena, const std::string &s = document ( ) )
+    {
+      text = strdup ( s.c_str ( ) );
+      xml = arena ? ezxml_parse_str_arena ( text, s.length ( ) )
+                  : ezxml_parse_str ( text, s.length ( ) );
+    }
+    ~Doc ( )
+    {
+      ezxml_free ( xml );
+      free ( text );
+    }
+  };
+
+  // The names looked up: all present, differently cased, and absent
+  const char *names[] =
+  {
+    "a0", "a7", "a11", "A3", "mixed", "MIXED", "Mixed", "x", "c0", "c3", "C5", "c11",
+    "upper", "Upper", "empty", "new", "none", NULL
+  };
+
+  std::string str ( const char *s )
+  {
+    return s ? std::string ( "'" ) + s + "'" : "NULL";
+  }
+
+  std::string tag ( ezxml_t x )
+  {
+    if ( !x )
+      return "NULL";
+    std::string s = std::string ( x->name ) + ":" + ezxml_txt ( x ) + ":" + str ( ezxml_attr ( x, "x" ) );
+    for ( x = ezxml_next ( x ); x; x = ezxml_next ( x ) )
+      s += std::string ( "," ) + str ( ezxml_attr ( x, "x" ) );
+    return s;
+  }
+
+  // Every lookup on a tag and its children, and its xml, as one string
+  std::string lookups ( ezxml_t x )
+  {
+    char *xml = ezxml_toxml ( x );
+    std::string s = xml;
+    free ( xml );
+    for ( ezxml_t t = x; t; t = t == x ? x->child : t->ordered )
+      for ( const char **n = names; *n; n++ )
+        s += std::string ( "\n" ) + *n + " " + str ( ezxml_attr ( t, *n ) ) + " " +
+          str ( ezxml_cattr ( t, *n ) ) + " " + tag ( ezxml_child ( t, *n ) ) + " " +
+          tag ( ezxml_cchild ( t, *n ) );
+    return s;
+  }
+
+  // Test 1: An arena document looks up and prints the same as a plain one
+  TEST( TestEzxmlArena, test_1 )
+  {
+    Doc plain ( false ), arena ( true );
+    ASSERT_TRUE( plain.xml && arena.xml );
+    EXPECT_STREQ( "", ezxml_error ( arena.xml ) );
+    EXPECT_EQ( lookups ( plain.xml ), lookups ( arena.xml ) );
+    // Again, now that the indexes are built
+    EXPECT_EQ( lookups ( plain.xml ), lookups ( arena.xml ) );
+  }
+
+  // Test 2: Setting, adding and removing attributes, including on a tag without any
+  TEST( TestEzxmlArena, test_2 )
+  {
+    Doc plain ( false ), arena ( true );
+    ezxml_t docs[] = { plain.xml, arena.xml };
+    std::string before = lookups ( arena.xml );
+    for ( unsigned d = 0; d < 2; d++ )
+    {
+      ezxml_t x = docs[d];
+      ezxml_set_attr ( x, "a7", "changed" );
+      ezxml_set_attr ( x, "a3", NULL );
+      ezxml_set_attr ( x, "new", "added" );
+      ezxml_set_attr_d ( ezxml_child ( x, "Upper" ), "x", "dup" );
+      ezxml_set_attr ( ezxml_child ( x, "c5" ), "x", NULL );
+    }
+    EXPECT_NE( before, lookups ( arena.xml ) );
+    EXPECT_EQ( lookups ( plain.xml ), lookups ( arena.xml ) );
+  }
+
+  // Test 3: The first attributes of tags without any, in a document with nothing else
+  // outside its arena, whose lists must still be freed with it
+  TEST( TestEzxmlArena, test_3 )
+  {
+    const std::string text = "<top a0='v0'><empty/><c0/></top>";
+    Doc plain ( false, text ), arena ( true, text );
+    ezxml_t docs[] = { plain.xml, arena.xml };
+    for ( unsigned d = 0; d < 2; d++ )
+    {
+      ezxml_set_attr ( ezxml_child ( docs[d], "empty" ), "new", "first" );
+      ezxml_set_attr ( ezxml_child ( docs[d], "empty" ), "x", "second" );
+      ezxml_set_attr ( ezxml_add_child ( docs[d], "new", 0 ), "x", "added" );
+    }
+    EXPECT_STREQ( "first", ezxml_attr ( ezxml_child ( arena.xml, "empty" ), "new" ) );
+    EXPECT_EQ( lookups ( plain.xml ), lookups ( arena.xml ) );
+  }
+
+  // Test 4: Adding, cutting and removing children
+  TEST( TestEzxmlArena, test_4 )
+  {
+    Doc plain ( false ), arena ( true );
+    ezxml_t docs[] = { plain.xml, arena.xml };
+    lookups ( arena.xml ); // build the indexes first
+    for ( unsigned d = 0; d < 2; d++ )
+    {
+      ezxml_t x = docs[d];
+      ezxml_set_attr ( ezxml_add_child ( x, "new", 2 ), "x", "child" );
+      ezxml_add_child ( x, "c3", 0 );
+      ezxml_remove ( ezxml_child ( x, "c0" ) );
+      ezxml_remove ( ezxml_child ( x, "c3" ) );
+      ezxml_t cut = ezxml_cut ( ezxml_child ( x, "c11" ) );
+      ASSERT_TRUE( cut != NULL );
+      ezxml_insert ( cut, ezxml_child ( x, "empty" ), 0 );
+    }
+    EXPECT_EQ( lookups ( plain.xml ), lookups ( arena.xml ) );
+  }
+
+  struct Lookups
+  {
+    ezxml_t xml;
+    const std::string *expected;
+    bool same;
+  };
+
+  void lookup_thread ( void* opaque )
+  {
+    Lookups &l = *static_cast<Lookups *> ( opaque );
+    for ( unsigned n = 0; n < 100; n++ )
+      l.same = l.same && lookups ( l.xml ) == *l.expected;
+  }
+
+  // Test 5: Threads looking up in a fresh arena document all build or use the same indexes
+  TEST( TestEzxmlArena, test_5 )
+  {
+    Doc plain ( false );
+    std::string expected = lookups ( plain.xml );
+    for ( unsigned n = 0; n < 20; n++ )
+    {
+      Doc arena ( true );
+      const unsigned nthreads = 4;
+      Lookups l[nthreads];
+      OCPI::OS::ThreadManager tm[nthreads];
+      for ( unsigned t = 0; t < nthreads; t++ )
+      {
+        l[t].xml = arena.xml;
+        l[t].expected = &expected;
+        l[t].same = true;
+        tm[t].start ( lookup_thread, &l[t] );
+      }
+      for ( unsigned t = 0; t < nthreads; t++ )
+      {
+        tm[t].join ( );
+        EXPECT_TRUE( l[t].same ) << "in thread " << t;
+      }
+    }
+  }
+} // End: namespace<unnamed>
@@ -0,0 +1,225 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "ezxml.h"
+
+namespace
+{
+  class TestEzxmlImage : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // The layout of an image, as ezxml.c writes it: a header, the tags, then the attribute
+  // table of unsigned words
+  struct Header
+  {
+    unsigned magic, version, ntags, nwords, size;
+  };
+  struct Tag
+  {
+    unsigned name, txt, attrs, parent, off;
+  };
+
+  const char text[] =
+    "<artifact uuid='1234' os='linux' arch='x86_64' a3='3' a4='4' a5='5' a6='6' a7='7' "
+    "a8='&lt;8&gt;'>"
+    "<worker name='w1' language='c'><property name='p1' type='ulong'/>"
+    "<property name='p2' type='string' stringlength='10'/><port name='in'/>text &amp; more"
+    "</worker><worker name='w2'/><Instance worker='w1'>inner</Instance><empty/>"
+    "<c0/><c1/><c2/><c3/><c4/><c5/><c6/><c7/><worker name='w3'/>tail</artifact>";
+
+  std::string str ( const char *s )
+  {
+    return s ? std::string ( "'" ) + s + "'" : "NULL";
+  }
+
+  // The xml of a document, and the lookups of each of its tags' attributes and children
+  std::string lookups ( ezxml_t x )
+  {
+    static const char *names[] =
+    {
+      "uuid", "os", "a8", "name", "type", "worker", "Worker", "property", "port",
+      "instance", "c7", "none", NULL
+    };
+    char *xml = ezxml_toxml ( x );
+    std::string s = xml;
+    free ( xml );
+    for ( ezxml_t t = x; t; t = t->child ? t->child : t->ordered ? t->ordered :
+            t->parent ? t->parent->ordered : NULL )
+      for ( const char **n = names; *n; n++ )
+      {
+        s += std::string ( "\n" ) + t->name + " " + *n + " " + str ( ezxml_attr ( t, *n ) ) +
+          " " + str ( ezxml_cattr ( t, *n ) );
+        for ( ezxml_t c = ezxml_child ( t, *n ); c; c = ezxml_next ( c ) )
+          s += " " + str ( ezxml_attr ( c, "name" ) );
+        for ( ezxml_t c = ezxml_cchild ( t, *n ); c; c = ezxml_cnext ( c ) )
+          s += " " + str ( ezxml_attr ( c, "name" ) );
+      }
+    return s;
+  }
+
+  // An image of the text, which must be freed
+  void *image ( size_t &len, bool arena )
+  {
+    char *copy = strdup ( text );
+    ezxml_t xml = arena ? ezxml_parse_str_arena ( copy, strlen ( copy ) )
+                        : ezxml_parse_str ( copy, strlen ( copy ) );
+    void *i = ezxml_image ( xml, &len );
+    ezxml_free ( xml );
+    free ( copy );
+    return i;
+  }
+
+  // Whether a damaged image is refused, and if not, that it can be used
+  bool refused ( const char *image, size_t len )
+  {
+    ezxml_t xml = ezxml_parse_image ( image, len );
+    if ( !xml )
+      return true;
+    lookups ( xml );
+    ezxml_free ( xml );
+    return false;
+  }
+
+  // Test 1: A document from an image looks up and prints the same as the parsed one
+  TEST( TestEzxmlImage, test_1 )
+  {
+    for ( unsigned arena = 0; arena < 2; arena++ )
+    {
+      char *copy = strdup ( text );
+      ezxml_t parsed = ezxml_parse_str ( copy, strlen ( copy ) );
+      size_t len = 0;
+      void *i = image ( len, arena );
+      ASSERT_TRUE( i != NULL );
+      EXPECT_EQ( 0u, len % sizeof ( unsigned ) );
+      ezxml_t xml = ezxml_parse_image ( i, len );
+      ASSERT_TRUE( xml != NULL );
+      EXPECT_STREQ( "", ezxml_error ( xml ) );
+      EXPECT_EQ( lookups ( parsed ), lookups ( xml ) );
+      // An image of the image is the same
+      size_t len2 = 0;
+      void *i2 = ezxml_image ( xml, &len2 );
+      ASSERT_TRUE( i2 != NULL );
+      EXPECT_EQ( len, len2 );
+      EXPECT_EQ( 0, memcmp ( i, i2, len ) );
+      free ( i2 );
+      ezxml_free ( xml );
+      free ( i );
+      ezxml_free ( parsed );
+      free ( copy );
+    }
+  }
+
+  // Test 2: Documents that do not keep are not imaged
+  TEST( TestEzxmlImage, test_2 )
+  {
+    char pi[] = "<?xml-stylesheet href='x'?><a/>", bad[] = "<a><b></a>";
+    size_t len = 0;
+    ezxml_t xml = ezxml_parse_str ( pi, strlen ( pi ) );
+    EXPECT_TRUE( ezxml_image ( xml, &len ) == NULL );
+    ezxml_free ( xml );
+    xml = ezxml_parse_str ( bad, strlen ( bad ) );
+    EXPECT_TRUE( ezxml_image ( xml, &len ) == NULL );
+    ezxml_free ( xml );
+    EXPECT_TRUE( ezxml_image ( NULL, &len ) == NULL );
+  }
+
+  // Test 3: Truncated images, and images with a damaged header, are refused
+  TEST( TestEzxmlImage, test_3 )
+  {
+    size_t len = 0;
+    char *i = ( char* ) image ( len, false );
+    ASSERT_TRUE( i != NULL );
+    for ( size_t l = 0; l < len; l++ )
+      EXPECT_TRUE( refused ( i, l ) ) << "truncated to " << l;
+    EXPECT_TRUE( ezxml_parse_image ( i, len + 1 ) == NULL );
+    unsigned Header::*fields[] =
+      { &Header::magic, &Header::version, &Header::ntags, &Header::nwords, &Header::size };
+    for ( unsigned f = 0; f < sizeof ( fields ) / sizeof ( fields[0] ); f++ )
+    {
+      Header &h = *( Header* ) i;
+      unsigned save = h.*fields[f];
+      unsigned values[] = { 0, save + 1, save * 4096, ~0u };
+      for ( unsigned v = 0; v < sizeof ( values ) / sizeof ( values[0] ); v++ )
+      {
+        h.*fields[f] = values[v];
+        if ( fields[f] != &Header::nwords || values[v] > save )
+          EXPECT_TRUE( refused ( i, len ) ) << "header field " << f << " is " << values[v];
+        else
+          refused ( i, len ); // a shorter attribute table leaves the tags valid
+      }
+      h.*fields[f] = save;
+    }
+    i[len - 1] = 'x'; // the last string does not end
+    EXPECT_TRUE( refused ( i, len ) );
+    free ( i );
+  }
+
+  // Test 4: Images with offsets outside the image or a damaged tree are refused, and no
+  // single damaged byte makes a document that cannot be used
+  TEST( TestEzxmlImage, test_4 )
+  {
+    size_t len = 0;
+    char *i = ( char* ) image ( len, false );
+    ASSERT_TRUE( i != NULL );
+    Header &h = *( Header* ) i;
+    Tag *tags = ( Tag* ) ( &h + 1 );
+    unsigned *words = ( unsigned* ) ( tags + h.ntags );
+    unsigned Tag::*fields[] = { &Tag::name, &Tag::txt, &Tag::attrs, &Tag::parent };
+    unsigned bad[] = { ( unsigned ) len, h.nwords + 1, 1 };
+    for ( unsigned f = 0; f < sizeof ( fields ) / sizeof ( fields[0] ); f++ )
+    {
+      unsigned save = tags[1].*fields[f];
+      tags[1].*fields[f] = bad[f < 2 ? 0 : f - 1];
+      EXPECT_TRUE( refused ( i, len ) ) << "tag field " << f;
+      tags[1].*fields[f] = save;
+    }
+    tags[0].name = 0; // a name without room for its hash
+    EXPECT_TRUE( refused ( i, len ) );
+    tags[0].name = tags[1].name + 1; // a name whose hash is not aligned
+    EXPECT_TRUE( refused ( i, len ) );
+    tags[0].name = tags[1].name;
+    unsigned save = words[0];
+    words[0] = h.nwords; // more attributes than the table holds
+    EXPECT_TRUE( refused ( i, len ) );
+    words[0] = save;
+    save = words[1];
+    words[1] = ( unsigned ) len;
+    EXPECT_TRUE( refused ( i, len ) );
+    words[1] = 0;
+    EXPECT_TRUE( refused ( i, len ) );
+    words[1] = save;
+    ASSERT_FALSE( refused ( i, len ) );
+    for ( size_t b = 0; b < len; b++ )
+      for ( unsigned bit = 0; bit < 8; bit++ )
+      {
+        i[b] = ( char ) ( i[b] ^ ( 1 << bit ) );
+        refused ( i, len );
+        i[b] = ( char ) ( i[b] ^ ( 1 << bit ) );
+      }
+    free ( i );
+  }
+} // End: namespace<unnamed>
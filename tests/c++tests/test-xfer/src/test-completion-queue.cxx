@@ -0,0 +1,129 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "XferServices.h"
+
+namespace XF = DataTransfer;
+
+namespace
+{
+  class TestXferCompletionQueue : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // A request whose driver either reports completion during the post, or only when
+  // asked, and which completes when the test says so.
+  class Request : public XF::XferRequest
+  {
+  public:
+    bool m_signals, m_done;
+    unsigned m_nPolls;
+    Request ( bool signals = false )
+      : m_signals ( signals ), m_done ( false ), m_nPolls ( 0 )
+    {
+      // Empty
+    }
+    using XF::XferRequest::post;
+    void post ( )
+    {
+      m_done = false;
+    }
+    CompletionStatus getStatus ( )
+    {
+      m_nPolls++;
+      return m_done ? CompleteSuccess : Pending;
+    }
+    void finish ( )
+    {
+      m_done = true;
+      if ( m_signals )
+        completed ( );
+    }
+  };
+
+  TEST( TestXferCompletionQueue, test_1 ) // signalled completions are reaped without polling
+  {
+    XF::XferCompletionQueue q;
+    Request a ( true ), b ( true );
+    std::vector<XF::XferRequest *> done;
+    a.post ( q );
+    b.post ( q );
+    EXPECT_EQ( 2u, q.nPolled ( ) );
+    b.finish ( );
+    a.finish ( );
+    EXPECT_EQ( 0u, q.nPolled ( ) );
+    unsigned polls = a.m_nPolls + b.m_nPolls;
+    EXPECT_EQ( 2u, q.reap ( done ) );
+    EXPECT_EQ( polls, a.m_nPolls + b.m_nPolls );
+    ASSERT_EQ( 2u, done.size ( ) );
+    EXPECT_EQ( &b, done[0] );
+    EXPECT_EQ( &a, done[1] );
+    EXPECT_EQ( 0u, q.reap ( done ) );
+  }
+
+  TEST( TestXferCompletionQueue, test_2 ) // a pending request is rotated, not rescanned
+  {
+    XF::XferCompletionQueue q;
+    Request a, b, c;
+    std::vector<XF::XferRequest *> done;
+    a.post ( q );
+    b.post ( q );
+    c.post ( q );
+    a.m_nPolls = b.m_nPolls = c.m_nPolls = 0;
+    EXPECT_EQ( 0u, q.reap ( done ) );
+    EXPECT_EQ( 1u, a.m_nPolls + b.m_nPolls + c.m_nPolls );
+    c.finish ( );
+    b.finish ( );
+    // b then c are found, and a, polled again, is still pending
+    EXPECT_EQ( 2u, q.reap ( done ) );
+    EXPECT_EQ( 1u, q.nPolled ( ) );
+    a.finish ( );
+    EXPECT_EQ( 1u, q.reap ( done ) );
+    ASSERT_EQ( 3u, done.size ( ) );
+    EXPECT_EQ( &a, done[2] );
+    EXPECT_EQ( 0u, q.nPolled ( ) );
+  }
+
+  TEST( TestXferCompletionQueue, test_3 ) // reposting or deleting unlinks a request
+  {
+    XF::XferCompletionQueue q;
+    Request a ( true );
+    std::vector<XF::XferRequest *> done;
+    a.post ( q );
+    a.finish ( );
+    a.post ( q ); // the earlier completion is superseded
+    EXPECT_EQ( 0u, q.reap ( done ) );
+    EXPECT_TRUE( a.pending ( ) );
+    {
+      Request b;
+      b.post ( q );
+      EXPECT_EQ( 2u, q.nPolled ( ) );
+    }
+    EXPECT_EQ( 1u, q.nPolled ( ) );
+    a.finish ( );
+    EXPECT_EQ( 1u, q.reap ( done ) );
+    EXPECT_EQ( &a, done[0] );
+  }
+
+} // End: namespace<unnamed>
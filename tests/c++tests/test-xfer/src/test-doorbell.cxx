@@ -0,0 +1,100 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include "gtest/gtest.h"
+
+#include "OcpiOsTimer.h"
+#include "XferEvent.h"
+
+namespace XF = DataTransfer;
+namespace OS = OCPI::OS;
+
+namespace
+{
+  class TestXferDoorbell : public ::testing::Test
+  {
+    // Empty
+  };
+
+  // Fork a process that rings this process's doorbell after a while, through the
+  // doorbell's file as the shm transfer driver does.  Return its pid.
+  pid_t ringLater ( unsigned usecs )
+  {
+    int fd;
+    XF::Doorbell::local ( &fd );
+    pid_t parent = getpid ( ), child = fork ( );
+    if ( child == 0 )
+    {
+      usleep ( usecs );
+      XF::Doorbell *db = XF::Doorbell::remote ( parent, fd );
+      if ( db )
+        db->ring ( );
+      _exit ( db ? 0 : 1 );
+    }
+    return child;
+  }
+
+  // Return the exit status of the ringing process
+  int ringerStatus ( pid_t pid )
+  {
+    int status;
+    if ( waitpid ( pid, &status, 0 ) != pid || !WIFEXITED ( status ) )
+      return -1;
+    return WEXITSTATUS ( status );
+  }
+
+  TEST( TestXferDoorbell, test_1 ) // a ring from another process wakes waitForEvent
+  {
+    int fd;
+    XF::Doorbell::local ( &fd );
+    ASSERT_GE( fd, 0 ) << "this system has no shareable doorbells";
+    XF::EventManager em ( 0, 0 );
+    em.arm ( );
+    EXPECT_EQ( XF::EventTimeout, em.waitForEvent ( 100 ) );
+    pid_t pid = ringLater ( 50000 );
+    ASSERT_GT( pid, 0 );
+    XF::ReturnStatus rs = XF::EventTimeout;
+    OS::Timer timer;
+    while ( rs == XF::EventTimeout && timer.getElapsed ( ).seconds ( ) < 5 )
+      rs = em.waitForEvent ( 0 );
+    EXPECT_EQ( XF::EventSuccess, rs );
+    EXPECT_EQ( 0, ringerStatus ( pid ) );
+    // Once the event is seen and the manager is armed again, it waits again
+    em.arm ( );
+    EXPECT_EQ( XF::EventTimeout, em.waitForEvent ( 100 ) );
+  }
+
+  TEST( TestXferDoorbell, test_2 ) // a waiter sleeping in the doorbell is woken at once
+  {
+    int fd;
+    XF::Doorbell &db = XF::Doorbell::local ( &fd );
+    ASSERT_GE( fd, 0 ) << "this system has no shareable doorbells";
+    uint32_t snapshot = db.m_sequence;
+    pid_t pid = ringLater ( 50000 );
+    ASSERT_GT( pid, 0 );
+    OS::Timer timer;
+    EXPECT_TRUE( db.wait ( snapshot, 10000000 ) );
+    // Much less than the 10 second timeout: it was the ring that ended the wait
+    EXPECT_LT( timer.getElapsed ( ).seconds ( ), 2u );
+    EXPECT_EQ( 0, ringerStatus ( pid ) );
+  }
+} // End: namespace<unnamed>
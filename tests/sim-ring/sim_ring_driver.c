@@ -0,0 +1,174 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The server side of the sim ring regression (see the Makefile).
+ * It creates and initializes the ring file as HdlLSimDevice.cxx does, runs the
+ * simulator given on the command line with the ring file in its environment, and then:
+ *   - gives it spin credits and waits for the ack,
+ *   - sends request dwords with DCP credits and checks they come back on the response
+ *     ring, going around the rings several times,
+ *   - tells it to terminate and checks that it exits cleanly.
+ * Every wait is bounded, and checks that the simulator is still running.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "HdlSimRing.h"
+
+#define TIMEOUT_SECS 30
+#define ROUND_DWORDS 1000  /* dwords per DCP credit */
+#define ROUNDS 50          /* enough to wrap the 64KB rings three times */
+
+static pid_t sim;
+static int simStatus, simExited;
+
+static void fail(const char *msg) __attribute__((noreturn));
+static void
+fail(const char *msg) {
+  fprintf(stderr, "sim_ring_driver: FAILED: %s\n", msg);
+  if (sim && !simExited)
+    kill(sim, SIGKILL);
+  exit(1);
+}
+
+static double
+now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Wait a bit for the simulator, failing if it has exited or has not moved for too long */
+static void
+simWait(unsigned *n, double start, const char *what) {
+  if (++*n < 1000)
+    return;
+  sched_yield();
+  if (*n & 0x3ff)
+    return;
+  if (!simExited && waitpid(sim, &simStatus, WNOHANG) == sim)
+    simExited = 1;
+  if (simExited)
+    fail(what);
+  if (now() - start > TIMEOUT_SECS)
+    fail("timed out waiting for the simulator");
+}
+
+static void
+put(OcpiSimRing *r, const uint8_t *data, size_t length) {
+  double start = now();
+  for (unsigned n = 0; length; ) {
+    size_t put = ocpiSimRingPut(r, data, length);
+    if (put) {
+      data += put;
+      length -= put;
+      n = 0;
+      start = now();
+    } else
+      simWait(&n, start, "simulator exited when the server was writing");
+  }
+}
+
+static void
+get(OcpiSimRing *r, uint8_t *data, size_t length) {
+  double start = now();
+  for (unsigned n = 0; length; ) {
+    size_t got = ocpiSimRingGet(r, data, length);
+    if (got) {
+      data += got;
+      length -= got;
+      n = 0;
+      start = now();
+    } else
+      simWait(&n, start, "simulator exited when the server was reading");
+  }
+}
+
+int
+main(int argc, char **argv) {
+  char dir[] = "/tmp/sim_ring_XXXXXX", name[sizeof(dir) + sizeof(OCPI_SIM_RING_FILE) + 1];
+  OcpiSimRings *rings;
+  int fd;
+  void *p;
+  if (argc < 2) {
+    fprintf(stderr, "Usage: sim_ring_driver <simulator> [<args>...]\n");
+    return 1;
+  }
+  if (!mkdtemp(dir))
+    fail("cannot create the simulation directory");
+  snprintf(name, sizeof(name), "%s/%s", dir, OCPI_SIM_RING_FILE);
+  if ((fd = open(name, O_RDWR | O_CREAT | O_EXCL, 0666)) < 0 ||
+      ftruncate(fd, sizeof(OcpiSimRings)) ||
+      (p = mmap(NULL, sizeof(OcpiSimRings), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0)) ==
+      MAP_FAILED)
+    fail("cannot create the ring file");
+  close(fd);
+  rings = (OcpiSimRings *)p;
+  ocpiSimRingsInit(rings, (int32_t)getpid());
+  setenv(OCPI_SIM_RING_ENV, name, 1);
+  switch ((sim = fork())) {
+  case -1:
+    fail("cannot fork");
+  case 0:
+    execvp(argv[1], argv + 1);
+    perror("sim_ring_driver: cannot run the simulator");
+    _exit(1);
+  }
+  uint8_t spin[2] = { 0, 20 }, ack;
+  put(&rings->rings[OCPI_SIM_RING_CONTROL], spin, sizeof(spin));
+  get(&rings->rings[OCPI_SIM_RING_ACK], &ack, 1);
+  if (ack != '1')
+    fail("bad ack from the simulator");
+  static uint32_t out[ROUND_DWORDS], in[ROUND_DWORDS];
+  for (unsigned round = 0, v = 0; round < ROUNDS; round++) {
+    uint8_t credit[3] = { 1, ROUND_DWORDS & 0xff, ROUND_DWORDS >> 8 };
+    for (unsigned i = 0; i < ROUND_DWORDS; i++)
+      out[i] = v++ * 2654435761u;
+    put(&rings->rings[OCPI_SIM_RING_REQUEST], (uint8_t *)out, sizeof(out));
+    put(&rings->rings[OCPI_SIM_RING_CONTROL], credit, sizeof(credit));
+    get(&rings->rings[OCPI_SIM_RING_RESPONSE], (uint8_t *)in, sizeof(in));
+    if (memcmp(in, out, sizeof(in)))
+      fail("response data does not match the request data");
+  }
+  uint8_t terminate = 255;
+  put(&rings->rings[OCPI_SIM_RING_CONTROL], &terminate, 1);
+  for (double start = now(); !simExited; usleep(1000))
+    if (waitpid(sim, &simStatus, WNOHANG) == sim)
+      simExited = 1;
+    else if (now() - start > TIMEOUT_SECS)
+      fail("simulator did not exit when told to");
+  munmap(p, sizeof(OcpiSimRings));
+  unlink(name);
+  rmdir(dir);
+  if (!WIFEXITED(simStatus) || WEXITSTATUS(simStatus))
+    fail("simulator did not exit cleanly");
+  printf("sim_ring_driver: PASSED: %u bytes looped back through the rings\n",
+	 ROUNDS * ROUND_DWORDS * 4);
+  return 0;
+}
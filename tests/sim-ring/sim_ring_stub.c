@@ -0,0 +1,77 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The loopback simulator of sim_ring_tb.vhd, in C, for when GHDL is not available.
+ * It uses the rings only through the functions in sim_ring.c, as the VHDL does.
+ */
+#include <stdio.h>
+#include <unistd.h>
+
+int ocpi_sim_ring_open(void);
+int ocpi_sim_ring_read(int ring);
+int ocpi_sim_ring_write(int ring, int c);
+
+enum { REQUEST, RESPONSE, CONTROL, ACK };
+
+static int
+read_byte(int ring) {
+  int c = ocpi_sim_ring_read(ring);
+  if (c < 0) {
+    fprintf(stderr, "sim_ring_stub: simulation server is gone\n");
+    _exit(1);
+  }
+  return c;
+}
+
+static void
+write_byte(int ring, int c) {
+  if (!ocpi_sim_ring_write(ring, c)) {
+    fprintf(stderr, "sim_ring_stub: simulation server is gone when writing\n");
+    _exit(1);
+  }
+}
+
+int
+main(void) {
+  if (ocpi_sim_ring_open())
+    return 1;
+  for (;;)
+    switch (read_byte(CONTROL)) {
+    case 0:
+      if (read_byte(CONTROL) >= 3)
+	write_byte(ACK, '1');
+      break;
+    case 1:
+      {
+	unsigned count = (unsigned)read_byte(CONTROL);
+	count += (unsigned)read_byte(CONTROL) * 256;
+	for (count *= 4; count; count--)
+	  write_byte(RESPONSE, read_byte(REQUEST));
+      }
+      break;
+    case 255:
+      printf("sim_ring_stub: end of simulation\n");
+      return 0;
+    default:
+      fprintf(stderr, "sim_ring_stub: unknown control byte\n");
+      return 1;
+    }
+}
@@ -0,0 +1,69 @@
+-- This file is protected by Copyright. Please refer to the COPYRIGHT file
+-- distributed with this source distribution.
+--
+-- This file is part of OpenCPI <http://www.opencpi.org>
+--
+-- OpenCPI is free software: you can redistribute it and/or modify it under the
+-- terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+-- A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+-- details.
+--
+-- You should have received a copy of the GNU Lesser General Public License
+-- along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+-- A simulator for the sim ring regression: it follows the control protocol of sdp_sim,
+-- but instead of an SDP it loops the request ring back to the response ring.
+--   0 <n>        spin credit: ack with '1' when there are at least 3 spins as sdp_sim does
+--   1 <lo> <hi>  DCP credit: copy that many dwords from the request to the response ring
+--   255          end of the simulation
+-- It uses the rings only through sim_ring_pkg, as the "ring" architecture of sdp_sim does.
+use work.sim_ring_pkg.all;
+entity sim_ring_tb is
+end entity sim_ring_tb;
+architecture loopback of sim_ring_tb is
+begin
+  process is
+    impure function read_byte(ring : integer) return natural is
+      variable data : integer := ring_read(ring);
+    begin
+      assert data >= 0 report "Simulation server is gone" severity failure;
+      return data;
+    end read_byte;
+    procedure write_byte(ring : integer; byte : natural) is
+    begin
+      assert ring_write(ring, byte) = 1 report "Simulation server is gone when writing"
+        severity failure;
+    end write_byte;
+    variable control : natural;
+    variable count   : natural;
+  begin
+    assert ring_open = 0 report "Cannot open the simulation server's rings" severity failure;
+    loop
+      control := read_byte(ring_control_c);
+      case control is
+        when 0 =>
+          if read_byte(ring_control_c) >= 3 then
+            write_byte(ring_ack_c, character'pos('1'));
+          end if;
+        when 1 =>
+          count := read_byte(ring_control_c);
+          count := count + read_byte(ring_control_c) * 256;
+          for i in 1 to count * 4 loop
+            write_byte(ring_response_c, read_byte(ring_request_c));
+          end loop;
+        when 255 =>
+          exit;
+        when others =>
+          report "unknown control byte" severity failure;
+      end case;
+      wait for 1 ns;
+    end loop;
+    report "End of simulation.";
+    wait;
+  end process;
+end architecture loopback;
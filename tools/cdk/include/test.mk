@@ -35,6 +35,7 @@ endif
 export Cases
 export KeepSimulations
 export TestTimeout
+export TestParallel
 include $(OCPI_CDK_DIR)/include/util.mk
 
 ifneq ($(Model),test)
@@ -208,6 +209,8 @@ The following variables can be set, usually on the command line:
   Cases                - set to specific cases, including wildcards for execute and/or verify
   KeepSimulations      - set to 1 to preserve simulation outputs rather than delete on success
   TestTimeout          - set to number of seconds to limit execution for any case
+  TestParallel         - set to the number of software (rcc) cases to execute at once,
+                         or 0 for the number of processors
   OnlyPlatforms        - set to platforms to run tests on, rather than those available
   View                 - set to 1 to enable the "view" script during verify
   TestApplications     - set to C++ programs to build (set only in the Makefile)
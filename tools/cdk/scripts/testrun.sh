@@ -50,6 +50,33 @@ ports=($*)
                    ./run.sh run remote
     exit $?
 }
+# Cases for software (rcc) workers run concurrently, up to TestParallel at a time, when it
+# is more than 1, or up to the number of processors when it is 0.  Cases for other models
+# run one at a time since they use the platform's devices.  Each concurrent case's console
+# output is shown when it is done, in the order the cases were started.
+parallel=${TestParallel:-1}
+[ "$parallel" = 0 ] && parallel=$(nproc 2>/dev/null || echo 1)
+[ -n "$remote" -o -x runremote.sh ] && parallel=1
+pids=()
+logs=()
+# Wait for the oldest running case and account for its result
+function waitcase {
+  wait ${pids[0]}
+  local r=$?
+  cat ${logs[0]} 1>&2
+  rm -f ${logs[0]}
+  pids=(${pids[@]:1})
+  logs=(${logs[@]:1})
+  [ $r = 0 ] && return 0
+  failed=1
+  [ "$TestAccumulateErrors" = 1 -a $r != 130 ] && return 0
+  wait
+  exit $r
+}
+# Wait for all running cases
+function waitcases {
+  while [ ${#pids[@]} != 0 ]; do waitcase; done
+}
 # docase <model> <worker> <case> <subcase> <timeout> <duration>
 function docase {
   [ -z "$Cases" ] || {
@@ -69,6 +96,19 @@ function docase {
     $tput sgr0 2>/dev/null
     echo ".  Functions are: $run $verify $view"
   } 1>&2
+  if [ "$parallel" -gt 1 -a "$1" = rcc ]; then
+    while [ ${#pids[@]} -ge $parallel ]; do waitcase; done
+    local log=.$3.$4.$2.$1.console # not removed by runcase, which removes $3.$4.$2.$1.*
+    (failed=0; runcase "$@"; exit $failed) > $log 2>&1 &
+    pids+=($!)
+    logs+=($log)
+  else
+    waitcases
+    runcase "$@"
+  fi
+}
+# runcase <model> <worker> <case> <subcase> <timeout> <duration>
+function runcase {
   r=0
   [ -z "$run" ] || {
     local output outputs timearg
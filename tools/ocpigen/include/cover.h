@@ -0,0 +1,91 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file
+ * distributed with this source distribution.
+ *
+ * This file is part of OpenCPI <http://www.opencpi.org>
+ *
+ * OpenCPI is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * OpenCPI is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _COVER_H_
+#define _COVER_H_
+#include <vector>
+#include <set>
+#include <string>
+#include <cstdio>
+
+// Covering arrays for the subcases of unit tests.
+// Rows are subcases and columns are swept properties: rows[r][c] is the value of
+// property c in subcase r.  A covering array of strength t is a subset of the rows in
+// which every combination of values of any t columns that occurs in some row still
+// occurs in at least one chosen row.
+
+typedef std::vector<std::string> CoverRow;
+typedef std::set<std::string> CoverTuples;
+
+// Add the keys for the combinations of "left" columns, from "first" on, in a row
+inline void
+coverTuples(const CoverRow &row, size_t first, size_t left, const std::string &prefix,
+            CoverTuples &tuples) {
+  if (!left) {
+    tuples.insert(prefix);
+    return;
+  }
+  for (size_t n = first; n + left <= row.size(); n++) {
+    std::string key(prefix);
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%zu=", n);
+    key += buf;
+    key += row[n];
+    key += ';';
+    coverTuples(row, n + 1, left - 1, key, tuples);
+  }
+}
+
+// Choose the rows of a covering array of the given strength, greedily: the row covering
+// the most remaining combinations first, the earliest row when there is a tie.
+// Return which rows are chosen.  A strength of zero, or not less than the number of
+// columns, chooses all the rows.
+inline std::vector<bool>
+coverRows(const std::vector<CoverRow> &rows, size_t strength) {
+  std::vector<bool> chosen(rows.size(), true);
+  if (!strength || rows.empty() || strength >= rows[0].size())
+    return chosen;
+  std::vector<CoverTuples> tuples(rows.size());
+  CoverTuples uncovered;
+  for (size_t r = 0; r < rows.size(); r++) {
+    coverTuples(rows[r], 0, strength, "", tuples[r]);
+    uncovered.insert(tuples[r].begin(), tuples[r].end());
+  }
+  chosen.assign(rows.size(), false);
+  while (uncovered.size()) {
+    size_t best = 0, bestCount = 0;
+    for (size_t r = 0; r < rows.size(); r++)
+      if (!chosen[r]) {
+        size_t count = 0;
+        for (CoverTuples::const_iterator ti = tuples[r].begin(); ti != tuples[r].end(); ++ti)
+          if (uncovered.find(*ti) != uncovered.end())
+            count++;
+        if (count > bestCount) {
+          best = r;
+          bestCount = count;
+        }
+      }
+    chosen[best] = true;
+    for (CoverTuples::const_iterator ti = tuples[best].begin(); ti != tuples[best].end(); ++ti)
+      uncovered.erase(*ti);
+  }
+  return chosen;
+}
+#endif
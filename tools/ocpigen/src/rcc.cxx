@@ -1005,7 +1005,8 @@ emitImplRCC() {
             "    OCPI::RCC::RCCConstruct ocpi_%s;\\\n"
             "    OCPI::RCC::RCCUserWorker *\\\n"
             "    ocpi_%s(void *place, OCPI::RCC::RCCWorkerInfo &info) {\\\n"
-            "      info.size = sizeof(%c%sWorker);\\\n",
+            "      info.size = sizeof(%c%sWorker);\\\n"
+            "      info.version = RCC_VERSION;\\\n",
             upper, m_implName, m_implName,
             toupper(m_implName[0]), m_implName + 1);
     fprintf(f,
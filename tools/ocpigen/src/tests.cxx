@@ -31,6 +31,7 @@
 #include "wip.h"
 #include "data.h"
 #include "hdl-device.h"
+#include "cover.h"
 
 #define TESTS "-tests.xml"
 #define MS_CONFIG "bypass", "metadata", "throttle", "full"
@@ -101,7 +102,7 @@ namespace {
     }
     return ws.end();
   }
-  size_t timeout, duration;
+  size_t timeout, duration, strength;
   const char *argPackage;
   std::string specName, specPackage;
   bool verbose;
@@ -448,11 +449,12 @@ namespace {
     ParamConfig m_results; // what the resulting properties should be
     ParamConfigs m_subCases;
     InputOutputs m_ports;  // the actual inputs and outputs to use
-    size_t m_timeout, m_duration;
+    size_t m_timeout, m_duration, m_strength;
     std::string m_delays;
 
     Case(ParamConfig &globals)
-      : m_settings(globals), m_results(*wFirst), m_timeout(timeout), m_duration(duration)
+      : m_settings(globals), m_results(*wFirst), m_timeout(timeout), m_duration(duration),
+        m_strength(strength)
     {}
     static const char *doExcludePlatform(const char *a_platform, void *arg) {
       Case &c = *(Case *)arg;
@@ -614,10 +616,11 @@ namespace {
       else
         OU::format(m_name, "case%02zu", ordinal);
       if ((err = OE::checkAttrs(x, "duration", "timeout", "onlyplatforms", "excludeplatforms",
-                                "onlyworkers", "excludeworkers", NULL)) ||
+                                "onlyworkers", "excludeworkers", "strength", NULL)) ||
           (err = OE::checkElements(x, "property", "input", "output", NULL)) ||
           (err = OE::getNumber(x, "duration", &m_duration, NULL, duration)) ||
-          (err = OE::getNumber(x, "timeout", &m_timeout, NULL, timeout)))
+          (err = OE::getNumber(x, "timeout", &m_timeout, NULL, timeout)) ||
+          (err = OE::getNumber(x, "strength", &m_strength, NULL, strength)))
         return err;
       if (m_duration && m_timeout)
         return OU::esprintf("Specifying both duration and timeout is not supported");
@@ -780,6 +783,36 @@ namespace {
         OU::esprintf("For case %s, there are no valid parameter combinations for any worker",
                      m_name.c_str()) : NULL;
     }
+    // Reduce the (already pruned) subcases to a covering array: a subset in which every
+    // combination of values of any "m_strength" swept properties that occurs in some
+    // subcase still occurs in at least one.  Subcases are chosen greedily, the one
+    // covering the most remaining combinations first, and keep their original order.
+    void
+    reduceSubCases() {
+      std::vector<unsigned> swept;
+      for (unsigned n = 0; n < m_settings.params.size(); n++) {
+        Param &p = m_settings.params[n];
+        if (p.m_param && p.m_generate.empty() && p.m_uValues.size() > 1)
+          swept.push_back(n);
+      }
+      if (!m_strength || m_strength >= swept.size() || m_subCases.size() <= 1)
+        return;
+      std::vector<CoverRow> rows(m_subCases.size());
+      for (unsigned s = 0; s < m_subCases.size(); s++)
+        for (unsigned n = 0; n < swept.size(); n++)
+          rows[s].push_back(m_subCases[s]->params[swept[n]].m_uValue);
+      std::vector<bool> chosen = coverRows(rows, m_strength);
+      ParamConfigs reduced;
+      for (unsigned s = 0; s < m_subCases.size(); s++)
+        if (chosen[s])
+          reduced.push_back(m_subCases[s]);
+      ocpiDebug("Reduced subcases for case %s from %zu to %zu for strength %zu",
+                m_name.c_str(), m_subCases.size(), reduced.size(), m_strength);
+      if (verbose)
+        fprintf(stderr, "Case %s: covering all %zu-way property combinations with %zu of %zu "
+                "subcases\n", m_name.c_str(), m_strength, reduced.size(), m_subCases.size());
+      m_subCases = reduced;
+    }
     void
     print(FILE *out) {
       fprintf(out, "Case %s:\n", m_name.c_str());
@@ -1631,13 +1664,14 @@ createTests(const char *file, const char *package, const char */*outDir*/, bool
   } else if ((err = parseFile(file, parent, "tests", &xml, xfile, false, false, false)) ||
              (err = OE::checkAttrs(xml, "spec", "timeout", "duration", "onlyWorkers",
                                    "excludeWorkers", "useHDLFileIo", "mode", "onlyPlatforms",
-                                   "excludePlatforms", NULL)) ||
+                                   "excludePlatforms", "strength", NULL)) ||
              (err = OE::checkElements(xml, "property", "case", "input", "output", NULL)))
     return err;
   // ================= 1. Get the spec
   if ((err = getSpec(xml, xfile, package, xspec, specFile, specName)) ||
       (err = OE::getNumber(xml, "duration", &duration)) ||
-      (err = OE::getNumber(xml, "timeout", &timeout)))
+      (err = OE::getNumber(xml, "timeout", &timeout)) ||
+      (err = OE::getNumber(xml, "strength", &strength)))
     return err;
   // ================= 2. Get/find/include/exclude the global workers
   // Parse global workers
@@ -2021,6 +2055,7 @@ createTests(const char *file, const char *package, const char */*outDir*/, bool
     cases[n]->doProp(0);
     if ((err = cases[n]->pruneSubCases()))
       return err;
+    cases[n]->reduceSubCases();
     cases[n]->print(out);
   }
   fclose(out);
@@ -2090,7 +2125,7 @@ createCases(const char **platforms, const char */*package*/, const char */*outDi
       if (m_run) {
         for (RunsIter ri = m_runs.begin(); ri != m_runs.end(); ++ri)
           fprintf(m_run, "%s", ri->second.c_str());
-        fprintf(m_run, "exit $failed\n");
+        fprintf(m_run, "waitcases\nexit $failed\n");
         fclose(m_run);
       }
       if (m_verify)
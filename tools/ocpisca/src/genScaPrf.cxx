@@ -133,6 +133,8 @@ genScaPrf(const char *outDir) const {
   const Property *p = m_properties;
   ezxml_t root = ezxml_new("properties");
   for (size_t n = m_nProperties; n; n--, p++) {
+    if (p->m_isCounter)
+      continue;
     const OU::Property &pr =
       m_instances[p->m_instance].
       m_bestDeployment.m_impls[0]->m_metadataImpl.property(p->m_property);